@@ -1,3 +1,7 @@
+#define _POSIX_C_SOURCE 200809L
+// only for syscall(2), perf_event_open has no glibc wrapper
+#define _GNU_SOURCE
+
 #include <sys/stat.h>
 #include <stdio.h>
 #include <sys/mman.h>
@@ -7,6 +11,16 @@
 #include <time.h>
 #include <math.h>
 #include <string.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <stdarg.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
 
 #include "thirdparty/glad/glad.h"
 #include "thirdparty/glad/glad_egl.h"
@@ -41,6 +55,17 @@
 
 #define my_array_count(a) (sizeof(a) / sizeof(a[0]))
 
+static double my_time_ms(void) {
+    struct timespec ts;
+    ASSERT_NOT_MINUS_ONE(clock_gettime(CLOCK_MONOTONIC, &ts));
+    return (double)ts.tv_sec * 1000.0 + (double)ts.tv_nsec / 1000000.0;
+}
+
+// Exact comparison for values that must reproduce bit for bit, without tripping -Wfloat-equal.
+static bool my_f64_bits_equal(const double first, const double second) {
+    return memcmp(&first, &second, sizeof(first)) == 0;
+}
+
 static void my_gl_clear_errors(void) {
     while(glGetError() != GL_NO_ERROR) {}
 }
@@ -115,6 +140,246 @@ static void egl_assert(const char *const function, const char *const file, const
 #define ASSERT_GL(x) do { my_gl_clear_errors(); (x); gl_assert(__FUNCTION__, __FILE__, __LINE__, #x); } while(0)
 #define ASSERT_EGL(x) do { my_egl_clear_errors(); (x); egl_assert(__FUNCTION__, __FILE__, __LINE__, #x); } while(0)
 
+#define MY_TRACE_CHUNK_EVENTS 4096
+#define MY_TRACE_GPU_QUERIES_MAX 256
+#define MY_TRACE_CONCAT_(a, b) a##b
+#define MY_TRACE_CONCAT(a, b) MY_TRACE_CONCAT_(a, b)
+
+typedef struct {
+    const char *name;
+    int64_t start_ns;
+    int64_t duration_ns;
+    bool gpu;
+} MyTraceEvent;
+
+typedef struct MyTraceChunk {
+    MyTraceEvent events[MY_TRACE_CHUNK_EVENTS];
+    size_t count;
+    struct MyTraceChunk *next;
+} MyTraceChunk;
+
+// Events of one thread, appended without locks by the owner and read by my_trace_finish after the thread is joined.
+// GPU zones are a ring of GL_TIMESTAMP query pairs in the context current on the thread, resolved in submission order.
+typedef struct MyTraceThread {
+    struct MyTraceThread *next;
+    uint32_t tid;
+    char name[32];
+    MyTraceChunk *first;
+    MyTraceChunk *last;
+    EGLContext gpu_context;
+    int64_t gpu_offset_ns;
+    GLuint gpu_queries[MY_TRACE_GPU_QUERIES_MAX][2];
+    const char *gpu_names[MY_TRACE_GPU_QUERIES_MAX];
+    size_t gpu_first;
+    size_t gpu_count;
+    bool gpu_used;
+} MyTraceThread;
+
+// `enabled` only changes while no other thread records, so a disabled zone costs one relaxed load and an untaken branch.
+typedef struct {
+    _Atomic bool enabled;
+    size_t generation;
+    int64_t start_ns;
+    pthread_mutex_t mutex;
+    MyTraceThread *threads;
+    uint32_t threads_count;
+} MyTrace;
+
+static MyTrace my_trace = {.mutex = PTHREAD_MUTEX_INITIALIZER};
+static _Thread_local MyTraceThread *my_trace_thread;
+static _Thread_local size_t my_trace_thread_generation;
+
+typedef struct {
+    const char *name;
+    int64_t start_ns;
+    bool open;
+} MyTraceZone;
+
+static bool my_trace_enabled(void) {
+    return atomic_load_explicit(&my_trace.enabled, memory_order_relaxed);
+}
+
+static int64_t my_trace_now_ns(void) {
+    struct timespec ts;
+    ASSERT_NOT_MINUS_ONE(clock_gettime(CLOCK_MONOTONIC, &ts));
+    return (int64_t)ts.tv_sec * 1000000000 + (int64_t)ts.tv_nsec;
+}
+
+static MyTraceThread* my_trace_thread_get(void) {
+    if(my_trace_thread && my_trace_thread_generation == my_trace.generation) {
+        return my_trace_thread;
+    }
+    MyTraceThread *const thread = (MyTraceThread*)calloc(1, sizeof(*thread));
+    ASSERT(thread);
+    thread->gpu_context = EGL_NO_CONTEXT;
+    ASSERT(pthread_mutex_lock(&my_trace.mutex) == 0);
+        thread->tid = ++my_trace.threads_count;
+        thread->next = my_trace.threads;
+        my_trace.threads = thread;
+    ASSERT(pthread_mutex_unlock(&my_trace.mutex) == 0);
+    snprintf(thread->name, sizeof(thread->name), "thread %" PRIu32, thread->tid);
+    my_trace_thread = thread;
+    my_trace_thread_generation = my_trace.generation;
+    return thread;
+}
+
+__attribute__((format(printf, 1, 2))) static void my_trace_thread_name(const char *const format, ...) {
+    if(!my_trace_enabled()) {
+        return;
+    }
+    MyTraceThread *const thread = my_trace_thread_get();
+    va_list args;
+    va_start(args, format);
+    vsnprintf(thread->name, sizeof(thread->name), format, args);
+    va_end(args);
+}
+
+static void my_trace_record(const char name[static 1], const int64_t start_ns, const int64_t duration_ns, const bool gpu) {
+    MyTraceThread *const thread = my_trace_thread_get();
+    if(!thread->last || thread->last->count == MY_TRACE_CHUNK_EVENTS) {
+        MyTraceChunk *const chunk = (MyTraceChunk*)calloc(1, sizeof(*chunk));
+        ASSERT(chunk);
+        if(thread->last) {
+            thread->last->next = chunk;
+        } else {
+            thread->first = chunk;
+        }
+        thread->last = chunk;
+    }
+    thread->last->events[thread->last->count++] = (MyTraceEvent){.name = name, .start_ns = start_ns, .duration_ns = duration_ns, .gpu = gpu};
+}
+
+static MyTraceZone my_trace_begin(const char name[static 1]) {
+    return (MyTraceZone){.name = name, .start_ns = my_trace_enabled() ? my_trace_now_ns() : 0, .open = true};
+}
+
+static void my_trace_end(MyTraceZone zone[static 1]) {
+    zone->open = false;
+    if(my_trace_enabled()) {
+        my_trace_record(zone->name, zone->start_ns, my_trace_now_ns() - zone->start_ns, false);
+    }
+}
+
+// Records the statement or block that follows as a CPU zone. Leaving it with return, break or goto drops the zone.
+#define my_trace_zone(name) \
+    for(MyTraceZone MY_TRACE_CONCAT(my_trace_zone_, __LINE__) = my_trace_begin((name)); \
+        MY_TRACE_CONCAT(my_trace_zone_, __LINE__).open; \
+        my_trace_end(&MY_TRACE_CONCAT(my_trace_zone_, __LINE__)))
+
+// Takes the oldest pending dispatch of the current context, `wait` blocks until the GPU has finished it.
+static bool my_trace_gpu_pop(MyTraceThread thread[static 1], const bool wait) {
+    if(thread->gpu_count == 0) {
+        return false;
+    }
+    GLuint *const queries = thread->gpu_queries[thread->gpu_first];
+    if(!wait) {
+        GLint available;
+        ASSERT_GL(glGetQueryObjectiv(queries[1], GL_QUERY_RESULT_AVAILABLE, &available));
+        if(!available) {
+            return false;
+        }
+    }
+    GLint64 start_ns, end_ns;
+    ASSERT_GL(glGetQueryObjecti64v(queries[0], GL_QUERY_RESULT, &start_ns));
+    ASSERT_GL(glGetQueryObjecti64v(queries[1], GL_QUERY_RESULT, &end_ns));
+    my_trace_record(thread->gpu_names[thread->gpu_first], start_ns + thread->gpu_offset_ns, end_ns - start_ns, true);
+    thread->gpu_first = (thread->gpu_first + 1) % MY_TRACE_GPU_QUERIES_MAX;
+    thread->gpu_count--;
+    return true;
+}
+
+// Resolves the pending dispatches while their context is still current, called before it stops being current on this thread.
+static void my_trace_gpu_flush(void) {
+    if(!my_trace_enabled() || !my_trace_thread || my_trace_thread_generation != my_trace.generation) {
+        return;
+    }
+    MyTraceThread *const thread = my_trace_thread;
+    if(thread->gpu_context != EGL_NO_CONTEXT && thread->gpu_context == eglGetCurrentContext()) {
+        while(my_trace_gpu_pop(thread, true)) {}
+        ASSERT_GL(glDeleteQueries(2 * MY_TRACE_GPU_QUERIES_MAX, &thread->gpu_queries[0][0]));
+    }
+    thread->gpu_context = EGL_NO_CONTEXT;
+    thread->gpu_first = 0;
+    thread->gpu_count = 0;
+}
+
+// glDispatchCompute, bracketed by GL_TIMESTAMP queries when tracing. GPU time is mapped to CLOCK_MONOTONIC
+// by an offset sampled with glGetInteger64v(GL_TIMESTAMP) the first time a context dispatches on the thread.
+static void my_gl_dispatch_compute(const char name[static 1], const GLuint groups_x, const GLuint groups_y, const GLuint groups_z) {
+    if(!my_trace_enabled()) {
+        ASSERT_GL(glDispatchCompute(groups_x, groups_y, groups_z));
+        return;
+    }
+    MyTraceThread *const thread = my_trace_thread_get();
+    if(thread->gpu_context != eglGetCurrentContext()) {
+        my_trace_gpu_flush();
+        thread->gpu_context = eglGetCurrentContext();
+        ASSERT_GL(glGenQueries(2 * MY_TRACE_GPU_QUERIES_MAX, &thread->gpu_queries[0][0]));
+        GLint64 gpu_ns;
+        ASSERT_GL(glGetInteger64v(GL_TIMESTAMP, &gpu_ns));
+        thread->gpu_offset_ns = my_trace_now_ns() - gpu_ns;
+        thread->gpu_used = true;
+    }
+    if(thread->gpu_count == MY_TRACE_GPU_QUERIES_MAX) {
+        my_trace_gpu_pop(thread, true);
+    }
+    const size_t slot = (thread->gpu_first + thread->gpu_count) % MY_TRACE_GPU_QUERIES_MAX;
+    thread->gpu_names[slot] = name;
+    ASSERT_GL(glQueryCounter(thread->gpu_queries[slot][0], GL_TIMESTAMP));
+    ASSERT_GL(glDispatchCompute(groups_x, groups_y, groups_z));
+    ASSERT_GL(glQueryCounter(thread->gpu_queries[slot][1], GL_TIMESTAMP));
+    thread->gpu_count++;
+    while(my_trace_gpu_pop(thread, false)) {}
+}
+
+static void my_trace_start(void) {
+    ASSERT(!my_trace_enabled());
+    my_trace.generation++;
+    my_trace.start_ns = my_trace_now_ns();
+    atomic_store_explicit(&my_trace.enabled, true, memory_order_relaxed);
+}
+
+// Chrome trace event JSON, loadable by Perfetto and chrome://tracing. CPU zones are process 1, the dispatches
+// of every thread land on a track of the same tid in process 2. Every recording thread must be joined by now.
+static size_t my_trace_finish(const char path[static 1]) {
+    ASSERT(my_trace_enabled());
+    my_trace_gpu_flush();
+    atomic_store_explicit(&my_trace.enabled, false, memory_order_relaxed);
+    FILE *const file = fopen(path, "w");
+    ASSERT(file, "%s: %s", path, strerror(errno));
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    fprintf(file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"cpu\"}},\n");
+    fprintf(file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":2,\"tid\":0,\"args\":{\"name\":\"gpu\"}}");
+    size_t events_count = 0;
+    for(MyTraceThread *thread = my_trace.threads, *next; thread; thread = next) {
+        next = thread->next;
+        fprintf(file, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%" PRIu32 ",\"args\":{\"name\":\"%s\"}}", thread->tid, thread->name);
+        if(thread->gpu_used) {
+            fprintf(file, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":2,\"tid\":%" PRIu32 ",\"args\":{\"name\":\"%s\"}}", thread->tid, thread->name);
+        }
+        for(MyTraceChunk *chunk = thread->first, *chunk_next; chunk; chunk = chunk_next) {
+            chunk_next = chunk->next;
+            for(size_t i = 0; i < chunk->count; ++i) {
+                const MyTraceEvent *const event = &chunk->events[i];
+                fprintf(
+                    file, ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":%d,\"tid\":%" PRIu32 ",\"ts\":%.3lf,\"dur\":%.3lf}",
+                    event->name, event->gpu ? "gpu" : "cpu", event->gpu ? 2 : 1, thread->tid,
+                    (double)(event->start_ns - my_trace.start_ns) / 1000.0, (double)event->duration_ns / 1000.0
+                );
+            }
+            events_count += chunk->count;
+            free(chunk);
+        }
+        free(thread);
+    }
+    fprintf(file, "\n]}\n");
+    ASSERT(fclose(file) == 0);
+    my_trace.threads = NULL;
+    my_trace.threads_count = 0;
+    LOG("trace: %s, events: %zu", path, events_count);
+    return events_count;
+}
+
 
 static GLuint mygl_create_compile_shader(const GLenum shader_type, const char *const shader_code) {
     GLuint shader_id;
@@ -145,25 +410,27 @@ static void mygl_create_shader_program(
     const char *const vertex_shader_code,
     const char *const fragment_shader_code
 ) {
-    *shader_vertex = mygl_create_compile_shader(GL_VERTEX_SHADER, vertex_shader_code);
-    *shader_fragment = mygl_create_compile_shader(GL_FRAGMENT_SHADER, fragment_shader_code);
-
-    *shader_program = glCreateProgram();
-    ASSERT(*shader_program);
-
-    ASSERT_GL(glAttachShader(*shader_program, *shader_vertex));
-    ASSERT_GL(glAttachShader(*shader_program, *shader_fragment));
-    {
-        ASSERT_GL(glLinkProgram(*shader_program));
-        GLint status;
-        ASSERT_GL(glGetProgramiv(*shader_program, GL_LINK_STATUS, &status));
-        ASSERT(status == GL_TRUE);
-    }
-    {
-        ASSERT_GL(glValidateProgram(*shader_program));
-        GLint status;
-        ASSERT_GL(glGetProgramiv(*shader_program, GL_VALIDATE_STATUS, &status));
-        ASSERT(status == GL_TRUE);
+    my_trace_zone("compile") {
+        *shader_vertex = mygl_create_compile_shader(GL_VERTEX_SHADER, vertex_shader_code);
+        *shader_fragment = mygl_create_compile_shader(GL_FRAGMENT_SHADER, fragment_shader_code);
+
+        *shader_program = glCreateProgram();
+        ASSERT(*shader_program);
+
+        ASSERT_GL(glAttachShader(*shader_program, *shader_vertex));
+        ASSERT_GL(glAttachShader(*shader_program, *shader_fragment));
+        {
+            ASSERT_GL(glLinkProgram(*shader_program));
+            GLint status;
+            ASSERT_GL(glGetProgramiv(*shader_program, GL_LINK_STATUS, &status));
+            ASSERT(status == GL_TRUE);
+        }
+        {
+            ASSERT_GL(glValidateProgram(*shader_program));
+            GLint status;
+            ASSERT_GL(glGetProgramiv(*shader_program, GL_VALIDATE_STATUS, &status));
+            ASSERT(status == GL_TRUE);
+        }
     }
 }
 
@@ -172,22 +439,24 @@ static void mygl_create_compute_shader_program(
     GLuint *const shader_compute,
     const char *const shader_code
 ) {
-    *shader_compute = mygl_create_compile_shader(GL_COMPUTE_SHADER, shader_code);
-    *shader_program = glCreateProgram();
-    ASSERT(*shader_program);
-
-    ASSERT_GL(glAttachShader(*shader_program, *shader_compute));
-    {
-        ASSERT_GL(glLinkProgram(*shader_program));
-        GLint status;
-        ASSERT_GL(glGetProgramiv(*shader_program, GL_LINK_STATUS, &status));
-        ASSERT(status == GL_TRUE);
-    }
-    {
-        ASSERT_GL(glValidateProgram(*shader_program));
-        GLint status;
-        ASSERT_GL(glGetProgramiv(*shader_program, GL_VALIDATE_STATUS, &status));
-        ASSERT(status == GL_TRUE);
+    my_trace_zone("compile") {
+        *shader_compute = mygl_create_compile_shader(GL_COMPUTE_SHADER, shader_code);
+        *shader_program = glCreateProgram();
+        ASSERT(*shader_program);
+
+        ASSERT_GL(glAttachShader(*shader_program, *shader_compute));
+        {
+            ASSERT_GL(glLinkProgram(*shader_program));
+            GLint status;
+            ASSERT_GL(glGetProgramiv(*shader_program, GL_LINK_STATUS, &status));
+            ASSERT(status == GL_TRUE);
+        }
+        {
+            ASSERT_GL(glValidateProgram(*shader_program));
+            GLint status;
+            ASSERT_GL(glGetProgramiv(*shader_program, GL_VALIDATE_STATUS, &status));
+            ASSERT(status == GL_TRUE);
+        }
     }
 }
 
@@ -256,6 +525,121 @@ static GLFWwindow* my_glfw_init(const bool visible) {
     return glfw_window;
 }
 
+typedef enum {
+    MY_MEM_PHASE_OTHER,
+    MY_MEM_PHASE_LOAD,
+    MY_MEM_PHASE_FEATURES,
+    MY_MEM_PHASE_UPLOAD,
+    MY_MEM_PHASE_TRAIN,
+    MY_MEM_PHASE_EVALUATE,
+    MY_MEM_PHASE_COUNT,
+} MyMemPhase;
+
+static const char *const my_mem_phase_names[MY_MEM_PHASE_COUNT] = {
+    [MY_MEM_PHASE_OTHER] = "other",
+    [MY_MEM_PHASE_LOAD] = "load",
+    [MY_MEM_PHASE_FEATURES] = "features",
+    [MY_MEM_PHASE_UPLOAD] = "upload",
+    [MY_MEM_PHASE_TRAIN] = "train",
+    [MY_MEM_PHASE_EVALUATE] = "evaluate",
+};
+
+// Totals count what was allocated or transferred while the phase was current, peaks the most bytes of every phase
+// alive at once while it was.
+typedef struct {
+    atomic_size_t host_bytes;
+    atomic_size_t host_peak_bytes;
+    atomic_size_t gl_bytes;
+    atomic_size_t gl_peak_bytes;
+    atomic_size_t uploaded_bytes;
+    atomic_size_t downloaded_bytes;
+} MyMemPhaseStats;
+
+// Host bytes are arena capacities, GL bytes are MyGLMat buffers.
+typedef struct {
+    atomic_size_t host_alive_bytes;
+    atomic_size_t gl_alive_bytes;
+    MyMemPhaseStats phases[MY_MEM_PHASE_COUNT];
+} MyMem;
+
+static MyMem my_mem;
+// every thread accounts to its own phase, the GL workers train while the next device uploads
+static _Thread_local MyMemPhase my_mem_phase;
+
+static void my_mem_peak_update(atomic_size_t peak[static 1], const size_t bytes_count) {
+    size_t current = atomic_load_explicit(peak, memory_order_relaxed);
+    while(bytes_count > current && !atomic_compare_exchange_weak_explicit(peak, &current, bytes_count, memory_order_relaxed, memory_order_relaxed)) {}
+}
+
+// Returns the previous phase of the calling thread so it can be restored.
+static MyMemPhase my_mem_phase_set(const MyMemPhase phase) {
+    const MyMemPhase previous = my_mem_phase;
+    my_mem_phase = phase;
+    MyMemPhaseStats *const stats = &my_mem.phases[phase];
+    my_mem_peak_update(&stats->host_peak_bytes, atomic_load_explicit(&my_mem.host_alive_bytes, memory_order_relaxed));
+    my_mem_peak_update(&stats->gl_peak_bytes, atomic_load_explicit(&my_mem.gl_alive_bytes, memory_order_relaxed));
+    return previous;
+}
+
+static void my_mem_host_alloc(const size_t bytes_count) {
+    MyMemPhaseStats *const stats = &my_mem.phases[my_mem_phase];
+    atomic_fetch_add_explicit(&stats->host_bytes, bytes_count, memory_order_relaxed);
+    my_mem_peak_update(&stats->host_peak_bytes, atomic_fetch_add_explicit(&my_mem.host_alive_bytes, bytes_count, memory_order_relaxed) + bytes_count);
+}
+
+static void my_mem_host_free(const size_t bytes_count) {
+    atomic_fetch_sub_explicit(&my_mem.host_alive_bytes, bytes_count, memory_order_relaxed);
+}
+
+static void my_mem_gl_alloc(const size_t bytes_count) {
+    MyMemPhaseStats *const stats = &my_mem.phases[my_mem_phase];
+    atomic_fetch_add_explicit(&stats->gl_bytes, bytes_count, memory_order_relaxed);
+    my_mem_peak_update(&stats->gl_peak_bytes, atomic_fetch_add_explicit(&my_mem.gl_alive_bytes, bytes_count, memory_order_relaxed) + bytes_count);
+}
+
+static void my_mem_gl_free(const size_t bytes_count) {
+    atomic_fetch_sub_explicit(&my_mem.gl_alive_bytes, bytes_count, memory_order_relaxed);
+}
+
+static void my_mem_uploaded(const size_t bytes_count) {
+    atomic_fetch_add_explicit(&my_mem.phases[my_mem_phase].uploaded_bytes, bytes_count, memory_order_relaxed);
+}
+
+static void my_mem_downloaded(const size_t bytes_count) {
+    atomic_fetch_add_explicit(&my_mem.phases[my_mem_phase].downloaded_bytes, bytes_count, memory_order_relaxed);
+}
+
+static double my_mem_mib(const atomic_size_t bytes_count[static 1]) {
+    return (double)atomic_load_explicit(bytes_count, memory_order_relaxed) / (1024.0 * 1024.0);
+}
+
+static bool my_mem_phase_used(const MyMemPhaseStats stats[static 1]) {
+    return my_mem_mib(&stats->host_peak_bytes) > 0.0 || my_mem_mib(&stats->gl_peak_bytes) > 0.0
+        || my_mem_mib(&stats->uploaded_bytes) > 0.0 || my_mem_mib(&stats->downloaded_bytes) > 0.0;
+}
+
+static void my_mem_report(void) {
+    bool used = false;
+    for(size_t phase = 0; phase < MY_MEM_PHASE_COUNT; ++phase) {
+        used = used || my_mem_phase_used(&my_mem.phases[phase]);
+    }
+    if(!used) {
+        return;
+    }
+    LOG("memory alive, host MiB: %.2lf, gl MiB: %.2lf", my_mem_mib(&my_mem.host_alive_bytes), my_mem_mib(&my_mem.gl_alive_bytes));
+    for(size_t phase = 0; phase < MY_MEM_PHASE_COUNT; ++phase) {
+        const MyMemPhaseStats *const stats = &my_mem.phases[phase];
+        if(!my_mem_phase_used(stats)) {
+            continue;
+        }
+        LOG(
+            "phase: %-8s, host MiB: %9.2lf, host peak MiB: %9.2lf, gl MiB: %9.2lf, gl peak MiB: %9.2lf, uploaded MiB: %9.2lf, downloaded MiB: %9.2lf",
+            my_mem_phase_names[phase], my_mem_mib(&stats->host_bytes), my_mem_mib(&stats->host_peak_bytes), my_mem_mib(&stats->gl_bytes),
+            my_mem_mib(&stats->gl_peak_bytes), my_mem_mib(&stats->uploaded_bytes), my_mem_mib(&stats->downloaded_bytes)
+        );
+    }
+}
+
 typedef struct {
     uint8_t *items;
     size_t count;
@@ -268,9 +652,16 @@ static MyArena my_arena_init(const size_t bytes_count) {
     MyArena arena = {.capacity = bytes_count, .items = (uint8_t*)malloc(bytes_count)};
     ASSERT(arena.items);
     memset(arena.items, 0, bytes_count);
+    my_mem_host_alloc(bytes_count);
     return arena;
 }
 
+static void my_arena_free(MyArena arena[static 1]) {
+    my_mem_host_free(arena->capacity);
+    free(arena->items);
+    *arena = (MyArena){0};
+}
+
 static void* my_arena_alloc(MyArena *const arena, const size_t bytes_count) {
     ASSERT(arena->count + bytes_count <= arena->capacity);
     void *const result = &arena->items[arena->count];
@@ -307,606 +698,9163 @@ static MyMat my_mat_alloc(MyArena arena[static 1], const size_t rows, const size
     return m;
 }
 
-static MyMat my_mat_hstack(MyArena arena[static 1], const MyMat first[static 1], const MyMat second[static 1]) {
-    ASSERT(first->rows == second->rows);
-    MyMat result = my_mat_alloc(arena, first->rows, first->cols + second->cols);
-    my_range_for_zero(size_t, row, first->rows) {
-        memcpy(&my_mat_row(&result, row), &my_mat_row(first, row), my_mat_row_bytes_count(first));
-        memcpy(&my_mat_item(&result, row, first->cols), &my_mat_row(second, row), my_mat_row_bytes_count(second));
+typedef enum {
+    MY_PERF_EVENT_CYCLES,
+    MY_PERF_EVENT_INSTRUCTIONS,
+    MY_PERF_EVENT_LLC_MISSES,
+    MY_PERF_EVENT_DTLB_MISSES,
+    MY_PERF_EVENT_COUNT,
+} MyPerfEvent;
+
+static const char *const my_perf_event_names[MY_PERF_EVENT_COUNT] = {
+    [MY_PERF_EVENT_CYCLES] = "cycles",
+    [MY_PERF_EVENT_INSTRUCTIONS] = "instructions",
+    [MY_PERF_EVENT_LLC_MISSES] = "llc misses",
+    [MY_PERF_EVENT_DTLB_MISSES] = "dtlb misses",
+};
+
+#define MY_PERF_CACHE_OP_MISS(cache) ((cache) | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16))
+
+static const uint32_t my_perf_event_types[MY_PERF_EVENT_COUNT] = {
+    [MY_PERF_EVENT_CYCLES] = PERF_TYPE_HARDWARE,
+    [MY_PERF_EVENT_INSTRUCTIONS] = PERF_TYPE_HARDWARE,
+    [MY_PERF_EVENT_LLC_MISSES] = PERF_TYPE_HW_CACHE,
+    [MY_PERF_EVENT_DTLB_MISSES] = PERF_TYPE_HW_CACHE,
+};
+
+static const uint64_t my_perf_event_configs[MY_PERF_EVENT_COUNT] = {
+    [MY_PERF_EVENT_CYCLES] = PERF_COUNT_HW_CPU_CYCLES,
+    [MY_PERF_EVENT_INSTRUCTIONS] = PERF_COUNT_HW_INSTRUCTIONS,
+    [MY_PERF_EVENT_LLC_MISSES] = MY_PERF_CACHE_OP_MISS(PERF_COUNT_HW_CACHE_LL),
+    [MY_PERF_EVENT_DTLB_MISSES] = MY_PERF_CACHE_OP_MISS(PERF_COUNT_HW_CACHE_DTLB),
+};
+
+// Every LLC read miss is counted as one line fetched from memory, so bandwidth figures are an estimate.
+#define MY_PERF_CACHE_LINE_BYTES 64.0
+
+// User space counters of one thread, opened on its first sample and closed when it exits.
+// An event the kernel refuses keeps fd -1 and every delta of it is NAN.
+typedef struct {
+    int fds[MY_PERF_EVENT_COUNT];
+} MyPerfCounters;
+
+typedef struct {
+    uint64_t values[MY_PERF_EVENT_COUNT];
+    uint64_t enabled_ns[MY_PERF_EVENT_COUNT];
+    uint64_t running_ns[MY_PERF_EVENT_COUNT];
+} MyPerfSample;
+
+// Set by --perf-counters before the thread pool starts.
+static bool my_perf_enabled;
+static pthread_key_t my_perf_key;
+static pthread_once_t my_perf_key_once = PTHREAD_ONCE_INIT;
+static atomic_bool my_perf_warned[MY_PERF_EVENT_COUNT];
+
+static void my_perf_counters_destroy(void *const arg) {
+    MyPerfCounters *const counters = (MyPerfCounters*)arg;
+    my_range_for_zero(size_t, i, MY_PERF_EVENT_COUNT) {
+        if(counters->fds[i] != -1) {
+            ASSERT_NOT_MINUS_ONE(close(counters->fds[i]));
+        }
     }
-    return result;
+    free(counters);
 }
 
-static MyMat my_mat_copy(MyArena arena[static 1], const MyMat src[static 1]) {
-    MyMat m = my_mat_alloc(arena, src->rows, src->cols);
-    memcpy(m.items, src->items, my_mat_bytes_count(src));
-    return m; 
+static void my_perf_key_create(void) {
+    ASSERT(pthread_key_create(&my_perf_key, my_perf_counters_destroy) == 0);
 }
 
-static void my_mat_mul(MyMat *const result, const MyMat *const first, const MyMat *const second) { ASSERT(first->cols == second->rows); ASSERT(first->rows == result->rows);
-    ASSERT(first->cols == second->rows);
-    ASSERT(first->rows == result->rows);
-    ASSERT(second->cols == result->cols);
-    my_range_for_zero(size_t, first_row_index, first->rows) {
-        my_range_for_zero(size_t, second_col_index, second->cols) {
-            GLfloat sum = 0.f;
-            my_range_for_zero(size_t, first_col_index, first->cols) {
-                sum += my_mat_item(first, first_row_index, first_col_index) * my_mat_item(second, first_col_index, second_col_index);
-            }
-            my_mat_item(result, first_row_index, second_col_index) = sum;
+static MyPerfCounters* my_perf_counters_get(void) {
+    ASSERT(pthread_once(&my_perf_key_once, my_perf_key_create) == 0);
+    MyPerfCounters *counters = (MyPerfCounters*)pthread_getspecific(my_perf_key);
+    if(counters) {
+        return counters;
+    }
+    counters = (MyPerfCounters*)malloc(sizeof(*counters));
+    ASSERT(counters);
+    my_range_for_zero(size_t, i, MY_PERF_EVENT_COUNT) {
+        struct perf_event_attr attr = {
+            .size = sizeof(attr),
+            .type = my_perf_event_types[i],
+            .config = my_perf_event_configs[i],
+            .read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING,
+            .exclude_kernel = 1,
+            .exclude_hv = 1,
+        };
+        counters->fds[i] = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, PERF_FLAG_FD_CLOEXEC);
+        if(counters->fds[i] == -1 && !atomic_exchange(&my_perf_warned[i], true)) {
+            LOG("perf counter %s unavailable: %s, see /proc/sys/kernel/perf_event_paranoid", my_perf_event_names[i], strerror(errno));
         }
     }
+    ASSERT(pthread_setspecific(my_perf_key, counters) == 0);
+    return counters;
 }
 
-static void my_mat_transpose(void) {
-
+static void my_perf_sample(MyPerfSample sample[static 1]) {
+    const MyPerfCounters *const counters = my_perf_counters_get();
+    *sample = (MyPerfSample){0};
+    my_range_for_zero(size_t, i, MY_PERF_EVENT_COUNT) {
+        if(counters->fds[i] != -1) {
+            uint64_t values[3];
+            ASSERT(read(counters->fds[i], values, sizeof(values)) == (ssize_t)sizeof(values));
+            sample->values[i] = values[0];
+            sample->enabled_ns[i] = values[1];
+            sample->running_ns[i] = values[2];
+        }
+    }
 }
 
-#define SHADER_VERSION_STRING "#version 460\n"
-
-static const char mygl_matrix_mul_compute_shader[] = SHADER_VERSION_STRING S(
-layout(local_size_x = 32, local_size_y = 32, local_size_z = 1) in;
+// Scaled up by enabled over running time when the kernel multiplexed the counters, NAN when an event never ran.
+static void my_perf_delta(const MyPerfSample first[static 1], const MyPerfSample end[static 1], double counts[static MY_PERF_EVENT_COUNT]) {
+    my_range_for_zero(size_t, i, MY_PERF_EVENT_COUNT) {
+        const uint64_t running_ns = end->running_ns[i] - first->running_ns[i];
+        counts[i] = running_ns == 0
+            ? (double)NAN
+            : (double)(end->values[i] - first->values[i]) * (double)(end->enabled_ns[i] - first->enabled_ns[i]) / (double)running_ns;
+    }
+}
 
-uniform uint m;
-uniform uint n;
-uniform uint l;
-uniform uint x0;
-uniform uint y0;
+// NAN deltas are skipped, so one worker that was never scheduled on an event does not poison the sum of the others.
+static void my_perf_accumulate(double sums[static MY_PERF_EVENT_COUNT], size_t samples[static MY_PERF_EVENT_COUNT], const double counts[static MY_PERF_EVENT_COUNT]) {
+    my_range_for_zero(size_t, i, MY_PERF_EVENT_COUNT) {
+        if(!isnan(counts[i])) {
+            sums[i] += counts[i];
+            samples[i]++;
+        }
+    }
+}
 
-layout(std430, binding = 0) readonly buffer ssbo_A { float A[]; };
-layout(std430, binding = 1) readonly buffer ssbo_B { float B[]; };
-layout(std430, binding = 2) writeonly buffer ssbo_R { float R[]; };
+#define MY_THREAD_POOL_THREADS_MAX 256
+#define MY_THREAD_POOL_TASKS_MAX 32
 
-const uint BLOCK_SIZE = gl_WorkGroupSize.x;
+// Chunks are [chunk * grain, (chunk + 1) * grain) of the iteration range.
+typedef void (*MyParallelForFn)(void *context, size_t first, size_t end);
+typedef double (*MyParallelReduceFn)(void *context, size_t first, size_t end);
 
-shared float As[BLOCK_SIZE][BLOCK_SIZE];
-shared float Bs[BLOCK_SIZE][BLOCK_SIZE];
+typedef struct {
+    pthread_mutex_t mutex;
+    size_t first_chunk;
+    size_t end_chunk;
+} MyThreadPoolQueue;
 
-void __memoryBarrierShared() {
-    memoryBarrierShared();
-    barrier();
+typedef struct {
+    const char *name;
+    size_t calls;
+    size_t chunks;
+    size_t steals;
+    double wall_ms;
+    double busy_ms;
+    double mean_busy_ms;
+    double max_busy_ms;
+    // summed over the workers, only sampled with --perf-counters; `counter_samples` counts the deltas that were not NAN
+    double counters[MY_PERF_EVENT_COUNT];
+    size_t counter_samples[MY_PERF_EVENT_COUNT];
+} MyThreadPoolTaskStats;
+
+// Fork-join pool with range stealing: every worker owns a contiguous range of chunks and takes them from
+// the front, an idle worker steals the back half of another worker's range. The calling thread is worker 0.
+typedef struct {
+    size_t threads_count;
+    pthread_t threads[MY_THREAD_POOL_THREADS_MAX];
+    MyThreadPoolQueue queues[MY_THREAD_POOL_THREADS_MAX];
+    double busy_ms[MY_THREAD_POOL_THREADS_MAX];
+    size_t steals[MY_THREAD_POOL_THREADS_MAX];
+    double counters[MY_THREAD_POOL_THREADS_MAX][MY_PERF_EVENT_COUNT];
+    pthread_mutex_t submit_mutex;
+    pthread_mutex_t mutex;
+    pthread_cond_t start;
+    pthread_cond_t done;
+    size_t generation;
+    size_t running;
+    bool stop;
+    const char *name;
+    MyParallelForFn fn;
+    void *context;
+    size_t count;
+    size_t grain;
+    MyThreadPoolTaskStats tasks[MY_THREAD_POOL_TASKS_MAX];
+    size_t tasks_count;
+} MyThreadPool;
+
+// Created once by my_thread_pool_init, until then and inside tasks every parallel loop runs on the calling thread.
+static MyThreadPool my_thread_pool;
+static _Thread_local bool my_thread_pool_inside;
+
+static bool my_thread_pool_queue_pop(MyThreadPoolQueue queue[static 1], size_t chunk[static 1]) {
+    ASSERT(pthread_mutex_lock(&queue->mutex) == 0);
+        const bool popped = queue->first_chunk < queue->end_chunk;
+        if(popped) {
+            *chunk = queue->first_chunk++;
+        }
+    ASSERT(pthread_mutex_unlock(&queue->mutex) == 0);
+    return popped;
 }
 
-void main() {
-    uint hA = m;
-    uint wA = n;
-    uint wB = l;
+static bool my_thread_pool_steal(MyThreadPool pool[static 1], const size_t worker) {
+    my_range_for(size_t, i, 1, pool->threads_count) {
+        MyThreadPoolQueue *const victim = &pool->queues[(worker + i) % pool->threads_count];
+        ASSERT(pthread_mutex_lock(&victim->mutex) == 0);
+            const size_t remaining = victim->end_chunk - victim->first_chunk;
+            const size_t end_chunk = victim->end_chunk;
+            victim->end_chunk -= (remaining + 1) / 2;
+        ASSERT(pthread_mutex_unlock(&victim->mutex) == 0);
+        if(remaining > 0) {
+            MyThreadPoolQueue *const queue = &pool->queues[worker];
+            ASSERT(pthread_mutex_lock(&queue->mutex) == 0);
+                queue->first_chunk = end_chunk - (remaining + 1) / 2;
+                queue->end_chunk = end_chunk;
+            ASSERT(pthread_mutex_unlock(&queue->mutex) == 0);
+            return true;
+        }
+    }
+    return false;
+}
 
-    uint bx = gl_WorkGroupID.x;
-    uint by = gl_WorkGroupID.y;
-    uint tx = gl_LocalInvocationID.x;
-    uint ty = gl_LocalInvocationID.y;
+static void my_thread_pool_run(MyThreadPool pool[static 1], const size_t worker) {
+    MyTraceZone zone = my_trace_begin(pool->name);
+    MyPerfSample first_sample;
+    if(my_perf_enabled) {
+        my_perf_sample(&first_sample);
+    }
+    const double start_ms = my_time_ms();
+    size_t steals = 0;
+    for(;;) {
+        size_t chunk;
+        if(my_thread_pool_queue_pop(&pool->queues[worker], &chunk)) {
+            const size_t first = chunk * pool->grain;
+            pool->fn(pool->context, first, first + pool->grain < pool->count ? first + pool->grain : pool->count);
+        } else if(my_thread_pool_steal(pool, worker)) {
+            steals++;
+        } else {
+            break;
+        }
+    }
+    pool->busy_ms[worker] = my_time_ms() - start_ms;
+    pool->steals[worker] = steals;
+    if(my_perf_enabled) {
+        MyPerfSample end_sample;
+        my_perf_sample(&end_sample);
+        my_perf_delta(&first_sample, &end_sample, pool->counters[worker]);
+    }
+    my_trace_end(&zone);
+}
 
-    uint gx = x0 + gl_GlobalInvocationID.x;
-    uint gy = y0 + gl_GlobalInvocationID.y;
+static void* my_thread_pool_worker(void *const arg) {
+    MyThreadPool *const pool = &my_thread_pool;
+    const size_t worker = (size_t)(uintptr_t)arg;
+    my_thread_pool_inside = true;
+    my_trace_thread_name("pool %zu", worker);
+    size_t generation = 0;
+    ASSERT(pthread_mutex_lock(&pool->mutex) == 0);
+    for(;;) {
+        while(!pool->stop && generation == pool->generation) {
+            ASSERT(pthread_cond_wait(&pool->start, &pool->mutex) == 0);
+        }
+        if(pool->stop) {
+            break;
+        }
+        generation = pool->generation;
+        ASSERT(pthread_mutex_unlock(&pool->mutex) == 0);
+            my_thread_pool_run(pool, worker);
+        ASSERT(pthread_mutex_lock(&pool->mutex) == 0);
+        if(--pool->running == 0) {
+            ASSERT(pthread_cond_signal(&pool->done) == 0);
+        }
+    }
+    ASSERT(pthread_mutex_unlock(&pool->mutex) == 0);
+    return NULL;
+}
 
-    uint aBegin = wA * (y0 + BLOCK_SIZE * by);
-    uint aEnd   = aBegin + wA - 1;
-    uint aStep  = BLOCK_SIZE;
+// `threads_count` 0 uses every online core.
+static void my_thread_pool_init(size_t threads_count) {
+    MyThreadPool *const pool = &my_thread_pool;
+    ASSERT(pool->threads_count == 0);
+    if(threads_count == 0) {
+        const long cores = sysconf(_SC_NPROCESSORS_ONLN);
+        threads_count = cores > 0 ? (size_t)cores : 1;
+    }
+    threads_count = threads_count < MY_THREAD_POOL_THREADS_MAX ? threads_count : MY_THREAD_POOL_THREADS_MAX;
+    pool->threads_count = threads_count;
+    ASSERT(pthread_mutex_init(&pool->submit_mutex, NULL) == 0);
+    ASSERT(pthread_mutex_init(&pool->mutex, NULL) == 0);
+    ASSERT(pthread_cond_init(&pool->start, NULL) == 0);
+    ASSERT(pthread_cond_init(&pool->done, NULL) == 0);
+    my_range_for_zero(size_t, i, threads_count) {
+        ASSERT(pthread_mutex_init(&pool->queues[i].mutex, NULL) == 0);
+    }
+    my_range_for(size_t, i, 1, threads_count) {
+        ASSERT(pthread_create(&pool->threads[i], NULL, my_thread_pool_worker, (void*)(uintptr_t)i) == 0);
+    }
+}
 
-    uint bBegin = x0 + BLOCK_SIZE * bx;
-    uint bStep  = BLOCK_SIZE * wB;
+static void my_thread_pool_deinit(void) {
+    MyThreadPool *const pool = &my_thread_pool;
+    ASSERT(pthread_mutex_lock(&pool->mutex) == 0);
+        pool->stop = true;
+        ASSERT(pthread_cond_broadcast(&pool->start) == 0);
+    ASSERT(pthread_mutex_unlock(&pool->mutex) == 0);
+    my_range_for(size_t, i, 1, pool->threads_count) {
+        ASSERT(pthread_join(pool->threads[i], NULL) == 0);
+    }
+    my_range_for_zero(size_t, i, pool->threads_count) {
+        ASSERT(pthread_mutex_destroy(&pool->queues[i].mutex) == 0);
+    }
+    ASSERT(pthread_cond_destroy(&pool->done) == 0);
+    ASSERT(pthread_cond_destroy(&pool->start) == 0);
+    ASSERT(pthread_mutex_destroy(&pool->mutex) == 0);
+    ASSERT(pthread_mutex_destroy(&pool->submit_mutex) == 0);
+    *pool = (MyThreadPool){0};
+}
 
-    float Rsub = 0.0f;
+// Called with submit_mutex held.
+static void my_thread_pool_record(
+    MyThreadPool pool[static 1],
+    const char name[static 1],
+    const size_t chunks,
+    const size_t steals,
+    const size_t workers,
+    const double wall_ms,
+    const double busy_ms,
+    const double max_busy_ms,
+    const double counters[static MY_PERF_EVENT_COUNT]
+) {
+    MyThreadPoolTaskStats *task = NULL;
+    my_range_for_zero(size_t, i, pool->tasks_count) {
+        if(strcmp(pool->tasks[i].name, name) == 0) {
+            task = &pool->tasks[i];
+        }
+    }
+    if(!task) {
+        ASSERT(pool->tasks_count < MY_THREAD_POOL_TASKS_MAX);
+        task = &pool->tasks[pool->tasks_count++];
+        *task = (MyThreadPoolTaskStats){.name = name};
+    }
+    task->calls++;
+    task->chunks += chunks;
+    task->steals += steals;
+    task->wall_ms += wall_ms;
+    task->busy_ms += busy_ms;
+    task->mean_busy_ms += busy_ms / (double)workers;
+    task->max_busy_ms += max_busy_ms;
+    my_perf_accumulate(task->counters, task->counter_samples, counters);
+}
 
-    for(uint a = aBegin, b = bBegin, blkStart = 0;
-        a <= aEnd;
-        a += aStep, b += bStep, blkStart += BLOCK_SIZE) {
-        As[ty][tx] = (gy < hA && blkStart + tx < wA)
-            ? A[a + wA * ty + tx]
-            : 0.0f;
+// Calls `fn` on every chunk of [0, count). Nested calls from inside a task run on the calling thread.
+static void my_parallel_for(const char name[static 1], const size_t count, const size_t grain, const MyParallelForFn fn, void *const context) {
+    ASSERT(grain > 0);
+    MyThreadPool *const pool = &my_thread_pool;
+    const size_t chunks = (count + grain - 1) / grain;
+    if(pool->threads_count <= 1 || chunks <= 1 || my_thread_pool_inside) {
+        const bool record = pool->threads_count > 0 && !my_thread_pool_inside;
+        MyPerfSample first_sample;
+        if(record && my_perf_enabled) {
+            my_perf_sample(&first_sample);
+        }
+        const double start_ms = my_time_ms();
+        my_trace_zone(name) {
+            for(size_t first = 0; first < count; first += grain) {
+                fn(context, first, first + grain < count ? first + grain : count);
+            }
+        }
+        if(record) {
+            const double wall_ms = my_time_ms() - start_ms;
+            double counters[MY_PERF_EVENT_COUNT] = {0};
+            if(my_perf_enabled) {
+                MyPerfSample end_sample;
+                my_perf_sample(&end_sample);
+                my_perf_delta(&first_sample, &end_sample, counters);
+            }
+            ASSERT(pthread_mutex_lock(&pool->submit_mutex) == 0);
+                my_thread_pool_record(pool, name, chunks, 0, 1, wall_ms, wall_ms, wall_ms, counters);
+            ASSERT(pthread_mutex_unlock(&pool->submit_mutex) == 0);
+        }
+        return;
+    }
 
-        Bs[ty][tx] = (gx < wB && blkStart + ty < wA)
-            ? B[b + wB * ty + tx]
-            : 0.0f;
+    ASSERT(pthread_mutex_lock(&pool->submit_mutex) == 0);
+    my_thread_pool_inside = true;
+    const double start_ms = my_time_ms();
+    pool->name = name;
+    pool->fn = fn;
+    pool->context = context;
+    pool->count = count;
+    pool->grain = grain;
+    my_range_for_zero(size_t, i, pool->threads_count) {
+        pool->queues[i].first_chunk = chunks * i / pool->threads_count;
+        pool->queues[i].end_chunk = chunks * (i + 1) / pool->threads_count;
+    }
+    ASSERT(pthread_mutex_lock(&pool->mutex) == 0);
+        pool->generation++;
+        pool->running = pool->threads_count - 1;
+        ASSERT(pthread_cond_broadcast(&pool->start) == 0);
+    ASSERT(pthread_mutex_unlock(&pool->mutex) == 0);
 
-        __memoryBarrierShared();
+    my_thread_pool_run(pool, 0);
 
-        // #pragma unroll
-        for(uint k = 0; k < BLOCK_SIZE; k++) {
-            Rsub += As[ty][k] * Bs[k][tx];
+    ASSERT(pthread_mutex_lock(&pool->mutex) == 0);
+        while(pool->running > 0) {
+            ASSERT(pthread_cond_wait(&pool->done, &pool->mutex) == 0);
         }
+    ASSERT(pthread_mutex_unlock(&pool->mutex) == 0);
+    const double wall_ms = my_time_ms() - start_ms;
+    my_thread_pool_inside = false;
+
+    size_t steals = 0;
+    double busy_ms = 0.0, max_busy_ms = 0.0;
+    double counters[MY_PERF_EVENT_COUNT] = {0};
+    size_t counter_samples[MY_PERF_EVENT_COUNT] = {0};
+    my_range_for_zero(size_t, i, pool->threads_count) {
+        steals += pool->steals[i];
+        busy_ms += pool->busy_ms[i];
+        max_busy_ms = fmax(max_busy_ms, pool->busy_ms[i]);
+        if(my_perf_enabled) {
+            my_perf_accumulate(counters, counter_samples, pool->counters[i]);
+        }
+    }
+    my_range_for_zero(size_t, event, MY_PERF_EVENT_COUNT) {
+        counters[event] = my_perf_enabled && counter_samples[event] == 0 ? (double)NAN : counters[event];
+    }
+    my_thread_pool_record(pool, name, chunks, steals, pool->threads_count, wall_ms, busy_ms, max_busy_ms, counters);
+    ASSERT(pthread_mutex_unlock(&pool->submit_mutex) == 0);
+}
 
-        __memoryBarrierShared();
+typedef struct {
+    MyParallelReduceFn fn;
+    void *context;
+    size_t grain;
+    double *partials;
+} MyParallelReduce;
+
+static void my_parallel_reduce_chunk(void *const context, const size_t first, const size_t end) {
+    MyParallelReduce *const reduce = (MyParallelReduce*)context;
+    reduce->partials[first / reduce->grain] = reduce->fn(reduce->context, first, end);
+}
+
+// Chunk results are combined in chunk order, so the result does not depend on which worker ran which chunk.
+static double my_parallel_reduce(
+    const char name[static 1],
+    const size_t count,
+    const size_t grain,
+    const MyParallelReduceFn fn,
+    void *const context,
+    double (*const combine)(double, double),
+    const double initial
+) {
+    const size_t chunks = (count + grain - 1) / grain;
+    MyParallelReduce reduce = {.fn = fn, .context = context, .grain = grain, .partials = (double*)malloc(chunks * sizeof(double))};
+    ASSERT(chunks == 0 || reduce.partials);
+    my_parallel_for(name, count, grain, my_parallel_reduce_chunk, &reduce);
+    double result = initial;
+    my_range_for_zero(size_t, i, chunks) {
+        result = combine(result, reduce.partials[i]);
     }
+    free(reduce.partials);
+    return result;
+}
 
-    if(gy < hA && gx < wB) {
-        uint c = wB * (y0 + BLOCK_SIZE * by) + (x0 + BLOCK_SIZE * bx);
-        R[c + wB * ty + tx] = Rsub;
+static double my_add(const double first, const double second) {
+    return first + second;
+}
+
+// busy is the time summed over the workers, imbalance is the slowest worker against the mean worker.
+// With --perf-counters mpki is LLC misses per thousand instructions and the bandwidth is the LLC miss traffic over wall time.
+static void my_thread_pool_report(void) {
+    MyThreadPool *const pool = &my_thread_pool;
+    LOG("thread pool threads: %zu", pool->threads_count);
+    my_range_for_zero(size_t, i, pool->tasks_count) {
+        const MyThreadPoolTaskStats *const task = &pool->tasks[i];
+        LOG(
+            "task: %s, calls: %zu, chunks: %zu, steals: %zu, wall ms: %lf, busy ms: %lf, imbalance: %lf",
+            task->name, task->calls, task->chunks, task->steals, task->wall_ms, task->busy_ms,
+            task->mean_busy_ms > 0.0 ? task->max_busy_ms / task->mean_busy_ms : 1.0
+        );
+        if(my_perf_enabled) {
+            // NAN for an event no call could count
+            double counters[MY_PERF_EVENT_COUNT];
+            my_range_for_zero(size_t, event, MY_PERF_EVENT_COUNT) {
+                counters[event] = task->counter_samples[event] > 0 ? task->counters[event] : (double)NAN;
+            }
+            LOG(
+                "task: %s, cycles: %.0lf, instructions: %.0lf, ipc: %lf, llc misses: %.0lf, llc mpki: %lf, dtlb misses: %.0lf, llc miss GB/s: %lf",
+                task->name, counters[MY_PERF_EVENT_CYCLES], counters[MY_PERF_EVENT_INSTRUCTIONS],
+                counters[MY_PERF_EVENT_INSTRUCTIONS] / counters[MY_PERF_EVENT_CYCLES],
+                counters[MY_PERF_EVENT_LLC_MISSES], 1000.0 * counters[MY_PERF_EVENT_LLC_MISSES] / counters[MY_PERF_EVENT_INSTRUCTIONS],
+                counters[MY_PERF_EVENT_DTLB_MISSES], counters[MY_PERF_EVENT_LLC_MISSES] * MY_PERF_CACHE_LINE_BYTES / task->wall_ms / 1e6
+            );
+        }
     }
 }
-);
 
 typedef struct {
-    GLuint rows;
-    GLuint cols;
-    GLuint ssb;
-} MyGLMat;
+    MyMat *result;
+    const MyMat *first;
+    const MyMat *second;
+} MyMatBinaryTask;
+
+static void my_mat_hstack_rows(void *const context, const size_t row_first, const size_t row_end) {
+    const MyMatBinaryTask *const task = (const MyMatBinaryTask*)context;
+    MyMat *const result = task->result;
+    const MyMat *const first = task->first;
+    const MyMat *const second = task->second;
+    my_range_for(size_t, row, row_first, row_end) {
+        memcpy(&my_mat_row(result, row), &my_mat_row(first, row), my_mat_row_bytes_count(first));
+        memcpy(&my_mat_item(result, row, first->cols), &my_mat_row(second, row), my_mat_row_bytes_count(second));
+    }
+}
 
-static inline GLint my_gl_get_uniform_location(const GLuint shader_program, const char uniform_location_name[]) {
-    GLint value;
-    ASSERT_GL(value = glGetUniformLocation(shader_program, uniform_location_name));
-    ASSERT(value != -1);
-    return value;
+static MyMat my_mat_hstack(MyArena arena[static 1], const MyMat first[static 1], const MyMat second[static 1]) {
+    ASSERT(first->rows == second->rows);
+    MyMat result = my_mat_alloc(arena, first->rows, first->cols + second->cols);
+    my_trace_zone("hstack") {
+        my_parallel_for("my_mat_hstack", result.rows, 256, my_mat_hstack_rows, &(MyMatBinaryTask){.result = &result, .first = first, .second = second});
+    }
+    return result;
 }
 
-static MyGLMat mygl_mat_buffer_data(const MyMat mat[static 1], const GLenum usage) {
-    MyGLMat gl_mat = {.rows = (GLuint)mat->rows, .cols = (GLuint)mat->cols};
-    ASSERT_GL(glGenBuffers(1, &gl_mat.ssb));
-    ASSERT_GL(glBindBuffer(GL_SHADER_STORAGE_BUFFER, gl_mat.ssb));
-        ASSERT_GL(glBufferData(GL_SHADER_STORAGE_BUFFER, (GLsizeiptr)my_mat_bytes_count(mat), mat->items, usage));
-    ASSERT_GL(glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0));
-    return gl_mat;
+static double my_mat_max_abs_diff_items(void *const context, const size_t first, const size_t end) {
+    const MyMatBinaryTask *const task = (const MyMatBinaryTask*)context;
+    double max_diff = 0.0;
+    my_range_for(size_t, i, first, end) {
+        max_diff = fmax(max_diff, fabs((double)task->first->items[i] - (double)task->second->items[i]));
+    }
+    return max_diff;
 }
 
-// static MyGLMat my_gl_mat_mul_result_alloc(const MyGLMat first[static 1], const MyGLMat second[static 1]) {
-//     ASSERT(first->cols == second->rows);
-// }
+static double my_mat_max_abs_diff(const MyMat first[static 1], const MyMat second[static 1]) {
+    ASSERT(first->rows == second->rows && first->cols == second->cols);
+    return my_parallel_reduce(
+        "my_mat_max_abs_diff", my_mat_items_count(first), 4096, my_mat_max_abs_diff_items,
+        &(MyMatBinaryTask){.first = first, .second = second}, fmax, 0.0
+    );
+}
 
-static void my_gl_dispatch_compute_mat_mul(const GLuint shader_program, const MyGLMat first[static 1], const MyGLMat second[static 1], const MyGLMat result[static 1]) {
-    ASSERT(first->cols == second->rows);
-    ASSERT(first->rows == result->rows);
-    ASSERT(second->cols == result->cols);
-
-    ASSERT_GL(glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, first->ssb));
-    ASSERT_GL(glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, second->ssb));
-    ASSERT_GL(glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, result->ssb));
-    ASSERT_GL(glUseProgram(shader_program));
+static MyMat my_mat_copy(MyArena arena[static 1], const MyMat src[static 1]) {
+    MyMat m = my_mat_alloc(arena, src->rows, src->cols);
+    memcpy(m.items, src->items, my_mat_bytes_count(src));
+    return m; 
+}
 
-        const GLuint BLOCK_SIZE = 32;
-        const GLuint wsize[3] = {BLOCK_SIZE, BLOCK_SIZE, 1};
-        const GLuint gsize[3] = {64, 64, 1};
-        
-        const GLuint wcnt_x = (second->cols + wsize[0] - 1) / wsize[0];
-        const GLuint wcnt_y = (first->rows + wsize[1] - 1) / wsize[1];
-        
-        const GLuint gcnt_x = (wcnt_x + gsize[0] - 1) / gsize[0];
-        const GLuint gcnt_y = (wcnt_y + gsize[1] - 1) / gsize[1];
-        
-        const GLuint nelem_x = wsize[0] * gsize[0];
-        const GLuint nelem_y = wsize[1] * gsize[1];
+// Accumulation policy of the matrix products on both the CPU and the GPU. f64 needs GL_ARB_gpu_shader_fp64
+// in the shaders, kahan is the compensated fp32 fallback.
+typedef enum {
+    MY_PRECISION_F32,
+    MY_PRECISION_F64,
+    MY_PRECISION_KAHAN,
+    MY_PRECISION_COUNT,
+} MyPrecision;
+
+static const char *const my_precision_names[MY_PRECISION_COUNT] = {
+    [MY_PRECISION_F32] = "f32",
+    [MY_PRECISION_F64] = "f64",
+    [MY_PRECISION_KAHAN] = "kahan",
+};
+
+static void my_mat_mul_rows(void *const context, const size_t row_first, const size_t row_end) {
+    const MyMatBinaryTask *const task = (const MyMatBinaryTask*)context;
+    MyMat *const result = task->result;
+    const MyMat *const first = task->first;
+    const MyMat *const second = task->second;
+    my_range_for(size_t, first_row_index, row_first, row_end) {
+        my_range_for_zero(size_t, second_col_index, second->cols) {
+            GLfloat sum = 0.f;
+            my_range_for_zero(size_t, first_col_index, first->cols) {
+                sum += my_mat_item(first, first_row_index, first_col_index) * my_mat_item(second, first_col_index, second_col_index);
+            }
+            my_mat_item(result, first_row_index, second_col_index) = sum;
+        }
+    }
+}
 
-        ASSERT_GL(glUniform1ui(my_gl_get_uniform_location(shader_program, "m"), first->rows));
-        ASSERT_GL(glUniform1ui(my_gl_get_uniform_location(shader_program, "n"), first->cols));
-        ASSERT_GL(glUniform1ui(my_gl_get_uniform_location(shader_program, "l"), second->cols));
+static void my_mat_mul(MyMat *const result, const MyMat *const first, const MyMat *const second) { ASSERT(first->cols == second->rows); ASSERT(first->rows == result->rows);
+    ASSERT(first->cols == second->rows);
+    ASSERT(first->rows == result->rows);
+    ASSERT(second->cols == result->cols);
+    my_parallel_for("my_mat_mul", first->rows, 8, my_mat_mul_rows, &(MyMatBinaryTask){.result = result, .first = first, .second = second});
+}
 
-        for(GLuint yi = 0; yi < gcnt_y; yi++) {
-            GLuint y0 = nelem_y * yi;
-            for(GLuint xi = 0; xi < gcnt_x; xi++) {
-                GLuint x0 = nelem_x * xi;
-                ASSERT_GL(glUniform1ui(my_gl_get_uniform_location(shader_program, "x0"), x0));
-                ASSERT_GL(glUniform1ui(my_gl_get_uniform_location(shader_program, "y0"), y0));
-                ASSERT_GL(glDispatchCompute(gsize[0], gsize[1], 1));
+static void my_mat_mul_f64_rows(void *const context, const size_t row_first, const size_t row_end) {
+    const MyMatBinaryTask *const task = (const MyMatBinaryTask*)context;
+    MyMat *const result = task->result;
+    const MyMat *const first = task->first;
+    const MyMat *const second = task->second;
+    my_range_for(size_t, first_row_index, row_first, row_end) {
+        my_range_for_zero(size_t, second_col_index, second->cols) {
+            double sum = 0.0;
+            my_range_for_zero(size_t, first_col_index, first->cols) {
+                sum += (double)my_mat_item(first, first_row_index, first_col_index) * (double)my_mat_item(second, first_col_index, second_col_index);
             }
+            my_mat_item(result, first_row_index, second_col_index) = (GLfloat)sum;
         }
-
-    ASSERT_GL(glUseProgram(0));
-    ASSERT_GL(glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, 0));
-    ASSERT_GL(glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, 0));
-    ASSERT_GL(glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, 0));
+    }
 }
 
-static void my_read_bin_data_to_mat(MyMat *const mat, MyArena *const arena, const char *const path) {
-    mat->items = (GLfloat*)my_arena_alloc(arena, my_mat_bytes_count(mat));
-    const int fd = open(path, O_RDONLY);
-    ASSERT_NOT_MINUS_ONE(fd);
-    struct stat stat;
-    ASSERT_NOT_MINUS_ONE(fstat(fd, &stat));
-    ASSERT((size_t)stat.st_size == my_mat_bytes_count(mat));
-    GLfloat *const data = (GLfloat*)mmap(NULL, my_mat_bytes_count(mat), PROT_READ, MAP_SHARED, fd, 0);
-    ASSERT(data != MAP_FAILED);
-    memcpy(mat->items, data, my_mat_bytes_count(mat));
-    ASSERT_NOT_MINUS_ONE(munmap(data, my_mat_bytes_count(mat)));
-    ASSERT_NOT_MINUS_ONE(close(fd));
+static void my_mat_mul_f64(MyMat *const result, const MyMat *const first, const MyMat *const second) {
+    ASSERT(first->cols == second->rows);
+    ASSERT(first->rows == result->rows);
+    ASSERT(second->cols == result->cols);
+    my_parallel_for("my_mat_mul_f64", first->rows, 8, my_mat_mul_f64_rows, &(MyMatBinaryTask){.result = result, .first = first, .second = second});
 }
 
-static inline float my_powf(const float value, const size_t degree) {
-    double res = (double)value;
-    for(size_t i = 1; i < degree; ++i) {
-        res *= (double)value;
+static void my_mat_mul_kahan_rows(void *const context, const size_t row_first, const size_t row_end) {
+    const MyMatBinaryTask *const task = (const MyMatBinaryTask*)context;
+    MyMat *const result = task->result;
+    const MyMat *const first = task->first;
+    const MyMat *const second = task->second;
+    my_range_for(size_t, first_row_index, row_first, row_end) {
+        my_range_for_zero(size_t, second_col_index, second->cols) {
+            GLfloat sum = 0.f;
+            GLfloat compensation = 0.f;
+            my_range_for_zero(size_t, first_col_index, first->cols) {
+                const GLfloat y = my_mat_item(first, first_row_index, first_col_index) * my_mat_item(second, first_col_index, second_col_index) - compensation;
+                const GLfloat t = sum + y;
+                compensation = (t - sum) - y;
+                sum = t;
+            }
+            my_mat_item(result, first_row_index, second_col_index) = sum;
+        }
     }
-    return (float)res;
 }
-static inline double my_pow(const double value, const size_t degree) {
-    double res = value;
-    for(size_t i = 1; i < degree; ++i) {
-        res *= value;
+
+static void my_mat_mul_kahan(MyMat *const result, const MyMat *const first, const MyMat *const second) {
+    ASSERT(first->cols == second->rows);
+    ASSERT(first->rows == result->rows);
+    ASSERT(second->cols == result->cols);
+    my_parallel_for("my_mat_mul_kahan", first->rows, 8, my_mat_mul_kahan_rows, &(MyMatBinaryTask){.result = result, .first = first, .second = second});
+}
+
+static void my_mat_mul_precision(const MyPrecision precision, MyMat *const result, const MyMat *const first, const MyMat *const second) {
+    switch(precision) {
+        case MY_PRECISION_F32: my_mat_mul(result, first, second); break;
+        case MY_PRECISION_F64: my_mat_mul_f64(result, first, second); break;
+        case MY_PRECISION_KAHAN: my_mat_mul_kahan(result, first, second); break;
+        case MY_PRECISION_COUNT:
+        default: ASSERT(false, "invalid precision: %d", precision);
     }
-    return res;
 }
 
-static MyMat my_polynomial_features_create(MyArena arena[static 1], const MyMat features[static 1], const size_t degree) {
-    ASSERT(degree > 0);
-    MyMat polynomial_features = my_mat_alloc(arena, features->rows, features->cols * degree);
-    my_range_for_zero(size_t, row, features->rows) {
-        for(size_t deg = 1, base_col = 0; deg < degree; deg++, base_col += features->cols) {
-            my_range_for_zero(size_t, col, features->cols) {
-                my_mat_item(&polynomial_features, row, base_col + col) = my_powf(my_mat_item(features, row, col), deg);
+#define MY_MAT_TRANSPOSE_TILE 32
+
+static void my_mat_transpose_tiles(void *const context, const size_t tile_row_first, const size_t tile_row_end) {
+    const MyMatBinaryTask *const task = (const MyMatBinaryTask*)context;
+    MyMat *const result = task->result;
+    const MyMat *const mat = task->first;
+    my_range_for(size_t, tile_row, tile_row_first, tile_row_end) {
+        const size_t row_first = tile_row * MY_MAT_TRANSPOSE_TILE;
+        const size_t row_end = row_first + MY_MAT_TRANSPOSE_TILE < mat->rows ? row_first + MY_MAT_TRANSPOSE_TILE : mat->rows;
+        for(size_t col_first = 0; col_first < mat->cols; col_first += MY_MAT_TRANSPOSE_TILE) {
+            const size_t col_end = col_first + MY_MAT_TRANSPOSE_TILE < mat->cols ? col_first + MY_MAT_TRANSPOSE_TILE : mat->cols;
+            my_range_for(size_t, row, row_first, row_end) {
+                my_range_for(size_t, col, col_first, col_end) {
+                    my_mat_item(result, col, row) = my_mat_item(mat, row, col);
+                }
             }
         }
     }
-    return polynomial_features; 
 }
 
-static void my_mat_polynomial_features_standard_scale(MyMat mat[static 1]) {
-    my_range_for_zero(size_t, col, mat->cols) {
-        double mean = 0.0;
-        my_range_for_zero(size_t, row, mat->rows) {
-            mean += (double)my_mat_item(mat, row, col);
+// Square tiles keep both the rows read and the rows written in cache.
+static void my_mat_transpose(MyMat result[static 1], const MyMat mat[static 1]) {
+    ASSERT(result->rows == mat->cols && result->cols == mat->rows);
+    const size_t tile_rows = (mat->rows + MY_MAT_TRANSPOSE_TILE - 1) / MY_MAT_TRANSPOSE_TILE;
+    my_parallel_for("my_mat_transpose", tile_rows, 1, my_mat_transpose_tiles, &(MyMatBinaryTask){.result = result, .first = mat});
+}
+
+#define MY_GL_CONTEXT_DISPLAYS_MAX 16
+
+// Headless compute context: a display per device from EGL_EXT_device_enumeration, or the Mesa surfaceless
+// platform when enumeration is unavailable, and a configless core context current without any surface.
+typedef struct {
+    EGLDisplay display;
+    EGLConfig config;
+    EGLContext context;
+    GLint major;
+    GLint minor;
+    bool shared;
+} MyGLContext;
+
+// Displays owned by live contexts, probing one of them for another device would terminate it under its worker.
+static struct {
+    pthread_mutex_t mutex;
+    EGLDisplay displays[MY_GL_CONTEXT_DISPLAYS_MAX];
+    size_t count;
+} my_gl_held_displays = {.mutex = PTHREAD_MUTEX_INITIALIZER};
+
+static bool my_gl_display_held(const EGLDisplay display) {
+    bool held = false;
+    ASSERT(pthread_mutex_lock(&my_gl_held_displays.mutex) == 0);
+        my_range_for_zero(size_t, i, my_gl_held_displays.count) {
+            held = held || my_gl_held_displays.displays[i] == display;
         }
-        mean /= (double)mat->rows;
+    ASSERT(pthread_mutex_unlock(&my_gl_held_displays.mutex) == 0);
+    return held;
+}
 
-        double std = 0.0;
-        my_range_for_zero(size_t, row, mat->rows) {
-            std += my_pow((double)my_mat_item(mat, row, col) - mean, 2);
+static EGLint my_egl_displays(EGLDisplay displays[static MY_GL_CONTEXT_DISPLAYS_MAX]) {
+    ASSERT(gladLoadEGLLoader((GLADloadproc)eglGetProcAddress));
+    const char *client_extensions;
+    ASSERT_EGL(client_extensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS));
+    EGLint count = 0;
+    if(strstr(client_extensions, "EGL_EXT_device_enumeration") && strstr(client_extensions, "EGL_EXT_platform_device")) {
+        EGLDeviceEXT devices[MY_GL_CONTEXT_DISPLAYS_MAX];
+        ASSERT(eglQueryDevicesEXT(MY_GL_CONTEXT_DISPLAYS_MAX, devices, &count) == EGL_TRUE);
+        my_range_for_zero(EGLint, i, count) {
+            ASSERT_EGL(displays[i] = eglGetPlatformDisplayEXT(EGL_PLATFORM_DEVICE_EXT, devices[i], NULL));
         }
-        std /= (double)mat->rows;
-        std = sqrt(std);
+    }
+    if(count == 0) {
+        ASSERT(strstr(client_extensions, "EGL_MESA_platform_surfaceless"), "no EGL devices and no surfaceless platform");
+        ASSERT_EGL(displays[0] = eglGetPlatformDisplayEXT(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL));
+        count = 1;
+    }
+    return count;
+}
 
-        my_range_for_zero(size_t, row, mat->rows) {
-            my_mat_item(mat, row, col) = (GLfloat)(((double)my_mat_item(mat, row, col) - mean) / std);
+// Tries the newest core profile first, false when the display cannot host a surfaceless 4.3+ context.
+static bool my_gl_context_init(MyGLContext context[static 1], const EGLDisplay display) {
+    *context = (MyGLContext){.display = display, .config = EGL_NO_CONFIG_KHR, .context = EGL_NO_CONTEXT};
+    EGLint major, minor;
+    if(eglInitialize(display, &major, &minor) != EGL_TRUE) {
+        my_egl_clear_errors();
+        return false;
+    }
+    const char *extensions;
+    ASSERT_EGL(extensions = eglQueryString(display, EGL_EXTENSIONS));
+    if(!strstr(extensions, "EGL_KHR_no_config_context")) {
+        const EGLint config_attribs[] = {EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE};
+        EGLint configs_count = 0;
+        ASSERT(eglChooseConfig(display, config_attribs, &context->config, 1, &configs_count) == EGL_TRUE);
+        if(configs_count == 0) {
+            ASSERT(eglTerminate(display) == EGL_TRUE);
+            return false;
         }
     }
+    if(strstr(extensions, "EGL_KHR_surfaceless_context")) {
+        ASSERT(eglBindAPI(EGL_OPENGL_API) == EGL_TRUE);
+        const EGLint versions[][2] = {{4, 6}, {4, 5}, {4, 4}, {4, 3}};
+        my_range_for_zero(size_t, i, my_array_count(versions)) {
+            const EGLint context_attribs[] = {
+                EGL_CONTEXT_MAJOR_VERSION, versions[i][0],
+                EGL_CONTEXT_MINOR_VERSION, versions[i][1],
+                EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+                EGL_NONE
+            };
+            context->context = eglCreateContext(display, context->config, EGL_NO_CONTEXT, context_attribs);
+            if(context->context != EGL_NO_CONTEXT) {
+                break;
+            }
+        }
+        my_egl_clear_errors();
+    }
+    if(context->context == EGL_NO_CONTEXT) {
+        ASSERT(eglTerminate(display) == EGL_TRUE);
+        return false;
+    }
+    my_trace_gpu_flush();
+    ASSERT(eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context->context) == EGL_TRUE);
+    ASSERT(gladLoadGLLoader((GLADloadproc)eglGetProcAddress));
+    ASSERT_GL(glGetIntegerv(GL_MAJOR_VERSION, &context->major));
+    ASSERT_GL(glGetIntegerv(GL_MINOR_VERSION, &context->minor));
+    return true;
 }
 
-typedef struct {
-    EGLDisplay eglDisplay;
-    EGLContext eglContext;
-    EGLSurface eglSurface;
-} MyEGLData;
+static void my_gl_context_make_current(const MyGLContext context[static 1]) {
+    my_trace_gpu_flush();
+    ASSERT(eglMakeCurrent(context->display, EGL_NO_SURFACE, EGL_NO_SURFACE, context->context) == EGL_TRUE);
+}
 
-static void my_egl_deinit(MyEGLData data[static 1]) {
-    ASSERT(eglMakeCurrent(data->eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT));
-    ASSERT(eglDestroyContext(data->eglDisplay, data->eglContext));
-    ASSERT(eglDestroySurface(data->eglDisplay, data->eglSurface));
-    ASSERT(eglTerminate(data->eglDisplay));
+static void my_gl_context_release(const MyGLContext context[static 1]) {
+    my_trace_gpu_flush();
+    ASSERT(eglMakeCurrent(context->display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT) == EGL_TRUE);
 }
 
-static MyEGLData my_egl_init(void) {
-    EGLDisplay egl_display;
-    EGLConfig egl_config;
-    EGLContext egl_context;
-    EGLSurface egl_surface;
+// A shared context must not be current on any other thread, the display is terminated with its parent.
+static void my_gl_context_destroy(MyGLContext context[static 1]) {
+    if(eglGetCurrentContext() == context->context) {
+        my_gl_context_release(context);
+    }
+    ASSERT(eglDestroyContext(context->display, context->context) == EGL_TRUE);
+    if(!context->shared) {
+        ASSERT(pthread_mutex_lock(&my_gl_held_displays.mutex) == 0);
+            my_range_for_zero(size_t, i, my_gl_held_displays.count) {
+                if(my_gl_held_displays.displays[i] == context->display) {
+                    my_gl_held_displays.displays[i] = my_gl_held_displays.displays[--my_gl_held_displays.count];
+                    break;
+                }
+            }
+        ASSERT(pthread_mutex_unlock(&my_gl_held_displays.mutex) == 0);
+        ASSERT(eglTerminate(context->display) == EGL_TRUE);
+    }
+}
 
-    egl_display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
-    ASSERT(egl_display != EGL_NO_DISPLAY);
-    EGLint major, minor;
-    ASSERT(eglInitialize(egl_display, &major, &minor) == EGL_TRUE);
-    
-    const EGLint configAttribs[] = {
-        EGL_SURFACE_TYPE,    EGL_PBUFFER_BIT,
-        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
-        EGL_NONE
-    };
-    EGLint numConfigs;
-    ASSERT(eglChooseConfig(egl_display, configAttribs, &egl_config, 1, &numConfigs) == EGL_TRUE);
-    ASSERT(numConfigs > 0);
-    const EGLint pbufferAttribs[] = {
-        EGL_WIDTH, 1920,
-        EGL_HEIGHT, 1080,
-        EGL_NONE
-    };
-    egl_surface = eglCreatePbufferSurface(egl_display, egl_config, pbufferAttribs);
-    ASSERT(egl_surface != EGL_NO_SURFACE);
-    const EGLint contextAttribs[] = {
-        EGL_CONTEXT_MAJOR_VERSION, 4,
-        EGL_CONTEXT_MINOR_VERSION, 3,
+// Buffers and programs of `parent` are visible in the new context, it is made current by the thread that uses it.
+static MyGLContext my_gl_context_create_shared(const MyGLContext parent[static 1]) {
+    MyGLContext context = *parent;
+    context.shared = true;
+    const EGLint context_attribs[] = {
+        EGL_CONTEXT_MAJOR_VERSION, parent->major,
+        EGL_CONTEXT_MINOR_VERSION, parent->minor,
         EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
         EGL_NONE
     };
     ASSERT(eglBindAPI(EGL_OPENGL_API) == EGL_TRUE);
-    egl_context = eglCreateContext(egl_display, egl_config, EGL_NO_CONTEXT, contextAttribs);
-    ASSERT(egl_context != EGL_NO_CONTEXT);
-    ASSERT(eglMakeCurrent(egl_display, egl_surface, egl_surface, egl_context) == EGL_TRUE);
-
-    ASSERT(gladLoadGLLoader((GLADloadproc)eglGetProcAddress));
-    ASSERT(gladLoadEGLLoader((GLADloadproc)eglGetProcAddress));
-
-    my_gl_egl_print_stats(egl_display);
-
-    return (MyEGLData){.eglDisplay = egl_display, .eglContext = egl_context, .eglSurface = egl_surface};
+    ASSERT_EGL(context.context = eglCreateContext(parent->display, parent->config, parent->context, context_attribs));
+    ASSERT(context.context != EGL_NO_CONTEXT);
+    return context;
 }
 
-static void my_polynomial_train(void) {
-    MyEGLData egl_data = my_egl_init();
-    // GLFWwindow* const glfw_window = my_glfw_init(false);
-    
-    MyMat x_train = {.rows = 20210, .cols = 167};
-    MyMat y_train = {.rows = 20210, .cols = 1};
-    MyMat x_test = {.rows = 1053, .cols = 167};
-    MyMat y_test = {.rows = 1053, .cols = 1};
-
-    MyArena arena = my_arena_init(
-        my_mat_bytes_count(&x_train)
-        + my_mat_bytes_count(&y_train)
-        + my_mat_bytes_count(&x_test)
-        + my_mat_bytes_count(&y_test)
-    );
-    #define LOCAL_MACRO(mat) my_read_bin_data_to_mat(&mat, &arena, "data/" #mat ".bin")
-        LOCAL_MACRO(x_train);
-        LOCAL_MACRO(y_train);
-        LOCAL_MACRO(x_test);
-        LOCAL_MACRO(y_test);
-    #undef LOCAL_MACRO
-
-    MyArena fit_arena = my_arena_init(1024 * 1024 * 300);
-    MyMat polynomial_features = my_polynomial_features_create(&fit_arena, &x_train, 4);
-    LOG("size: %lu", my_mat_bytes_count(&polynomial_features));
-    my_mat_polynomial_features_standard_scale(&polynomial_features);
-    MyMat ones = my_mat_alloc(&fit_arena, polynomial_features.rows, 1); 
-    my_mat_foreach(el, &ones) {
-        *el = 1.f;
-    }
-    MyMat xb = my_mat_hstack(&fit_arena, &ones, &polynomial_features);
-
-    const MyGLMat gl_xb = mygl_mat_buffer_data(&xb, GL_DYNAMIC_DRAW);
-    const MyGLMat gl_weights = mygl_mat_buffer_data(&(MyMat){.rows = xb.cols, .cols = 1}, GL_DYNAMIC_COPY);
-    {
-        ASSERT_GL(glBindBuffer(GL_SHADER_STORAGE_BUFFER, gl_weights.ssb));
-            const GLfloat value = 0.f;
-            ASSERT_GL(glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32F, GL_RED, GL_FLOAT, &value));
-        ASSERT_GL(glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0));
+// Takes the first free device whose GL_RENDERER contains `device`, or the first usable free device when it is NULL.
+// Devices already held by another context are skipped.
+static MyGLContext my_gl_context_create(const char *const device) {
+    EGLDisplay displays[MY_GL_CONTEXT_DISPLAYS_MAX];
+    const EGLint displays_count = my_egl_displays(displays);
+    my_range_for_zero(EGLint, i, displays_count) {
+        MyGLContext context;
+        if(my_gl_display_held(displays[i]) || !my_gl_context_init(&context, displays[i])) {
+            continue;
+        }
+        const GLubyte *renderer;
+        ASSERT_GL(renderer = glGetString(GL_RENDERER));
+        if(!device || strstr((const char*)renderer, device)) {
+            ASSERT(pthread_mutex_lock(&my_gl_held_displays.mutex) == 0);
+                my_gl_held_displays.displays[my_gl_held_displays.count++] = context.display;
+            ASSERT(pthread_mutex_unlock(&my_gl_held_displays.mutex) == 0);
+            my_gl_egl_print_stats(context.display);
+            return context;
+        }
+        my_gl_context_destroy(&context);
     }
-    GLuint shader_program_mul_mat, compute_shader_mul_mat;
-    mygl_create_compute_shader_program(&shader_program_mul_mat, &compute_shader_mul_mat, mygl_matrix_mul_compute_shader);
-
-    MyGLMat predictions = mygl_mat_buffer_data(&(MyMat){.rows = gl_xb.rows, .cols = gl_weights.cols}, GL_DYNAMIC_COPY);
+    ASSERT(false, "no free usable device matches: %s", device ? device : "any");
+    return (MyGLContext){0};
+}
 
-    my_range_for_zero(size_t, i, 100) {
-        my_gl_dispatch_compute_mat_mul(shader_program_mul_mat, &gl_xb, &gl_weights, &predictions);
-        ASSERT_GL(glFinish());
+static void my_gl_context_list_devices(void) {
+    EGLDisplay displays[MY_GL_CONTEXT_DISPLAYS_MAX];
+    const EGLint displays_count = my_egl_displays(displays);
+    my_range_for_zero(EGLint, i, displays_count) {
+        MyGLContext context;
+        if(!my_gl_context_init(&context, displays[i])) {
+            LOG("device %d: no surfaceless OpenGL 4.3+ context", i);
+            continue;
+        }
+        const GLubyte *renderer;
+        ASSERT_GL(renderer = glGetString(GL_RENDERER));
+        LOG("device %d: %s, OpenGL %d.%d", i, renderer, context.major, context.minor);
+        my_gl_context_destroy(&context);
     }
+}
 
-    free(fit_arena.items);
-    free(arena.items);
-    // glfwTerminate();
-    my_egl_deinit(&egl_data);
+// The shaders are written against 460 but only need compute shaders, so the newest version of the current context is used.
+static void mygl_shader_version_string(char version[static 16]) {
+    GLint major, minor;
+    ASSERT_GL(glGetIntegerv(GL_MAJOR_VERSION, &major));
+    ASSERT_GL(glGetIntegerv(GL_MINOR_VERSION, &minor));
+    const GLint glsl_version = major * 100 + minor * 10;
+    ASSERT(glsl_version >= 430, "compute shaders need OpenGL 4.3, got %d.%d", major, minor);
+    snprintf(version, 16, "#version %d\n", glsl_version < 460 ? glsl_version : 460);
 }
 
-static void window_demo(void) {
-    GLFWwindow* const glfw_window = my_glfw_init(true);
-    ImGuiContext *const ig_context = igCreateContext(NULL);
-    ImPlotContext *const implot_context = ImPlot_CreateContext();
-    ImGuiIO *const ig_io = igGetIO_Nil();
-    ig_io->IniFilename = NULL;
-    ig_io->ConfigFlags |= ImGuiConfigFlags_NavEnableKeyboard;
-    ig_io->ConfigFlags |= ImGuiConfigFlags_NavEnableGamepad;
+static void mygl_create_compute_shader_program_with_header(
+    GLuint *const shader_program,
+    GLuint *const shader_compute,
+    const char *const shader_header,
+    const char *const shader_code
+) {
+    char version[16];
+    mygl_shader_version_string(version);
+    const size_t bytes_count = strlen(version) + strlen(shader_header) + strlen(shader_code) + 1;
+    char *const source = (char*)malloc(bytes_count);
+    ASSERT(source);
+    snprintf(source, bytes_count, "%s%s%s", version, shader_header, shader_code);
+    mygl_create_compute_shader_program(shader_program, shader_compute, source);
+    free(source);
+}
 
-    ig_io->ConfigFlags |= ImGuiConfigFlags_DockingEnable;
-    ImGuiStyle *const ig_style = igGetStyle();
-    igStyleColorsDark(ig_style);
-    ImGui_ImplGlfw_InitForOpenGL(glfw_window, true);
-    ImGui_ImplOpenGL3_Init("#version 460");
+static bool mygl_has_extension(const char extension[static 1]) {
+    GLint extensions_count;
+    ASSERT_GL(glGetIntegerv(GL_NUM_EXTENSIONS, &extensions_count));
+    my_range_for_zero(GLint, i, extensions_count) {
+        const GLubyte *name;
+        ASSERT_GL(name = glGetStringi(GL_EXTENSIONS, (GLuint)i));
+        if(strcmp((const char*)name, extension) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
 
-    while(!glfwWindowShouldClose(glfw_window)) {
-        glfwPollEvents();
-        ASSERT_GL(glClearColor(0, 0, 0, 1));
-        ASSERT_GL(glClear(GL_COLOR_BUFFER_BIT));
+// Storage of the A operand of the matmul and reduce shaders. Packed formats keep two 16 bit values per uint,
+// the even element in the low half, and are always widened to fp32 before accumulation.
+typedef enum {
+    MY_GL_MAT_FORMAT_F32,
+    MY_GL_MAT_FORMAT_F16,
+    MY_GL_MAT_FORMAT_BF16,
+    MY_GL_MAT_FORMAT_COUNT,
+} MyGLMatFormat;
+
+static const char *const my_gl_mat_format_names[MY_GL_MAT_FORMAT_COUNT] = {
+    [MY_GL_MAT_FORMAT_F32] = "f32",
+    [MY_GL_MAT_FORMAT_F16] = "f16",
+    [MY_GL_MAT_FORMAT_BF16] = "bf16",
+};
+
+static const char *const mygl_mat_format_shader_headers[MY_GL_MAT_FORMAT_COUNT] = {
+    [MY_GL_MAT_FORMAT_F32] = "#define MY_FORMAT 0\n",
+    [MY_GL_MAT_FORMAT_F16] = "#define MY_FORMAT 1\n",
+    [MY_GL_MAT_FORMAT_BF16] = "#define MY_FORMAT 2\n",
+};
+
+#define MYGL_SHADER_LOAD_A "\n#if MY_FORMAT == 0\n" S(\
+layout(std430, binding = 0) readonly buffer ssbo_A { float A[]; };\
+float load_a(uint i) { return A[i]; }\
+) "\n#else\n" S(\
+layout(std430, binding = 0) readonly buffer ssbo_A { uint A[]; };\
+) "\n#endif\n#if MY_FORMAT == 1\n" S(\
+float load_a(uint i) { return unpackHalf2x16(A[i >> 1u])[i & 1u]; }\
+) "\n#elif MY_FORMAT == 2\n" S(\
+float load_a(uint i) {\
+    uint word = A[i >> 1u];\
+    return uintBitsToFloat((i & 1u) != 0u ? (word & 0xffff0000u) : (word << 16u));\
+}\
+) "\n#endif\n"
+
+static const char *const mygl_precision_shader_headers[MY_PRECISION_COUNT] = {
+    [MY_PRECISION_F32] = "#define MY_PRECISION 0\n",
+    [MY_PRECISION_F64] = "#extension GL_ARB_gpu_shader_fp64 : require\n#define MY_PRECISION 1\n",
+    [MY_PRECISION_KAHAN] = "#define MY_PRECISION 2\n",
+};
+
+#define MYGL_SHADER_ACCUMULATOR "\n#if MY_PRECISION == 1\n" S(\
+struct Acc { double sum; };\
+Acc acc_zero() { return Acc(0.0lf); }\
+void acc_add(inout Acc acc, float a, float b) { acc.sum += double(a) * double(b); }\
+float acc_value(Acc acc) { return float(acc.sum); }\
+) "\n#elif MY_PRECISION == 2\n" S(\
+struct Acc { float sum; float compensation; };\
+Acc acc_zero() { return Acc(0.0f, 0.0f); }\
+void acc_add(inout Acc acc, float a, float b) {\
+    precise float y = a * b - acc.compensation;\
+    precise float t = acc.sum + y;\
+    precise float compensation = (t - acc.sum) - y;\
+    acc.compensation = compensation;\
+    acc.sum = t;\
+}\
+float acc_value(Acc acc) { return acc.sum; }\
+) "\n#else\n" S(\
+struct Acc { float sum; };\
+Acc acc_zero() { return Acc(0.0f); }\
+void acc_add(inout Acc acc, float a, float b) { acc.sum += a * b; }\
+float acc_value(Acc acc) { return acc.sum; }\
+) "\n#endif\n"
+
+static const char mygl_matrix_mul_compute_shader[] = S(
+layout(local_size_x = 32, local_size_y = 32, local_size_z = 1) in;
 
-        ImGui_ImplOpenGL3_NewFrame();
-        ImGui_ImplGlfw_NewFrame();
-        igNewFrame();
+uniform uint m;
+uniform uint n;
+uniform uint l;
+uniform uint x0;
+uniform uint y0;
+) MYGL_SHADER_LOAD_A MYGL_SHADER_ACCUMULATOR S(
+layout(std430, binding = 1) readonly buffer ssbo_B { float B[]; };
+layout(std430, binding = 2) writeonly buffer ssbo_R { float R[]; };
 
-        // {
-        //     ImGuiViewport* const ig_viewport = igGetWindowViewport();
-        //     igSetNextWindowPos((ImVec2){0}, ImGuiCond_FirstUseEver, (ImVec2){0});
-        //     igSetNextWindowSize(ig_viewport->WorkSize, ImGuiCond_Always);
-        // }
-        // if(igBegin("demo", NULL, ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoMove)) {
-        //
-        // }
-        // igEnd();
+const uint BLOCK_SIZE = gl_WorkGroupSize.x;
 
+shared float As[BLOCK_SIZE][BLOCK_SIZE];
+shared float Bs[BLOCK_SIZE][BLOCK_SIZE];
 
-            ImS64   bar_data[11];
-            for(int i = 0; i < 11; i++) {
-                bar_data[i] = i;
-            }
+void __memoryBarrierShared() {
+    memoryBarrierShared();
+    barrier();
+}
 
-            ImVec2 plot_size;
-            plot_size.x = 500;
-            plot_size.y = 300;
-            
-            igBegin("My Window", NULL, 0);
-            
-            if(ImPlot_BeginPlot("My Plot",plot_size,0)) {
-                ImPlot_PlotBars_S64PtrInt("My Bar Plot", bar_data, 11,0.67,0,0,0,sizeof(ImS64));
-                ImPlot_EndPlot();
-            }
-            
-            //igText("Test");
-            //igButton("Test",(struct ImVec2){200,50});
+void main() {
+    uint hA = m;
+    uint wA = n;
+    uint wB = l;
 
-            igEnd();
+    uint bx = gl_WorkGroupID.x;
+    uint by = gl_WorkGroupID.y;
+    uint tx = gl_LocalInvocationID.x;
+    uint ty = gl_LocalInvocationID.y;
 
+    uint gx = x0 + gl_GlobalInvocationID.x;
+    uint gy = y0 + gl_GlobalInvocationID.y;
 
-        static bool showdemowindow = true;
-        igShowDemoWindow(&showdemowindow);
+    uint aBegin = wA * (y0 + BLOCK_SIZE * by);
+    uint aEnd   = aBegin + wA - 1;
+    uint aStep  = BLOCK_SIZE;
 
+    uint bBegin = x0 + BLOCK_SIZE * bx;
+    uint bStep  = BLOCK_SIZE * wB;
 
+    Acc Rsub = acc_zero();
 
+    for(uint a = aBegin, b = bBegin, blkStart = 0;
+        a <= aEnd;
+        a += aStep, b += bStep, blkStart += BLOCK_SIZE) {
+        As[ty][tx] = (gy < hA && blkStart + tx < wA)
+            ? load_a(a + wA * ty + tx)
+            : 0.0f;
+
+        Bs[ty][tx] = (gx < wB && blkStart + ty < wA)
+            ? B[b + wB * ty + tx]
+            : 0.0f;
+
+        __memoryBarrierShared();
+
+        // #pragma unroll
+        for(uint k = 0; k < BLOCK_SIZE; k++) {
+            acc_add(Rsub, As[ty][k], Bs[k][tx]);
+        }
+
+        __memoryBarrierShared();
+    }
+
+    if(gy < hA && gx < wB) {
+        uint c = wB * (y0 + BLOCK_SIZE * by) + (x0 + BLOCK_SIZE * bx);
+        R[c + wB * ty + tx] = acc_value(Rsub);
+    }
+}
+);
+
+typedef struct {
+    GLuint rows;
+    GLuint cols;
+    GLuint ssb;
+    MyGLMatFormat format;
+} MyGLMat;
+
+static inline GLint my_gl_get_uniform_location(const GLuint shader_program, const char uniform_location_name[]) {
+    GLint value;
+    ASSERT_GL(value = glGetUniformLocation(shader_program, uniform_location_name));
+    ASSERT(value != -1);
+    return value;
+}
+
+static MyGLMat mygl_mat_buffer_data(const MyMat mat[static 1], const GLenum usage) {
+    MyGLMat gl_mat = {.rows = (GLuint)mat->rows, .cols = (GLuint)mat->cols};
+    ASSERT_GL(glGenBuffers(1, &gl_mat.ssb));
+    ASSERT_GL(glBindBuffer(GL_SHADER_STORAGE_BUFFER, gl_mat.ssb));
+        my_trace_zone("upload") ASSERT_GL(glBufferData(GL_SHADER_STORAGE_BUFFER, (GLsizeiptr)my_mat_bytes_count(mat), mat->items, usage));
+    ASSERT_GL(glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0));
+    my_mem_gl_alloc(my_mat_bytes_count(mat));
+    if(mat->items) {
+        my_mem_uploaded(my_mat_bytes_count(mat));
+    }
+    return gl_mat;
+}
+
+static uint16_t my_f32_to_f16(const GLfloat value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    const uint32_t sign = (bits >> 16) & 0x8000u;
+    const uint32_t biased_exponent = (bits >> 23) & 0xffu;
+    uint32_t mantissa = bits & 0x7fffffu;
+    if(biased_exponent == 0xffu) {
+        return (uint16_t)(sign | 0x7c00u | (mantissa ? 0x200u : 0u));
+    }
+    const int32_t exponent = (int32_t)biased_exponent - 127 + 15;
+    if(exponent >= 31) {
+        return (uint16_t)(sign | 0x7c00u);
+    }
+    if(exponent <= 0) {
+        if(exponent < -10) {
+            return (uint16_t)sign;
+        }
+        mantissa |= 0x800000u;
+        const uint32_t shift = (uint32_t)(14 - exponent);
+        const uint32_t rest = mantissa & ((1u << shift) - 1u);
+        const uint32_t halfway = 1u << (shift - 1u);
+        uint32_t half = mantissa >> shift;
+        if(rest > halfway || (rest == halfway && (half & 1u))) {
+            half++;
+        }
+        return (uint16_t)(sign | half);
+    }
+    // A carry out of the mantissa correctly rounds up into the exponent (and up to infinity).
+    uint32_t half = ((uint32_t)exponent << 10) | (mantissa >> 13);
+    const uint32_t rest = mantissa & 0x1fffu;
+    if(rest > 0x1000u || (rest == 0x1000u && (half & 1u))) {
+        half++;
+    }
+    return (uint16_t)(sign | half);
+}
+
+static uint16_t my_f32_to_bf16(const GLfloat value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    if((bits & 0x7fffffffu) > 0x7f800000u) {
+        return (uint16_t)((bits >> 16) | 0x40u);
+    }
+    bits += 0x7fffu + ((bits >> 16) & 1u);
+    return (uint16_t)(bits >> 16);
+}
+
+#define my_gl_mat_format_bytes_count(format, items_count) \
+    ((format) == MY_GL_MAT_FORMAT_F32 ? (items_count) * sizeof(GLfloat) : (((items_count) + 1) / 2) * sizeof(GLuint))
+
+// Writes my_gl_mat_format_bytes_count(format, items_count) bytes to `dst`, an odd tail is padded with a zero half.
+static void my_gl_mat_format_pack(const MyGLMatFormat format, const GLfloat *const items, const size_t items_count, void *const dst) {
+    if(format == MY_GL_MAT_FORMAT_F32) {
+        memcpy(dst, items, items_count * sizeof(*items));
+        return;
+    }
+    uint16_t *const packed = (uint16_t*)dst;
+    packed[my_gl_mat_format_bytes_count(format, items_count) / sizeof(*packed) - 1] = 0;
+    my_range_for_zero(size_t, i, items_count) {
+        packed[i] = format == MY_GL_MAT_FORMAT_F16 ? my_f32_to_f16(items[i]) : my_f32_to_bf16(items[i]);
+    }
+}
+
+static MyGLMat mygl_mat_buffer_data_format(const MyMat mat[static 1], const MyGLMatFormat format, const GLenum usage) {
+    if(format == MY_GL_MAT_FORMAT_F32) {
+        return mygl_mat_buffer_data(mat, usage);
+    }
+    const size_t items_count = my_mat_items_count(mat);
+    const size_t bytes_count = my_gl_mat_format_bytes_count(format, items_count);
+    void *const packed = malloc(bytes_count);
+    ASSERT(packed);
+    my_gl_mat_format_pack(format, mat->items, items_count, packed);
+    MyGLMat gl_mat = {.rows = (GLuint)mat->rows, .cols = (GLuint)mat->cols, .format = format};
+    ASSERT_GL(glGenBuffers(1, &gl_mat.ssb));
+    ASSERT_GL(glBindBuffer(GL_SHADER_STORAGE_BUFFER, gl_mat.ssb));
+        my_trace_zone("upload") ASSERT_GL(glBufferData(GL_SHADER_STORAGE_BUFFER, (GLsizeiptr)bytes_count, packed, usage));
+    ASSERT_GL(glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0));
+    my_mem_gl_alloc(bytes_count);
+    my_mem_uploaded(bytes_count);
+    free(packed);
+    return gl_mat;
+}
+
+static void mygl_buffer_read(const GLuint ssb, const GLintptr offset, const GLsizeiptr bytes_count, void *const data) {
+    ASSERT_GL(glBindBuffer(GL_SHADER_STORAGE_BUFFER, ssb));
+        ASSERT_GL(glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, offset, bytes_count, data));
+    ASSERT_GL(glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0));
+    my_mem_downloaded((size_t)bytes_count);
+}
+
+static void mygl_mat_delete(const MyGLMat mat[static 1]) {
+    if(mat->ssb != 0) {
+        ASSERT_GL(glDeleteBuffers(1, &mat->ssb));
+        my_mem_gl_free(my_gl_mat_format_bytes_count(mat->format, (size_t)mat->rows * mat->cols));
+    }
+}
+
+// static MyGLMat my_gl_mat_mul_result_alloc(const MyGLMat first[static 1], const MyGLMat second[static 1]) {
+//     ASSERT(first->cols == second->rows);
+// }
+
+// Falls back to compensated summation when the driver has no fp64 support.
+static MyPrecision mygl_precision_supported(const MyPrecision precision) {
+    if(precision == MY_PRECISION_F64 && !mygl_has_extension("GL_ARB_gpu_shader_fp64")) {
+        LOG("GL_ARB_gpu_shader_fp64 is not supported, falling back to %s accumulation", my_precision_names[MY_PRECISION_KAHAN]);
+        return MY_PRECISION_KAHAN;
+    }
+    return precision;
+}
+
+static void mygl_matrix_mul_create_program(GLuint *const shader_program, GLuint *const shader_compute, const MyGLMatFormat format, const MyPrecision precision) {
+    char header[256];
+    snprintf(header, sizeof(header), "%s%s", mygl_mat_format_shader_headers[format], mygl_precision_shader_headers[precision]);
+    mygl_create_compute_shader_program_with_header(shader_program, shader_compute, header, mygl_matrix_mul_compute_shader);
+}
+
+// Only the result rows [row_first, row_end) are computed, the other rows of `first` are never read.
+static void my_gl_dispatch_compute_mat_mul_rows(
+    const GLuint shader_program,
+    const MyGLMat first[static 1],
+    const MyGLMat second[static 1],
+    const MyGLMat result[static 1],
+    const GLuint row_first,
+    const GLuint row_end
+) {
+    ASSERT(first->cols == second->rows);
+    ASSERT(first->rows == result->rows);
+    ASSERT(second->cols == result->cols);
+    ASSERT(second->format == MY_GL_MAT_FORMAT_F32 && result->format == MY_GL_MAT_FORMAT_F32);
+    ASSERT(row_first < row_end && row_end <= first->rows);
+
+    ASSERT_GL(glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, first->ssb));
+    ASSERT_GL(glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, second->ssb));
+    ASSERT_GL(glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, result->ssb));
+    ASSERT_GL(glUseProgram(shader_program));
+
+        const GLuint BLOCK_SIZE = 32;
+        const GLuint wsize[3] = {BLOCK_SIZE, BLOCK_SIZE, 1};
+        const GLuint gsize[3] = {64, 64, 1};
+        
+        const GLuint wcnt_x = (second->cols + wsize[0] - 1) / wsize[0];
+        const GLuint wcnt_y = (row_end - row_first + wsize[1] - 1) / wsize[1];
+        
+        const GLuint gcnt_x = (wcnt_x + gsize[0] - 1) / gsize[0];
+        const GLuint gcnt_y = (wcnt_y + gsize[1] - 1) / gsize[1];
+        
+        const GLuint nelem_x = wsize[0] * gsize[0];
+        const GLuint nelem_y = wsize[1] * gsize[1];
+
+        ASSERT_GL(glUniform1ui(my_gl_get_uniform_location(shader_program, "m"), row_end));
+        ASSERT_GL(glUniform1ui(my_gl_get_uniform_location(shader_program, "n"), first->cols));
+        ASSERT_GL(glUniform1ui(my_gl_get_uniform_location(shader_program, "l"), second->cols));
+
+        for(GLuint yi = 0; yi < gcnt_y; yi++) {
+            GLuint y0 = row_first + nelem_y * yi;
+            for(GLuint xi = 0; xi < gcnt_x; xi++) {
+                GLuint x0 = nelem_x * xi;
+                ASSERT_GL(glUniform1ui(my_gl_get_uniform_location(shader_program, "x0"), x0));
+                ASSERT_GL(glUniform1ui(my_gl_get_uniform_location(shader_program, "y0"), y0));
+                const GLuint groups_x = wcnt_x - xi * gsize[0] < gsize[0] ? wcnt_x - xi * gsize[0] : gsize[0];
+                const GLuint groups_y = wcnt_y - yi * gsize[1] < gsize[1] ? wcnt_y - yi * gsize[1] : gsize[1];
+                my_gl_dispatch_compute("mat_mul_rows", groups_x, groups_y, 1);
+            }
+        }
+
+    ASSERT_GL(glUseProgram(0));
+    ASSERT_GL(glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, 0));
+    ASSERT_GL(glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, 0));
+    ASSERT_GL(glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, 0));
+}
+
+static void my_gl_dispatch_compute_mat_mul(const GLuint shader_program, const MyGLMat first[static 1], const MyGLMat second[static 1], const MyGLMat result[static 1]) {
+    my_gl_dispatch_compute_mat_mul_rows(shader_program, first, second, result, 0, first->rows);
+}
+
+static const char mygl_axpby_compute_shader[] = S(
+layout(local_size_x = 256, local_size_y = 1, local_size_z = 1) in;
+
+uniform uint n;
+uniform float alpha;
+uniform float beta;
+uniform uint r_offset;
+uniform uint a_offset;
+uniform uint a_stride;
+uniform uint b_offset;
+uniform uint b_stride;
+
+layout(std430, binding = 0) buffer ssbo_A { float A[]; };
+layout(std430, binding = 1) buffer ssbo_B { float B[]; };
+layout(std430, binding = 2) buffer ssbo_R { float R[]; };
+
+void main() {
+    uint i = gl_GlobalInvocationID.x;
+    if(i < n) {
+        R[r_offset + i] = alpha * A[a_offset + i * a_stride] + beta * B[b_offset + i * b_stride];
+    }
+}
+);
+
+// R[r_offset + i] = alpha * A[a_offset + i * a_stride] + beta * B[b_offset + i * b_stride] for i < n, R may alias A or B
+static void my_gl_dispatch_compute_axpby(
+    const GLuint shader_program,
+    const GLuint r_ssb, const GLuint r_offset, const GLuint n,
+    const GLfloat alpha,
+    const GLuint a_ssb, const GLuint a_offset, const GLuint a_stride,
+    const GLfloat beta,
+    const GLuint b_ssb, const GLuint b_offset, const GLuint b_stride
+) {
+    ASSERT_GL(glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, a_ssb));
+    ASSERT_GL(glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, b_ssb));
+    ASSERT_GL(glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, r_ssb));
+    ASSERT_GL(glUseProgram(shader_program));
+        ASSERT_GL(glUniform1ui(my_gl_get_uniform_location(shader_program, "n"), n));
+        ASSERT_GL(glUniform1f(my_gl_get_uniform_location(shader_program, "alpha"), alpha));
+        ASSERT_GL(glUniform1f(my_gl_get_uniform_location(shader_program, "beta"), beta));
+        ASSERT_GL(glUniform1ui(my_gl_get_uniform_location(shader_program, "r_offset"), r_offset));
+        ASSERT_GL(glUniform1ui(my_gl_get_uniform_location(shader_program, "a_offset"), a_offset));
+        ASSERT_GL(glUniform1ui(my_gl_get_uniform_location(shader_program, "a_stride"), a_stride));
+        ASSERT_GL(glUniform1ui(my_gl_get_uniform_location(shader_program, "b_offset"), b_offset));
+        ASSERT_GL(glUniform1ui(my_gl_get_uniform_location(shader_program, "b_stride"), b_stride));
+        my_gl_dispatch_compute("axpby", (n + 255) / 256, 1, 1);
+    ASSERT_GL(glUseProgram(0));
+    ASSERT_GL(glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, 0));
+    ASSERT_GL(glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, 0));
+    ASSERT_GL(glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, 0));
+}
+
+typedef enum {
+    MY_OPTIMIZER_SGD,
+    MY_OPTIMIZER_MOMENTUM,
+    MY_OPTIMIZER_RMSPROP,
+    MY_OPTIMIZER_ADAM,
+    MY_OPTIMIZER_COUNT,
+} MyOptimizer;
+
+static const char *const my_optimizer_names[MY_OPTIMIZER_COUNT] = {
+    [MY_OPTIMIZER_SGD] = "sgd",
+    [MY_OPTIMIZER_MOMENTUM] = "momentum",
+    [MY_OPTIMIZER_RMSPROP] = "rmsprop",
+    [MY_OPTIMIZER_ADAM] = "adam",
+};
+
+// Decay rates of the first and the second moment estimates, 0 where the optimizer keeps no such moment.
+static const GLfloat my_optimizer_betas[MY_OPTIMIZER_COUNT][2] = {
+    [MY_OPTIMIZER_SGD] = {0.f, 0.f},
+    [MY_OPTIMIZER_MOMENTUM] = {0.9f, 0.f},
+    [MY_OPTIMIZER_RMSPROP] = {0.f, 0.9f},
+    [MY_OPTIMIZER_ADAM] = {0.9f, 0.999f},
+};
+
+#define MY_OPTIMIZER_EPSILON 1e-8f
+
+typedef enum {
+    MY_MINIBATCH_STAGE_SHUFFLE,
+    MY_MINIBATCH_STAGE_FORWARD,
+    MY_MINIBATCH_STAGE_UPDATE,
+    MY_MINIBATCH_STAGE_COUNT,
+} MyMinibatchStage;
+
+// Shuffle writes a random permutation of [0, n) to I: a Feistel network is a bijection on 2 * half_bits bits and
+// values outside [0, n) are walked through the cycle until they land inside. Forward runs one work group per batch
+// row and writes the residuals of the rows I[batch_offset..] to R. Update is fused with the optimizer, it sums the
+// gradient of one weight over the batch and updates the weight and its moments in State, the first moment at [j]
+// and the second one at [stride + j].
+static const char mygl_minibatch_compute_shader[] = "\n#if MY_STAGE == 1\n" S(
+layout(local_size_x = 64, local_size_y = 1, local_size_z = 1) in;
+) "\n#else\n" S(
+layout(local_size_x = 256, local_size_y = 1, local_size_z = 1) in;
+) "\n#endif\n" S(
+
+uniform uint n;
+uniform uint seed;
+uniform uint half_bits;
+uniform uint batch_offset;
+uniform uint stride;
+uniform uint cols;
+uniform float learning_rate;
+uniform float l2;
+uniform float bias_correction1;
+uniform float bias_correction2;
+) MYGL_SHADER_LOAD_A MYGL_SHADER_ACCUMULATOR S(
+layout(std430, binding = 1) readonly buffer ssbo_Y { float Y[]; };
+layout(std430, binding = 2) buffer ssbo_I { uint I[]; };
+layout(std430, binding = 3) buffer ssbo_W { float W[]; };
+layout(std430, binding = 4) buffer ssbo_R { float R[]; };
+layout(std430, binding = 5) buffer ssbo_State { float State[]; };
+
+uint hash(uint x) {
+    x ^= x >> 16u;
+    x *= 0x7feb352du;
+    x ^= x >> 15u;
+    x *= 0x846ca68bu;
+    x ^= x >> 16u;
+    return x;
+}
+
+uint permute(uint value) {
+    uint half_mask = (1u << half_bits) - 1u;
+    do {
+        uint left = value >> half_bits;
+        uint right = value & half_mask;
+        for(uint round_index = 0u; round_index < 4u; round_index++) {
+            uint next = left ^ (hash(right ^ (seed + round_index * 0x9e3779b9u)) & half_mask);
+            left = right;
+            right = next;
+        }
+        value = (left << half_bits) | right;
+    } while(value >= n);
+    return value;
+}
+
+shared float partial_sums[64];
+) "\n#if MY_STAGE == 0\n" S(
+void main() {
+    uint i = gl_GlobalInvocationID.x;
+    if(i < n) {
+        I[i] = permute(i);
+    }
+}
+) "\n#elif MY_STAGE == 1\n" S(
+void main() {
+    uint k = gl_WorkGroupID.x;
+    uint lid = gl_LocalInvocationID.x;
+    uint row = I[batch_offset + k];
+    Acc acc = acc_zero();
+    for(uint j = lid; j < cols; j += gl_WorkGroupSize.x) {
+        acc_add(acc, load_a(row * stride + j), W[j]);
+    }
+    partial_sums[lid] = acc_value(acc);
+    memoryBarrierShared();
+    barrier();
+    for(uint width = gl_WorkGroupSize.x / 2u; width > 0u; width >>= 1u) {
+        if(lid < width) {
+            partial_sums[lid] += partial_sums[lid + width];
+        }
+        memoryBarrierShared();
+        barrier();
+    }
+    if(lid == 0u) {
+        R[k] = partial_sums[0] - Y[row];
+    }
+}
+) "\n#else\n" S(
+void main() {
+    uint j = gl_GlobalInvocationID.x;
+    if(j >= cols) {
+        return;
+    }
+    Acc acc = acc_zero();
+    for(uint k = 0u; k < n; k++) {
+        acc_add(acc, R[k], load_a(I[batch_offset + k] * stride + j));
+    }
+    float w = W[j];
+    float g = 2.0f / float(n) * acc_value(acc) + (j > 0u ? 2.0f * l2 * w : 0.0f);
+) "\n#if MY_OPTIMIZER == 0\n" S(
+    w -= learning_rate * g;
+) "\n#elif MY_OPTIMIZER == 1\n" S(
+    float m = MY_BETA1 * State[j] + g;
+    State[j] = m;
+    w -= learning_rate * m;
+) "\n#elif MY_OPTIMIZER == 2\n" S(
+    float v = MY_BETA2 * State[stride + j] + (1.0f - MY_BETA2) * g * g;
+    State[stride + j] = v;
+    w -= learning_rate * g / (sqrt(v) + MY_EPSILON);
+) "\n#else\n" S(
+    float m = MY_BETA1 * State[j] + (1.0f - MY_BETA1) * g;
+    float v = MY_BETA2 * State[stride + j] + (1.0f - MY_BETA2) * g * g;
+    State[j] = m;
+    State[stride + j] = v;
+    w -= learning_rate * (m * bias_correction1) / (sqrt(v * bias_correction2) + MY_EPSILON);
+) "\n#endif\n" S(
+    W[j] = w;
+}
+) "\n#endif\n";
+
+static void mygl_minibatch_create_programs(
+    GLuint shader_programs[static MY_MINIBATCH_STAGE_COUNT],
+    GLuint shader_computes[static MY_MINIBATCH_STAGE_COUNT],
+    const MyGLMatFormat format,
+    const MyPrecision precision,
+    const MyOptimizer optimizer
+) {
+    my_range_for_zero(size_t, stage, MY_MINIBATCH_STAGE_COUNT) {
+        char header[512];
+        snprintf(
+            header, sizeof(header), "%s%s#define MY_STAGE %zu\n#define MY_OPTIMIZER %d\n#define MY_BETA1 float(%.9g)\n#define MY_BETA2 float(%.9g)\n#define MY_EPSILON float(%.9g)\n",
+            mygl_mat_format_shader_headers[format], mygl_precision_shader_headers[precision], stage, (int)optimizer,
+            (double)my_optimizer_betas[optimizer][0], (double)my_optimizer_betas[optimizer][1], (double)MY_OPTIMIZER_EPSILON
+        );
+        mygl_create_compute_shader_program_with_header(&shader_programs[stage], &shader_computes[stage], header, mygl_minibatch_compute_shader);
+    }
+}
+
+static void my_gl_dispatch_compute_shuffle(const GLuint shader_program, const GLuint indices_ssb, const GLuint n, const GLuint seed) {
+    GLuint half_bits = 0;
+    while((1ull << (2 * half_bits)) < n) {
+        half_bits++;
+    }
+    ASSERT_GL(glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, indices_ssb));
+    ASSERT_GL(glUseProgram(shader_program));
+        ASSERT_GL(glUniform1ui(my_gl_get_uniform_location(shader_program, "n"), n));
+        ASSERT_GL(glUniform1ui(my_gl_get_uniform_location(shader_program, "seed"), seed));
+        ASSERT_GL(glUniform1ui(my_gl_get_uniform_location(shader_program, "half_bits"), half_bits));
+        my_gl_dispatch_compute("shuffle", (n + 255) / 256, 1, 1);
+    ASSERT_GL(glUseProgram(0));
+    ASSERT_GL(glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, 0));
+}
+
+// R[k] = dot(xb[I[batch_offset + k]][0..cols), W) - y[I[batch_offset + k]] for k < batch_size
+static void my_gl_dispatch_compute_minibatch_forward(
+    const GLuint shader_program,
+    const MyGLMat xb[static 1],
+    const MyGLMat y[static 1],
+    const GLuint indices_ssb,
+    const GLuint batch_offset,
+    const GLuint batch_size,
+    const GLuint weights_ssb,
+    const GLuint cols,
+    const GLuint residuals_ssb
+) {
+    ASSERT(cols <= xb->cols && xb->rows == y->rows);
+    ASSERT_GL(glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, xb->ssb));
+    ASSERT_GL(glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, y->ssb));
+    ASSERT_GL(glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, indices_ssb));
+    ASSERT_GL(glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, weights_ssb));
+    ASSERT_GL(glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, residuals_ssb));
+    ASSERT_GL(glUseProgram(shader_program));
+        ASSERT_GL(glUniform1ui(my_gl_get_uniform_location(shader_program, "batch_offset"), batch_offset));
+        ASSERT_GL(glUniform1ui(my_gl_get_uniform_location(shader_program, "stride"), xb->cols));
+        ASSERT_GL(glUniform1ui(my_gl_get_uniform_location(shader_program, "cols"), cols));
+        my_gl_dispatch_compute("minibatch_forward", batch_size, 1, 1);
+    ASSERT_GL(glUseProgram(0));
+    my_range_for_zero(GLuint, binding, 5) {
+        ASSERT_GL(glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, 0));
+    }
+}
+
+// One optimizer step of the weights [0, cols) on the batch residuals of my_gl_dispatch_compute_minibatch_forward,
+// `step` counts from 1 and only matters for the Adam bias correction.
+static void my_gl_dispatch_compute_minibatch_update(
+    const GLuint shader_program,
+    const MyOptimizer optimizer,
+    const MyGLMat xb[static 1],
+    const GLuint indices_ssb,
+    const GLuint batch_offset,
+    const GLuint batch_size,
+    const GLuint residuals_ssb,
+    const GLuint weights_ssb,
+    const GLuint state_ssb,
+    const GLuint cols,
+    const GLfloat learning_rate,
+    const GLfloat l2,
+    const size_t step
+) {
+    ASSERT(cols <= xb->cols && step > 0);
+    ASSERT_GL(glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, xb->ssb));
+    ASSERT_GL(glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, indices_ssb));
+    ASSERT_GL(glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, weights_ssb));
+    ASSERT_GL(glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, residuals_ssb));
+    ASSERT_GL(glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 5, state_ssb));
+    ASSERT_GL(glUseProgram(shader_program));
+        ASSERT_GL(glUniform1ui(my_gl_get_uniform_location(shader_program, "n"), batch_size));
+        ASSERT_GL(glUniform1ui(my_gl_get_uniform_location(shader_program, "batch_offset"), batch_offset));
+        ASSERT_GL(glUniform1ui(my_gl_get_uniform_location(shader_program, "stride"), xb->cols));
+        ASSERT_GL(glUniform1ui(my_gl_get_uniform_location(shader_program, "cols"), cols));
+        ASSERT_GL(glUniform1f(my_gl_get_uniform_location(shader_program, "learning_rate"), learning_rate));
+        ASSERT_GL(glUniform1f(my_gl_get_uniform_location(shader_program, "l2"), l2));
+        if(optimizer == MY_OPTIMIZER_ADAM) {
+            ASSERT_GL(glUniform1f(my_gl_get_uniform_location(shader_program, "bias_correction1"), (GLfloat)(1.0 / (1.0 - pow((double)my_optimizer_betas[optimizer][0], (double)step)))));
+            ASSERT_GL(glUniform1f(my_gl_get_uniform_location(shader_program, "bias_correction2"), (GLfloat)(1.0 / (1.0 - pow((double)my_optimizer_betas[optimizer][1], (double)step)))));
+        }
+        my_gl_dispatch_compute("minibatch_update", (cols + 255) / 256, 1, 1);
+    ASSERT_GL(glUseProgram(0));
+    my_range_for_zero(GLuint, binding, 6) {
+        ASSERT_GL(glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, 0));
+    }
+}
+
+// Sum, min/max and Welford mean/M2 of a line of elements, partial results are merged with Chan's formula.
+// Layout matches `struct Stats` in the shaders (std430, 6 floats).
+typedef struct {
+    GLfloat sum;
+    GLfloat minimum;
+    GLfloat maximum;
+    GLfloat mean;
+    GLfloat m2;
+    GLfloat count;
+} MyGLStats;
+
+#define MY_GL_STATS_FIELDS_COUNT (sizeof(MyGLStats) / sizeof(GLfloat))
+#define my_gl_stats_variance(s) ((s)->count > 0.f ? (double)(s)->m2 / (double)(s)->count : 0.0)
+
+#define MYGL_SHADER_STATS S(\
+struct Stats { float sum; float minimum; float maximum; float mean; float m2; float count; };\
+\
+Stats stats_empty() {\
+    float inf = uintBitsToFloat(0x7f800000u);\
+    return Stats(0.0f, inf, -inf, 0.0f, 0.0f, 0.0f);\
+}\
+\
+void stats_push(inout Stats s, float x) {\
+    s.count += 1.0f;\
+    float delta = x - s.mean;\
+    s.mean += delta / s.count;\
+    s.m2 += delta * (x - s.mean);\
+    s.sum += x;\
+    s.minimum = min(s.minimum, x);\
+    s.maximum = max(s.maximum, x);\
+}\
+\
+Stats stats_combine(Stats a, Stats b) {\
+    float count = a.count + b.count;\
+    if(a.count == 0.0f) return b;\
+    if(b.count == 0.0f) return a;\
+    float delta = b.mean - a.mean;\
+    return Stats(\
+        a.sum + b.sum,\
+        min(a.minimum, b.minimum),\
+        max(a.maximum, b.maximum),\
+        a.mean + delta * (b.count / count),\
+        a.m2 + b.m2 + delta * delta * (a.count * b.count / count),\
+        count\
+    );\
+}\
+)
+
+typedef enum {
+    MY_GL_REDUCE_VALUE,
+    MY_GL_REDUCE_SQUARE,
+    MY_GL_REDUCE_DIFF,
+    MY_GL_REDUCE_SQUARED_DIFF,
+    MY_GL_REDUCE_PRODUCT,
+} MyGLReduceOp;
+
+#define MY_GL_REDUCE_LOCAL_SIZE 256
+#define MY_GL_REDUCE_ITEMS_PER_INVOCATION 4
+
+static const char mygl_reduce_compute_shader[] = S(
+layout(local_size_x = 256, local_size_y = 1, local_size_z = 1) in;
+) MYGL_SHADER_STATS S(
+uniform uint op;
+uniform uint from_partials;
+uniform uint line_length;
+uniform uint a_offset;
+uniform uint a_line_stride;
+uniform uint a_elem_stride;
+uniform uint b_offset;
+uniform uint b_line_stride;
+uniform uint b_elem_stride;
+uniform uint out_offset;
+) MYGL_SHADER_LOAD_A S(
+layout(std430, binding = 1) readonly buffer ssbo_B { float B[]; };
+layout(std430, binding = 2) readonly buffer ssbo_P { Stats P[]; };
+layout(std430, binding = 3) writeonly buffer ssbo_R { Stats R[]; };
+
+const uint LOCAL_SIZE = gl_WorkGroupSize.x;
+const uint ITEMS_PER_INVOCATION = 4u;
+
+shared Stats shared_stats[LOCAL_SIZE];
+
+float element(uint line, uint i) {
+    float a = load_a(a_offset + line * a_line_stride + i * a_elem_stride);
+    if(op == 0u) return a;
+    if(op == 1u) return a * a;
+    float b = B[b_offset + line * b_line_stride + i * b_elem_stride];
+    if(op == 2u) return a - b;
+    if(op == 3u) return (a - b) * (a - b);
+    return a * b;
+}
+) "\n#if MY_SUBGROUP\n" S(
+Stats subgroup_combine(Stats s) {
+    float count = subgroupAdd(s.count);
+    float mean = count > 0.0f ? subgroupAdd(s.count * s.mean) / count : 0.0f;
+    float delta = s.mean - mean;
+    return Stats(
+        subgroupAdd(s.sum),
+        subgroupMin(s.minimum),
+        subgroupMax(s.maximum),
+        mean,
+        subgroupAdd(s.m2 + s.count * delta * delta),
+        count
+    );
+}
+
+Stats workgroup_combine(Stats s, uint t) {
+    s = subgroup_combine(s);
+    if(gl_SubgroupInvocationID == 0u) {
+        shared_stats[gl_SubgroupID] = s;
+    }
+    memoryBarrierShared();
+    barrier();
+    if(t == 0u) {
+        s = stats_empty();
+        for(uint i = 0u; i < gl_NumSubgroups; ++i) {
+            s = stats_combine(s, shared_stats[i]);
+        }
+    }
+    return s;
+}
+) "\n#else\n" S(
+Stats workgroup_combine(Stats s, uint t) {
+    shared_stats[t] = s;
+    memoryBarrierShared();
+    barrier();
+    for(uint stride = LOCAL_SIZE / 2u; stride > 0u; stride >>= 1u) {
+        if(t < stride) {
+            shared_stats[t] = stats_combine(shared_stats[t], shared_stats[t + stride]);
+        }
+        memoryBarrierShared();
+        barrier();
+    }
+    return shared_stats[0];
+}
+) "\n#endif\n" S(
+void main() {
+    uint line = gl_WorkGroupID.y;
+    uint t = gl_LocalInvocationID.x;
+    uint base = gl_WorkGroupID.x * LOCAL_SIZE * ITEMS_PER_INVOCATION + t;
+
+    Stats s = stats_empty();
+    for(uint k = 0u; k < ITEMS_PER_INVOCATION; ++k) {
+        uint i = base + k * LOCAL_SIZE;
+        if(i < line_length) {
+            if(from_partials != 0u) {
+                s = stats_combine(s, P[line * line_length + i]);
+            } else {
+                stats_push(s, element(line, i));
+            }
+        }
+    }
+    s = workgroup_combine(s, t);
+    if(t == 0u) {
+        R[out_offset + line * gl_NumWorkGroups.x + gl_WorkGroupID.x] = s;
+    }
+}
+);
+
+// Strided addressing of `line_count` lines of `line_length` floats inside an SSBO:
+// element i of line l lives at offset + l * line_stride + i * elem_stride.
+typedef struct {
+    GLuint ssb;
+    GLuint offset;
+    GLuint line_count;
+    GLuint line_length;
+    GLuint line_stride;
+    GLuint elem_stride;
+    MyGLMatFormat format;
+} MyGLReduceView;
+
+static MyGLReduceView mygl_reduce_view_all(const MyGLMat mat[static 1]) {
+    return (MyGLReduceView){.ssb = mat->ssb, .line_count = 1, .line_length = mat->rows * mat->cols, .elem_stride = 1, .format = mat->format};
+}
+
+static MyGLReduceView mygl_reduce_view_rows(const MyGLMat mat[static 1]) {
+    return (MyGLReduceView){.ssb = mat->ssb, .line_count = mat->rows, .line_length = mat->cols, .line_stride = mat->cols, .elem_stride = 1, .format = mat->format};
+}
+
+static MyGLReduceView mygl_reduce_view_cols(const MyGLMat mat[static 1]) {
+    return (MyGLReduceView){.ssb = mat->ssb, .line_count = mat->cols, .line_length = mat->rows, .line_stride = 1, .elem_stride = mat->cols, .format = mat->format};
+}
+
+static MyGLReduceView mygl_reduce_view_col(const MyGLMat mat[static 1], const GLuint col) {
+    ASSERT(col < mat->cols);
+    return (MyGLReduceView){.ssb = mat->ssb, .offset = col, .line_count = 1, .line_length = mat->rows, .elem_stride = mat->cols, .format = mat->format};
+}
+
+// Element i of every line maps to vec[i], e.g. the residual vector against the columns of the design matrix.
+static MyGLReduceView mygl_reduce_view_broadcast(const MyGLMat vec[static 1]) {
+    return (MyGLReduceView){.ssb = vec->ssb, .line_count = 1, .line_length = vec->rows * vec->cols, .elem_stride = 1, .format = vec->format};
+}
+
+typedef struct {
+    bool has_subgroup;
+    GLuint shader_programs[MY_GL_MAT_FORMAT_COUNT];
+    GLuint shader_computes[MY_GL_MAT_FORMAT_COUNT];
+    GLuint partials_ssb[2];
+    GLsizeiptr partials_bytes_count;
+    GLuint scalars_ssb;
+    MyGLStats *scalars;
+    GLuint scalars_count;
+    GLuint scalars_used;
+} MyGLReduce;
+
+static MyGLReduce mygl_reduce_create(const GLuint scalars_count) {
+    MyGLReduce reduce = {.scalars_count = scalars_count};
+    reduce.has_subgroup = mygl_has_extension("GL_KHR_shader_subgroup");
+    LOG("reduce subgroup intrinsics: %s", reduce.has_subgroup ? "yes" : "no");
+    ASSERT_GL(glGenBuffers(2, reduce.partials_ssb));
+
+    const GLbitfield flags = GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    const GLsizeiptr scalars_bytes_count = (GLsizeiptr)(sizeof(MyGLStats) * scalars_count);
+    ASSERT_GL(glGenBuffers(1, &reduce.scalars_ssb));
+    ASSERT_GL(glBindBuffer(GL_SHADER_STORAGE_BUFFER, reduce.scalars_ssb));
+        ASSERT_GL(glBufferStorage(GL_SHADER_STORAGE_BUFFER, scalars_bytes_count, NULL, flags));
+        ASSERT_GL(reduce.scalars = (MyGLStats*)glMapBufferRange(GL_SHADER_STORAGE_BUFFER, 0, scalars_bytes_count, flags));
+        ASSERT(reduce.scalars);
+    ASSERT_GL(glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0));
+    return reduce;
+}
+
+static void mygl_reduce_destroy(MyGLReduce reduce[static 1]) {
+    ASSERT_GL(glBindBuffer(GL_SHADER_STORAGE_BUFFER, reduce->scalars_ssb));
+        ASSERT_GL(glUnmapBuffer(GL_SHADER_STORAGE_BUFFER));
+    ASSERT_GL(glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0));
+    ASSERT_GL(glDeleteBuffers(1, &reduce->scalars_ssb));
+    ASSERT_GL(glDeleteBuffers(2, reduce->partials_ssb));
+    my_range_for_zero(size_t, format, MY_GL_MAT_FORMAT_COUNT) {
+        if(reduce->shader_programs[format]) {
+            ASSERT_GL(glDeleteShader(reduce->shader_computes[format]));
+            ASSERT_GL(glDeleteProgram(reduce->shader_programs[format]));
+        }
+    }
+    *reduce = (MyGLReduce){0};
+}
+
+// Programs are compiled on first use, most runs only ever reduce fp32 buffers.
+static GLuint mygl_reduce_program(MyGLReduce reduce[static 1], const MyGLMatFormat format) {
+    if(!reduce->shader_programs[format]) {
+        char header[256];
+        snprintf(header, sizeof(header), "%s%s",
+            reduce->has_subgroup
+                ? "#extension GL_KHR_shader_subgroup_basic : require\n#extension GL_KHR_shader_subgroup_arithmetic : require\n#define MY_SUBGROUP 1\n"
+                : "#define MY_SUBGROUP 0\n",
+            mygl_mat_format_shader_headers[format]
+        );
+        mygl_create_compute_shader_program_with_header(&reduce->shader_programs[format], &reduce->shader_computes[format], header, mygl_reduce_compute_shader);
+    }
+    return reduce->shader_programs[format];
+}
+
+static void mygl_reduce_partials_reserve(MyGLReduce reduce[static 1], const GLsizeiptr bytes_count) {
+    if(bytes_count <= reduce->partials_bytes_count) {
+        return;
+    }
+    my_range_for_zero(size_t, i, my_array_count(reduce->partials_ssb)) {
+        ASSERT_GL(glBindBuffer(GL_SHADER_STORAGE_BUFFER, reduce->partials_ssb[i]));
+            ASSERT_GL(glBufferData(GL_SHADER_STORAGE_BUFFER, bytes_count, NULL, GL_DYNAMIC_COPY));
+        ASSERT_GL(glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0));
+    }
+    reduce->partials_bytes_count = bytes_count;
+}
+
+// Writes one MyGLStats per line of `a` into dst_ssb starting at dst_offset (in MyGLStats units).
+// Lines longer than one work group chunk are reduced in several passes through ping-pong partial buffers.
+static void mygl_reduce(
+    MyGLReduce reduce[static 1],
+    const MyGLReduceOp op,
+    const MyGLReduceView a[static 1],
+    const MyGLReduceView *const b,
+    const GLuint dst_ssb,
+    const GLuint dst_offset
+) {
+    ASSERT(a->line_count > 0 && a->line_count <= 65535);
+    ASSERT(a->line_length > 0);
+    ASSERT(b || op == MY_GL_REDUCE_VALUE || op == MY_GL_REDUCE_SQUARE);
+
+    const GLuint chunk = MY_GL_REDUCE_LOCAL_SIZE * MY_GL_REDUCE_ITEMS_PER_INVOCATION;
+    GLuint length = a->line_length;
+    GLuint groups = (length + chunk - 1) / chunk;
+    if(groups > 1) {
+        mygl_reduce_partials_reserve(reduce, (GLsizeiptr)(sizeof(MyGLStats) * a->line_count * groups));
+    }
+
+    ASSERT(!b || b->format == MY_GL_MAT_FORMAT_F32);
+    const GLuint program = mygl_reduce_program(reduce, a->format);
+    ASSERT_GL(glUseProgram(program));
+    ASSERT_GL(glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, a->ssb));
+    ASSERT_GL(glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, b ? b->ssb : a->ssb));
+    ASSERT_GL(glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, a->ssb));
+        ASSERT_GL(glUniform1ui(my_gl_get_uniform_location(program, "op"), (GLuint)op));
+        ASSERT_GL(glUniform1ui(my_gl_get_uniform_location(program, "a_offset"), a->offset));
+        ASSERT_GL(glUniform1ui(my_gl_get_uniform_location(program, "a_line_stride"), a->line_stride));
+        ASSERT_GL(glUniform1ui(my_gl_get_uniform_location(program, "a_elem_stride"), a->elem_stride));
+        ASSERT_GL(glUniform1ui(my_gl_get_uniform_location(program, "b_offset"), b ? b->offset : 0));
+        ASSERT_GL(glUniform1ui(my_gl_get_uniform_location(program, "b_line_stride"), b ? b->line_stride : 0));
+        ASSERT_GL(glUniform1ui(my_gl_get_uniform_location(program, "b_elem_stride"), b ? b->elem_stride : 0));
+
+        GLuint from_partials = 0;
+        size_t partials_index = 0;
+        while(true) {
+            const bool last = groups == 1;
+            ASSERT_GL(glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, last ? dst_ssb : reduce->partials_ssb[partials_index]));
+            ASSERT_GL(glUniform1ui(my_gl_get_uniform_location(program, "from_partials"), from_partials));
+            ASSERT_GL(glUniform1ui(my_gl_get_uniform_location(program, "line_length"), length));
+            ASSERT_GL(glUniform1ui(my_gl_get_uniform_location(program, "out_offset"), last ? dst_offset : 0));
+            my_gl_dispatch_compute("reduce", groups, a->line_count, 1);
+            if(last) {
+                break;
+            }
+            ASSERT_GL(glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT));
+            ASSERT_GL(glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, reduce->partials_ssb[partials_index]));
+            partials_index ^= 1;
+            from_partials = 1;
+            length = groups;
+            groups = (length + chunk - 1) / chunk;
+        }
+
+    ASSERT_GL(glUseProgram(0));
+    my_range_for_zero(GLuint, binding, 4) {
+        ASSERT_GL(glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, 0));
+    }
+}
+
+// Reduces the whole view into the next slot of the persistent-mapped scalars buffer, read it after mygl_reduce_scalars_wait.
+static GLuint mygl_reduce_scalar(MyGLReduce reduce[static 1], const MyGLReduceOp op, const MyGLReduceView a[static 1], const MyGLReduceView *const b) {
+    ASSERT(a->line_count == 1);
+    ASSERT(reduce->scalars_used < reduce->scalars_count);
+    const GLuint slot = reduce->scalars_used++;
+    mygl_reduce(reduce, op, a, b, reduce->scalars_ssb, slot);
+    return slot;
+}
+
+static const MyGLStats* mygl_reduce_scalars_wait(MyGLReduce reduce[static 1]) {
+    ASSERT_GL(glMemoryBarrier(GL_CLIENT_MAPPED_BUFFER_BARRIER_BIT));
+    GLsync sync;
+    ASSERT_GL(sync = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+    while(true) {
+        GLenum status;
+        ASSERT_GL(status = glClientWaitSync(sync, GL_SYNC_FLUSH_COMMANDS_BIT, 1000 * 1000 * 1000));
+        ASSERT(status != GL_WAIT_FAILED);
+        if(status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED) {
+            break;
+        }
+    }
+    ASSERT_GL(glDeleteSync(sync));
+    my_mem_downloaded(reduce->scalars_used * sizeof(*reduce->scalars));
+    reduce->scalars_used = 0;
+    return reduce->scalars;
+}
+
+static const char mygl_standard_scale_compute_shader[] = S(
+layout(local_size_x = 256, local_size_y = 1, local_size_z = 1) in;
+) MYGL_SHADER_STATS S(
+uniform uint rows;
+uniform uint cols;
+uniform uint col_first;
+
+layout(std430, binding = 0) buffer ssbo_A { float A[]; };
+layout(std430, binding = 1) readonly buffer ssbo_S { Stats column_stats[]; };
+
+void main() {
+    uint i = gl_GlobalInvocationID.x;
+    uint row = gl_WorkGroupID.y;
+    uint col = col_first + i;
+    if(row < rows && col < cols) {
+        Stats s = column_stats[col];
+        float std_dev = sqrt(s.m2 / s.count);
+        A[row * cols + col] = (A[row * cols + col] - s.mean) / (std_dev > 0.0f ? std_dev : 1.0f);
+    }
+}
+);
+
+// GPU counterpart of my_mat_polynomial_features_standard_scale for the columns [col_first, mat->cols).
+// `column_stats` receives the per-column MyGLStats and must hold mat->cols of them.
+static void mygl_mat_standard_scale(
+    MyGLReduce reduce[static 1],
+    const GLuint shader_program,
+    const MyGLMat mat[static 1],
+    const GLuint col_first,
+    const MyGLMat column_stats[static 1]
+) {
+    ASSERT(mat->format == MY_GL_MAT_FORMAT_F32);
+    ASSERT(column_stats->rows * column_stats->cols >= mat->cols * MY_GL_STATS_FIELDS_COUNT);
+    ASSERT(mat->rows <= 65535);
+    const MyGLReduceView view = mygl_reduce_view_cols(mat);
+    mygl_reduce(reduce, MY_GL_REDUCE_VALUE, &view, NULL, column_stats->ssb, 0);
+    ASSERT_GL(glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT));
+
+    ASSERT_GL(glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, mat->ssb));
+    ASSERT_GL(glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, column_stats->ssb));
+    ASSERT_GL(glUseProgram(shader_program));
+        ASSERT_GL(glUniform1ui(my_gl_get_uniform_location(shader_program, "rows"), mat->rows));
+        ASSERT_GL(glUniform1ui(my_gl_get_uniform_location(shader_program, "cols"), mat->cols));
+        ASSERT_GL(glUniform1ui(my_gl_get_uniform_location(shader_program, "col_first"), col_first));
+        my_gl_dispatch_compute("standard_scale", (mat->cols - col_first + 255) / 256, mat->rows, 1);
+    ASSERT_GL(glUseProgram(0));
+    ASSERT_GL(glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, 0));
+    ASSERT_GL(glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, 0));
+}
+
+static void my_read_bin_data_to_mat(MyMat *const mat, MyArena *const arena, const char *const path) {
+    my_trace_zone("load") {
+        mat->items = (GLfloat*)my_arena_alloc(arena, my_mat_bytes_count(mat));
+        const int fd = open(path, O_RDONLY);
+        ASSERT_NOT_MINUS_ONE(fd);
+        struct stat stat;
+        ASSERT_NOT_MINUS_ONE(fstat(fd, &stat));
+        ASSERT((size_t)stat.st_size == my_mat_bytes_count(mat));
+        GLfloat *const data = (GLfloat*)mmap(NULL, my_mat_bytes_count(mat), PROT_READ, MAP_SHARED, fd, 0);
+        ASSERT(data != MAP_FAILED);
+        memcpy(mat->items, data, my_mat_bytes_count(mat));
+        ASSERT_NOT_MINUS_ONE(munmap(data, my_mat_bytes_count(mat)));
+        ASSERT_NOT_MINUS_ONE(close(fd));
+    }
+}
+
+static inline float my_powf(const float value, const size_t degree) {
+    double res = (double)value;
+    for(size_t i = 1; i < degree; ++i) {
+        res *= (double)value;
+    }
+    return (float)res;
+}
+static inline double my_pow(const double value, const size_t degree) {
+    double res = value;
+    for(size_t i = 1; i < degree; ++i) {
+        res *= value;
+    }
+    return res;
+}
+
+typedef struct {
+    MyMat *mat;
+    MyMat *fitted_scaler;
+    const MyMat *scaler;
+    const MyMat *features;
+    size_t degree;
+    size_t row_first;
+    // rows [held_out_first, held_out_end) of `features` are left out of the fitted scaler
+    size_t held_out_first;
+    size_t held_out_end;
+} MyPolynomialTask;
+
+static void my_polynomial_features_create_rows(void *const context, const size_t row_first, const size_t row_end) {
+    const MyPolynomialTask *const task = (const MyPolynomialTask*)context;
+    const MyMat *const features = task->features;
+    my_range_for(size_t, row, row_first, row_end) {
+        for(size_t deg = 1, base_col = 0; deg <= task->degree; deg++, base_col += features->cols) {
+            my_range_for_zero(size_t, col, features->cols) {
+                my_mat_item(task->mat, row, base_col + col) = my_powf(my_mat_item(features, row, col), deg);
+            }
+        }
+    }
+}
+
+static MyMat my_polynomial_features_create(MyArena arena[static 1], const MyMat features[static 1], const size_t degree) {
+    ASSERT(degree > 0);
+    MyMat polynomial_features = my_mat_alloc(arena, features->rows, features->cols * degree);
+    my_trace_zone("features") {
+        my_parallel_for(
+            "my_polynomial_features_create", features->rows, 64, my_polynomial_features_create_rows,
+            &(MyPolynomialTask){.mat = &polynomial_features, .features = features, .degree = degree}
+        );
+    }
+    return polynomial_features; 
+}
+
+static void my_polynomial_features_create_cols_block(void *const context, const size_t scaler_col_first, const size_t scaler_col_end) {
+    const MyPolynomialTask *const task = (const MyPolynomialTask*)context;
+    const MyMat *const features = task->features;
+    const MyMat *const scaler = task->scaler;
+    my_range_for(size_t, scaler_col, scaler_col_first, scaler_col_end) {
+        const size_t deg = scaler_col / features->cols + 1;
+        const size_t col = scaler_col % features->cols;
+        const GLfloat mean = my_mat_item(scaler, 0, scaler_col);
+        const GLfloat std = my_mat_item(scaler, 1, scaler_col);
+        GLfloat *const dst = &my_mat_row(task->mat, scaler_col);
+        my_range_for_zero(size_t, row, features->rows) {
+            dst[row] = (my_powf(my_mat_item(features, row, col), deg) - mean) / std;
+        }
+    }
+}
+
+// Column-major copy of the scaled polynomial features: row j of the result is column j of
+// my_polynomial_features_create after my_mat_standard_scale_apply, so a coordinate update streams one contiguous column.
+static MyMat my_polynomial_features_create_cols(MyArena arena[static 1], const MyMat features[static 1], const size_t degree, const MyMat scaler[static 1]) {
+    ASSERT(degree > 0);
+    ASSERT(scaler->rows == 2 && scaler->cols >= features->cols * degree);
+    MyMat cols = my_mat_alloc(arena, features->cols * degree, features->rows);
+    my_trace_zone("features") {
+        my_parallel_for(
+            "my_polynomial_features_create_cols", cols.rows, 4, my_polynomial_features_create_cols_block,
+            &(MyPolynomialTask){.mat = &cols, .scaler = scaler, .features = features, .degree = degree}
+        );
+    }
+    return cols;
+}
+
+static void my_mat_polynomial_features_standard_scale_cols(void *const context, const size_t col_first, const size_t col_end) {
+    const MyPolynomialTask *const task = (const MyPolynomialTask*)context;
+    MyMat *const mat = task->mat;
+    MyMat *const scaler = task->fitted_scaler;
+    my_range_for(size_t, col, col_first, col_end) {
+        double mean = 0.0;
+        my_range_for_zero(size_t, row, mat->rows) {
+            mean += (double)my_mat_item(mat, row, col);
+        }
+        mean /= (double)mat->rows;
+
+        double std = 0.0;
+        my_range_for_zero(size_t, row, mat->rows) {
+            std += my_pow((double)my_mat_item(mat, row, col) - mean, 2);
+        }
+        std /= (double)mat->rows;
+        std = std > 0.0 ? sqrt(std) : 1.0;
+        if(scaler) {
+            my_mat_item(scaler, 0, col) = (GLfloat)mean;
+            my_mat_item(scaler, 1, col) = (GLfloat)std;
+        }
+
+        my_range_for_zero(size_t, row, mat->rows) {
+            my_mat_item(mat, row, col) = (GLfloat)(((double)my_mat_item(mat, row, col) - mean) / std);
+        }
+    }
+}
+
+// `scaler`, when given, receives the column means in row 0 and standard deviations in row 1.
+static void my_mat_polynomial_features_standard_scale(MyMat mat[static 1], MyMat *const scaler) {
+    ASSERT(!scaler || (scaler->rows == 2 && scaler->cols == mat->cols));
+    my_trace_zone("scale") {
+        my_parallel_for(
+            "my_mat_polynomial_features_standard_scale", mat->cols, 1, my_mat_polynomial_features_standard_scale_cols,
+            &(MyPolynomialTask){.mat = mat, .fitted_scaler = scaler}
+        );
+    }
+}
+
+static void my_mat_standard_scale_apply_rows(void *const context, const size_t row_first, const size_t row_end) {
+    const MyPolynomialTask *const task = (const MyPolynomialTask*)context;
+    MyMat *const mat = task->mat;
+    const MyMat *const scaler = task->scaler;
+    my_range_for(size_t, row, row_first, row_end) {
+        my_range_for_zero(size_t, col, mat->cols) {
+            my_mat_item(mat, row, col) = (my_mat_item(mat, row, col) - my_mat_item(scaler, 0, col)) / my_mat_item(scaler, 1, col);
+        }
+    }
+}
+
+static void my_mat_standard_scale_apply(MyMat mat[static 1], const MyMat scaler[static 1]) {
+    ASSERT(scaler->rows == 2 && scaler->cols == mat->cols);
+    my_trace_zone("scale") {
+        my_parallel_for("my_mat_standard_scale_apply", mat->rows, 64, my_mat_standard_scale_apply_rows, &(MyPolynomialTask){.mat = mat, .scaler = scaler});
+    }
+}
+
+// Polynomial features of `features` behind a column of ones. The scaler is fitted when `fit` is set and applied otherwise.
+static MyMat my_polynomial_design_matrix(MyArena arena[static 1], const MyMat features[static 1], const size_t degree, MyMat scaler[static 1], const bool fit) {
+    MyMat polynomial_features = my_polynomial_features_create(arena, features, degree);
+    if(fit) {
+        my_mat_polynomial_features_standard_scale(&polynomial_features, scaler);
+    } else {
+        my_mat_standard_scale_apply(&polynomial_features, scaler);
+    }
+    MyMat ones = my_mat_alloc(arena, polynomial_features.rows, 1);
+    my_mat_foreach(el, &ones) {
+        *el = 1.f;
+    }
+    return my_mat_hstack(arena, &ones, &polynomial_features);
+}
+
+static void my_polynomial_scaler_fit_cols(void *const context, const size_t scaler_col_first, const size_t scaler_col_end) {
+    const MyPolynomialTask *const task = (const MyPolynomialTask*)context;
+    const MyMat *const features = task->features;
+    MyMat *const scaler = task->fitted_scaler;
+    my_range_for(size_t, scaler_col, scaler_col_first, scaler_col_end) {
+        const size_t deg = scaler_col / features->cols + 1;
+        const size_t col = scaler_col % features->cols;
+        const size_t rows = features->rows - (task->held_out_end - task->held_out_first);
+        double mean = 0.0;
+        my_range_for_zero(size_t, row, features->rows) {
+            if(row < task->held_out_first || row >= task->held_out_end) {
+                mean += (double)my_powf(my_mat_item(features, row, col), deg);
+            }
+        }
+        mean /= (double)rows;
+
+        double std = 0.0;
+        my_range_for_zero(size_t, row, features->rows) {
+            if(row < task->held_out_first || row >= task->held_out_end) {
+                std += my_pow((double)my_powf(my_mat_item(features, row, col), deg) - mean, 2);
+            }
+        }
+        std /= (double)rows;
+        std = std > 0.0 ? sqrt(std) : 1.0;
+        my_mat_item(scaler, 0, scaler_col) = (GLfloat)mean;
+        my_mat_item(scaler, 1, scaler_col) = (GLfloat)std;
+    }
+}
+
+// Statistics of the rows of `features` outside [held_out_first, held_out_end), a cross-validation fold fits its scaler
+// on its training rows only.
+static void my_polynomial_scaler_fit_rows(
+    const MyMat features[static 1],
+    const size_t degree,
+    const size_t held_out_first,
+    const size_t held_out_end,
+    MyMat scaler[static 1]
+) {
+    ASSERT(scaler->rows == 2 && scaler->cols == features->cols * degree);
+    ASSERT(held_out_first <= held_out_end && held_out_end - held_out_first < features->rows);
+    my_trace_zone("scale") {
+        my_parallel_for(
+            "my_polynomial_scaler_fit", scaler->cols, 1, my_polynomial_scaler_fit_cols,
+            &(MyPolynomialTask){.fitted_scaler = scaler, .features = features, .held_out_first = held_out_first, .held_out_end = held_out_end}
+        );
+    }
+}
+
+// Same statistics as my_mat_polynomial_features_standard_scale, computed from `features` without materializing the polynomial features.
+static void my_polynomial_scaler_fit(const MyMat features[static 1], const size_t degree, MyMat scaler[static 1]) {
+    my_polynomial_scaler_fit_rows(features, degree, 0, 0, scaler);
+}
+
+static void my_polynomial_design_rows_block(void *const context, const size_t row_first, const size_t row_end) {
+    const MyPolynomialTask *const task = (const MyPolynomialTask*)context;
+    const MyMat *const features = task->features;
+    const MyMat *const scaler = task->scaler;
+    MyMat *const block = task->mat;
+    my_range_for(size_t, row, row_first, row_end) {
+        my_mat_item(block, row, 0) = 1.f;
+        for(size_t deg = 1, base_col = 0; deg <= task->degree; deg++, base_col += features->cols) {
+            my_range_for_zero(size_t, col, features->cols) {
+                const GLfloat value = my_powf(my_mat_item(features, task->row_first + row, col), deg);
+                my_mat_item(block, row, 1 + base_col + col) = (value - my_mat_item(scaler, 0, base_col + col)) / my_mat_item(scaler, 1, base_col + col);
+            }
+        }
+    }
+}
+
+// Rows [row_first, row_first + block->rows) of my_polynomial_design_matrix with a fitted scaler.
+static void my_polynomial_design_rows(const MyMat features[static 1], const size_t degree, const MyMat scaler[static 1], const size_t row_first, MyMat block[static 1]) {
+    ASSERT(block->cols == features->cols * degree + 1);
+    ASSERT(row_first + block->rows <= features->rows);
+    my_trace_zone("features") {
+        my_parallel_for(
+            "my_polynomial_design_rows", block->rows, 64, my_polynomial_design_rows_block,
+            &(MyPolynomialTask){.mat = block, .scaler = scaler, .features = features, .degree = degree, .row_first = row_first}
+        );
+    }
+}
+
+#define MY_UPLOAD_STAGING_COUNT 3
+
+// A worker thread fills a ring of staging blocks with packed design matrix rows while the GL thread
+// uploads finished blocks with glBufferSubData, so callers can dispatch on the rows that already landed.
+typedef struct {
+    const MyMat *features;
+    const MyMat *scaler;
+    size_t degree;
+    size_t block_rows;
+    size_t blocks_count;
+    size_t staging_bytes_count;
+    void *staging[MY_UPLOAD_STAGING_COUNT];
+    pthread_t worker;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    size_t produced;
+    size_t consumed;
+    MyGLMat gl_mat;
+} MyUploadPipeline;
+
+#define my_upload_pipeline_block_end(p, block) ((block) + 1 == (p)->blocks_count ? (size_t)(p)->gl_mat.rows : ((block) + 1) * (p)->block_rows)
+
+static void* my_upload_pipeline_worker(void *const arg) {
+    MyUploadPipeline *const pipeline = (MyUploadPipeline*)arg;
+    my_trace_thread_name("upload");
+    MyMat block = {.rows = pipeline->block_rows, .cols = pipeline->gl_mat.cols};
+    block.items = (GLfloat*)malloc(my_mat_bytes_count(&block));
+    ASSERT(block.items);
+    my_range_for_zero(size_t, i, pipeline->blocks_count) {
+        ASSERT(pthread_mutex_lock(&pipeline->mutex) == 0);
+            while(pipeline->produced - pipeline->consumed == MY_UPLOAD_STAGING_COUNT) {
+                ASSERT(pthread_cond_wait(&pipeline->cond, &pipeline->mutex) == 0);
+            }
+        ASSERT(pthread_mutex_unlock(&pipeline->mutex) == 0);
+
+        const size_t row_first = i * pipeline->block_rows;
+        block.rows = my_upload_pipeline_block_end(pipeline, i) - row_first;
+        my_polynomial_design_rows(pipeline->features, pipeline->degree, pipeline->scaler, row_first, &block);
+        my_gl_mat_format_pack(pipeline->gl_mat.format, block.items, my_mat_items_count(&block), pipeline->staging[i % MY_UPLOAD_STAGING_COUNT]);
+
+        ASSERT(pthread_mutex_lock(&pipeline->mutex) == 0);
+            pipeline->produced++;
+            ASSERT(pthread_cond_broadcast(&pipeline->cond) == 0);
+        ASSERT(pthread_mutex_unlock(&pipeline->mutex) == 0);
+    }
+    free(block.items);
+    return NULL;
+}
+
+// `block_rows` is rounded up to an even count so packed 16 bit blocks start on a uint boundary.
+static void my_upload_pipeline_start(
+    MyUploadPipeline pipeline[static 1],
+    const MyMat features[static 1],
+    const size_t degree,
+    const MyMat scaler[static 1],
+    const MyGLMatFormat format,
+    const size_t block_rows
+) {
+    ASSERT(block_rows > 0);
+    *pipeline = (MyUploadPipeline){
+        .features = features,
+        .scaler = scaler,
+        .degree = degree,
+        .block_rows = block_rows + block_rows % 2,
+        .gl_mat = {.rows = (GLuint)features->rows, .cols = (GLuint)(features->cols * degree + 1), .format = format},
+    };
+    pipeline->blocks_count = (features->rows + pipeline->block_rows - 1) / pipeline->block_rows;
+    pipeline->staging_bytes_count = my_gl_mat_format_bytes_count(format, pipeline->block_rows * pipeline->gl_mat.cols);
+    my_range_for_zero(size_t, i, MY_UPLOAD_STAGING_COUNT) {
+        pipeline->staging[i] = malloc(pipeline->staging_bytes_count);
+        ASSERT(pipeline->staging[i]);
+    }
+
+    ASSERT_GL(glGenBuffers(1, &pipeline->gl_mat.ssb));
+    ASSERT_GL(glBindBuffer(GL_SHADER_STORAGE_BUFFER, pipeline->gl_mat.ssb));
+        const size_t bytes_count = my_gl_mat_format_bytes_count(format, (size_t)pipeline->gl_mat.rows * pipeline->gl_mat.cols);
+        ASSERT_GL(glBufferStorage(GL_SHADER_STORAGE_BUFFER, (GLsizeiptr)bytes_count, NULL, GL_DYNAMIC_STORAGE_BIT));
+    ASSERT_GL(glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0));
+    my_mem_gl_alloc(bytes_count);
+
+    ASSERT(pthread_mutex_init(&pipeline->mutex, NULL) == 0);
+    ASSERT(pthread_cond_init(&pipeline->cond, NULL) == 0);
+    ASSERT(pthread_create(&pipeline->worker, NULL, my_upload_pipeline_worker, pipeline) == 0);
+}
+
+// Blocks until the next staging block is ready and uploads it, false once every block is on the GPU.
+static bool my_upload_pipeline_next(MyUploadPipeline pipeline[static 1], GLuint row_first[static 1], GLuint row_end[static 1]) {
+    if(pipeline->consumed == pipeline->blocks_count) {
+        return false;
+    }
+    ASSERT(pthread_mutex_lock(&pipeline->mutex) == 0);
+        while(pipeline->produced == pipeline->consumed) {
+            ASSERT(pthread_cond_wait(&pipeline->cond, &pipeline->mutex) == 0);
+        }
+    ASSERT(pthread_mutex_unlock(&pipeline->mutex) == 0);
+
+    const size_t block = pipeline->consumed;
+    *row_first = (GLuint)(block * pipeline->block_rows);
+    *row_end = (GLuint)my_upload_pipeline_block_end(pipeline, block);
+    const size_t items_first = (size_t)*row_first * pipeline->gl_mat.cols;
+    const size_t items_count = (size_t)(*row_end - *row_first) * pipeline->gl_mat.cols;
+    ASSERT_GL(glBindBuffer(GL_SHADER_STORAGE_BUFFER, pipeline->gl_mat.ssb));
+        my_trace_zone("upload") ASSERT_GL(glBufferSubData(
+            GL_SHADER_STORAGE_BUFFER,
+            (GLintptr)my_gl_mat_format_bytes_count(pipeline->gl_mat.format, items_first),
+            (GLsizeiptr)my_gl_mat_format_bytes_count(pipeline->gl_mat.format, items_count),
+            pipeline->staging[block % MY_UPLOAD_STAGING_COUNT]
+        ));
+    ASSERT_GL(glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0));
+    my_mem_uploaded(my_gl_mat_format_bytes_count(pipeline->gl_mat.format, items_count));
+
+    // glBufferSubData has copied the staging block, the worker may refill it
+    ASSERT(pthread_mutex_lock(&pipeline->mutex) == 0);
+        pipeline->consumed++;
+        ASSERT(pthread_cond_broadcast(&pipeline->cond) == 0);
+    ASSERT(pthread_mutex_unlock(&pipeline->mutex) == 0);
+    return true;
+}
+
+// Drains the remaining blocks and joins the worker, the uploaded matrix stays in `pipeline->gl_mat`.
+static void my_upload_pipeline_finish(MyUploadPipeline pipeline[static 1]) {
+    GLuint row_first, row_end;
+    while(my_upload_pipeline_next(pipeline, &row_first, &row_end)) {}
+    ASSERT(pthread_join(pipeline->worker, NULL) == 0);
+    ASSERT(pthread_cond_destroy(&pipeline->cond) == 0);
+    ASSERT(pthread_mutex_destroy(&pipeline->mutex) == 0);
+    my_range_for_zero(size_t, i, MY_UPLOAD_STAGING_COUNT) {
+        free(pipeline->staging[i]);
+    }
+}
+
+// Evaluates the trained weights on the test set with the design matrix stored in every format and reports
+// how far the packed formats drift from the fp32 predictions.
+static void my_polynomial_validate_storage(MyGLReduce reduce[static 1], const MyPrecision precision, const MyMat xb_test[static 1], const MyMat y_test[static 1], const MyGLMat gl_weights[static 1]) {
+    const MyGLMat gl_y_test = mygl_mat_buffer_data(y_test, GL_STATIC_DRAW);
+    const MyGLReduceView y_view = mygl_reduce_view_all(&gl_y_test);
+    MyGLMat predictions[MY_GL_MAT_FORMAT_COUNT];
+    double f32_mse = 0.0;
+    my_range_for_zero(size_t, format, MY_GL_MAT_FORMAT_COUNT) {
+        GLuint shader_program, compute_shader;
+        mygl_matrix_mul_create_program(&shader_program, &compute_shader, (MyGLMatFormat)format, precision);
+        const MyGLMat gl_x = mygl_mat_buffer_data_format(xb_test, (MyGLMatFormat)format, GL_STATIC_DRAW);
+        predictions[format] = mygl_mat_buffer_data(&(MyMat){.rows = gl_x.rows, .cols = gl_weights->cols}, GL_DYNAMIC_COPY);
+        my_gl_dispatch_compute_mat_mul(shader_program, &gl_x, gl_weights, &predictions[format]);
+        ASSERT_GL(glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT));
+
+        const MyGLReduceView view = mygl_reduce_view_all(&predictions[format]);
+        const MyGLReduceView f32_view = mygl_reduce_view_all(&predictions[MY_GL_MAT_FORMAT_F32]);
+        const GLuint mse_slot = mygl_reduce_scalar(reduce, MY_GL_REDUCE_SQUARED_DIFF, &view, &y_view);
+        const GLuint deviation_slot = mygl_reduce_scalar(reduce, MY_GL_REDUCE_DIFF, &view, &f32_view);
+        const MyGLStats *const scalars = mygl_reduce_scalars_wait(reduce);
+
+        const double mse = (double)scalars[mse_slot].sum / (double)scalars[mse_slot].count;
+        if(format == MY_GL_MAT_FORMAT_F32) {
+            f32_mse = mse;
+        }
+        LOG(
+            "storage: %s, xb bytes: %zu, test mse: %lf, mse delta vs f32: %lf, max |prediction - f32 prediction|: %lf",
+            my_gl_mat_format_names[format],
+            my_gl_mat_format_bytes_count(format, my_mat_items_count(xb_test)),
+            mse,
+            mse - f32_mse,
+            fmax(fabs((double)scalars[deviation_slot].minimum), fabs((double)scalars[deviation_slot].maximum))
+        );
+
+        mygl_mat_delete(&gl_x);
+        ASSERT_GL(glDeleteShader(compute_shader));
+        ASSERT_GL(glDeleteProgram(shader_program));
+    }
+    my_range_for_zero(size_t, format, MY_GL_MAT_FORMAT_COUNT) {
+        mygl_mat_delete(&predictions[format]);
+    }
+    mygl_mat_delete(&gl_y_test);
+}
+
+#define MY_TRAIN_SWEEP_MAX 16
+
+typedef enum {
+    MY_TRAIN_BACKEND_GL,
+    MY_TRAIN_BACKEND_CPU,
+    MY_TRAIN_BACKEND_COUNT,
+} MyTrainBackend;
+
+static const char *const my_train_backend_names[MY_TRAIN_BACKEND_COUNT] = {
+    [MY_TRAIN_BACKEND_GL] = "gl",
+    [MY_TRAIN_BACKEND_CPU] = "cpu",
+};
+
+typedef enum {
+    MY_SCHEDULE_CONSTANT,
+    MY_SCHEDULE_STEP,
+    MY_SCHEDULE_COSINE,
+    MY_SCHEDULE_COUNT,
+} MySchedule;
+
+static const char *const my_schedule_names[MY_SCHEDULE_COUNT] = {
+    [MY_SCHEDULE_CONSTANT] = "constant",
+    [MY_SCHEDULE_STEP] = "step",
+    [MY_SCHEDULE_COSINE] = "cosine",
+};
+
+typedef enum {
+    MY_SOLVER_GD,
+    MY_SOLVER_CG,
+    MY_SOLVER_LBFGS,
+    MY_SOLVER_CD,
+    MY_SOLVER_CHOLESKY,
+    MY_SOLVER_COUNT,
+} MySolver;
+
+static const char *const my_solver_names[MY_SOLVER_COUNT] = {
+    [MY_SOLVER_GD] = "gd",
+    [MY_SOLVER_CG] = "cg",
+    [MY_SOLVER_LBFGS] = "lbfgs",
+    [MY_SOLVER_CD] = "cd",
+    [MY_SOLVER_CHOLESKY] = "cholesky",
+};
+
+#define MY_METRIC_RING_CAPACITY 4096
+
+// One epoch of one job of a device, `gflops` and `epoch_ms` cover every job the device ran in that epoch.
+typedef struct {
+    uint32_t job;
+    uint32_t degree;
+    GLfloat l2;
+    uint32_t epoch;
+    double mse;
+    double gradient_norm;
+    double epoch_ms;
+    double gflops;
+} MyTrainMetric;
+
+// Single producer, single consumer: the training thread of a device pushes and drops the metric when the ring is full,
+// the render loop pops whatever is there, so neither ever waits for the other.
+typedef struct {
+    _Alignas(64) atomic_size_t head;
+    _Alignas(64) atomic_size_t tail;
+    atomic_size_t dropped;
+    MyTrainMetric items[MY_METRIC_RING_CAPACITY];
+} MyMetricRing;
+
+// calloc only aligns to max_align_t, which would put head and tail back on a shared cache line.
+static MyMetricRing* my_metric_rings_create(const size_t count) {
+    MyMetricRing *const rings = (MyMetricRing*)aligned_alloc(_Alignof(MyMetricRing), count * sizeof(MyMetricRing));
+    ASSERT(rings);
+    memset(rings, 0, count * sizeof(MyMetricRing));
+    return rings;
+}
+
+static void my_metric_ring_push(MyMetricRing ring[static 1], const MyTrainMetric metric[static 1]) {
+    const size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    if(head - atomic_load_explicit(&ring->tail, memory_order_acquire) == MY_METRIC_RING_CAPACITY) {
+        atomic_fetch_add_explicit(&ring->dropped, 1, memory_order_relaxed);
+        return;
+    }
+    ring->items[head % MY_METRIC_RING_CAPACITY] = *metric;
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+}
+
+static bool my_metric_ring_pop(MyMetricRing ring[static 1], MyTrainMetric metric[static 1]) {
+    const size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    if(tail == atomic_load_explicit(&ring->head, memory_order_acquire)) {
+        return false;
+    }
+    *metric = ring->items[tail % MY_METRIC_RING_CAPACITY];
+    atomic_store_explicit(&ring->tail, tail + 1, memory_order_release);
+    return true;
+}
+
+#define MY_DIAGNOSTICS_BINS 64
+#define MY_DIAGNOSTICS_IMAGE_MAX 4096
+#define MY_DIAGNOSTICS_FRESH 4u
+
+// Residual histogram over [-range, range), the outermost bins also count what falls outside, and log10 |weight|
+// of every feature (columns) and power (rows) of one job, both computed on the GPU.
+typedef struct {
+    uint32_t job;
+    uint32_t epoch;
+    uint32_t rows;
+    uint32_t cols;
+    GLfloat range;
+    uint32_t bins[MY_DIAGNOSTICS_BINS];
+    GLfloat image[MY_DIAGNOSTICS_IMAGE_MAX];
+} MyDiagnosticsFrame;
+
+// Triple buffer of the latest diagnostics of one device: the training thread fills `back` and swaps it with `middle`,
+// the render loop swaps a fresh `middle` with `front`, so either side only ever touches its own frame.
+typedef struct {
+    MyDiagnosticsFrame frames[3];
+    atomic_uint middle;
+    unsigned back;
+    unsigned front;
+    // job the render loop wants to see
+    atomic_uint job;
+} MyDiagnosticsBuffer;
+
+static void my_diagnostics_buffer_init(MyDiagnosticsBuffer buffer[static 1]) {
+    buffer->back = 0;
+    atomic_init(&buffer->middle, 1u);
+    buffer->front = 2;
+    atomic_init(&buffer->job, 0u);
+}
+
+static void my_diagnostics_buffer_publish(MyDiagnosticsBuffer buffer[static 1]) {
+    buffer->back = atomic_exchange_explicit(&buffer->middle, buffer->back | MY_DIAGNOSTICS_FRESH, memory_order_acq_rel) & ~MY_DIAGNOSTICS_FRESH;
+}
+
+// Returns the newest frame, or NULL while nothing new was published.
+static const MyDiagnosticsFrame* my_diagnostics_buffer_take(MyDiagnosticsBuffer buffer[static 1]) {
+    if(!(atomic_load_explicit(&buffer->middle, memory_order_relaxed) & MY_DIAGNOSTICS_FRESH)) {
+        return NULL;
+    }
+    buffer->front = atomic_exchange_explicit(&buffer->middle, buffer->front, memory_order_acq_rel) & ~MY_DIAGNOSTICS_FRESH;
+    return &buffer->frames[buffer->front];
+}
+
+typedef struct {
+    MyTrainBackend backend;
+    MyGLMatFormat storage;
+    bool validate_storage;
+    MyPrecision precision;
+    size_t upload_block_rows;
+    // comma separated GL_RENDERER substrings, one training context per device
+    const char *device;
+    size_t epochs;
+    size_t degrees[MY_TRAIN_SWEEP_MAX];
+    size_t degrees_count;
+    GLfloat l2s[MY_TRAIN_SWEEP_MAX];
+    size_t l2s_count;
+    MyOptimizer optimizer;
+    // rows per mini-batch, 0 trains on the full batch
+    size_t batch_size;
+    MySchedule schedule;
+    GLfloat learning_rate;
+    // cg and lbfgs run at most `epochs` iterations and stop once the gradient norm falls below `tolerance` times its initial value,
+    // cholesky solves the normal equations of the whole sweep on the CPU
+    MySolver solver;
+    GLfloat tolerance;
+    // cd fits an elastic net path of `path_count` lambdas on the CPU, l1_ratio 1 is the lasso
+    GLfloat l1_ratio;
+    size_t path_count;
+    // k-fold cross-validation, every degree x l2 combination trains one job per fold, the jobs of a fold share its design matrix
+    size_t folds;
+    // total degree of the interaction monomials, 0 trains per-column powers; only the `top_k` best are fitted
+    size_t interactions;
+    size_t top_k;
+    // model file for the infer subcommand, with several degree x l2 combinations the folds pick the saved one
+    const char *model_path;
+    // gradient descent snapshots its jobs here every `checkpoint_every` epochs and after the last one,
+    // resume continues from the epochs the checkpoint had finished
+    const char *checkpoint_path;
+    size_t checkpoint_every;
+    bool resume;
+    // plots the training live, the dashboard sets one metric ring and one diagnostics buffer per device, NULL trains headless
+    bool dashboard;
+    MyMetricRing *metric_rings;
+    MyDiagnosticsBuffer *diagnostics;
+} MyTrainOptions;
+
+#define MY_PI 3.14159265358979323846
+
+// Learning rate of optimizer step `step` out of `steps_count`, step decays it tenfold at half and at three quarters of the steps.
+static GLfloat my_train_learning_rate(const MyTrainOptions options[static 1], const size_t step, const size_t steps_count) {
+    const double progress = (double)step / (double)steps_count;
+    switch(options->schedule) {
+        case MY_SCHEDULE_CONSTANT:
+            return options->learning_rate;
+        case MY_SCHEDULE_STEP:
+            return options->learning_rate * (progress < 0.5 ? 1.f : progress < 0.75 ? 0.1f : 0.01f);
+        case MY_SCHEDULE_COSINE:
+            return (GLfloat)((double)options->learning_rate * 0.5 * (1.0 + cos(MY_PI * progress)));
+        case MY_SCHEDULE_COUNT:
+        default:
+            ASSERT(false, "unknown schedule %d", (int)options->schedule);
+            return 0.f;
+    }
+}
+
+// One model of a sweep. The design matrix is built for the largest degree and its columns are ordered by degree,
+// so a lower degree model uses the first `cols` columns and keeps the remaining weights at zero.
+typedef struct {
+    size_t degree;
+    GLfloat l2;
+    GLuint cols;
+    MyGLMat weights;
+    MyGLMat predictions;
+    MyGLMat residuals;
+    MyGLMat gradient_stats;
+    // mini-batch residuals and the first and second moments of the optimizer, only allocated for mini-batch training
+    MyGLMat batch_residuals;
+    MyGLMat optimizer_state;
+    // rows held out by a cross-validation fold, empty when the job trains on every row
+    GLuint fold_first;
+    GLuint fold_end;
+    // host copy of the first `cols` weights once training ends, NULL when nobody reads them
+    GLfloat *trained_weights;
+    double mse;
+    double r2;
+    double fold_mse;
+} MyTrainJob;
+
+// The degree, l2, fold and host weights of `spec` are kept, its buffers are created.
+static MyTrainJob my_train_job_create(const MyTrainJob spec[static 1], const size_t features_count, const MyGLMat gl_xb[static 1], const size_t batch_size) {
+    MyTrainJob job = *spec;
+    job.cols = (GLuint)(features_count * spec->degree + 1);
+    job.weights = mygl_mat_buffer_data(&(MyMat){.rows = gl_xb->cols, .cols = 1}, GL_DYNAMIC_COPY);
+    job.predictions = mygl_mat_buffer_data(&(MyMat){.rows = gl_xb->rows, .cols = 1}, GL_DYNAMIC_COPY);
+    job.residuals = mygl_mat_buffer_data(&(MyMat){.rows = gl_xb->rows, .cols = 1}, GL_DYNAMIC_COPY);
+    job.gradient_stats = mygl_mat_buffer_data(&(MyMat){.rows = gl_xb->cols, .cols = MY_GL_STATS_FIELDS_COUNT}, GL_DYNAMIC_COPY);
+    ASSERT(job.cols <= gl_xb->cols);
+    const GLfloat value = 0.f;
+    ASSERT_GL(glBindBuffer(GL_SHADER_STORAGE_BUFFER, job.weights.ssb));
+        ASSERT_GL(glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32F, GL_RED, GL_FLOAT, &value));
+    ASSERT_GL(glBindBuffer(GL_SHADER_STORAGE_BUFFER, job.residuals.ssb));
+        ASSERT_GL(glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32F, GL_RED, GL_FLOAT, &value));
+    ASSERT_GL(glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0));
+    if(batch_size > 0) {
+        job.batch_residuals = mygl_mat_buffer_data(&(MyMat){.rows = batch_size, .cols = 1}, GL_DYNAMIC_COPY);
+        job.optimizer_state = mygl_mat_buffer_data(&(MyMat){.rows = 2, .cols = gl_xb->cols}, GL_DYNAMIC_COPY);
+        ASSERT_GL(glBindBuffer(GL_SHADER_STORAGE_BUFFER, job.optimizer_state.ssb));
+            ASSERT_GL(glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32F, GL_RED, GL_FLOAT, &value));
+        ASSERT_GL(glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0));
+    }
+    return job;
+}
+
+static void my_train_job_destroy(MyTrainJob job[static 1]) {
+    mygl_mat_delete(&job->weights);
+    mygl_mat_delete(&job->predictions);
+    mygl_mat_delete(&job->residuals);
+    mygl_mat_delete(&job->gradient_stats);
+    mygl_mat_delete(&job->batch_residuals);
+    mygl_mat_delete(&job->optimizer_state);
+}
+
+// Every job queued on a device shares its uploaded data and programs. The worker thread runs on a context
+// shared with the upload context and issues one epoch of every job before it waits for their scalars.
+typedef struct {
+    const MyTrainOptions *options;
+    MyGLContext upload_context;
+    MyGLContext context;
+    pthread_t worker;
+    MyPrecision precision;
+    MyGLMat gl_xb;
+    MyGLMat gl_y;
+    GLuint shader_program_mul_mat;
+    GLuint compute_shader_mul_mat;
+    GLuint shader_program_axpby;
+    GLuint compute_shader_axpby;
+    // rows per mini-batch, 0 runs full-batch gradient descent
+    size_t batch_size;
+    GLuint shader_programs_minibatch[MY_MINIBATCH_STAGE_COUNT];
+    GLuint compute_shaders_minibatch[MY_MINIBATCH_STAGE_COUNT];
+    MyGLMat gl_indices;
+    MyTrainJob *jobs;
+    size_t jobs_count;
+    const MyMat *xb_test;
+    const MyMat *y_test;
+    double start_ms;
+    size_t features_count;
+    size_t degree;
+    const MyMat *scaler;
+    // first epoch to run, past the epochs of a resumed checkpoint
+    size_t epoch_first;
+    MyMetricRing *metrics;
+    MyDiagnosticsBuffer *diagnostics;
+} MyTrainDevice;
+
+#define MY_TRAIN_LEARNING_RATE 0.05f
+
+static GLuint my_train_job_rows(const MyTrainDevice device[static 1], const MyTrainJob job[static 1]) {
+    return device->gl_xb.rows - (job->fold_end - job->fold_first);
+}
+
+// Full-batch residuals of the current weights, returns the slot of their squared sum. The residuals of held out rows
+// are never written and stay zero, so neither the loss nor the gradient sees them.
+static GLuint my_train_job_residuals(const MyTrainDevice device[static 1], const MyTrainJob job[static 1], MyGLReduce reduce[static 1], const bool forward) {
+    const MyGLReduceView residuals_view = mygl_reduce_view_all(&job->residuals);
+    if(forward) {
+        my_gl_dispatch_compute_mat_mul(device->shader_program_mul_mat, &device->gl_xb, &job->weights, &job->predictions);
+    }
+    ASSERT_GL(glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT));
+    const GLuint segments[2][2] = {{0, job->fold_first}, {job->fold_end, job->residuals.rows}};
+    my_range_for_zero(size_t, i, my_array_count(segments)) {
+        const GLuint first = segments[i][0], n = segments[i][1] - segments[i][0];
+        if(n > 0) {
+            my_gl_dispatch_compute_axpby(device->shader_program_axpby, job->residuals.ssb, first, n, 1.f, job->predictions.ssb, first, 1, -1.f, device->gl_y.ssb, first, 1);
+        }
+    }
+    ASSERT_GL(glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT));
+    return mygl_reduce_scalar(reduce, MY_GL_REDUCE_SQUARE, &residuals_view, NULL);
+}
+
+// Squared error of the held out rows of a cross-validation job, the predictions are refreshed for those rows only.
+static GLuint my_train_job_fold_loss(const MyTrainDevice device[static 1], const MyTrainJob job[static 1], MyGLReduce reduce[static 1]) {
+    ASSERT(job->fold_first < job->fold_end);
+    my_gl_dispatch_compute_mat_mul_rows(device->shader_program_mul_mat, &device->gl_xb, &job->weights, &job->predictions, job->fold_first, job->fold_end);
+    ASSERT_GL(glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT));
+    MyGLReduceView predictions_view = mygl_reduce_view_all(&job->predictions);
+    predictions_view.offset = job->fold_first;
+    predictions_view.line_length = job->fold_end - job->fold_first;
+    MyGLReduceView y_view = mygl_reduce_view_all(&device->gl_y);
+    y_view.offset = job->fold_first;
+    y_view.line_length = job->fold_end - job->fold_first;
+    return mygl_reduce_scalar(reduce, MY_GL_REDUCE_SQUARED_DIFF, &predictions_view, &y_view);
+}
+
+static void my_train_job_epoch(
+    const MyTrainDevice device[static 1],
+    const MyTrainJob job[static 1],
+    MyGLReduce reduce[static 1],
+    const bool forward,
+    const GLfloat learning_rate,
+    GLuint loss_slot[static 1],
+    GLuint gradient_slot[static 1]
+) {
+    const GLuint rows = my_train_job_rows(device, job);
+    const GLfloat gradient_scale = 2.f / (GLfloat)rows;
+    MyGLReduceView xb_cols_view = mygl_reduce_view_cols(&device->gl_xb);
+    xb_cols_view.line_count = job->cols;
+    const MyGLReduceView residuals_broadcast_view = mygl_reduce_view_broadcast(&job->residuals);
+    MyGLReduceView gradient_view = mygl_reduce_view_col(&job->gradient_stats, 0);
+    gradient_view.line_length = job->cols;
+
+    *loss_slot = my_train_job_residuals(device, job, reduce, forward);
+    mygl_reduce(reduce, MY_GL_REDUCE_PRODUCT, &xb_cols_view, &residuals_broadcast_view, job->gradient_stats.ssb, 0);
+    ASSERT_GL(glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT));
+    *gradient_slot = mygl_reduce_scalar(reduce, MY_GL_REDUCE_SQUARE, &gradient_view, NULL);
+    // w -= lr * (gradient + 2 * l2 * w), the intercept is not regularized
+    const GLfloat step = -learning_rate * gradient_scale;
+    my_gl_dispatch_compute_axpby(device->shader_program_axpby, job->weights.ssb, 0, 1, 1.f, job->weights.ssb, 0, 1, step, job->gradient_stats.ssb, 0, MY_GL_STATS_FIELDS_COUNT);
+    my_gl_dispatch_compute_axpby(
+        device->shader_program_axpby, job->weights.ssb, 1, job->cols - 1,
+        1.f - 2.f * learning_rate * job->l2, job->weights.ssb, 1, 1,
+        step, job->gradient_stats.ssb, MY_GL_STATS_FIELDS_COUNT, MY_GL_STATS_FIELDS_COUNT
+    );
+    ASSERT_GL(glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT));
+}
+
+// Solver vectors hold one float per design matrix column and every operation only touches the first `count` items,
+// the columns a job does not use stay zero. Each helper ends with a barrier, so its result can be read right away.
+static MyGLMat my_gl_vec_create(const GLuint count) {
+    const MyGLMat vec = mygl_mat_buffer_data(&(MyMat){.rows = count, .cols = 1}, GL_DYNAMIC_COPY);
+    const GLfloat value = 0.f;
+    ASSERT_GL(glBindBuffer(GL_SHADER_STORAGE_BUFFER, vec.ssb));
+        ASSERT_GL(glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32F, GL_RED, GL_FLOAT, &value));
+    ASSERT_GL(glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0));
+    return vec;
+}
+
+// r = alpha * a + beta * b
+static void my_gl_vec_axpby(
+    const MyTrainDevice device[static 1],
+    const GLuint count,
+    const MyGLMat r[static 1],
+    const GLfloat alpha,
+    const MyGLMat a[static 1],
+    const GLfloat beta,
+    const MyGLMat b[static 1]
+) {
+    my_gl_dispatch_compute_axpby(device->shader_program_axpby, r->ssb, 0, count, alpha, a->ssb, 0, 1, beta, b->ssb, 0, 1);
+    ASSERT_GL(glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT));
+}
+
+static GLuint my_gl_vec_dot(MyGLReduce reduce[static 1], const GLuint count, const MyGLMat a[static 1], const MyGLMat b[static 1]) {
+    MyGLReduceView a_view = mygl_reduce_view_all(a);
+    MyGLReduceView b_view = mygl_reduce_view_all(b);
+    a_view.line_length = count;
+    b_view.line_length = count;
+    return mygl_reduce_scalar(reduce, MY_GL_REDUCE_PRODUCT, &a_view, &b_view);
+}
+
+// With `residual` set, result = 2 / rows * X^T (X v - y) + 2 * l2 * D v is the gradient of the objective at v.
+// Without it, y is dropped and result is the normal equations matrix times v. D skips the intercept.
+// Returns the slot of the squared sum of X v - y, or of X v without `residual`.
+static GLuint my_train_job_normal_apply(
+    const MyTrainDevice device[static 1],
+    const MyTrainJob job[static 1],
+    MyGLReduce reduce[static 1],
+    const MyGLMat v[static 1],
+    const MyGLMat result[static 1],
+    const bool residual
+) {
+    const GLfloat gradient_scale = 2.f / (GLfloat)device->gl_xb.rows;
+    MyGLReduceView xb_cols_view = mygl_reduce_view_cols(&device->gl_xb);
+    xb_cols_view.line_count = job->cols;
+    const MyGLMat *const lhs = residual ? &job->residuals : &job->predictions;
+    const MyGLReduceView lhs_view = mygl_reduce_view_all(lhs);
+    const MyGLReduceView lhs_broadcast_view = mygl_reduce_view_broadcast(lhs);
+
+    my_gl_dispatch_compute_mat_mul(device->shader_program_mul_mat, &device->gl_xb, v, &job->predictions);
+    ASSERT_GL(glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT));
+    if(residual) {
+        my_gl_dispatch_compute_axpby(device->shader_program_axpby, job->residuals.ssb, 0, job->residuals.rows, 1.f, job->predictions.ssb, 0, 1, -1.f, device->gl_y.ssb, 0, 1);
+        ASSERT_GL(glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT));
+    }
+    mygl_reduce(reduce, MY_GL_REDUCE_PRODUCT, &xb_cols_view, &lhs_broadcast_view, job->gradient_stats.ssb, 0);
+    const GLuint slot = mygl_reduce_scalar(reduce, MY_GL_REDUCE_SQUARE, &lhs_view, NULL);
+    ASSERT_GL(glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT));
+    my_gl_dispatch_compute_axpby(device->shader_program_axpby, result->ssb, 0, 1, 0.f, v->ssb, 0, 1, gradient_scale, job->gradient_stats.ssb, 0, MY_GL_STATS_FIELDS_COUNT);
+    my_gl_dispatch_compute_axpby(
+        device->shader_program_axpby, result->ssb, 1, job->cols - 1,
+        2.f * job->l2, v->ssb, 1, 1,
+        gradient_scale, job->gradient_stats.ssb, MY_GL_STATS_FIELDS_COUNT, MY_GL_STATS_FIELDS_COUNT
+    );
+    ASSERT_GL(glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT));
+    return slot;
+}
+
+typedef struct {
+    size_t iterations;
+    bool converged;
+    double gradient_norm;
+} MySolveResult;
+
+// Conjugate gradients on the normal equations, starting from the job weights, until the gradient norm drops
+// below `tolerance` times its initial value. Only the scalars of the dot products are read back.
+static MySolveResult my_train_job_solve_cg(const MyTrainDevice device[static 1], MyTrainJob job[static 1], MyGLReduce reduce[static 1]) {
+    const MyTrainOptions *const options = device->options;
+    const GLuint cols = job->cols;
+    MyGLMat r = my_gl_vec_create(device->gl_xb.cols);
+    MyGLMat p = my_gl_vec_create(device->gl_xb.cols);
+    MyGLMat ap = my_gl_vec_create(device->gl_xb.cols);
+
+    // r = b - A w is the negative gradient
+    my_train_job_normal_apply(device, job, reduce, &job->weights, &r, true);
+    my_gl_vec_axpby(device, cols, &r, -1.f, &r, 0.f, &r);
+    my_gl_vec_axpby(device, cols, &p, 1.f, &r, 0.f, &r);
+    GLuint slot = my_gl_vec_dot(reduce, cols, &r, &r);
+    double rs = (double)mygl_reduce_scalars_wait(reduce)[slot].sum;
+    const double threshold = (double)options->tolerance * sqrt(rs);
+
+    MySolveResult result = {0};
+    while(!(result.converged = sqrt(rs) <= threshold) && result.iterations < options->epochs) {
+        my_train_job_normal_apply(device, job, reduce, &p, &ap, false);
+        slot = my_gl_vec_dot(reduce, cols, &p, &ap);
+        const double pap = (double)mygl_reduce_scalars_wait(reduce)[slot].sum;
+        if(pap <= 0.0) {
+            break;
+        }
+        const GLfloat alpha = (GLfloat)(rs / pap);
+        my_gl_vec_axpby(device, cols, &job->weights, 1.f, &job->weights, alpha, &p);
+        my_gl_vec_axpby(device, cols, &r, 1.f, &r, -alpha, &ap);
+        slot = my_gl_vec_dot(reduce, cols, &r, &r);
+        const double rs_next = (double)mygl_reduce_scalars_wait(reduce)[slot].sum;
+        my_gl_vec_axpby(device, cols, &p, 1.f, &r, (GLfloat)(rs_next / rs), &p);
+        rs = rs_next;
+        result.iterations++;
+    }
+    result.gradient_norm = sqrt(rs);
+
+    mygl_mat_delete(&r);
+    mygl_mat_delete(&p);
+    mygl_mat_delete(&ap);
+    return result;
+}
+
+#define MY_LBFGS_HISTORY 8
+#define MY_LBFGS_ARMIJO 1e-4
+#define MY_LBFGS_BACKTRACKS_MAX 30
+
+// Objective of my_train_job_normal_apply at `w`: the mse plus the l2 penalty of every weight but the intercept.
+// The gradient at `w` is written to `gradient`.
+static double my_train_job_objective(
+    const MyTrainDevice device[static 1],
+    const MyTrainJob job[static 1],
+    MyGLReduce reduce[static 1],
+    const MyGLMat w[static 1],
+    const MyGLMat gradient[static 1]
+) {
+    const GLuint loss_slot = my_train_job_normal_apply(device, job, reduce, w, gradient, true);
+    MyGLReduceView penalty_view = mygl_reduce_view_all(w);
+    penalty_view.offset = 1;
+    penalty_view.line_length = job->cols - 1;
+    const GLuint penalty_slot = mygl_reduce_scalar(reduce, MY_GL_REDUCE_SQUARE, &penalty_view, NULL);
+    const MyGLStats *const scalars = mygl_reduce_scalars_wait(reduce);
+    return (double)scalars[loss_slot].sum / (double)device->gl_xb.rows + (double)job->l2 * (double)scalars[penalty_slot].sum;
+}
+
+// L-BFGS with the two-loop recursion over the last MY_LBFGS_HISTORY steps and a backtracking Armijo line search.
+static MySolveResult my_train_job_solve_lbfgs(const MyTrainDevice device[static 1], MyTrainJob job[static 1], MyGLReduce reduce[static 1]) {
+    const MyTrainOptions *const options = device->options;
+    const GLuint cols = job->cols;
+    MyGLMat s[MY_LBFGS_HISTORY], y[MY_LBFGS_HISTORY];
+    double rho[MY_LBFGS_HISTORY], alpha[MY_LBFGS_HISTORY];
+    my_range_for_zero(size_t, i, MY_LBFGS_HISTORY) {
+        s[i] = my_gl_vec_create(device->gl_xb.cols);
+        y[i] = my_gl_vec_create(device->gl_xb.cols);
+    }
+    MyGLMat gradient = my_gl_vec_create(device->gl_xb.cols);
+    MyGLMat next_gradient = my_gl_vec_create(device->gl_xb.cols);
+    MyGLMat next_w = my_gl_vec_create(device->gl_xb.cols);
+    MyGLMat direction = my_gl_vec_create(device->gl_xb.cols);
+    MyGLMat next_s = my_gl_vec_create(device->gl_xb.cols);
+    MyGLMat next_y = my_gl_vec_create(device->gl_xb.cols);
+    size_t history_count = 0, history_newest = 0;
+    double gamma = 1.0;
+
+    double objective = my_train_job_objective(device, job, reduce, &job->weights, &gradient);
+    GLuint slot = my_gl_vec_dot(reduce, cols, &gradient, &gradient);
+    double gradient_norm = sqrt((double)mygl_reduce_scalars_wait(reduce)[slot].sum);
+    const double threshold = (double)options->tolerance * gradient_norm;
+
+    MySolveResult result = {0};
+    while(!(result.converged = gradient_norm <= threshold) && result.iterations < options->epochs) {
+        // direction = H gradient, the step is -t * direction
+        my_gl_vec_axpby(device, cols, &direction, 1.f, &gradient, 0.f, &gradient);
+        my_range_for_zero(size_t, k, history_count) {
+            const size_t i = (history_newest + MY_LBFGS_HISTORY - k) % MY_LBFGS_HISTORY;
+            slot = my_gl_vec_dot(reduce, cols, &s[i], &direction);
+            alpha[i] = rho[i] * (double)mygl_reduce_scalars_wait(reduce)[slot].sum;
+            my_gl_vec_axpby(device, cols, &direction, 1.f, &direction, (GLfloat)-alpha[i], &y[i]);
+        }
+        my_gl_vec_axpby(device, cols, &direction, (GLfloat)gamma, &direction, 0.f, &direction);
+        my_range_for_zero(size_t, k, history_count) {
+            const size_t i = (history_newest + MY_LBFGS_HISTORY - (history_count - 1 - k)) % MY_LBFGS_HISTORY;
+            slot = my_gl_vec_dot(reduce, cols, &y[i], &direction);
+            const double beta = rho[i] * (double)mygl_reduce_scalars_wait(reduce)[slot].sum;
+            my_gl_vec_axpby(device, cols, &direction, 1.f, &direction, (GLfloat)(alpha[i] - beta), &s[i]);
+        }
+        slot = my_gl_vec_dot(reduce, cols, &gradient, &direction);
+        double descent = (double)mygl_reduce_scalars_wait(reduce)[slot].sum;
+        if(descent <= 0.0) {
+            // not a descent direction, restart from steepest descent
+            history_count = 0;
+            gamma = 1.0;
+            my_gl_vec_axpby(device, cols, &direction, 1.f, &gradient, 0.f, &gradient);
+            descent = gradient_norm * gradient_norm;
+        }
+
+        double step = 1.0, next_objective = objective;
+        bool accepted = false;
+        my_range_for_zero(size_t, backtrack, MY_LBFGS_BACKTRACKS_MAX) {
+            my_gl_vec_axpby(device, cols, &next_w, 1.f, &job->weights, (GLfloat)-step, &direction);
+            next_objective = my_train_job_objective(device, job, reduce, &next_w, &next_gradient);
+            if(next_objective <= objective - MY_LBFGS_ARMIJO * step * descent) {
+                accepted = true;
+                break;
+            }
+            step *= 0.5;
+        }
+        if(!accepted) {
+            break;
+        }
+
+        my_gl_vec_axpby(device, cols, &next_s, 1.f, &next_w, -1.f, &job->weights);
+        my_gl_vec_axpby(device, cols, &next_y, 1.f, &next_gradient, -1.f, &gradient);
+        const GLuint sy_slot = my_gl_vec_dot(reduce, cols, &next_s, &next_y);
+        const GLuint yy_slot = my_gl_vec_dot(reduce, cols, &next_y, &next_y);
+        const GLuint gg_slot = my_gl_vec_dot(reduce, cols, &next_gradient, &next_gradient);
+        const MyGLStats *const scalars = mygl_reduce_scalars_wait(reduce);
+        const double sy = (double)scalars[sy_slot].sum, yy = (double)scalars[yy_slot].sum;
+        gradient_norm = sqrt((double)scalars[gg_slot].sum);
+        // pairs without positive curvature would make H indefinite and are dropped, the ring keeps its oldest pair then
+        if(sy > 0.0 && yy > 0.0) {
+            history_newest = history_count == 0 ? 0 : (history_newest + 1) % MY_LBFGS_HISTORY;
+            const MyGLMat evicted_s = s[history_newest], evicted_y = y[history_newest];
+            s[history_newest] = next_s;
+            y[history_newest] = next_y;
+            next_s = evicted_s;
+            next_y = evicted_y;
+            rho[history_newest] = 1.0 / sy;
+            gamma = sy / yy;
+            history_count += history_count < MY_LBFGS_HISTORY ? 1 : 0;
+        }
+        my_gl_vec_axpby(device, cols, &job->weights, 1.f, &next_w, 0.f, &next_w);
+        my_gl_vec_axpby(device, cols, &gradient, 1.f, &next_gradient, 0.f, &next_gradient);
+        objective = next_objective;
+        result.iterations++;
+    }
+    result.gradient_norm = gradient_norm;
+
+    my_range_for_zero(size_t, i, MY_LBFGS_HISTORY) {
+        mygl_mat_delete(&s[i]);
+        mygl_mat_delete(&y[i]);
+    }
+    mygl_mat_delete(&gradient);
+    mygl_mat_delete(&next_gradient);
+    mygl_mat_delete(&next_w);
+    mygl_mat_delete(&direction);
+    mygl_mat_delete(&next_s);
+    mygl_mat_delete(&next_y);
+    return result;
+}
+
+// One pass over a GPU shuffled permutation of the rows, every batch is one optimizer step of every job.
+static void my_train_device_minibatch_epoch(const MyTrainDevice device[static 1], const size_t epoch) {
+    const MyTrainOptions *const options = device->options;
+    const GLuint rows = device->gl_xb.rows;
+    const size_t batches_count = (rows + device->batch_size - 1) / device->batch_size;
+    my_gl_dispatch_compute_shuffle(device->shader_programs_minibatch[MY_MINIBATCH_STAGE_SHUFFLE], device->gl_indices.ssb, rows, (GLuint)(epoch + 1) * 0x9e3779b9u);
+    ASSERT_GL(glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT));
+    my_range_for_zero(size_t, batch, batches_count) {
+        const GLuint batch_offset = (GLuint)(batch * device->batch_size);
+        const GLuint batch_size = rows - batch_offset < device->batch_size ? rows - batch_offset : (GLuint)device->batch_size;
+        const size_t step = epoch * batches_count + batch;
+        const GLfloat learning_rate = my_train_learning_rate(options, step, options->epochs * batches_count);
+        my_range_for_zero(size_t, i, device->jobs_count) {
+            const MyTrainJob *const job = &device->jobs[i];
+            my_gl_dispatch_compute_minibatch_forward(
+                device->shader_programs_minibatch[MY_MINIBATCH_STAGE_FORWARD], &device->gl_xb, &device->gl_y, device->gl_indices.ssb,
+                batch_offset, batch_size, job->weights.ssb, job->cols, job->batch_residuals.ssb
+            );
+        }
+        ASSERT_GL(glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT));
+        my_range_for_zero(size_t, i, device->jobs_count) {
+            const MyTrainJob *const job = &device->jobs[i];
+            my_gl_dispatch_compute_minibatch_update(
+                device->shader_programs_minibatch[MY_MINIBATCH_STAGE_UPDATE], options->optimizer, &device->gl_xb, device->gl_indices.ssb,
+                batch_offset, batch_size, job->batch_residuals.ssb, job->weights.ssb, job->optimizer_state.ssb, job->cols, learning_rate, job->l2, step + 1
+            );
+        }
+        ASSERT_GL(glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT));
+    }
+}
+
+#define MY_CHECKPOINT_MAGIC "mypolyck"
+#define MY_CHECKPOINT_ALIGN 64
+#define MY_CHECKPOINT_SLOTS 2
+#define my_checkpoint_align(bytes) (((bytes) + MY_CHECKPOINT_ALIGN - 1) / MY_CHECKPOINT_ALIGN * MY_CHECKPOINT_ALIGN)
+
+// Checkpoint file of the jobs of one device. Sections start at multiples of MY_CHECKPOINT_ALIGN, so a read-only mapping
+// is used in place: header, scaler (2 x features_count * degree), job table, weights (jobs x cols) and, for the moment
+// optimizers, their state (jobs x 2 x cols).
+typedef struct {
+    char magic[8];
+    uint32_t features_count;
+    uint32_t degree;
+    uint32_t jobs_count;
+    uint32_t cols;
+    // epochs finished when the snapshot was taken
+    uint32_t epochs;
+    uint32_t optimizer;
+    uint32_t has_optimizer_state;
+    uint8_t padding[MY_CHECKPOINT_ALIGN - 36];
+} MyCheckpointHeader;
+
+_Static_assert(sizeof(MyCheckpointHeader) == MY_CHECKPOINT_ALIGN, "the checkpoint header is one section");
+
+typedef struct {
+    uint32_t degree;
+    GLfloat l2;
+} MyCheckpointJob;
+
+typedef struct {
+    size_t scaler;
+    size_t jobs;
+    size_t weights;
+    size_t optimizer_state;
+    size_t end;
+} MyCheckpointLayout;
+
+static MyCheckpointLayout my_checkpoint_layout(const MyCheckpointHeader header[static 1]) {
+    MyCheckpointLayout layout = {.scaler = sizeof(*header)};
+    layout.jobs = my_checkpoint_align(layout.scaler + 2 * (size_t)header->features_count * header->degree * sizeof(GLfloat));
+    layout.weights = my_checkpoint_align(layout.jobs + header->jobs_count * sizeof(MyCheckpointJob));
+    layout.optimizer_state = my_checkpoint_align(layout.weights + (size_t)header->jobs_count * header->cols * sizeof(GLfloat));
+    layout.end = my_checkpoint_align(layout.optimizer_state + (header->has_optimizer_state ? 2 * (size_t)header->jobs_count * header->cols * sizeof(GLfloat) : 0));
+    return layout;
+}
+
+typedef enum {
+    MY_CHECKPOINT_SLOT_FREE,
+    MY_CHECKPOINT_SLOT_COPYING,
+    MY_CHECKPOINT_SLOT_WRITING,
+} MyCheckpointSlotState;
+
+// Snapshots copy the job buffers into a slot of a persistent-mapped staging buffer on the GPU timeline and fence it.
+// The training thread polls the fences between epochs and hands signaled slots to a writer thread, which writes a
+// temporary file and renames it over `path`, so training never waits on the copy or the disk and the file is always whole.
+// A periodic snapshot is skipped while every slot is still busy, the final one waits for a slot.
+typedef struct {
+    const char *path;
+    const MyMat *scaler;
+    MyCheckpointHeader header;
+    MyCheckpointLayout layout;
+    MyCheckpointJob *jobs;
+    // weights and optimizer state of every job, laid out as in the file from layout.weights on
+    size_t slot_bytes_count;
+    GLuint staging_ssb;
+    char *staging;
+    GLsync fences[MY_CHECKPOINT_SLOTS];
+    uint32_t epochs[MY_CHECKPOINT_SLOTS];
+    MyCheckpointSlotState states[MY_CHECKPOINT_SLOTS];
+    pthread_t writer;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    bool done;
+} MyCheckpointer;
+
+static void my_checkpointer_write(MyCheckpointer checkpointer[static 1], const size_t slot) {
+    const double start_ms = my_time_ms();
+    char tmp_path[4096];
+    ASSERT((size_t)snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", checkpointer->path) < sizeof(tmp_path));
+    MyCheckpointHeader header = checkpointer->header;
+    header.epochs = checkpointer->epochs[slot];
+    const int fd = open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    ASSERT_NOT_MINUS_ONE(fd, "%s", tmp_path);
+    ASSERT_NOT_MINUS_ONE(ftruncate(fd, (off_t)checkpointer->layout.end));
+    const size_t scaler_cols = (size_t)header.features_count * header.degree;
+    #define LOCAL_MACRO(data, bytes_count, offset) ASSERT(pwrite(fd, (data), (bytes_count), (off_t)(offset)) == (ssize_t)(bytes_count))
+        LOCAL_MACRO(&header, sizeof(header), 0);
+        LOCAL_MACRO(&my_mat_row(checkpointer->scaler, 0), scaler_cols * sizeof(GLfloat), checkpointer->layout.scaler);
+        LOCAL_MACRO(&my_mat_row(checkpointer->scaler, 1), scaler_cols * sizeof(GLfloat), checkpointer->layout.scaler + scaler_cols * sizeof(GLfloat));
+        LOCAL_MACRO(checkpointer->jobs, header.jobs_count * sizeof(MyCheckpointJob), checkpointer->layout.jobs);
+        LOCAL_MACRO(checkpointer->staging + slot * checkpointer->slot_bytes_count, checkpointer->slot_bytes_count, checkpointer->layout.weights);
+    #undef LOCAL_MACRO
+    ASSERT_NOT_MINUS_ONE(fdatasync(fd));
+    ASSERT_NOT_MINUS_ONE(close(fd));
+    ASSERT_NOT_MINUS_ONE(rename(tmp_path, checkpointer->path));
+    LOG("checkpoint: %s, epochs: %u, bytes: %zu, write ms: %lf", checkpointer->path, header.epochs, checkpointer->layout.end, my_time_ms() - start_ms);
+}
+
+static void* my_checkpointer_writer(void *const arg) {
+    MyCheckpointer *const checkpointer = (MyCheckpointer*)arg;
+    ASSERT(pthread_mutex_lock(&checkpointer->mutex) == 0);
+    while(true) {
+        // the oldest pending snapshot goes first, so the file only moves forward
+        size_t slot = MY_CHECKPOINT_SLOTS;
+        my_range_for_zero(size_t, i, MY_CHECKPOINT_SLOTS) {
+            if(checkpointer->states[i] == MY_CHECKPOINT_SLOT_WRITING && (slot == MY_CHECKPOINT_SLOTS || checkpointer->epochs[i] < checkpointer->epochs[slot])) {
+                slot = i;
+            }
+        }
+        if(slot == MY_CHECKPOINT_SLOTS) {
+            if(checkpointer->done) {
+                break;
+            }
+            ASSERT(pthread_cond_wait(&checkpointer->cond, &checkpointer->mutex) == 0);
+            continue;
+        }
+        ASSERT(pthread_mutex_unlock(&checkpointer->mutex) == 0);
+        my_checkpointer_write(checkpointer, slot);
+        ASSERT(pthread_mutex_lock(&checkpointer->mutex) == 0);
+        checkpointer->states[slot] = MY_CHECKPOINT_SLOT_FREE;
+        // a final snapshot may be waiting for the slot
+        ASSERT(pthread_cond_broadcast(&checkpointer->cond) == 0);
+    }
+    ASSERT(pthread_mutex_unlock(&checkpointer->mutex) == 0);
+    return NULL;
+}
+
+// Runs on the training thread's context.
+static void my_checkpointer_start(
+    MyCheckpointer checkpointer[static 1],
+    const char path[static 1],
+    const MyTrainJob *const jobs,
+    const size_t jobs_count,
+    const MyGLMat gl_xb[static 1],
+    const size_t features_count,
+    const size_t degree,
+    const MyMat scaler[static 1],
+    const MyOptimizer optimizer
+) {
+    *checkpointer = (MyCheckpointer){
+        .path = path,
+        .scaler = scaler,
+        .header = {
+            .features_count = (uint32_t)features_count,
+            .degree = (uint32_t)degree,
+            .jobs_count = (uint32_t)jobs_count,
+            .cols = gl_xb->cols,
+            .optimizer = (uint32_t)optimizer,
+            .has_optimizer_state = jobs_count > 0 && jobs[0].optimizer_state.ssb != 0,
+        },
+        .jobs = (MyCheckpointJob*)malloc(jobs_count * sizeof(MyCheckpointJob)),
+    };
+    memcpy(checkpointer->header.magic, MY_CHECKPOINT_MAGIC, sizeof(checkpointer->header.magic));
+    ASSERT(checkpointer->jobs);
+    my_range_for_zero(size_t, i, jobs_count) {
+        checkpointer->jobs[i] = (MyCheckpointJob){.degree = (uint32_t)jobs[i].degree, .l2 = jobs[i].l2};
+    }
+    checkpointer->layout = my_checkpoint_layout(&checkpointer->header);
+    checkpointer->slot_bytes_count = checkpointer->layout.end - checkpointer->layout.weights;
+
+    const GLsizeiptr staging_bytes_count = (GLsizeiptr)(MY_CHECKPOINT_SLOTS * checkpointer->slot_bytes_count);
+    const GLbitfield flags = GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    ASSERT_GL(glGenBuffers(1, &checkpointer->staging_ssb));
+    ASSERT_GL(glBindBuffer(GL_COPY_WRITE_BUFFER, checkpointer->staging_ssb));
+        ASSERT_GL(glBufferStorage(GL_COPY_WRITE_BUFFER, staging_bytes_count, NULL, flags));
+        ASSERT_GL(checkpointer->staging = (char*)glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, staging_bytes_count, flags));
+    ASSERT_GL(glBindBuffer(GL_COPY_WRITE_BUFFER, 0));
+    ASSERT(checkpointer->staging);
+    ASSERT(pthread_mutex_init(&checkpointer->mutex, NULL) == 0);
+    ASSERT(pthread_cond_init(&checkpointer->cond, NULL) == 0);
+    ASSERT(pthread_create(&checkpointer->writer, NULL, my_checkpointer_writer, checkpointer) == 0);
+}
+
+// Hands the slots whose copies finished to the writer, with `wait` it blocks until no copy is pending.
+static void my_checkpointer_poll(MyCheckpointer checkpointer[static 1], const bool wait) {
+    ASSERT(pthread_mutex_lock(&checkpointer->mutex) == 0);
+    my_range_for_zero(size_t, slot, MY_CHECKPOINT_SLOTS) {
+        if(checkpointer->states[slot] != MY_CHECKPOINT_SLOT_COPYING) {
+            continue;
+        }
+        GLenum status;
+        do {
+            ASSERT_GL(status = glClientWaitSync(checkpointer->fences[slot], GL_SYNC_FLUSH_COMMANDS_BIT, wait ? 1000 * 1000 * 1000 : 0));
+            ASSERT(status != GL_WAIT_FAILED);
+        } while(wait && status == GL_TIMEOUT_EXPIRED);
+        if(status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED) {
+            ASSERT_GL(glDeleteSync(checkpointer->fences[slot]));
+            checkpointer->states[slot] = MY_CHECKPOINT_SLOT_WRITING;
+            ASSERT(pthread_cond_broadcast(&checkpointer->cond) == 0);
+        }
+    }
+    ASSERT(pthread_mutex_unlock(&checkpointer->mutex) == 0);
+}
+
+// With `wait` it blocks until a slot is free instead of skipping the snapshot.
+static void my_checkpointer_snapshot(MyCheckpointer checkpointer[static 1], const MyTrainJob *const jobs, const size_t epochs, const bool wait) {
+    // copies still in flight can only free a slot once they are handed to the writer
+    my_checkpointer_poll(checkpointer, wait);
+    size_t slot = MY_CHECKPOINT_SLOTS;
+    ASSERT(pthread_mutex_lock(&checkpointer->mutex) == 0);
+    while(true) {
+        my_range_for_zero(size_t, i, MY_CHECKPOINT_SLOTS) {
+            slot = slot == MY_CHECKPOINT_SLOTS && checkpointer->states[i] == MY_CHECKPOINT_SLOT_FREE ? i : slot;
+        }
+        if(slot != MY_CHECKPOINT_SLOTS || !wait) {
+            break;
+        }
+        ASSERT(pthread_cond_wait(&checkpointer->cond, &checkpointer->mutex) == 0);
+    }
+    ASSERT(pthread_mutex_unlock(&checkpointer->mutex) == 0);
+    if(slot == MY_CHECKPOINT_SLOTS) {
+        LOG("checkpoint after %zu epochs skipped, the previous snapshots are still being written", epochs);
+        return;
+    }
+    const MyCheckpointHeader *const header = &checkpointer->header;
+    const size_t weights_bytes_count = header->cols * sizeof(GLfloat);
+    const size_t slot_offset = slot * checkpointer->slot_bytes_count;
+    ASSERT_GL(glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT | GL_CLIENT_MAPPED_BUFFER_BARRIER_BIT));
+    ASSERT_GL(glBindBuffer(GL_COPY_WRITE_BUFFER, checkpointer->staging_ssb));
+    my_range_for_zero(size_t, i, header->jobs_count) {
+        ASSERT_GL(glBindBuffer(GL_COPY_READ_BUFFER, jobs[i].weights.ssb));
+            ASSERT_GL(glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, (GLintptr)(slot_offset + i * weights_bytes_count), (GLsizeiptr)weights_bytes_count));
+        my_mem_downloaded(weights_bytes_count);
+        if(header->has_optimizer_state) {
+            const size_t state_offset = checkpointer->layout.optimizer_state - checkpointer->layout.weights + 2 * i * weights_bytes_count;
+            ASSERT_GL(glBindBuffer(GL_COPY_READ_BUFFER, jobs[i].optimizer_state.ssb));
+                ASSERT_GL(glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, (GLintptr)(slot_offset + state_offset), (GLsizeiptr)(2 * weights_bytes_count)));
+            my_mem_downloaded(2 * weights_bytes_count);
+        }
+    }
+    ASSERT_GL(glBindBuffer(GL_COPY_READ_BUFFER, 0));
+    ASSERT_GL(glBindBuffer(GL_COPY_WRITE_BUFFER, 0));
+    ASSERT_GL(checkpointer->fences[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+    ASSERT_GL(glFlush());
+    checkpointer->epochs[slot] = (uint32_t)epochs;
+    ASSERT(pthread_mutex_lock(&checkpointer->mutex) == 0);
+    checkpointer->states[slot] = MY_CHECKPOINT_SLOT_COPYING;
+    ASSERT(pthread_mutex_unlock(&checkpointer->mutex) == 0);
+}
+
+static void my_checkpointer_finish(MyCheckpointer checkpointer[static 1]) {
+    my_checkpointer_poll(checkpointer, true);
+    ASSERT(pthread_mutex_lock(&checkpointer->mutex) == 0);
+    checkpointer->done = true;
+    ASSERT(pthread_cond_broadcast(&checkpointer->cond) == 0);
+    ASSERT(pthread_mutex_unlock(&checkpointer->mutex) == 0);
+    ASSERT(pthread_join(checkpointer->writer, NULL) == 0);
+    ASSERT(pthread_cond_destroy(&checkpointer->cond) == 0);
+    ASSERT(pthread_mutex_destroy(&checkpointer->mutex) == 0);
+    ASSERT_GL(glBindBuffer(GL_COPY_WRITE_BUFFER, checkpointer->staging_ssb));
+        ASSERT_GL(glUnmapBuffer(GL_COPY_WRITE_BUFFER));
+    ASSERT_GL(glBindBuffer(GL_COPY_WRITE_BUFFER, 0));
+    ASSERT_GL(glDeleteBuffers(1, &checkpointer->staging_ssb));
+    free(checkpointer->jobs);
+}
+
+// Maps a checkpoint written for the same jobs, data and optimizer, uploads its weights and optimizer state and returns
+// the number of epochs it had finished.
+static size_t my_checkpoint_restore(
+    const char path[static 1],
+    MyTrainJob *const jobs,
+    const size_t jobs_count,
+    const MyGLMat gl_xb[static 1],
+    const size_t features_count,
+    const MyMat scaler[static 1],
+    const MyOptimizer optimizer
+) {
+    const int fd = open(path, O_RDONLY);
+    ASSERT_NOT_MINUS_ONE(fd, "%s", path);
+    struct stat stat;
+    ASSERT_NOT_MINUS_ONE(fstat(fd, &stat));
+    ASSERT((size_t)stat.st_size >= sizeof(MyCheckpointHeader), "%s is not a checkpoint", path);
+    void *const mapping = mmap(NULL, (size_t)stat.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ASSERT(mapping != MAP_FAILED);
+    const char *const data = (const char*)mapping;
+    const MyCheckpointHeader *const header = (const MyCheckpointHeader*)mapping;
+    ASSERT(memcmp(header->magic, MY_CHECKPOINT_MAGIC, sizeof(header->magic)) == 0, "%s is not a checkpoint", path);
+    const MyCheckpointLayout layout = my_checkpoint_layout(header);
+    ASSERT((size_t)stat.st_size == layout.end, "%s is truncated", path);
+    ASSERT(
+        header->features_count == features_count && header->jobs_count == jobs_count && header->cols == gl_xb->cols,
+        "%s was written for other jobs or data", path
+    );
+    // moments of another optimizer, or none for a full batch run, would be silently misread
+    const bool has_optimizer_state = jobs_count > 0 && jobs[0].optimizer_state.ssb != 0;
+    ASSERT(
+        header->optimizer == (uint32_t)optimizer && (bool)header->has_optimizer_state == has_optimizer_state,
+        "%s was written with optimizer %s%s", path,
+        header->optimizer < MY_OPTIMIZER_COUNT ? my_optimizer_names[header->optimizer] : "unknown", header->has_optimizer_state ? " and mini-batch state" : ""
+    );
+    // the mapping is page aligned and every section starts on an aligned offset
+    const MyCheckpointJob *const checkpoint_jobs = (const MyCheckpointJob*)(const void*)(data + layout.jobs);
+    my_range_for_zero(size_t, i, jobs_count) {
+        ASSERT(checkpoint_jobs[i].degree == jobs[i].degree && my_f64_bits_equal((double)checkpoint_jobs[i].l2, (double)jobs[i].l2), "%s was written for other jobs", path);
+    }
+    const size_t scaler_cols = features_count * header->degree;
+    ASSERT(scaler_cols <= scaler->cols);
+    const GLfloat *const scaler_items = (const GLfloat*)(const void*)(data + layout.scaler);
+    my_range_for_zero(size_t, col, scaler_cols) {
+        ASSERT(my_f64_bits_equal((double)scaler_items[col], (double)my_mat_item(scaler, 0, col)) && my_f64_bits_equal((double)scaler_items[scaler_cols + col], (double)my_mat_item(scaler, 1, col)), "%s was written for other data", path);
+    }
+    const size_t weights_bytes_count = header->cols * sizeof(GLfloat);
+    my_range_for_zero(size_t, i, jobs_count) {
+        ASSERT_GL(glBindBuffer(GL_SHADER_STORAGE_BUFFER, jobs[i].weights.ssb));
+            ASSERT_GL(glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, (GLsizeiptr)weights_bytes_count, data + layout.weights + i * weights_bytes_count));
+        my_mem_uploaded(weights_bytes_count);
+        if(header->has_optimizer_state) {
+            ASSERT_GL(glBindBuffer(GL_SHADER_STORAGE_BUFFER, jobs[i].optimizer_state.ssb));
+                ASSERT_GL(glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, (GLsizeiptr)(2 * weights_bytes_count), data + layout.optimizer_state + 2 * i * weights_bytes_count));
+            my_mem_uploaded(2 * weights_bytes_count);
+        }
+    }
+    ASSERT_GL(glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0));
+    const size_t epochs = header->epochs;
+    LOG("resumed: %s, epochs: %zu, optimizer state: %s", path, epochs, header->has_optimizer_state ? "yes" : "no");
+    ASSERT_NOT_MINUS_ONE(munmap(mapping, (size_t)stat.st_size));
+    ASSERT_NOT_MINUS_ONE(close(fd));
+    return epochs;
+}
+
+#define MY_DIAGNOSTICS_EVERY_MS 50.0
+#define MY_DIAGNOSTICS_GROUPS_MAX 64
+
+// Grid-stride over the rows, every work group bins into shared memory and adds its bins to B once.
+static const char mygl_histogram_compute_shader[] = S(
+layout(local_size_x = 256, local_size_y = 1, local_size_z = 1) in;
+
+uniform uint rows;
+uniform uint skip_first;
+uniform uint skip_end;
+uniform float range;
+
+layout(std430, binding = 0) readonly buffer ssbo_R { float R[]; };
+layout(std430, binding = 1) buffer ssbo_B { uint B[]; };
+
+shared uint local_bins[BINS_COUNT];
+
+void main() {
+    uint lid = gl_LocalInvocationID.x;
+    for(uint bin = lid; bin < BINS_COUNT; bin += 256u) {
+        local_bins[bin] = 0u;
+    }
+    barrier();
+    for(uint row = gl_GlobalInvocationID.x; row < rows; row += gl_NumWorkGroups.x * 256u) {
+        if(row < skip_first || row >= skip_end) {
+            float position = (R[row] + range) / (2.0 * range) * float(BINS_COUNT);
+            atomicAdd(local_bins[uint(clamp(position, 0.0, float(BINS_COUNT - 1u)))], 1u);
+        }
+    }
+    barrier();
+    for(uint bin = lid; bin < BINS_COUNT; bin += 256u) {
+        if(local_bins[bin] > 0u) {
+            atomicAdd(B[bin], local_bins[bin]);
+        }
+    }
+}
+);
+
+// log10 |weight| of power d + 1 of feature j, the highest power is the first image row and the intercept is left out.
+static const char mygl_weight_image_compute_shader[] = S(
+layout(local_size_x = 256, local_size_y = 1, local_size_z = 1) in;
+
+uniform uint features_count;
+uniform uint rows;
+
+layout(std430, binding = 0) readonly buffer ssbo_W { float W[]; };
+layout(std430, binding = 1) writeonly buffer ssbo_I { float I[]; };
+
+void main() {
+    uint i = gl_GlobalInvocationID.x;
+    if(i < rows * features_count) {
+        uint d = i / features_count;
+        I[(rows - 1u - d) * features_count + i % features_count] = log(abs(W[1u + i]) + 1e-12) * 0.4342944819;
+    }
+}
+);
+
+static void my_gl_dispatch_compute_histogram(
+    const GLuint shader_program,
+    const GLuint residuals_ssb,
+    const GLuint rows,
+    const GLuint skip_first,
+    const GLuint skip_end,
+    const GLfloat range,
+    const GLuint bins_ssb
+) {
+    const GLuint value = 0;
+    ASSERT_GL(glBindBuffer(GL_SHADER_STORAGE_BUFFER, bins_ssb));
+        ASSERT_GL(glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, &value));
+    ASSERT_GL(glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0));
+    ASSERT_GL(glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT));
+    ASSERT_GL(glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, residuals_ssb));
+    ASSERT_GL(glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, bins_ssb));
+    ASSERT_GL(glUseProgram(shader_program));
+        ASSERT_GL(glUniform1ui(my_gl_get_uniform_location(shader_program, "rows"), rows));
+        ASSERT_GL(glUniform1ui(my_gl_get_uniform_location(shader_program, "skip_first"), skip_first));
+        ASSERT_GL(glUniform1ui(my_gl_get_uniform_location(shader_program, "skip_end"), skip_end));
+        ASSERT_GL(glUniform1f(my_gl_get_uniform_location(shader_program, "range"), range));
+        const GLuint groups_count = (rows + 255) / 256;
+        my_gl_dispatch_compute("histogram", groups_count < MY_DIAGNOSTICS_GROUPS_MAX ? groups_count : MY_DIAGNOSTICS_GROUPS_MAX, 1, 1);
+    ASSERT_GL(glUseProgram(0));
+    ASSERT_GL(glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, 0));
+    ASSERT_GL(glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, 0));
+}
+
+static void my_gl_dispatch_compute_weight_image(
+    const GLuint shader_program,
+    const GLuint weights_ssb,
+    const GLuint features_count,
+    const GLuint rows,
+    const GLuint image_ssb
+) {
+    ASSERT_GL(glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, weights_ssb));
+    ASSERT_GL(glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, image_ssb));
+    ASSERT_GL(glUseProgram(shader_program));
+        ASSERT_GL(glUniform1ui(my_gl_get_uniform_location(shader_program, "features_count"), features_count));
+        ASSERT_GL(glUniform1ui(my_gl_get_uniform_location(shader_program, "rows"), rows));
+        my_gl_dispatch_compute("weight_image", (rows * features_count + 255) / 256, 1, 1);
+    ASSERT_GL(glUseProgram(0));
+    ASSERT_GL(glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, 0));
+    ASSERT_GL(glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, 0));
+}
+
+static void mygl_histogram_create_program(GLuint shader_program[static 1], GLuint compute_shader[static 1]) {
+    char header[64];
+    snprintf(header, sizeof(header), "#define BINS_COUNT %du\n", MY_DIAGNOSTICS_BINS);
+    mygl_create_compute_shader_program_with_header(shader_program, compute_shader, header, mygl_histogram_compute_shader);
+}
+
+// Diagnostics of the training thread. At most one snapshot is in flight: its bins and image are copied into a
+// persistent-mapped buffer behind a fence, which later epochs poll without waiting, so only the bins and the image
+// ever cross to the host.
+typedef struct {
+    MyDiagnosticsBuffer *buffer;
+    GLuint shader_program_histogram;
+    GLuint compute_shader_histogram;
+    GLuint shader_program_image;
+    GLuint compute_shader_image;
+    GLuint bins_ssb;
+    GLuint image_ssb;
+    GLuint readback_ssb;
+    const char *readback;
+    GLsync fence;
+    uint32_t job;
+    uint32_t epoch;
+    uint32_t rows;
+    uint32_t cols;
+    GLfloat range;
+    double dispatch_ms;
+} MyGLDiagnostics;
+
+#define MY_DIAGNOSTICS_READBACK_BYTES (MY_DIAGNOSTICS_BINS * sizeof(uint32_t) + MY_DIAGNOSTICS_IMAGE_MAX * sizeof(GLfloat))
+
+static void my_gl_diagnostics_create(MyGLDiagnostics diagnostics[static 1], MyDiagnosticsBuffer buffer[static 1], const GLfloat range) {
+    *diagnostics = (MyGLDiagnostics){.buffer = buffer, .range = range, .dispatch_ms = -INFINITY};
+    mygl_histogram_create_program(&diagnostics->shader_program_histogram, &diagnostics->compute_shader_histogram);
+    mygl_create_compute_shader_program_with_header(&diagnostics->shader_program_image, &diagnostics->compute_shader_image, "", mygl_weight_image_compute_shader);
+    GLuint buffers[3];
+    ASSERT_GL(glGenBuffers(3, buffers));
+    diagnostics->bins_ssb = buffers[0];
+    diagnostics->image_ssb = buffers[1];
+    diagnostics->readback_ssb = buffers[2];
+    ASSERT_GL(glBindBuffer(GL_SHADER_STORAGE_BUFFER, diagnostics->bins_ssb));
+        ASSERT_GL(glBufferData(GL_SHADER_STORAGE_BUFFER, MY_DIAGNOSTICS_BINS * sizeof(uint32_t), NULL, GL_DYNAMIC_COPY));
+    ASSERT_GL(glBindBuffer(GL_SHADER_STORAGE_BUFFER, diagnostics->image_ssb));
+        ASSERT_GL(glBufferData(GL_SHADER_STORAGE_BUFFER, MY_DIAGNOSTICS_IMAGE_MAX * sizeof(GLfloat), NULL, GL_DYNAMIC_COPY));
+    ASSERT_GL(glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0));
+    const GLbitfield flags = GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    ASSERT_GL(glBindBuffer(GL_COPY_WRITE_BUFFER, diagnostics->readback_ssb));
+        ASSERT_GL(glBufferStorage(GL_COPY_WRITE_BUFFER, MY_DIAGNOSTICS_READBACK_BYTES, NULL, flags));
+        ASSERT_GL(diagnostics->readback = (const char*)glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, MY_DIAGNOSTICS_READBACK_BYTES, flags));
+    ASSERT_GL(glBindBuffer(GL_COPY_WRITE_BUFFER, 0));
+    ASSERT(diagnostics->readback);
+}
+
+// Publishes the snapshot in flight once its fence signaled, with `wait` it blocks for it.
+static void my_gl_diagnostics_poll(MyGLDiagnostics diagnostics[static 1], const bool wait) {
+    if(!diagnostics->fence) {
+        return;
+    }
+    GLenum status;
+    do {
+        ASSERT_GL(status = glClientWaitSync(diagnostics->fence, GL_SYNC_FLUSH_COMMANDS_BIT, wait ? 1000 * 1000 * 1000 : 0));
+        ASSERT(status != GL_WAIT_FAILED);
+    } while(wait && status == GL_TIMEOUT_EXPIRED);
+    if(status == GL_TIMEOUT_EXPIRED) {
+        return;
+    }
+    ASSERT_GL(glDeleteSync(diagnostics->fence));
+    diagnostics->fence = NULL;
+    MyDiagnosticsBuffer *const buffer = diagnostics->buffer;
+    MyDiagnosticsFrame *const frame = &buffer->frames[buffer->back];
+    frame->job = diagnostics->job;
+    frame->epoch = diagnostics->epoch;
+    frame->rows = diagnostics->rows;
+    frame->cols = diagnostics->cols;
+    frame->range = diagnostics->range;
+    memcpy(frame->bins, diagnostics->readback, sizeof(frame->bins));
+    memcpy(frame->image, diagnostics->readback + sizeof(frame->bins), (size_t)diagnostics->rows * diagnostics->cols * sizeof(GLfloat));
+    my_mem_downloaded(sizeof(frame->bins) + (size_t)diagnostics->rows * diagnostics->cols * sizeof(GLfloat));
+    my_diagnostics_buffer_publish(buffer);
+}
+
+// Snapshots the job the render loop selected at most every MY_DIAGNOSTICS_EVERY_MS, `force` snapshots regardless.
+static void my_gl_diagnostics_update(
+    MyGLDiagnostics diagnostics[static 1],
+    const MyTrainJob *const jobs,
+    const size_t jobs_count,
+    const size_t features_count,
+    const GLuint rows,
+    const size_t epoch,
+    const bool force
+) {
+    my_gl_diagnostics_poll(diagnostics, false);
+    const double now_ms = my_time_ms();
+    if(diagnostics->fence || (!force && now_ms - diagnostics->dispatch_ms < MY_DIAGNOSTICS_EVERY_MS)) {
+        return;
+    }
+    const unsigned selected = atomic_load_explicit(&diagnostics->buffer->job, memory_order_relaxed);
+    const MyTrainJob *const job = &jobs[selected < jobs_count ? selected : 0];
+    diagnostics->job = selected < jobs_count ? selected : 0;
+    diagnostics->epoch = (uint32_t)epoch;
+    diagnostics->cols = (uint32_t)features_count;
+    diagnostics->rows = (uint32_t)(job->degree < MY_DIAGNOSTICS_IMAGE_MAX / features_count ? job->degree : MY_DIAGNOSTICS_IMAGE_MAX / features_count);
+    diagnostics->dispatch_ms = now_ms;
+
+    my_gl_dispatch_compute_histogram(diagnostics->shader_program_histogram, job->residuals.ssb, rows, job->fold_first, job->fold_end, diagnostics->range, diagnostics->bins_ssb);
+    my_gl_dispatch_compute_weight_image(diagnostics->shader_program_image, job->weights.ssb, diagnostics->cols, diagnostics->rows, diagnostics->image_ssb);
+    ASSERT_GL(glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT | GL_CLIENT_MAPPED_BUFFER_BARRIER_BIT));
+    ASSERT_GL(glBindBuffer(GL_COPY_WRITE_BUFFER, diagnostics->readback_ssb));
+    ASSERT_GL(glBindBuffer(GL_COPY_READ_BUFFER, diagnostics->bins_ssb));
+        ASSERT_GL(glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, MY_DIAGNOSTICS_BINS * sizeof(uint32_t)));
+    ASSERT_GL(glBindBuffer(GL_COPY_READ_BUFFER, diagnostics->image_ssb));
+        ASSERT_GL(glCopyBufferSubData(
+            GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, MY_DIAGNOSTICS_BINS * sizeof(uint32_t), (GLsizeiptr)(diagnostics->rows * diagnostics->cols * sizeof(GLfloat))
+        ));
+    ASSERT_GL(glBindBuffer(GL_COPY_READ_BUFFER, 0));
+    ASSERT_GL(glBindBuffer(GL_COPY_WRITE_BUFFER, 0));
+    ASSERT_GL(diagnostics->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+    ASSERT_GL(glFlush());
+}
+
+static void my_gl_diagnostics_destroy(MyGLDiagnostics diagnostics[static 1]) {
+    my_gl_diagnostics_poll(diagnostics, true);
+    ASSERT_GL(glBindBuffer(GL_COPY_WRITE_BUFFER, diagnostics->readback_ssb));
+        ASSERT_GL(glUnmapBuffer(GL_COPY_WRITE_BUFFER));
+    ASSERT_GL(glBindBuffer(GL_COPY_WRITE_BUFFER, 0));
+    const GLuint buffers[] = {diagnostics->bins_ssb, diagnostics->image_ssb, diagnostics->readback_ssb};
+    ASSERT_GL(glDeleteBuffers((GLsizei)my_array_count(buffers), buffers));
+    ASSERT_GL(glDeleteShader(diagnostics->compute_shader_histogram));
+    ASSERT_GL(glDeleteProgram(diagnostics->shader_program_histogram));
+    ASSERT_GL(glDeleteShader(diagnostics->compute_shader_image));
+    ASSERT_GL(glDeleteProgram(diagnostics->shader_program_image));
+}
+
+// The forward pass and the gradient are two multiply-adds per design matrix item a job uses.
+static double my_train_flops(const MyTrainJob *const jobs, const size_t jobs_count, const size_t rows) {
+    double flops = 0.0;
+    my_range_for_zero(size_t, i, jobs_count) {
+        flops += 4.0 * (double)rows * (double)jobs[i].cols;
+    }
+    return flops;
+}
+
+static void my_train_metric_publish(
+    MyMetricRing ring[static 1],
+    const MyTrainJob *const jobs,
+    const size_t jobs_count,
+    const size_t job,
+    const size_t epoch,
+    const double gradient_norm,
+    const size_t rows,
+    const double epoch_ms
+) {
+    const MyTrainMetric metric = {
+        .job = (uint32_t)job,
+        .degree = (uint32_t)jobs[job].degree,
+        .l2 = jobs[job].l2,
+        .epoch = (uint32_t)epoch,
+        .mse = jobs[job].mse,
+        .gradient_norm = gradient_norm,
+        .epoch_ms = epoch_ms,
+        .gflops = my_train_flops(jobs, jobs_count, rows) / epoch_ms / 1e6,
+    };
+    my_metric_ring_push(ring, &metric);
+}
+
+static void my_train_throughput_log(const MyTrainBackend backend, const MyTrainJob *const jobs, const size_t jobs_count, const size_t rows, const size_t epochs, const double elapsed_ms) {
+    const double flops = my_train_flops(jobs, jobs_count, rows) * (double)epochs;
+    LOG(
+        "backend: %s, jobs: %zu, ms per epoch: %lf, samples/s: %lf, gflops: %lf", my_train_backend_names[backend], jobs_count,
+        elapsed_ms / (double)epochs, (double)(rows * jobs_count * epochs) / elapsed_ms * 1e3, flops / elapsed_ms / 1e6
+    );
+}
+
+static void* my_train_device_worker(void *const arg) {
+    MyTrainDevice *const device = (MyTrainDevice*)arg;
+    my_trace_thread_name("train worker");
+    my_mem_phase_set(MY_MEM_PHASE_TRAIN);
+    my_gl_context_make_current(&device->context);
+
+    MyGLReduce reduce = mygl_reduce_create((GLuint)(2 * device->jobs_count + 3));
+    MyGLStats y_stats;
+    {
+        const MyGLReduceView y_view = mygl_reduce_view_all(&device->gl_y);
+        const GLuint slot = mygl_reduce_scalar(&reduce, MY_GL_REDUCE_VALUE, &y_view, NULL);
+        y_stats = mygl_reduce_scalars_wait(&reduce)[slot];
+    }
+    const double y_variance = (double)y_stats.m2 / (double)y_stats.count;
+
+    if(device->options->solver != MY_SOLVER_GD) {
+        my_range_for_zero(size_t, i, device->jobs_count) {
+            MyTrainJob *const job = &device->jobs[i];
+            const double solve_start_ms = my_time_ms();
+            const MySolveResult result = device->options->solver == MY_SOLVER_CG
+                ? my_train_job_solve_cg(device, job, &reduce)
+                : my_train_job_solve_lbfgs(device, job, &reduce);
+            const double solve_ms = my_time_ms() - solve_start_ms;
+            const GLuint slot = my_train_job_residuals(device, job, &reduce, true);
+            const MyGLStats *const scalars = mygl_reduce_scalars_wait(&reduce);
+            const double rows = my_train_job_rows(device, job);
+            job->mse = (double)scalars[slot].sum / rows;
+            job->r2 = 1.0 - job->mse / y_variance;
+            LOG(
+                "degree: %zu, l2: %g, solver: %s, iterations: %zu, converged: %s, gradient_norm: %lf, ms: %lf, mse: %lf, r2: %lf",
+                job->degree, (double)job->l2, my_solver_names[device->options->solver], result.iterations, result.converged ? "yes" : "no",
+                result.gradient_norm, solve_ms, job->mse, job->r2
+            );
+        }
+    }
+    const size_t epochs_count = device->options->solver == MY_SOLVER_GD ? device->options->epochs : 0;
+
+    GLuint *const slots = (GLuint*)malloc(2 * device->jobs_count * sizeof(*slots));
+    ASSERT(slots);
+    MyCheckpointer checkpointer;
+    if(device->options->checkpoint_path) {
+        my_checkpointer_start(
+            &checkpointer, device->options->checkpoint_path, device->jobs, device->jobs_count, &device->gl_xb,
+            device->features_count, device->degree, device->scaler, device->options->optimizer
+        );
+    }
+    MyGLDiagnostics diagnostics;
+    if(device->diagnostics) {
+        my_gl_diagnostics_create(&diagnostics, device->diagnostics, 4.f * (GLfloat)sqrt(y_variance));
+    }
+    const double epochs_start_ms = my_time_ms();
+    my_range_for(size_t, epoch, device->epoch_first, epochs_count) {
+        const double epoch_start_ms = my_time_ms();
+        MyTraceZone epoch_zone = my_trace_begin("epoch");
+        my_range_for_zero(size_t, i, device->jobs_count) {
+            // the first forward pass already ran while the data was uploaded
+            if(device->batch_size > 0) {
+                slots[2 * i] = my_train_job_residuals(device, &device->jobs[i], &reduce, epoch > 0);
+            } else {
+                const GLfloat learning_rate = my_train_learning_rate(device->options, epoch, device->options->epochs);
+                my_train_job_epoch(device, &device->jobs[i], &reduce, epoch > 0, learning_rate, &slots[2 * i], &slots[2 * i + 1]);
+            }
+        }
+        if(device->batch_size > 0) {
+            my_train_device_minibatch_epoch(device, epoch);
+        }
+        const MyGLStats *const scalars = mygl_reduce_scalars_wait(&reduce);
+        my_trace_end(&epoch_zone);
+        const double epoch_ms = my_time_ms() - epoch_start_ms;
+        my_range_for_zero(size_t, i, device->jobs_count) {
+            MyTrainJob *const job = &device->jobs[i];
+            const double rows = my_train_job_rows(device, job);
+            job->mse = (double)scalars[slots[2 * i]].sum / rows;
+            job->r2 = 1.0 - job->mse / y_variance;
+            double gradient_norm = NAN;
+            if(device->batch_size > 0) {
+                LOG("degree: %zu, l2: %g, epoch: %zu, mse: %lf, r2: %lf", job->degree, (double)job->l2, epoch, job->mse, job->r2);
+            } else {
+                gradient_norm = 2.0 / rows * sqrt((double)scalars[slots[2 * i + 1]].sum);
+                LOG("degree: %zu, l2: %g, epoch: %zu, mse: %lf, r2: %lf, gradient_norm: %lf", job->degree, (double)job->l2, epoch, job->mse, job->r2, gradient_norm);
+            }
+            if(device->metrics) {
+                my_train_metric_publish(device->metrics, device->jobs, device->jobs_count, i, epoch, gradient_norm, device->gl_xb.rows, epoch_ms);
+            }
+        }
+        if(device->diagnostics) {
+            my_gl_diagnostics_update(&diagnostics, device->jobs, device->jobs_count, device->features_count, device->gl_xb.rows, epoch, false);
+        }
+        if(epoch == device->epoch_first) {
+            LOG("time to first epoch ms: %lf", my_time_ms() - device->start_ms);
+        }
+        if(device->options->checkpoint_path && (epoch + 1) % device->options->checkpoint_every == 0 && epoch + 1 < epochs_count) {
+            my_checkpointer_snapshot(&checkpointer, device->jobs, epoch + 1, false);
+        }
+    }
+    if(epochs_count > device->epoch_first) {
+        my_train_throughput_log(MY_TRAIN_BACKEND_GL, device->jobs, device->jobs_count, device->gl_xb.rows, epochs_count - device->epoch_first, my_time_ms() - epochs_start_ms);
+    }
+    if(device->options->checkpoint_path) {
+        my_checkpointer_snapshot(&checkpointer, device->jobs, epochs_count > device->epoch_first ? epochs_count : device->epoch_first, true);
+        my_checkpointer_finish(&checkpointer);
+    }
+    if(device->diagnostics) {
+        // the final weights, the snapshot in flight is published first
+        my_gl_diagnostics_poll(&diagnostics, true);
+        my_gl_diagnostics_update(&diagnostics, device->jobs, device->jobs_count, device->features_count, device->gl_xb.rows, epochs_count, true);
+        my_gl_diagnostics_destroy(&diagnostics);
+    }
+    my_mem_phase_set(MY_MEM_PHASE_EVALUATE);
+    if(device->options->folds > 0) {
+        my_range_for_zero(size_t, i, device->jobs_count) {
+            slots[i] = my_train_job_fold_loss(device, &device->jobs[i], &reduce);
+        }
+        const MyGLStats *const scalars = mygl_reduce_scalars_wait(&reduce);
+        my_range_for_zero(size_t, i, device->jobs_count) {
+            device->jobs[i].fold_mse = (double)scalars[slots[i]].sum / (double)scalars[slots[i]].count;
+        }
+    }
+    free(slots);
+    my_range_for_zero(size_t, i, device->jobs_count) {
+        const MyTrainJob *const job = &device->jobs[i];
+        if(job->trained_weights) {
+            mygl_buffer_read(job->weights.ssb, 0, (GLsizeiptr)(job->cols * sizeof(GLfloat)), job->trained_weights);
+        }
+    }
+
+    if(device->options->validate_storage) {
+        my_range_for_zero(size_t, i, device->jobs_count) {
+            LOG("degree: %zu, l2: %g", device->jobs[i].degree, (double)device->jobs[i].l2);
+            my_polynomial_validate_storage(&reduce, device->precision, device->xb_test, device->y_test, &device->jobs[i].weights);
+        }
+    }
+    mygl_reduce_destroy(&reduce);
+    my_gl_context_release(&device->context);
+    return NULL;
+}
+
+// Uploads the design matrix on the device's own context, runs the first forward pass of its jobs on each uploaded block
+// and hands the jobs to a worker thread.
+static void my_train_device_start(
+    MyTrainDevice device[static 1],
+    const MyMat x_train[static 1],
+    const MyMat y_train[static 1],
+    const size_t degree,
+    const MyMat scaler[static 1]
+) {
+    const MyTrainOptions *const options = device->options;
+    const MyMemPhase phase = my_mem_phase_set(MY_MEM_PHASE_UPLOAD);
+    MyUploadPipeline upload;
+    my_upload_pipeline_start(&upload, x_train, degree, scaler, options->storage, options->upload_block_rows);
+    device->gl_xb = upload.gl_mat;
+    LOG(
+        "storage: %s, gl_xb bytes: %zu, upload blocks: %zu x %zu rows, jobs: %zu",
+        my_gl_mat_format_names[device->gl_xb.format],
+        my_gl_mat_format_bytes_count(device->gl_xb.format, (size_t)device->gl_xb.rows * device->gl_xb.cols),
+        upload.blocks_count,
+        upload.block_rows,
+        device->jobs_count
+    );
+    device->precision = mygl_precision_supported(options->precision);
+    LOG("precision: %s", my_precision_names[device->precision]);
+    mygl_matrix_mul_create_program(&device->shader_program_mul_mat, &device->compute_shader_mul_mat, device->gl_xb.format, device->precision);
+    mygl_create_compute_shader_program_with_header(&device->shader_program_axpby, &device->compute_shader_axpby, "", mygl_axpby_compute_shader);
+    // the moment optimizers always run through the mini-batch kernels, with the full batch when no batch size is given
+    device->batch_size = options->batch_size > 0 || options->optimizer == MY_OPTIMIZER_SGD ? options->batch_size : x_train->rows;
+    device->batch_size = device->batch_size < x_train->rows ? device->batch_size : x_train->rows;
+    LOG(
+        "optimizer: %s, batch size: %zu, schedule: %s, learning rate: %g",
+        my_optimizer_names[options->optimizer], device->batch_size, my_schedule_names[options->schedule], (double)options->learning_rate
+    );
+    if(device->batch_size > 0) {
+        mygl_minibatch_create_programs(device->shader_programs_minibatch, device->compute_shaders_minibatch, device->gl_xb.format, device->precision, options->optimizer);
+        device->gl_indices = mygl_mat_buffer_data(&(MyMat){.rows = x_train->rows, .cols = 1}, GL_DYNAMIC_COPY);
+    }
+    device->gl_y = mygl_mat_buffer_data(y_train, GL_STATIC_DRAW);
+    my_range_for_zero(size_t, i, device->jobs_count) {
+        MyTrainJob *const job = &device->jobs[i];
+        *job = my_train_job_create(job, x_train->cols, &device->gl_xb, device->batch_size);
+    }
+    device->features_count = x_train->cols;
+    device->degree = degree;
+    device->scaler = scaler;
+    if(options->resume) {
+        device->epoch_first = my_checkpoint_restore(options->checkpoint_path, device->jobs, device->jobs_count, &device->gl_xb, x_train->cols, scaler, options->optimizer);
+    }
+
+    GLuint row_first, row_end;
+    while(my_upload_pipeline_next(&upload, &row_first, &row_end)) {
+        my_range_for_zero(size_t, i, device->jobs_count) {
+            my_gl_dispatch_compute_mat_mul_rows(device->shader_program_mul_mat, &device->gl_xb, &device->jobs[i].weights, &device->jobs[i].predictions, row_first, row_end);
+        }
+    }
+    my_upload_pipeline_finish(&upload);
+    // objects written here must be complete before the shared context reads them
+    ASSERT_GL(glFinish());
+
+    device->context = my_gl_context_create_shared(&device->upload_context);
+    ASSERT(pthread_create(&device->worker, NULL, my_train_device_worker, device) == 0);
+    my_mem_phase_set(phase);
+}
+
+static void my_train_device_finish(MyTrainDevice device[static 1]) {
+    ASSERT(pthread_join(device->worker, NULL) == 0);
+    my_gl_context_make_current(&device->upload_context);
+    my_range_for_zero(size_t, i, device->jobs_count) {
+        my_train_job_destroy(&device->jobs[i]);
+    }
+    ASSERT_GL(glDeleteShader(device->compute_shader_axpby));
+    ASSERT_GL(glDeleteProgram(device->shader_program_axpby));
+    ASSERT_GL(glDeleteShader(device->compute_shader_mul_mat));
+    ASSERT_GL(glDeleteProgram(device->shader_program_mul_mat));
+    if(device->batch_size > 0) {
+        my_range_for_zero(size_t, stage, MY_MINIBATCH_STAGE_COUNT) {
+            ASSERT_GL(glDeleteShader(device->compute_shaders_minibatch[stage]));
+            ASSERT_GL(glDeleteProgram(device->shader_programs_minibatch[stage]));
+        }
+    }
+    mygl_mat_delete(&device->gl_xb);
+    mygl_mat_delete(&device->gl_y);
+    mygl_mat_delete(&device->gl_indices);
+    my_gl_context_destroy(&device->context);
+    my_gl_context_destroy(&device->upload_context);
+}
+
+// Jobs are spread over the comma separated devices, the jobs of a device are contiguous in `jobs`.
+static void my_train_gl(
+    const MyTrainOptions options[static 1],
+    const MyMat x_train[static 1],
+    const MyMat y_train[static 1],
+    const MyMat y_test[static 1],
+    const size_t degree,
+    const MyMat scaler[static 1],
+    const MyMat xb_test[static 1],
+    MyTrainJob *const jobs,
+    const size_t jobs_count,
+    const double start_ms
+) {
+    char device_names[256] = "";
+    if(options->device) {
+        ASSERT(strlen(options->device) < sizeof(device_names));
+        strcpy(device_names, options->device);
+    }
+    const char *names[MY_GL_CONTEXT_DISPLAYS_MAX] = {NULL};
+    size_t devices_count = 0;
+    {
+        char *save;
+        for(char *name = strtok_r(device_names, ",", &save); name; name = strtok_r(NULL, ",", &save)) {
+            ASSERT(devices_count < MY_GL_CONTEXT_DISPLAYS_MAX);
+            names[devices_count++] = name;
+        }
+        devices_count = devices_count > 0 ? devices_count : 1;
+    }
+
+    MyTrainDevice devices[MY_GL_CONTEXT_DISPLAYS_MAX] = {0};
+    {
+        size_t job = 0;
+        my_range_for_zero(size_t, d, devices_count) {
+            devices[d].options = options;
+            devices[d].xb_test = xb_test;
+            devices[d].y_test = y_test;
+            devices[d].start_ms = start_ms;
+            devices[d].jobs = jobs + job;
+            devices[d].jobs_count = jobs_count / devices_count + (d < jobs_count % devices_count ? 1 : 0);
+            devices[d].metrics = options->metric_rings ? &options->metric_rings[d] : NULL;
+            devices[d].diagnostics = options->diagnostics ? &options->diagnostics[d] : NULL;
+            job += devices[d].jobs_count;
+        }
+    }
+
+    my_range_for_zero(size_t, d, devices_count) {
+        // earlier devices are training already, their displays are skipped rather than probed
+        devices[d].upload_context = my_gl_context_create(names[d]);
+        if(devices[d].jobs_count > 0) {
+            my_train_device_start(&devices[d], x_train, y_train, degree, scaler);
+        }
+    }
+    my_range_for_zero(size_t, d, devices_count) {
+        if(devices[d].jobs_count > 0) {
+            my_train_device_finish(&devices[d]);
+        } else {
+            my_gl_context_destroy(&devices[d].upload_context);
+        }
+    }
+}
+
+// Jobs of one degree x l2 combination are its folds in order. A fold fits the scaler on its training rows only, so
+// no statistic of its held out rows leaks into the features, and the combinations of a fold share its design matrix.
+static void my_train_gl_folds(
+    const MyTrainOptions options[static 1],
+    const MyMat x_train[static 1],
+    const MyMat y_train[static 1],
+    const MyMat y_test[static 1],
+    const size_t degree,
+    const MyMat xb_test[static 1],
+    MyTrainJob *const jobs,
+    const size_t jobs_count,
+    const double start_ms
+) {
+    const size_t folds = options->folds, combinations = jobs_count / options->folds;
+    ASSERT(combinations * folds == jobs_count);
+    MyArena arena = my_arena_init(my_mat_bytes_count(&((MyMat){.rows = 2, .cols = x_train->cols * degree})));
+    MyMat scaler = my_mat_alloc(&arena, 2, x_train->cols * degree);
+    MyTrainJob *const fold_jobs = (MyTrainJob*)malloc(combinations * sizeof(*fold_jobs));
+    ASSERT(fold_jobs);
+    my_range_for_zero(size_t, fold, folds) {
+        my_range_for_zero(size_t, i, combinations) {
+            fold_jobs[i] = jobs[i * folds + fold];
+        }
+        my_polynomial_scaler_fit_rows(x_train, degree, fold_jobs[0].fold_first, fold_jobs[0].fold_end, &scaler);
+        my_train_gl(options, x_train, y_train, y_test, degree, &scaler, xb_test, fold_jobs, combinations, start_ms);
+        my_range_for_zero(size_t, i, combinations) {
+            jobs[i * folds + fold] = fold_jobs[i];
+        }
+    }
+    free(fold_jobs);
+    my_arena_free(&arena);
+}
+
+#define MY_TRAIN_CPU_GRAIN 256
+#define MY_TRAIN_CPU_LANES 8
+
+typedef struct {
+    const MyMat *xb;
+    const MyMat *y;
+    const GLfloat *weights;
+    size_t cols;
+    // one row per chunk of rows: the gradient sums of the first `cols` columns, then the squared residual sum
+    MyMat *partials;
+} MyTrainCpuTask;
+
+// Independent lane sums keep the loop vectorizable without letting the compiler reassociate float additions.
+static GLfloat my_train_cpu_dot(const GLfloat *restrict const first, const GLfloat *restrict const second, const size_t count) {
+    GLfloat lanes[MY_TRAIN_CPU_LANES] = {0.f};
+    size_t i = 0;
+    for(; i + MY_TRAIN_CPU_LANES <= count; i += MY_TRAIN_CPU_LANES) {
+        my_range_for_zero(size_t, lane, MY_TRAIN_CPU_LANES) {
+            lanes[lane] += first[i + lane] * second[i + lane];
+        }
+    }
+    GLfloat sum = ((lanes[0] + lanes[1]) + (lanes[2] + lanes[3])) + ((lanes[4] + lanes[5]) + (lanes[6] + lanes[7]));
+    for(; i < count; ++i) {
+        sum += first[i] * second[i];
+    }
+    return sum;
+}
+
+// Forward pass, residuals and gradient of a chunk in one sweep over its rows. The gradient update is blocked
+// by four rows, so every gradient item is loaded and stored once per block instead of once per row.
+static void my_train_cpu_rows(void *const context, const size_t row_first, const size_t row_end) {
+    const MyTrainCpuTask *const task = (const MyTrainCpuTask*)context;
+    const size_t cols = task->cols;
+    const size_t stride = task->xb->cols;
+    const GLfloat *const weights = task->weights;
+    const GLfloat *const y = task->y->items;
+    GLfloat *restrict const gradient = &my_mat_row(task->partials, row_first / MY_TRAIN_CPU_GRAIN);
+    memset(gradient, 0, cols * sizeof(*gradient));
+    double loss = 0.0;
+    size_t row = row_first;
+    for(; row + 4 <= row_end; row += 4) {
+        const GLfloat *const x0 = &my_mat_row(task->xb, row);
+        const GLfloat *const x1 = x0 + stride;
+        const GLfloat *const x2 = x1 + stride;
+        const GLfloat *const x3 = x2 + stride;
+        const GLfloat r0 = my_train_cpu_dot(x0, weights, cols) - y[row];
+        const GLfloat r1 = my_train_cpu_dot(x1, weights, cols) - y[row + 1];
+        const GLfloat r2 = my_train_cpu_dot(x2, weights, cols) - y[row + 2];
+        const GLfloat r3 = my_train_cpu_dot(x3, weights, cols) - y[row + 3];
+        loss += (double)(r0 * r0) + (double)(r1 * r1) + (double)(r2 * r2) + (double)(r3 * r3);
+        my_range_for_zero(size_t, col, cols) {
+            gradient[col] += (r0 * x0[col] + r1 * x1[col]) + (r2 * x2[col] + r3 * x3[col]);
+        }
+    }
+    for(; row < row_end; ++row) {
+        const GLfloat *const x = &my_mat_row(task->xb, row);
+        const GLfloat r = my_train_cpu_dot(x, weights, cols) - y[row];
+        loss += (double)(r * r);
+        my_range_for_zero(size_t, col, cols) {
+            gradient[col] += r * x[col];
+        }
+    }
+    gradient[cols] = (GLfloat)loss;
+}
+
+// Same epochs as the GL path on a design matrix built by the thread pool. Chunk partials are summed in chunk order,
+// so the result does not depend on the threads count.
+static void my_train_cpu(
+    const MyTrainOptions options[static 1],
+    const MyMat x_train[static 1],
+    const MyMat y_train[static 1],
+    const size_t degree,
+    const MyMat scaler[static 1],
+    MyTrainJob *const jobs,
+    const size_t jobs_count,
+    const double start_ms
+) {
+    ASSERT(!options->validate_storage, "--validate-storage needs the gl backend");
+    ASSERT(options->storage == MY_GL_MAT_FORMAT_F32 && options->precision == MY_PRECISION_F32, "--storage and --precision need the gl backend");
+    ASSERT(options->optimizer == MY_OPTIMIZER_SGD && options->batch_size == 0, "mini-batch training needs the gl backend");
+    ASSERT(options->solver == MY_SOLVER_GD, "the %s solver needs the gl backend", my_solver_names[options->solver]);
+    MyArena arena = my_arena_init(
+        my_mat_bytes_count(&((MyMat){.rows = x_train->rows, .cols = x_train->cols * degree + 1}))
+        + my_mat_bytes_count(&((MyMat){.rows = (x_train->rows + MY_TRAIN_CPU_GRAIN - 1) / MY_TRAIN_CPU_GRAIN, .cols = x_train->cols * degree + 2}))
+        + jobs_count * (x_train->cols * degree + 1) * sizeof(GLfloat)
+    );
+    MyMat xb = my_mat_alloc(&arena, x_train->rows, x_train->cols * degree + 1);
+    my_polynomial_design_rows(x_train, degree, scaler, 0, &xb);
+    MyMat partials = my_mat_alloc(&arena, (xb.rows + MY_TRAIN_CPU_GRAIN - 1) / MY_TRAIN_CPU_GRAIN, xb.cols + 1);
+    MyMat weights = my_mat_alloc(&arena, jobs_count, xb.cols);
+    memset(weights.items, 0, my_mat_bytes_count(&weights));
+    my_range_for_zero(size_t, i, jobs_count) {
+        jobs[i].cols = (GLuint)(x_train->cols * jobs[i].degree + 1);
+    }
+
+    double y_m2 = 0.0;
+    {
+        double y_mean = 0.0;
+        my_mat_foreach(el, y_train) {
+            y_mean += (double)*el;
+        }
+        y_mean /= (double)y_train->rows;
+        my_mat_foreach(el, y_train) {
+            y_m2 += ((double)*el - y_mean) * ((double)*el - y_mean);
+        }
+    }
+
+    const GLfloat gradient_scale = 2.f / (GLfloat)xb.rows;
+    double *const gradient_norms = (double*)malloc(jobs_count * sizeof(double));
+    ASSERT(gradient_norms);
+    const double epochs_start_ms = my_time_ms();
+    my_range_for_zero(size_t, epoch, options->epochs) {
+        const double epoch_start_ms = my_time_ms();
+        my_range_for_zero(size_t, i, jobs_count) {
+            MyTrainJob *const job = &jobs[i];
+            GLfloat *const job_weights = &my_mat_row(&weights, i);
+            my_parallel_for(
+                "my_train_cpu_rows", xb.rows, MY_TRAIN_CPU_GRAIN, my_train_cpu_rows,
+                &(MyTrainCpuTask){.xb = &xb, .y = y_train, .weights = job_weights, .cols = job->cols, .partials = &partials}
+            );
+            double loss = 0.0;
+            my_range_for_zero(size_t, chunk, partials.rows) {
+                loss += (double)my_mat_item(&partials, chunk, job->cols);
+            }
+            double gradient_m2 = 0.0;
+            // w -= lr * (gradient + 2 * l2 * w), the intercept is not regularized
+            const GLfloat learning_rate = my_train_learning_rate(options, epoch, options->epochs);
+            const GLfloat step = -learning_rate * gradient_scale;
+            my_range_for_zero(size_t, col, job->cols) {
+                GLfloat gradient = 0.f;
+                my_range_for_zero(size_t, chunk, partials.rows) {
+                    gradient += my_mat_item(&partials, chunk, col);
+                }
+                gradient_m2 += (double)gradient * (double)gradient;
+                const GLfloat decay = col == 0 ? 1.f : 1.f - 2.f * learning_rate * job->l2;
+                job_weights[col] = decay * job_weights[col] + step * gradient;
+            }
+            job->mse = loss / (double)xb.rows;
+            job->r2 = 1.0 - loss / y_m2;
+            gradient_norms[i] = (double)gradient_scale * sqrt(gradient_m2);
+            LOG(
+                "degree: %zu, l2: %g, epoch: %zu, mse: %lf, r2: %lf, gradient_norm: %lf",
+                job->degree, (double)job->l2, epoch, job->mse, job->r2, gradient_norms[i]
+            );
+        }
+        if(options->metric_rings) {
+            const double epoch_ms = my_time_ms() - epoch_start_ms;
+            my_range_for_zero(size_t, i, jobs_count) {
+                my_train_metric_publish(&options->metric_rings[0], jobs, jobs_count, i, epoch, gradient_norms[i], xb.rows, epoch_ms);
+            }
+        }
+        if(epoch == 0) {
+            LOG("time to first epoch ms: %lf", my_time_ms() - start_ms);
+        }
+    }
+    if(options->epochs > 0) {
+        my_train_throughput_log(MY_TRAIN_BACKEND_CPU, jobs, jobs_count, xb.rows, options->epochs, my_time_ms() - epochs_start_ms);
+    }
+    my_range_for_zero(size_t, i, jobs_count) {
+        if(jobs[i].trained_weights) {
+            memcpy(jobs[i].trained_weights, &my_mat_row(&weights, i), jobs[i].cols * sizeof(GLfloat));
+        }
+    }
+    free(gradient_norms);
+    my_arena_free(&arena);
+}
+
+#define MY_CD_PATH_RATIO 1e-3
+
+// Coordinate descent state of one elastic net path. Row j of `cols` is design column j without the intercept,
+// only the first `count` columns are fitted. `correlations` holds x_j . r / n of the last KKT check.
+typedef struct {
+    const MyMat *cols;
+    size_t count;
+    GLfloat intercept;
+    GLfloat *norms;
+    GLfloat *weights;
+    GLfloat *residuals;
+    GLfloat *correlations;
+    bool *strong;
+    size_t *coords;
+} MyCdPath;
+
+static void my_cd_correlations_cols(void *const context, const size_t col_first, const size_t col_end) {
+    const MyCdPath *const path = (const MyCdPath*)context;
+    const size_t rows = path->cols->cols;
+    my_range_for(size_t, col, col_first, col_end) {
+        path->correlations[col] = my_train_cpu_dot(&my_mat_row(path->cols, col), path->residuals, rows) / (GLfloat)rows;
+    }
+}
+
+static void my_cd_correlations(MyCdPath path[static 1]) {
+    my_parallel_for("my_cd_correlations", path->count, 8, my_cd_correlations_cols, path);
+}
+
+// Features are standardized, so the intercept is the mean of y and is never penalized.
+static MyCdPath my_cd_path_create(const MyMat cols[static 1], const size_t count, const MyMat y[static 1]) {
+    ASSERT(count <= cols->rows && y->rows == cols->cols);
+    const size_t rows = cols->cols;
+    MyCdPath path = {
+        .cols = cols,
+        .count = count,
+        .norms = (GLfloat*)malloc(count * sizeof(GLfloat)),
+        .weights = (GLfloat*)calloc(count, sizeof(GLfloat)),
+        .residuals = (GLfloat*)malloc(rows * sizeof(GLfloat)),
+        .correlations = (GLfloat*)malloc(count * sizeof(GLfloat)),
+        .strong = (bool*)calloc(count, sizeof(bool)),
+        .coords = (size_t*)malloc(count * sizeof(size_t)),
+    };
+    ASSERT(path.norms && path.weights && path.residuals && path.correlations && path.strong && path.coords);
+    double mean = 0.0;
+    my_range_for_zero(size_t, row, rows) {
+        mean += (double)y->items[row];
+    }
+    path.intercept = (GLfloat)(mean / (double)rows);
+    my_range_for_zero(size_t, row, rows) {
+        path.residuals[row] = y->items[row] - path.intercept;
+    }
+    my_range_for_zero(size_t, col, count) {
+        const GLfloat *const x = &my_mat_row(cols, col);
+        path.norms[col] = my_train_cpu_dot(x, x, rows) / (GLfloat)rows;
+    }
+    my_cd_correlations(&path);
+    return path;
+}
+
+static void my_cd_path_destroy(MyCdPath path[static 1]) {
+    free(path->norms);
+    free(path->weights);
+    free(path->residuals);
+    free(path->correlations);
+    free(path->strong);
+    free(path->coords);
+    *path = (MyCdPath){0};
+}
+
+// Smallest lambda whose fit is all zeros.
+static GLfloat my_cd_lambda_max(const MyCdPath path[static 1], const GLfloat l1_ratio) {
+    GLfloat max_correlation = 0.f;
+    my_range_for_zero(size_t, col, path->count) {
+        max_correlation = fmaxf(max_correlation, fabsf(path->correlations[col]));
+    }
+    return max_correlation / l1_ratio;
+}
+
+// One cyclic pass over path->coords[0, coords_count) with residual updates, returns the largest weight change.
+static GLfloat my_cd_sweep(MyCdPath path[static 1], const size_t coords_count, const GLfloat l1, const GLfloat l2) {
+    const size_t rows = path->cols->cols;
+    GLfloat max_change = 0.f;
+    my_range_for_zero(size_t, i, coords_count) {
+        const size_t col = path->coords[i];
+        if(path->norms[col] == 0.f) {
+            continue;
+        }
+        const GLfloat *const x = &my_mat_row(path->cols, col);
+        const GLfloat old = path->weights[col];
+        const GLfloat rho = my_train_cpu_dot(x, path->residuals, rows) / (GLfloat)rows + path->norms[col] * old;
+        const GLfloat updated = (rho > l1 ? rho - l1 : rho < -l1 ? rho + l1 : 0.f) / (path->norms[col] + l2);
+        const GLfloat delta = updated - old;
+        if(delta != 0.f) {
+            my_range_for_zero(size_t, row, rows) {
+                path->residuals[row] -= delta * x[row];
+            }
+            path->weights[col] = updated;
+            max_change = fmaxf(max_change, fabsf(delta));
+        }
+    }
+    return max_change;
+}
+
+static size_t my_cd_coords(MyCdPath path[static 1], const bool active_only) {
+    size_t coords_count = 0;
+    my_range_for_zero(size_t, col, path->count) {
+        if(active_only ? path->weights[col] != 0.f : path->strong[col]) {
+            path->coords[coords_count++] = col;
+        }
+    }
+    return coords_count;
+}
+
+// Fits (1/2n)|y - b - Xw|^2 + l1 |w|_1 + l2 / 2 |w|^2 from the current weights. The sequential strong rule with the previous
+// lambda's `previous_l1` screens the coordinates, a sweep over the screened set fixes the active set and sweeps over the nonzero
+// weights refine it. Screened out coordinates that violate the KKT conditions are added back until there are none.
+// Returns the number of sweeps.
+static size_t my_cd_fit(MyCdPath path[static 1], const GLfloat l1, const GLfloat l2, const GLfloat previous_l1, const GLfloat tolerance, const size_t sweeps_max) {
+    my_range_for_zero(size_t, col, path->count) {
+        path->strong[col] = path->weights[col] != 0.f || fabsf(path->correlations[col]) >= 2.f * l1 - previous_l1;
+    }
+    size_t sweeps = 0;
+    bool violations = true;
+    while(violations && sweeps < sweeps_max) {
+        while(sweeps < sweeps_max) {
+            sweeps++;
+            if(my_cd_sweep(path, my_cd_coords(path, false), l1, l2) <= tolerance) {
+                break;
+            }
+            GLfloat change;
+            do {
+                sweeps++;
+                change = my_cd_sweep(path, my_cd_coords(path, true), l1, l2);
+            } while(change > tolerance && sweeps < sweeps_max);
+        }
+        my_cd_correlations(path);
+        violations = false;
+        my_range_for_zero(size_t, col, path->count) {
+            if(!path->strong[col] && fabsf(path->correlations[col]) > l1) {
+                path->strong[col] = true;
+                violations = true;
+            }
+        }
+    }
+    return sweeps;
+}
+
+// Elastic net paths of every degree on the column-major features: lambdas are log spaced from my_cd_lambda_max down to
+// MY_CD_PATH_RATIO of it and every fit warm starts from the previous one. The l2 sweep does not apply, the path replaces it.
+static void my_train_cd(
+    const MyTrainOptions options[static 1],
+    const MyMat x_train[static 1],
+    const MyMat y_train[static 1],
+    const MyMat x_test[static 1],
+    const MyMat y_test[static 1],
+    const size_t degree,
+    const MyMat scaler[static 1]
+) {
+    ASSERT(options->l1_ratio > 0.f && options->l1_ratio <= 1.f, "invalid l1 ratio: %g", (double)options->l1_ratio);
+    const size_t count = x_train->cols * degree;
+    MyArena arena = my_arena_init(my_mat_bytes_count(&((MyMat){.rows = count, .cols = x_train->rows})) + x_test->rows * (count + 1) * sizeof(GLfloat));
+    const double start_ms = my_time_ms();
+    const MyMat cols = my_polynomial_features_create_cols(&arena, x_train, degree, scaler);
+    MyMat xb_test = my_mat_alloc(&arena, x_test->rows, count + 1);
+    my_polynomial_design_rows(x_test, degree, scaler, 0, &xb_test);
+    LOG("column-major features ms: %lf", my_time_ms() - start_ms);
+
+    my_range_for_zero(size_t, i, options->degrees_count) {
+        MyCdPath path = my_cd_path_create(&cols, x_train->cols * options->degrees[i], y_train);
+        const GLfloat lambda_max = my_cd_lambda_max(&path, options->l1_ratio);
+        GLfloat previous_l1 = lambda_max * options->l1_ratio;
+        my_range_for_zero(size_t, step, options->path_count) {
+            const double fit_start_ms = my_time_ms();
+            const double progress = options->path_count > 1 ? (double)step / (double)(options->path_count - 1) : 1.0;
+            const GLfloat lambda = (GLfloat)((double)lambda_max * pow(MY_CD_PATH_RATIO, progress));
+            const GLfloat l1 = lambda * options->l1_ratio;
+            const size_t sweeps = my_cd_fit(&path, l1, lambda * (1.f - options->l1_ratio), previous_l1, options->tolerance, options->epochs);
+            previous_l1 = l1;
+            const double fit_ms = my_time_ms() - fit_start_ms;
+
+            size_t nonzeros = 0;
+            my_range_for_zero(size_t, col, path.count) {
+                nonzeros += path.weights[col] != 0.f ? 1 : 0;
+            }
+            double train_loss = 0.0;
+            my_range_for_zero(size_t, row, x_train->rows) {
+                train_loss += (double)path.residuals[row] * (double)path.residuals[row];
+            }
+            double test_loss = 0.0;
+            const size_t active_count = my_cd_coords(&path, true);
+            my_range_for_zero(size_t, row, x_test->rows) {
+                GLfloat prediction = path.intercept;
+                my_range_for_zero(size_t, k, active_count) {
+                    prediction += path.weights[path.coords[k]] * my_mat_item(&xb_test, row, 1 + path.coords[k]);
+                }
+                test_loss += my_pow((double)(prediction - y_test->items[row]), 2);
+            }
+            LOG(
+                "degree: %zu, lambda: %g, l1_ratio: %g, nonzeros: %zu / %zu, sweeps: %zu, ms: %lf, mse: %lf, test mse: %lf",
+                options->degrees[i], (double)lambda, (double)options->l1_ratio, nonzeros, path.count, sweeps, fit_ms,
+                train_loss / (double)x_train->rows, test_loss / (double)x_test->rows
+            );
+        }
+        my_cd_path_destroy(&path);
+    }
+    my_arena_free(&arena);
+}
+
+// Normal equations of the design matrix, grown one degree at a time. Design columns are ordered by degree, so the
+// Gram matrix of a lower degree is a leading block of a higher one and growing it only computes the new power columns'
+// blocks. The Cholesky factor of gram + l2 D grows the same way, one row per new column. D skips the intercept.
+typedef struct {
+    // column-major features, design column j > 0 is row j - 1 and column 0 is the intercept
+    const MyMat *cols;
+    const MyMat *y;
+    size_t capacity;
+    size_t count;
+    size_t factor_count;
+    GLfloat l2;
+    // capacity x capacity X^T X / n, X^T y / n and y^T y / n
+    double *gram;
+    double *xty;
+    double yty;
+    double *factor;
+} MyGram;
+
+typedef struct {
+    MyGram *gram;
+    size_t first;
+} MyGramTask;
+
+#define MY_GRAM_BLOCK 4
+#define MY_GRAM_TILE_ROWS 1024
+
+// A NULL column is the intercept's column of ones.
+static double my_gram_dot(const GLfloat *const first, const GLfloat *const second, const size_t count) {
+    if(!first || !second) {
+        const GLfloat *const x = first ? first : second;
+        double sum = 0.0;
+        my_range_for_zero(size_t, i, x ? count : 0) {
+            sum += (double)x[i];
+        }
+        return x ? sum : (double)count;
+    }
+    double lanes[4] = {0.0};
+    size_t i = 0;
+    for(; i + 4 <= count; i += 4) {
+        my_range_for_zero(size_t, lane, 4) {
+            lanes[lane] += (double)first[i + lane] * (double)second[i + lane];
+        }
+    }
+    for(; i < count; ++i) {
+        lanes[0] += (double)first[i] * (double)second[i];
+    }
+    return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+}
+
+// Dot products of `x` with MY_GRAM_BLOCK columns in one pass, x is loaded once for all of them. A tile is short
+// enough to accumulate in float lanes, the tiles of a dot product add up in double.
+static void my_gram_dots(const GLfloat *const *const columns, const GLfloat *const x, const size_t count, double dots[static MY_GRAM_BLOCK]) {
+    GLfloat lanes[MY_GRAM_BLOCK][MY_TRAIN_CPU_LANES] = {{0.f}};
+    size_t i = 0;
+    for(; i + MY_TRAIN_CPU_LANES <= count; i += MY_TRAIN_CPU_LANES) {
+        my_range_for_zero(size_t, b, MY_GRAM_BLOCK) {
+            my_range_for_zero(size_t, lane, MY_TRAIN_CPU_LANES) {
+                lanes[b][lane] += x[i + lane] * columns[b][i + lane];
+            }
+        }
+    }
+    my_range_for_zero(size_t, b, MY_GRAM_BLOCK) {
+        double sum = 0.0;
+        my_range_for(size_t, tail, i, count) {
+            sum += (double)x[tail] * (double)columns[b][tail];
+        }
+        my_range_for_zero(size_t, lane, MY_TRAIN_CPU_LANES) {
+            sum += (double)lanes[b][lane];
+        }
+        dots[b] = sum;
+    }
+}
+
+static const GLfloat* my_gram_col(const MyGram gram[static 1], const size_t col) {
+    return col == 0 ? NULL : &my_mat_row(gram->cols, (col - 1));
+}
+
+static MyGram my_gram_create(const MyMat cols[static 1], const MyMat y[static 1]) {
+    ASSERT(y->rows == cols->cols);
+    const size_t capacity = cols->rows + 1;
+    MyGram gram = {
+        .cols = cols,
+        .y = y,
+        .capacity = capacity,
+        .gram = (double*)malloc(capacity * capacity * sizeof(double)),
+        .xty = (double*)malloc(capacity * sizeof(double)),
+        .yty = my_gram_dot(y->items, y->items, y->rows) / (double)y->rows,
+        .factor = (double*)malloc(capacity * capacity * sizeof(double)),
+    };
+    ASSERT(gram.gram && gram.xty && gram.factor);
+    return gram;
+}
+
+static void my_gram_destroy(MyGram gram[static 1]) {
+    free(gram->gram);
+    free(gram->xty);
+    free(gram->factor);
+    *gram = (MyGram){0};
+}
+
+// Rows go MY_GRAM_TILE_ROWS at a time, so the tiles of the old columns stay in cache while every new column of the chunk reads them.
+static void my_gram_grow_cols(void *const context, const size_t first, const size_t end) {
+    const MyGramTask *const task = (const MyGramTask*)context;
+    MyGram *const gram = task->gram;
+    const size_t rows = gram->cols->cols;
+    const size_t capacity = gram->capacity;
+    my_range_for(size_t, j, task->first + first, task->first + end) {
+        memset(&gram->gram[j * capacity], 0, (j + 1) * sizeof(double));
+        gram->xty[j] = 0.0;
+    }
+    for(size_t row_first = 0; row_first < rows; row_first += MY_GRAM_TILE_ROWS) {
+        const size_t tile_rows = rows - row_first < MY_GRAM_TILE_ROWS ? rows - row_first : MY_GRAM_TILE_ROWS;
+        my_range_for(size_t, j, task->first + first, task->first + end) {
+            const GLfloat *const x = my_gram_col(gram, j) ? my_gram_col(gram, j) + row_first : NULL;
+            double *const dst = &gram->gram[j * capacity];
+            // the intercept column is the sum of x, the others go MY_GRAM_BLOCK at a time
+            size_t i = 0;
+            if(x) {
+                dst[0] += my_gram_dot(NULL, x, tile_rows);
+                for(i = 1; i + MY_GRAM_BLOCK <= j + 1; i += MY_GRAM_BLOCK) {
+                    const GLfloat *columns[MY_GRAM_BLOCK];
+                    my_range_for_zero(size_t, k, MY_GRAM_BLOCK) {
+                        columns[k] = my_gram_col(gram, i + k) + row_first;
+                    }
+                    double dots[MY_GRAM_BLOCK];
+                    my_gram_dots(columns, x, tile_rows, dots);
+                    my_range_for_zero(size_t, k, MY_GRAM_BLOCK) {
+                        dst[i + k] += dots[k];
+                    }
+                }
+            }
+            for(; i < j + 1; ++i) {
+                const GLfloat *const column = my_gram_col(gram, i) ? my_gram_col(gram, i) + row_first : NULL;
+                dst[i] += my_gram_dot(column, x, tile_rows);
+            }
+            gram->xty[j] += my_gram_dot(x, gram->y->items + row_first, tile_rows);
+        }
+    }
+    my_range_for(size_t, j, task->first + first, task->first + end) {
+        my_range_for_zero(size_t, i, j + 1) {
+            gram->gram[j * capacity + i] /= (double)rows;
+            gram->gram[i * capacity + j] = gram->gram[j * capacity + i];
+        }
+        gram->xty[j] /= (double)rows;
+    }
+}
+
+static void my_gram_grow(MyGram gram[static 1], const size_t count) {
+    ASSERT(count <= gram->capacity);
+    if(count > gram->count) {
+        my_parallel_for("my_gram_grow", count - gram->count, MY_GRAM_BLOCK, my_gram_grow_cols, &(MyGramTask){.gram = gram, .first = gram->count});
+        gram->count = count;
+    }
+}
+
+// Extends the factor to the first `count` columns, a different l2 starts it over. Returns false when gram + l2 D
+// is not numerically positive definite, the factor then keeps its valid leading rows.
+static bool my_gram_factor(MyGram gram[static 1], const size_t count, const GLfloat l2) {
+    ASSERT(count <= gram->count);
+    if(!my_f64_bits_equal((double)l2, (double)gram->l2)) {
+        gram->factor_count = 0;
+        gram->l2 = l2;
+    }
+    double *const factor = gram->factor;
+    const size_t capacity = gram->capacity;
+    my_range_for(size_t, j, gram->factor_count, count) {
+        my_range_for_zero(size_t, i, j + 1) {
+            double sum = gram->gram[j * capacity + i] + (i == j && j > 0 ? (double)l2 : 0.0);
+            my_range_for_zero(size_t, k, i) {
+                sum -= factor[j * capacity + k] * factor[i * capacity + k];
+            }
+            if(i < j) {
+                factor[j * capacity + i] = sum / factor[i * capacity + i];
+            } else if(sum > 0.0) {
+                factor[j * capacity + j] = sqrt(sum);
+            } else {
+                return false;
+            }
+        }
+        gram->factor_count = j + 1;
+    }
+    return true;
+}
+
+// Solves L L^T w = X^T y / n for the first `count` columns.
+static void my_gram_solve(const MyGram gram[static 1], const size_t count, double *const weights) {
+    ASSERT(count <= gram->factor_count);
+    const double *const factor = gram->factor;
+    const size_t capacity = gram->capacity;
+    my_range_for_zero(size_t, i, count) {
+        double sum = gram->xty[i];
+        my_range_for_zero(size_t, k, i) {
+            sum -= factor[i * capacity + k] * weights[k];
+        }
+        weights[i] = sum / factor[i * capacity + i];
+    }
+    for(size_t i = count; i-- > 0;) {
+        double sum = weights[i];
+        my_range_for(size_t, k, i + 1, count) {
+            sum -= factor[k * capacity + i] * weights[k];
+        }
+        weights[i] = sum / factor[i * capacity + i];
+    }
+}
+
+// Training mse from the normal equations, w^T G w - 2 w^T X^T y / n + y^T y / n.
+static double my_gram_mse(const MyGram gram[static 1], const size_t count, const double *const weights) {
+    double mse = gram->yty;
+    my_range_for_zero(size_t, i, count) {
+        double row = 0.0;
+        my_range_for_zero(size_t, j, count) {
+            row += gram->gram[i * gram->capacity + j] * weights[j];
+        }
+        mse += weights[i] * (row - 2.0 * gram->xty[i]);
+    }
+    return mse;
+}
+
+// Closed form ridge fits of every degree x l2 combination. Degrees run in ascending order, so the Gram matrix and the
+// factor of each l2 are only extended by the new power columns and the sweep costs about as much as its largest degree.
+static void my_train_cholesky(
+    const MyTrainOptions options[static 1],
+    const MyMat x_train[static 1],
+    const MyMat y_train[static 1],
+    const MyMat x_test[static 1],
+    const MyMat y_test[static 1],
+    const size_t degree,
+    const MyMat scaler[static 1]
+) {
+    const size_t count = x_train->cols * degree + 1;
+    MyArena arena = my_arena_init((x_train->rows * (count - 1) + x_test->rows * count) * sizeof(GLfloat));
+    const double start_ms = my_time_ms();
+    const MyMat cols = my_polynomial_features_create_cols(&arena, x_train, degree, scaler);
+    MyMat xb_test = my_mat_alloc(&arena, x_test->rows, count);
+    my_polynomial_design_rows(x_test, degree, scaler, 0, &xb_test);
+    LOG("column-major features ms: %lf", my_time_ms() - start_ms);
+
+    size_t degrees[MY_TRAIN_SWEEP_MAX];
+    memcpy(degrees, options->degrees, options->degrees_count * sizeof(*degrees));
+    my_range_for(size_t, i, 1, options->degrees_count) {
+        for(size_t j = i; j > 0 && degrees[j - 1] > degrees[j]; --j) {
+            const size_t swapped = degrees[j];
+            degrees[j] = degrees[j - 1];
+            degrees[j - 1] = swapped;
+        }
+    }
+    MyGram gram = my_gram_create(&cols, y_train);
+    double *const weights = (double*)malloc(count * sizeof(double));
+    ASSERT(weights);
+    const double y_variance = gram.yty - my_pow(gram.xty[0], 2);
+    double gram_ms = 0.0, factor_ms = 0.0;
+    my_range_for_zero(size_t, l, options->l2s_count) {
+        const GLfloat l2 = options->l2s[l];
+        my_range_for_zero(size_t, i, options->degrees_count) {
+            const size_t job_count = x_train->cols * degrees[i] + 1;
+            const double grow_start_ms = my_time_ms();
+            my_gram_grow(&gram, job_count);
+            const double factor_start_ms = my_time_ms();
+            const bool factored = my_gram_factor(&gram, job_count, l2);
+            gram_ms += factor_start_ms - grow_start_ms;
+            factor_ms += my_time_ms() - factor_start_ms;
+            if(!factored) {
+                LOG("degree: %zu, l2: %g, the normal equations are not positive definite, higher degrees of this l2 are skipped", degrees[i], (double)l2);
+                break;
+            }
+            my_gram_solve(&gram, job_count, weights);
+            const double mse = my_gram_mse(&gram, job_count, weights);
+            double test_loss = 0.0;
+            my_range_for_zero(size_t, row, x_test->rows) {
+                double prediction = 0.0;
+                my_range_for_zero(size_t, col, job_count) {
+                    prediction += weights[col] * (double)my_mat_item(&xb_test, row, col);
+                }
+                test_loss += my_pow(prediction - (double)y_test->items[row], 2);
+            }
+            LOG(
+                "degree: %zu, l2: %g, solver: cholesky, mse: %lf, r2: %lf, test mse: %lf",
+                degrees[i], (double)l2, mse, 1.0 - mse / y_variance, test_loss / (double)x_test->rows
+            );
+        }
+    }
+    LOG("cholesky sweep ms: %lf, gram ms: %lf, factor ms: %lf", my_time_ms() - start_ms, gram_ms, factor_ms);
+    free(weights);
+    my_gram_destroy(&gram);
+    my_arena_free(&arena);
+}
+
+#define MY_MONOMIAL_DEGREE_MAX 4
+#define MY_MONOMIAL_BLOCK 1024
+
+// Product of standardized raw features z[vars[0]] * ... * z[vars[degree - 1]] with nondecreasing vars,
+// so x_i * x_j and x_j^2 are both monomials of degree 2.
+typedef struct {
+    size_t degree;
+    uint16_t vars[MY_MONOMIAL_DEGREE_MAX];
+} MyMonomial;
+
+// Graded lexicographic order: all monomials of degree d come before degree d + 1, C(n + D, D) - 1 of them up to degree D.
+// Starts from a zeroed monomial and returns false after the last one.
+static bool my_monomial_next(MyMonomial monomial[static 1], const size_t features_count, const size_t degree_max) {
+    ASSERT(degree_max <= MY_MONOMIAL_DEGREE_MAX && features_count <= UINT16_MAX);
+    for(size_t i = monomial->degree; i-- > 0;) {
+        if(monomial->vars[i] + 1u < features_count) {
+            monomial->vars[i]++;
+            my_range_for(size_t, j, i + 1, monomial->degree) {
+                monomial->vars[j] = monomial->vars[i];
+            }
+            return true;
+        }
+    }
+    if(monomial->degree == degree_max) {
+        return false;
+    }
+    *monomial = (MyMonomial){.degree = monomial->degree + 1};
+    return true;
+}
+
+static size_t my_monomial_name(const MyMonomial monomial[static 1], char *const name, const size_t name_size) {
+    size_t length = 0;
+    my_range_for_zero(size_t, i, monomial->degree) {
+        length += (size_t)snprintf(name + length, length < name_size ? name_size - length : 0, "%sx%u", i > 0 ? "*" : "", (unsigned)monomial->vars[i]);
+    }
+    return length;
+}
+
+// Values of a monomial over `count` rows of column-major standardized features.
+static void my_monomial_eval(const MyMonomial monomial[static 1], const MyMat z_cols[static 1], const size_t row_first, const size_t count, GLfloat *const dst) {
+    memcpy(dst, &my_mat_row(z_cols, (size_t)monomial->vars[0]) + row_first, count * sizeof(GLfloat));
+    my_range_for(size_t, i, 1, monomial->degree) {
+        const GLfloat *const z = &my_mat_row(z_cols, (size_t)monomial->vars[i]) + row_first;
+        my_range_for_zero(size_t, row, count) {
+            dst[row] *= z[row];
+        }
+    }
+}
+
+typedef struct {
+    MyMonomial monomial;
+    double mean;
+    double std;
+    // |correlation| with y
+    double score;
+} MyMonomialStats;
+
+typedef struct {
+    const MyMat *z_cols;
+    const GLfloat *y_centered;
+    MyMonomialStats *stats;
+} MyMonomialTask;
+
+#define MY_MONOMIAL_TILE_ROWS 1024
+
+// Mean, std and correlation with y of every monomial in the chunk, the values live in one tile at a time.
+static void my_monomial_stats_block(void *const context, const size_t first, const size_t end) {
+    const MyMonomialTask *const task = (const MyMonomialTask*)context;
+    const size_t rows = task->z_cols->cols;
+    GLfloat values[MY_MONOMIAL_TILE_ROWS];
+    my_range_for(size_t, i, first, end) {
+        MyMonomialStats *const stats = &task->stats[i];
+        double sum = 0.0, squares = 0.0, products = 0.0, y_squares = 0.0;
+        for(size_t row_first = 0; row_first < rows; row_first += MY_MONOMIAL_TILE_ROWS) {
+            const size_t count = rows - row_first < MY_MONOMIAL_TILE_ROWS ? rows - row_first : MY_MONOMIAL_TILE_ROWS;
+            my_monomial_eval(&stats->monomial, task->z_cols, row_first, count, values);
+            my_range_for_zero(size_t, row, count) {
+                const double value = (double)values[row], y = (double)task->y_centered[row_first + row];
+                sum += value;
+                squares += value * value;
+                products += value * y;
+                y_squares += y * y;
+            }
+        }
+        stats->mean = sum / (double)rows;
+        const double variance = squares / (double)rows - stats->mean * stats->mean;
+        stats->std = variance > 0.0 ? sqrt(variance) : 1.0;
+        stats->score = variance > 0.0 && y_squares > 0.0 ? fabs(products) / sqrt(variance * (double)rows * y_squares) : 0.0;
+    }
+}
+
+// Keeps the `k` best scoring monomials in a min-heap on score, heap[0] is the weakest kept one.
+static void my_monomial_heap_push(MyMonomialStats *const heap, size_t heap_count[static 1], const size_t k, const MyMonomialStats stats[static 1]) {
+    size_t i;
+    if(*heap_count < k) {
+        i = (*heap_count)++;
+        while(i > 0 && heap[(i - 1) / 2].score > stats->score) {
+            heap[i] = heap[(i - 1) / 2];
+            i = (i - 1) / 2;
+        }
+    } else if(stats->score > heap[0].score) {
+        i = 0;
+        for(size_t child; (child = 2 * i + 1) < k; i = child) {
+            child += child + 1 < k && heap[child + 1].score < heap[child].score ? 1 : 0;
+            if(heap[child].score >= stats->score) {
+                break;
+            }
+            heap[i] = heap[child];
+        }
+    } else {
+        return;
+    }
+    heap[i] = *stats;
+}
+
+static int my_monomial_stats_compare(const void *const first, const void *const second) {
+    const double a = ((const MyMonomialStats*)first)->score, b = ((const MyMonomialStats*)second)->score;
+    return a < b ? 1 : a > b ? -1 : 0;
+}
+
+// Streams every monomial up to `degree_max` in blocks of MY_MONOMIAL_BLOCK, scores them by correlation with y without
+// materializing any, and returns how many of the `k` best were kept in `selected`, best first.
+static size_t my_monomial_select(
+    const MyMat z_cols[static 1],
+    const MyMat y[static 1],
+    const size_t degree_max,
+    const size_t k,
+    MyMonomialStats selected[static 1],
+    size_t monomials_count[static 1]
+) {
+    const size_t rows = z_cols->cols;
+    GLfloat *const y_centered = (GLfloat*)malloc(rows * sizeof(GLfloat));
+    MyMonomialStats *const block = (MyMonomialStats*)malloc(MY_MONOMIAL_BLOCK * sizeof(MyMonomialStats));
+    ASSERT(y_centered && block);
+    double y_mean = 0.0;
+    my_range_for_zero(size_t, row, rows) {
+        y_mean += (double)y->items[row];
+    }
+    y_mean /= (double)rows;
+    my_range_for_zero(size_t, row, rows) {
+        y_centered[row] = (GLfloat)((double)y->items[row] - y_mean);
+    }
+    size_t selected_count = 0;
+    *monomials_count = 0;
+    MyMonomial monomial = {0};
+    for(bool more = my_monomial_next(&monomial, z_cols->rows, degree_max); more;) {
+        size_t block_count = 0;
+        for(; more && block_count < MY_MONOMIAL_BLOCK; more = my_monomial_next(&monomial, z_cols->rows, degree_max)) {
+            block[block_count++] = (MyMonomialStats){.monomial = monomial};
+        }
+        my_parallel_for("my_monomial_select", block_count, 16, my_monomial_stats_block, &(MyMonomialTask){.z_cols = z_cols, .y_centered = y_centered, .stats = block});
+        my_range_for_zero(size_t, i, block_count) {
+            my_monomial_heap_push(selected, &selected_count, k, &block[i]);
+        }
+        *monomials_count += block_count;
+    }
+    qsort(selected, selected_count, sizeof(*selected), my_monomial_stats_compare);
+    free(block);
+    free(y_centered);
+    return selected_count;
+}
+
+typedef struct {
+    const MyMat *z_cols;
+    const MyMonomialStats *selected;
+    MyMat *cols;
+} MyMonomialColsTask;
+
+static void my_monomial_cols_block(void *const context, const size_t first, const size_t end) {
+    const MyMonomialColsTask *const task = (const MyMonomialColsTask*)context;
+    my_range_for(size_t, i, first, end) {
+        GLfloat *const dst = &my_mat_row(task->cols, i);
+        my_monomial_eval(&task->selected[i].monomial, task->z_cols, 0, task->z_cols->cols, dst);
+        my_range_for_zero(size_t, row, task->z_cols->cols) {
+            dst[row] = (GLfloat)(((double)dst[row] - task->selected[i].mean) / task->selected[i].std);
+        }
+    }
+}
+
+// Ridge fits on the `top_k` monomials up to total degree `interactions` that correlate best with y. Only the selected
+// monomials are materialized, as standardized column-major features for the Gram matrix and Cholesky solve of
+// my_train_cholesky. Test rows evaluate the selected monomials on the fly.
+static void my_train_interactions(
+    const MyTrainOptions options[static 1],
+    const MyMat x_train[static 1],
+    const MyMat y_train[static 1],
+    const MyMat x_test[static 1],
+    const MyMat y_test[static 1],
+    const MyMat scaler[static 1]
+) {
+    const size_t rows = x_train->rows;
+    MyArena arena = my_arena_init((x_train->cols + options->top_k) * rows * sizeof(GLfloat) + x_test->rows * (x_train->cols + 1) * sizeof(GLfloat));
+    const double start_ms = my_time_ms();
+    const MyMat z_cols = my_polynomial_features_create_cols(&arena, x_train, 1, scaler);
+    MyMat z_test = my_mat_alloc(&arena, x_test->rows, x_train->cols + 1);
+    my_polynomial_design_rows(x_test, 1, scaler, 0, &z_test);
+
+    MyMonomialStats *const selected = (MyMonomialStats*)malloc(options->top_k * sizeof(MyMonomialStats));
+    ASSERT(selected);
+    size_t monomials_count;
+    const size_t selected_count = my_monomial_select(&z_cols, y_train, options->interactions, options->top_k, selected, &monomials_count);
+    LOG("interactions: %zu, monomials: %zu, top-k: %zu, selection ms: %lf", options->interactions, monomials_count, selected_count, my_time_ms() - start_ms);
+    my_range_for_zero(size_t, i, selected_count < 10 ? selected_count : 10) {
+        char name[64];
+        my_monomial_name(&selected[i].monomial, name, sizeof(name));
+        LOG("rank: %zu, monomial: %s, score: %lf", i, name, selected[i].score);
+    }
+
+    MyMat cols = my_mat_alloc(&arena, selected_count, rows);
+    my_parallel_for("my_monomial_cols", selected_count, 4, my_monomial_cols_block, &(MyMonomialColsTask){.z_cols = &z_cols, .selected = selected, .cols = &cols});
+    MyGram gram = my_gram_create(&cols, y_train);
+    my_gram_grow(&gram, selected_count + 1);
+    double *const weights = (double*)malloc((selected_count + 1) * sizeof(double));
+    ASSERT(weights);
+    const double y_variance = gram.yty - my_pow(gram.xty[0], 2);
+    my_range_for_zero(size_t, l, options->l2s_count) {
+        const GLfloat l2 = options->l2s[l];
+        if(!my_gram_factor(&gram, selected_count + 1, l2)) {
+            LOG("l2: %g, the normal equations are not positive definite", (double)l2);
+            continue;
+        }
+        my_gram_solve(&gram, selected_count + 1, weights);
+        const double mse = my_gram_mse(&gram, selected_count + 1, weights);
+        double test_loss = 0.0;
+        my_range_for_zero(size_t, row, x_test->rows) {
+            double prediction = weights[0];
+            my_range_for_zero(size_t, i, selected_count) {
+                const MyMonomial *const monomial = &selected[i].monomial;
+                double value = 1.0;
+                my_range_for_zero(size_t, v, monomial->degree) {
+                    value *= (double)my_mat_item(&z_test, row, 1 + (size_t)monomial->vars[v]);
+                }
+                prediction += weights[1 + i] * (value - selected[i].mean) / selected[i].std;
+            }
+            test_loss += my_pow(prediction - (double)y_test->items[row], 2);
+        }
+        LOG(
+            "interactions: %zu, top-k: %zu, l2: %g, solver: cholesky, mse: %lf, r2: %lf, test mse: %lf",
+            options->interactions, selected_count, (double)l2, mse, 1.0 - mse / y_variance, test_loss / (double)x_test->rows
+        );
+    }
+    LOG("interactions ms: %lf", my_time_ms() - start_ms);
+    free(weights);
+    my_gram_destroy(&gram);
+    free(selected);
+    my_arena_free(&arena);
+}
+
+#define MY_MODEL_MAGIC "mypoly1"
+
+// Model file: header, scaler means and stds of the n * degree power columns, then the n * degree + 1 weights.
+typedef struct {
+    char magic[8];
+    uint32_t features_count;
+    uint32_t degree;
+} MyModelHeader;
+
+// `scaler` may hold more columns than the model uses, the power columns of a lower degree are its prefix.
+static void my_model_save(const char path[static 1], const size_t features_count, const size_t degree, const MyMat scaler[static 1], const GLfloat weights[static 1]) {
+    const size_t cols = features_count * degree;
+    ASSERT(scaler->rows == 2 && scaler->cols >= cols);
+    MyModelHeader header = {.features_count = (uint32_t)features_count, .degree = (uint32_t)degree};
+    memcpy(header.magic, MY_MODEL_MAGIC, sizeof(header.magic));
+    const int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    ASSERT_NOT_MINUS_ONE(fd, "%s", path);
+    ASSERT(write(fd, &header, sizeof(header)) == (ssize_t)sizeof(header));
+    my_range_for_zero(size_t, row, 2) {
+        ASSERT(write(fd, &my_mat_row(scaler, row), cols * sizeof(GLfloat)) == (ssize_t)(cols * sizeof(GLfloat)));
+    }
+    ASSERT(write(fd, weights, (cols + 1) * sizeof(GLfloat)) == (ssize_t)((cols + 1) * sizeof(GLfloat)));
+    ASSERT_NOT_MINUS_ONE(close(fd));
+    LOG("model: %s, features: %zu, degree: %zu", path, features_count, degree);
+}
+
+// Jobs of one degree x l2 combination are its folds in order, the held out mse of every fold is averaged.
+// Returns the first job of the combination with the lowest mean fold mse.
+static size_t my_train_cv_report(const MyTrainOptions options[static 1], const MyTrainJob *const jobs, const size_t jobs_count, const double elapsed_ms) {
+    size_t best = 0;
+    double best_mse = INFINITY;
+    for(size_t first = 0; first < jobs_count; first += options->folds) {
+        double mean = 0.0;
+        my_range_for(size_t, i, first, first + options->folds) {
+            LOG(
+                "degree: %zu, l2: %g, fold: %zu, held out rows: %u, train mse: %lf, fold mse: %lf",
+                jobs[i].degree, (double)jobs[i].l2, i - first, jobs[i].fold_end - jobs[i].fold_first, jobs[i].mse, jobs[i].fold_mse
+            );
+            mean += jobs[i].fold_mse;
+        }
+        mean /= (double)options->folds;
+        double variance = 0.0;
+        my_range_for(size_t, i, first, first + options->folds) {
+            variance += my_pow(jobs[i].fold_mse - mean, 2);
+        }
+        LOG(
+            "degree: %zu, l2: %g, folds: %zu, mean fold mse: %lf, std: %lf",
+            jobs[first].degree, (double)jobs[first].l2, options->folds, mean, sqrt(variance / (double)options->folds)
+        );
+        if(mean < best_mse) {
+            best_mse = mean;
+            best = first;
+        }
+    }
+    LOG("best degree: %zu, l2: %g, mean fold mse: %lf, cross-validation ms: %lf", jobs[best].degree, (double)jobs[best].l2, best_mse, elapsed_ms);
+    return best;
+}
+
+// Every degree x l2 combination of the options is one job, or one job per fold with cross-validation, trained by the selected backend.
+static void my_polynomial_train(const MyTrainOptions options) {
+    MyMat x_train = {.rows = 20210, .cols = 167};
+    MyMat y_train = {.rows = 20210, .cols = 1};
+    MyMat x_test = {.rows = 1053, .cols = 167};
+    MyMat y_test = {.rows = 1053, .cols = 1};
+
+    const MyMemPhase phase = my_mem_phase_set(MY_MEM_PHASE_LOAD);
+    MyArena arena = my_arena_init(
+        my_mat_bytes_count(&x_train)
+        + my_mat_bytes_count(&y_train)
+        + my_mat_bytes_count(&x_test)
+        + my_mat_bytes_count(&y_test)
+    );
+    #define LOCAL_MACRO(mat) my_read_bin_data_to_mat(&mat, &arena, "data/" #mat ".bin")
+        LOCAL_MACRO(x_train);
+        LOCAL_MACRO(y_train);
+        LOCAL_MACRO(x_test);
+        LOCAL_MACRO(y_test);
+    #undef LOCAL_MACRO
+
+    const double start_ms = my_time_ms();
+    size_t degree = 0;
+    my_range_for_zero(size_t, i, options.degrees_count) {
+        degree = options.degrees[i] > degree ? options.degrees[i] : degree;
+    }
+    my_mem_phase_set(MY_MEM_PHASE_FEATURES);
+    MyArena fit_arena = my_arena_init(1024 * 1024 * 300);
+    MyMat scaler = my_mat_alloc(&fit_arena, 2, x_train.cols * degree);
+    my_polynomial_scaler_fit(&x_train, degree, &scaler);
+    my_mem_phase_set(MY_MEM_PHASE_TRAIN);
+    if(options.interactions > 0) {
+        my_train_interactions(&options, &x_train, &y_train, &x_test, &y_test, &scaler);
+        my_arena_free(&fit_arena);
+        my_arena_free(&arena);
+        my_mem_phase_set(phase);
+        return;
+    }
+    if(options.solver == MY_SOLVER_CD) {
+        my_train_cd(&options, &x_train, &y_train, &x_test, &y_test, degree, &scaler);
+        my_arena_free(&fit_arena);
+        my_arena_free(&arena);
+        my_mem_phase_set(phase);
+        return;
+    }
+    if(options.solver == MY_SOLVER_CHOLESKY) {
+        my_train_cholesky(&options, &x_train, &y_train, &x_test, &y_test, degree, &scaler);
+        my_arena_free(&fit_arena);
+        my_arena_free(&arena);
+        my_mem_phase_set(phase);
+        return;
+    }
+    MyMat xb_test = {0};
+    if(options.validate_storage || options.model_path) {
+        my_mem_phase_set(MY_MEM_PHASE_FEATURES);
+        xb_test = my_polynomial_design_matrix(&fit_arena, &x_test, degree, &scaler, false);
+        my_mem_phase_set(MY_MEM_PHASE_TRAIN);
+    }
+
+    const size_t folds_count = options.folds > 0 ? options.folds : 1;
+    const size_t jobs_count = options.degrees_count * options.l2s_count * folds_count;
+    MyTrainJob *const jobs = (MyTrainJob*)malloc(jobs_count * sizeof(*jobs));
+    ASSERT(jobs);
+    my_range_for_zero(size_t, i, jobs_count) {
+        const size_t combination = i / folds_count, fold = i % folds_count;
+        jobs[i] = (MyTrainJob){
+            .degree = options.degrees[combination / options.l2s_count],
+            .l2 = options.l2s[combination % options.l2s_count],
+        };
+        if(options.folds > 0) {
+            jobs[i].fold_first = (GLuint)(x_train.rows * fold / options.folds);
+            jobs[i].fold_end = (GLuint)(x_train.rows * (fold + 1) / options.folds);
+        }
+        if(options.model_path && options.folds == 0) {
+            jobs[i].trained_weights = (GLfloat*)malloc((x_train.cols * jobs[i].degree + 1) * sizeof(GLfloat));
+            ASSERT(jobs[i].trained_weights);
+        }
+    }
+    if(options.backend == MY_TRAIN_BACKEND_CPU) {
+        ASSERT(!options.device, "--device needs the gl backend");
+        ASSERT(options.folds == 0, "--folds needs the gl backend");
+        my_train_cpu(&options, &x_train, &y_train, degree, &scaler, jobs, jobs_count, start_ms);
+    } else if(options.folds > 0) {
+        my_train_gl_folds(&options, &x_train, &y_train, &y_test, degree, &xb_test, jobs, jobs_count, start_ms);
+    } else {
+        my_train_gl(&options, &x_train, &y_train, &y_test, degree, &scaler, &xb_test, jobs, jobs_count, start_ms);
+    }
+    my_mem_phase_set(MY_MEM_PHASE_EVALUATE);
+    size_t best = 0;
+    if(options.folds > 0) {
+        best = my_train_cv_report(&options, jobs, jobs_count, my_time_ms() - start_ms);
+    } else {
+        my_range_for_zero(size_t, i, jobs_count) {
+            LOG("degree: %zu, l2: %g, final mse: %lf, r2: %lf", jobs[i].degree, (double)jobs[i].l2, jobs[i].mse, jobs[i].r2);
+        }
+    }
+    if(options.model_path) {
+        // the fold jobs only pick the combination, the saved model is retrained on every training row
+        MyTrainJob model_job = jobs[best];
+        if(options.folds > 0) {
+            MyTrainOptions model_options = options;
+            model_options.folds = 0;
+            model_job = (MyTrainJob){
+                .degree = jobs[best].degree,
+                .l2 = jobs[best].l2,
+                .trained_weights = (GLfloat*)malloc((x_train.cols * jobs[best].degree + 1) * sizeof(GLfloat)),
+            };
+            ASSERT(model_job.trained_weights);
+            my_train_gl(&model_options, &x_train, &y_train, &y_test, degree, &scaler, &xb_test, &model_job, 1, start_ms);
+        }
+        // the test split is only reported, it never takes part in picking the model
+        const size_t cols = x_train.cols * model_job.degree + 1;
+        double test_loss = 0.0;
+        my_range_for_zero(size_t, row, xb_test.rows) {
+            double prediction = 0.0;
+            my_range_for_zero(size_t, col, cols) {
+                prediction += (double)model_job.trained_weights[col] * (double)my_mat_item(&xb_test, row, col);
+            }
+            test_loss += my_pow(prediction - (double)y_test.items[row], 2);
+        }
+        LOG("degree: %zu, l2: %g, test mse: %lf", model_job.degree, (double)model_job.l2, test_loss / (double)xb_test.rows);
+        my_model_save(options.model_path, x_train.cols, model_job.degree, &scaler, model_job.trained_weights);
+        if(options.folds > 0) {
+            free(model_job.trained_weights);
+        }
+        my_range_for_zero(size_t, i, jobs_count) {
+            free(jobs[i].trained_weights);
+        }
+    }
+
+    free(jobs);
+    my_arena_free(&fit_arena);
+    my_arena_free(&arena);
+    my_mem_phase_set(phase);
+}
+
+// A loaded model with the scaling folded into the weights: coefficient d of feature j multiplies x_j^(d + 1) and
+// lives at coeffs[d * features_count + j], so one power of neighbouring features is contiguous.
+typedef struct {
+    size_t features_count;
+    size_t degree;
+    GLfloat bias;
+    GLfloat *coeffs;
+} MyModel;
+
+static MyModel my_model_load(const char path[static 1]) {
+    const int fd = open(path, O_RDONLY);
+    ASSERT_NOT_MINUS_ONE(fd, "%s", path);
+    struct stat stat;
+    ASSERT_NOT_MINUS_ONE(fstat(fd, &stat));
+    ASSERT((size_t)stat.st_size >= sizeof(MyModelHeader), "%s is not a model", path);
+    void *const data = mmap(NULL, (size_t)stat.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ASSERT(data != MAP_FAILED);
+    MyModelHeader header;
+    memcpy(&header, data, sizeof(header));
+    ASSERT(memcmp(header.magic, MY_MODEL_MAGIC, sizeof(header.magic)) == 0 && header.degree > 0, "%s is not a model", path);
+    const size_t cols = (size_t)header.features_count * header.degree;
+    ASSERT((size_t)stat.st_size == sizeof(header) + (3 * cols + 1) * sizeof(GLfloat), "%s is truncated", path);
+    // the mapping is page aligned and the header is a whole number of floats
+    const GLfloat *const means = (const GLfloat*)(const void*)((const char*)data + sizeof(header));
+    const GLfloat *const stds = means + cols;
+    const GLfloat *const weights = stds + cols;
+
+    MyModel model = {.features_count = header.features_count, .degree = header.degree, .coeffs = (GLfloat*)malloc(cols * sizeof(GLfloat))};
+    ASSERT(model.coeffs);
+    // w (x^d - mean) / std = (w / std) x^d - w mean / std
+    double bias = (double)weights[0];
+    my_range_for_zero(size_t, col, cols) {
+        model.coeffs[col] = weights[1 + col] / stds[col];
+        bias -= (double)weights[1 + col] * (double)means[col] / (double)stds[col];
+    }
+    model.bias = (GLfloat)bias;
+    ASSERT_NOT_MINUS_ONE(munmap(data, (size_t)stat.st_size));
+    ASSERT_NOT_MINUS_ONE(close(fd));
+    return model;
+}
+
+static void my_model_destroy(MyModel model[static 1]) {
+    free(model->coeffs);
+    *model = (MyModel){0};
+}
+
+// bias + sum_j x_j (c_0j + x_j (c_1j + ... + x_j c_(degree - 1)j)), Horner steps run on MY_TRAIN_CPU_LANES features at once.
+static GLfloat my_model_predict_row(const MyModel model[static 1], const GLfloat *restrict const x) {
+    const size_t n = model->features_count;
+    const GLfloat *restrict const coeffs = model->coeffs;
+    GLfloat sums[MY_TRAIN_CPU_LANES] = {0.f};
+    size_t j = 0;
+    for(; j + MY_TRAIN_CPU_LANES <= n; j += MY_TRAIN_CPU_LANES) {
+        GLfloat acc[MY_TRAIN_CPU_LANES];
+        my_range_for_zero(size_t, lane, MY_TRAIN_CPU_LANES) {
+            acc[lane] = coeffs[(model->degree - 1) * n + j + lane];
+        }
+        for(size_t d = model->degree - 1; d-- > 0;) {
+            my_range_for_zero(size_t, lane, MY_TRAIN_CPU_LANES) {
+                acc[lane] = acc[lane] * x[j + lane] + coeffs[d * n + j + lane];
+            }
+        }
+        my_range_for_zero(size_t, lane, MY_TRAIN_CPU_LANES) {
+            sums[lane] += acc[lane] * x[j + lane];
+        }
+    }
+    for(; j < n; ++j) {
+        GLfloat acc = coeffs[(model->degree - 1) * n + j];
+        for(size_t d = model->degree - 1; d-- > 0;) {
+            acc = acc * x[j] + coeffs[d * n + j];
+        }
+        sums[0] += acc * x[j];
+    }
+    GLfloat sum = model->bias;
+    my_range_for_zero(size_t, lane, MY_TRAIN_CPU_LANES) {
+        sum += sums[lane];
+    }
+    return sum;
+}
+
+typedef struct {
+    const MyModel *model;
+    const MyMat *x;
+    GLfloat *predictions;
+} MyModelTask;
+
+static void my_model_predict_rows(void *const context, const size_t row_first, const size_t row_end) {
+    const MyModelTask *const task = (const MyModelTask*)context;
+    my_range_for(size_t, row, row_first, row_end) {
+        task->predictions[row] = my_model_predict_row(task->model, &my_mat_row(task->x, row));
+    }
+}
+
+#define MY_MODEL_GRAIN 64
+
+static void my_model_predict(const MyModel model[static 1], const MyMat x[static 1], GLfloat predictions[static 1]) {
+    ASSERT(x->cols == model->features_count);
+    my_parallel_for("my_model_predict", x->rows, MY_MODEL_GRAIN, my_model_predict_rows, &(MyModelTask){.model = model, .x = x, .predictions = predictions});
+}
+
+// One work group per row, its threads run the Horner steps of strided features and reduce their sums in shared memory.
+static const char mygl_model_predict_compute_shader[] = S(
+layout(local_size_x = 64, local_size_y = 1, local_size_z = 1) in;
+
+uniform uint features_count;
+uniform uint degree;
+uniform float bias;
+
+layout(std430, binding = 0) readonly buffer ssbo_X { float X[]; };
+layout(std430, binding = 1) readonly buffer ssbo_C { float C[]; };
+layout(std430, binding = 2) writeonly buffer ssbo_P { float P[]; };
+
+shared float partial_sums[64];
+
+void main() {
+    uint row = gl_WorkGroupID.x;
+    uint lid = gl_LocalInvocationID.x;
+    float sum = 0.0;
+    for(uint j = lid; j < features_count; j += 64u) {
+        float value = X[row * features_count + j];
+        float acc = C[(degree - 1u) * features_count + j];
+        for(uint d = degree - 1u; d > 0u; --d) {
+            acc = acc * value + C[(d - 1u) * features_count + j];
+        }
+        sum += acc * value;
+    }
+    partial_sums[lid] = sum;
+    barrier();
+    for(uint width = 32u; width > 0u; width >>= 1) {
+        if(lid < width) {
+            partial_sums[lid] += partial_sums[lid + width];
+        }
+        barrier();
+    }
+    if(lid == 0u) {
+        P[row] = bias + partial_sums[0];
+    }
+}
+);
+
+static void my_gl_dispatch_compute_model_predict(
+    const GLuint shader_program,
+    const MyModel model[static 1],
+    const GLuint x_ssb,
+    const GLuint coeffs_ssb,
+    const GLuint predictions_ssb,
+    const GLuint rows
+) {
+    ASSERT(rows > 0 && rows <= 65535);
+    ASSERT_GL(glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, x_ssb));
+    ASSERT_GL(glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, coeffs_ssb));
+    ASSERT_GL(glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, predictions_ssb));
+    ASSERT_GL(glUseProgram(shader_program));
+        ASSERT_GL(glUniform1ui(my_gl_get_uniform_location(shader_program, "features_count"), (GLuint)model->features_count));
+        ASSERT_GL(glUniform1ui(my_gl_get_uniform_location(shader_program, "degree"), (GLuint)model->degree));
+        ASSERT_GL(glUniform1f(my_gl_get_uniform_location(shader_program, "bias"), model->bias));
+        my_gl_dispatch_compute("model_predict", rows, 1, 1);
+    ASSERT_GL(glUseProgram(0));
+    ASSERT_GL(glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, 0));
+    ASSERT_GL(glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, 0));
+    ASSERT_GL(glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, 0));
+}
+
+#define MY_INFER_BATCH_SIZES_MAX 16
+#define MY_INFER_REPEATS 200
+#define MY_INFER_WARMUP 3
+
+typedef struct {
+    const char *model_path;
+    // both backends run when none is given
+    bool backends[MY_TRAIN_BACKEND_COUNT];
+    const char *device;
+    size_t batch_sizes[MY_INFER_BATCH_SIZES_MAX];
+    size_t batch_sizes_count;
+} MyInferOptions;
+
+static int my_double_compare(const void *const first, const void *const second) {
+    const double a = *(const double*)first, b = *(const double*)second;
+    return a < b ? -1 : a > b ? 1 : 0;
+}
+
+// Latency of one batch from host rows to host predictions, the GL path uploads the rows and reads the predictions back.
+static void my_infer(const MyInferOptions options[static 1]) {
+    MyModel model = my_model_load(options->model_path);
+    MyMat x_test = {.rows = 1053, .cols = 167};
+    MyMat y_test = {.rows = 1053, .cols = 1};
+    size_t batch_rows_max = 0;
+    my_range_for_zero(size_t, i, options->batch_sizes_count) {
+        batch_rows_max = options->batch_sizes[i] > batch_rows_max ? options->batch_sizes[i] : batch_rows_max;
+    }
+    MyArena arena = my_arena_init(my_mat_bytes_count(&x_test) * 2 + batch_rows_max * (x_test.cols + 1) * sizeof(GLfloat));
+    my_read_bin_data_to_mat(&x_test, &arena, "data/x_test.bin");
+    my_read_bin_data_to_mat(&y_test, &arena, "data/y_test.bin");
+    ASSERT(model.features_count == x_test.cols, "the model has %zu features, the data %zu", model.features_count, x_test.cols);
+    LOG("model: %s, features: %zu, degree: %zu", options->model_path, model.features_count, model.degree);
+
+    GLfloat *const test_predictions = (GLfloat*)my_arena_alloc(&arena, x_test.rows * sizeof(GLfloat));
+    my_model_predict(&model, &x_test, test_predictions);
+    double test_loss = 0.0;
+    my_range_for_zero(size_t, row, x_test.rows) {
+        test_loss += my_pow((double)test_predictions[row] - (double)y_test.items[row], 2);
+    }
+    LOG("test mse: %lf", test_loss / (double)x_test.rows);
+
+    // batches cycle through the test rows and are checked against the CPU predictions of those rows
+    MyMat batch = my_mat_alloc(&arena, batch_rows_max, x_test.cols);
+    my_range_for_zero(size_t, row, batch.rows) {
+        memcpy(&my_mat_row(&batch, row), &my_mat_row(&x_test, (row % x_test.rows)), x_test.cols * sizeof(GLfloat));
+    }
+    GLfloat *const predictions = (GLfloat*)my_arena_alloc(&arena, batch.rows * sizeof(GLfloat));
+
+    MyGLContext gl_context = {0};
+    GLuint shader_program = 0, compute_shader = 0, buffers[3] = {0};
+    if(options->backends[MY_TRAIN_BACKEND_GL]) {
+        gl_context = my_gl_context_create(options->device);
+        mygl_create_compute_shader_program_with_header(&shader_program, &compute_shader, "", mygl_model_predict_compute_shader);
+        ASSERT_GL(glGenBuffers((GLsizei)my_array_count(buffers), buffers));
+        const GLsizeiptr sizes[] = {
+            (GLsizeiptr)my_mat_bytes_count(&batch),
+            (GLsizeiptr)(model.features_count * model.degree * sizeof(GLfloat)),
+            (GLsizeiptr)(batch.rows * sizeof(GLfloat)),
+        };
+        my_range_for_zero(size_t, i, my_array_count(buffers)) {
+            ASSERT_GL(glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffers[i]));
+                ASSERT_GL(glBufferData(GL_SHADER_STORAGE_BUFFER, sizes[i], i == 1 ? model.coeffs : NULL, i == 1 ? GL_STATIC_DRAW : GL_DYNAMIC_DRAW));
+        }
+        ASSERT_GL(glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0));
+    }
+
+    double *const latencies = (double*)malloc(MY_INFER_REPEATS * sizeof(double));
+    ASSERT(latencies);
+    my_range_for_zero(size_t, backend, MY_TRAIN_BACKEND_COUNT) {
+        if(!options->backends[backend]) {
+            continue;
+        }
+        my_range_for_zero(size_t, i, options->batch_sizes_count) {
+            const size_t batch_size = options->batch_sizes[i];
+            const size_t offsets_count = batch.rows - batch_size + 1;
+            my_range_for_zero(size_t, repeat, MY_INFER_WARMUP + MY_INFER_REPEATS) {
+                const size_t row_first = repeat * batch_size % offsets_count;
+                const MyMat rows = {.rows = batch_size, .cols = batch.cols, .items = &my_mat_row(&batch, row_first)};
+                const double batch_start_ms = my_time_ms();
+                if(backend == MY_TRAIN_BACKEND_CPU) {
+                    my_model_predict(&model, &rows, predictions + row_first);
+                } else {
+                    ASSERT_GL(glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffers[0]));
+                        ASSERT_GL(glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, (GLsizeiptr)my_mat_bytes_count(&rows), rows.items));
+                    ASSERT_GL(glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0));
+                    my_mem_uploaded(my_mat_bytes_count(&rows));
+                    my_gl_dispatch_compute_model_predict(shader_program, &model, buffers[0], buffers[1], buffers[2], (GLuint)batch_size);
+                    ASSERT_GL(glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT));
+                    mygl_buffer_read(buffers[2], 0, (GLsizeiptr)(batch_size * sizeof(GLfloat)), predictions + row_first);
+                }
+                if(repeat >= MY_INFER_WARMUP) {
+                    latencies[repeat - MY_INFER_WARMUP] = my_time_ms() - batch_start_ms;
+                }
+                my_range_for(size_t, row, row_first, row_first + batch_size) {
+                    const GLfloat expected = test_predictions[row % x_test.rows];
+                    ASSERT(fabsf(predictions[row] - expected) <= 1e-3f * (1.f + fabsf(expected)), "row %zu: %f != %f", row, (double)predictions[row], (double)expected);
+                }
+            }
+            qsort(latencies, MY_INFER_REPEATS, sizeof(*latencies), my_double_compare);
+            double total_ms = 0.0;
+            my_range_for_zero(size_t, repeat, MY_INFER_REPEATS) {
+                total_ms += latencies[repeat];
+            }
+            LOG(
+                "backend: %s, batch size: %zu, p50 ms: %lf, p99 ms: %lf, rows/s: %lf", my_train_backend_names[backend], batch_size,
+                latencies[MY_INFER_REPEATS / 2], latencies[MY_INFER_REPEATS * 99 / 100], (double)(batch_size * MY_INFER_REPEATS) / total_ms * 1e3
+            );
+        }
+    }
+    free(latencies);
+
+    if(options->backends[MY_TRAIN_BACKEND_GL]) {
+        ASSERT_GL(glDeleteBuffers((GLsizei)my_array_count(buffers), buffers));
+        ASSERT_GL(glDeleteShader(compute_shader));
+        ASSERT_GL(glDeleteProgram(shader_program));
+        my_gl_context_destroy(&gl_context);
+    }
+    my_model_destroy(&model);
+    my_arena_free(&arena);
+}
+
+#define MY_SERVE_LATENCIES_COUNT 4096
+#define MY_SERVE_LOG_MS 5000.0
+
+typedef struct {
+    const char *model_path;
+    const char *socket_path;
+    MyTrainBackend backend;
+    const char *device;
+    // a batch runs once its first request waited `window_ms` or it holds `batch_rows_max` rows
+    double window_ms;
+    size_t batch_rows_max;
+} MyServeOptions;
+
+// Wire format on the host's byte order: the server greets every connection with MyServeHello, a request is a uint32 row
+// count followed by rows of features_count floats and is answered with one float per row. A request of 0 rows is answered
+// with MyServeStats.
+typedef struct {
+    uint32_t features_count;
+    uint32_t degree;
+} MyServeHello;
+
+typedef struct {
+    uint64_t requests;
+    uint64_t rows;
+    uint64_t batches;
+    // from the end of a request's read to its predictions, over the last MY_SERVE_LATENCIES_COUNT requests
+    double p50_ms;
+    double p99_ms;
+    double rows_per_s;
+} MyServeStats;
+
+// Lives on the stack of its connection thread until the batcher marks it done.
+typedef struct MyServeRequest {
+    struct MyServeRequest *next;
+    size_t rows;
+    const GLfloat *x;
+    GLfloat *predictions;
+    double arrival_ms;
+    bool done;
+} MyServeRequest;
+
+typedef struct {
+    const MyServeOptions *options;
+    MyModel model;
+    int listen_fd;
+    pthread_t acceptor;
+    pthread_t batcher;
+    pthread_mutex_t mutex;
+    // signals queued requests to the batcher and finished batches to the connections
+    pthread_cond_t queued;
+    pthread_cond_t done;
+    MyServeRequest *head;
+    MyServeRequest *tail;
+    size_t queued_rows;
+    // also read by the acceptor without the mutex
+    _Atomic bool stopping;
+    double start_ms;
+    uint64_t requests;
+    uint64_t rows;
+    uint64_t batches;
+    double latencies[MY_SERVE_LATENCIES_COUNT];
+} MyServer;
+
+static bool my_fd_read(const int fd, void *const data, const size_t bytes_count) {
+    size_t offset = 0;
+    while(offset < bytes_count) {
+        const ssize_t count = read(fd, (char*)data + offset, bytes_count - offset);
+        if(count <= 0) {
+            return false;
+        }
+        offset += (size_t)count;
+    }
+    return true;
+}
+
+static bool my_fd_write(const int fd, const void *const data, const size_t bytes_count) {
+    size_t offset = 0;
+    while(offset < bytes_count) {
+        const ssize_t count = send(fd, (const char*)data + offset, bytes_count - offset, MSG_NOSIGNAL);
+        if(count <= 0) {
+            return false;
+        }
+        offset += (size_t)count;
+    }
+    return true;
+}
+
+static struct sockaddr_un my_unix_address(const char path[static 1]) {
+    struct sockaddr_un address = {.sun_family = AF_UNIX};
+    ASSERT(strlen(path) < sizeof(address.sun_path), "socket path too long: %s", path);
+    strcpy(address.sun_path, path);
+    return address;
+}
+
+// Takes the server mutex only to copy the counters, the latencies are sorted after it is released.
+static MyServeStats my_server_stats(MyServer server[static 1]) {
+    double latencies[MY_SERVE_LATENCIES_COUNT];
+    ASSERT(pthread_mutex_lock(&server->mutex) == 0);
+        MyServeStats stats = {
+            .requests = server->requests,
+            .rows = server->rows,
+            .batches = server->batches,
+            .rows_per_s = (double)server->rows / (my_time_ms() - server->start_ms) * 1e3,
+        };
+        const size_t count = server->requests < MY_SERVE_LATENCIES_COUNT ? (size_t)server->requests : MY_SERVE_LATENCIES_COUNT;
+        memcpy(latencies, server->latencies, count * sizeof(double));
+    ASSERT(pthread_mutex_unlock(&server->mutex) == 0);
+    if(count > 0) {
+        qsort(latencies, count, sizeof(double), my_double_compare);
+        stats.p50_ms = latencies[count / 2];
+        stats.p99_ms = latencies[count * 99 / 100];
+    }
+    return stats;
+}
+
+static void my_serve_stats_log(const MyServeStats stats[static 1]) {
+    LOG(
+        "requests: %" PRIu64 ", rows: %" PRIu64 ", batches: %" PRIu64 ", rows per batch: %lf, p50 ms: %lf, p99 ms: %lf, rows/s: %lf",
+        stats->requests, stats->rows, stats->batches, stats->batches > 0 ? (double)stats->rows / (double)stats->batches : 0.0,
+        stats->p50_ms, stats->p99_ms, stats->rows_per_s
+    );
+}
+
+// Owns the inference backend: coalesces queued requests into one batch, predicts it and hands the predictions back.
+static void* my_server_batcher(void *const arg) {
+    MyServer *const server = (MyServer*)arg;
+    my_trace_thread_name("batcher");
+    const MyServeOptions *const options = server->options;
+    const MyModel *const model = &server->model;
+    MyMat batch = {.rows = options->batch_rows_max, .cols = model->features_count};
+    batch.items = (GLfloat*)malloc(my_mat_bytes_count(&batch));
+    GLfloat *const predictions = (GLfloat*)malloc(batch.rows * sizeof(GLfloat));
+    ASSERT(batch.items && predictions);
+
+    MyGLContext gl_context = {0};
+    GLuint shader_program = 0, compute_shader = 0, buffers[3] = {0};
+    if(options->backend == MY_TRAIN_BACKEND_GL) {
+        gl_context = my_gl_context_create(options->device);
+        mygl_create_compute_shader_program_with_header(&shader_program, &compute_shader, "", mygl_model_predict_compute_shader);
+        ASSERT_GL(glGenBuffers((GLsizei)my_array_count(buffers), buffers));
+        const GLsizeiptr sizes[] = {
+            (GLsizeiptr)my_mat_bytes_count(&batch),
+            (GLsizeiptr)(model->features_count * model->degree * sizeof(GLfloat)),
+            (GLsizeiptr)(batch.rows * sizeof(GLfloat)),
+        };
+        my_range_for_zero(size_t, i, my_array_count(buffers)) {
+            ASSERT_GL(glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffers[i]));
+                ASSERT_GL(glBufferData(GL_SHADER_STORAGE_BUFFER, sizes[i], i == 1 ? model->coeffs : NULL, i == 1 ? GL_STATIC_DRAW : GL_DYNAMIC_DRAW));
+        }
+        ASSERT_GL(glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0));
+    }
+
+    double log_ms = my_time_ms();
+    uint64_t log_requests = 0;
+    ASSERT(pthread_mutex_lock(&server->mutex) == 0);
+    while(true) {
+        while(!server->head && !atomic_load_explicit(&server->stopping, memory_order_relaxed)) {
+            ASSERT(pthread_cond_wait(&server->queued, &server->mutex) == 0);
+        }
+        if(!server->head) {
+            break;
+        }
+        // the window opens with the oldest request
+        const double deadline_ms = server->head->arrival_ms + options->window_ms;
+        while(server->queued_rows < batch.rows && !atomic_load_explicit(&server->stopping, memory_order_relaxed) && my_time_ms() < deadline_ms) {
+            struct timespec deadline;
+            deadline.tv_sec = (time_t)(deadline_ms / 1000.0);
+            deadline.tv_nsec = (long)((deadline_ms - (double)deadline.tv_sec * 1000.0) * 1e6);
+            const int result = pthread_cond_timedwait(&server->queued, &server->mutex, &deadline);
+            ASSERT(result == 0 || result == ETIMEDOUT);
+        }
+        MyServeRequest *const first = server->head;
+        MyServeRequest *last = NULL;
+        size_t rows = 0;
+        for(MyServeRequest *request = first; request && rows + request->rows <= batch.rows; request = request->next) {
+            rows += request->rows;
+            last = request;
+        }
+        server->head = last->next;
+        server->tail = server->head ? server->tail : NULL;
+        server->queued_rows -= rows;
+        ASSERT(pthread_mutex_unlock(&server->mutex) == 0);
+
+        {
+            size_t row = 0;
+            for(const MyServeRequest *request = first; request != last->next; request = request->next) {
+                memcpy(&my_mat_row(&batch, row), request->x, request->rows * batch.cols * sizeof(GLfloat));
+                row += request->rows;
+            }
+        }
+        const MyMat rows_mat = {.rows = rows, .cols = batch.cols, .items = batch.items};
+        if(options->backend == MY_TRAIN_BACKEND_CPU) {
+            my_model_predict(model, &rows_mat, predictions);
+        } else {
+            ASSERT_GL(glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffers[0]));
+                ASSERT_GL(glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, (GLsizeiptr)my_mat_bytes_count(&rows_mat), rows_mat.items));
+            ASSERT_GL(glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0));
+            my_mem_uploaded(my_mat_bytes_count(&rows_mat));
+            my_gl_dispatch_compute_model_predict(shader_program, model, buffers[0], buffers[1], buffers[2], (GLuint)rows);
+            ASSERT_GL(glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT));
+            mygl_buffer_read(buffers[2], 0, (GLsizeiptr)(rows * sizeof(GLfloat)), predictions);
+        }
+
+        ASSERT(pthread_mutex_lock(&server->mutex) == 0);
+        const double now_ms = my_time_ms();
+        size_t row = 0;
+        for(MyServeRequest *request = first, *next; request != last->next; request = next) {
+            next = request->next;
+            memcpy(request->predictions, predictions + row, request->rows * sizeof(GLfloat));
+            row += request->rows;
+            server->latencies[server->requests % MY_SERVE_LATENCIES_COUNT] = now_ms - request->arrival_ms;
+            server->requests += 1;
+            request->done = true;
+        }
+        server->rows += rows;
+        server->batches += 1;
+        ASSERT(pthread_cond_broadcast(&server->done) == 0);
+        if(now_ms - log_ms >= MY_SERVE_LOG_MS && server->requests != log_requests) {
+            log_ms = now_ms;
+            log_requests = server->requests;
+            ASSERT(pthread_mutex_unlock(&server->mutex) == 0);
+            const MyServeStats stats = my_server_stats(server);
+            my_serve_stats_log(&stats);
+            ASSERT(pthread_mutex_lock(&server->mutex) == 0);
+        }
+    }
+    ASSERT(pthread_mutex_unlock(&server->mutex) == 0);
+
+    if(options->backend == MY_TRAIN_BACKEND_GL) {
+        ASSERT_GL(glDeleteBuffers((GLsizei)my_array_count(buffers), buffers));
+        ASSERT_GL(glDeleteShader(compute_shader));
+        ASSERT_GL(glDeleteProgram(shader_program));
+        my_gl_context_destroy(&gl_context);
+    }
+    free(predictions);
+    free(batch.items);
+    return NULL;
+}
+
+typedef struct {
+    MyServer *server;
+    int fd;
+} MyServeConnection;
+
+static void* my_server_connection(void *const arg) {
+    const MyServeConnection connection = *(MyServeConnection*)arg;
+    free(arg);
+    MyServer *const server = connection.server;
+    const size_t features_count = server->model.features_count;
+    const MyServeHello hello = {.features_count = (uint32_t)features_count, .degree = (uint32_t)server->model.degree};
+    GLfloat *x = NULL, *predictions = NULL;
+    size_t capacity = 0;
+    uint32_t rows;
+    for(bool open = my_fd_write(connection.fd, &hello, sizeof(hello)); open && my_fd_read(connection.fd, &rows, sizeof(rows));) {
+        if(rows == 0) {
+            const MyServeStats stats = my_server_stats(server);
+            open = my_fd_write(connection.fd, &stats, sizeof(stats));
+            continue;
+        }
+        if(rows > server->options->batch_rows_max) {
+            LOG("request of %u rows exceeds the batch of %zu rows, closing the connection", rows, server->options->batch_rows_max);
+            break;
+        }
+        if(rows > capacity) {
+            capacity = rows;
+            x = (GLfloat*)realloc(x, capacity * features_count * sizeof(GLfloat));
+            predictions = (GLfloat*)realloc(predictions, capacity * sizeof(GLfloat));
+            ASSERT(x && predictions);
+        }
+        if(!my_fd_read(connection.fd, x, rows * features_count * sizeof(GLfloat))) {
+            break;
+        }
+        MyServeRequest request = {.rows = rows, .x = x, .predictions = predictions, .arrival_ms = my_time_ms()};
+        ASSERT(pthread_mutex_lock(&server->mutex) == 0);
+        if(atomic_load_explicit(&server->stopping, memory_order_relaxed)) {
+            ASSERT(pthread_mutex_unlock(&server->mutex) == 0);
+            break;
+        }
+        if(server->tail) {
+            server->tail->next = &request;
+        } else {
+            server->head = &request;
+        }
+        server->tail = &request;
+        server->queued_rows += rows;
+        ASSERT(pthread_cond_signal(&server->queued) == 0);
+        while(!request.done) {
+            ASSERT(pthread_cond_wait(&server->done, &server->mutex) == 0);
+        }
+        ASSERT(pthread_mutex_unlock(&server->mutex) == 0);
+        open = my_fd_write(connection.fd, predictions, rows * sizeof(GLfloat));
+    }
+    free(predictions);
+    free(x);
+    ASSERT_NOT_MINUS_ONE(close(connection.fd));
+    return NULL;
+}
+
+static void* my_server_acceptor(void *const arg) {
+    MyServer *const server = (MyServer*)arg;
+    while(true) {
+        const int fd = accept(server->listen_fd, NULL, NULL);
+        if(fd == -1) {
+            // shutdown of the listening socket ends the loop
+            const bool stopping = atomic_load_explicit(&server->stopping, memory_order_acquire);
+            ASSERT(stopping || errno == EINTR || errno == ECONNABORTED, "accept: %s", strerror(errno));
+            if(stopping) {
+                break;
+            }
+            continue;
+        }
+        MyServeConnection *const connection = (MyServeConnection*)malloc(sizeof(MyServeConnection));
+        ASSERT(connection);
+        *connection = (MyServeConnection){.server = server, .fd = fd};
+        pthread_t thread;
+        ASSERT(pthread_create(&thread, NULL, my_server_connection, connection) == 0);
+        ASSERT(pthread_detach(thread) == 0);
+    }
+    return NULL;
+}
+
+// Every connection gets a detached thread that blocks on its socket, so `server` must outlive them. One batcher thread
+// owns the CPU or GL inference path.
+static void my_server_start(MyServer server[static 1], const MyServeOptions options[static 1]) {
+    *server = (MyServer){.options = options, .model = my_model_load(options->model_path), .start_ms = my_time_ms()};
+    LOG(
+        "model: %s, features: %zu, degree: %zu, backend: %s, window ms: %lf, batch rows: %zu",
+        options->model_path, server->model.features_count, server->model.degree, my_train_backend_names[options->backend],
+        options->window_ms, options->batch_rows_max
+    );
+    pthread_condattr_t condattr;
+    ASSERT(pthread_condattr_init(&condattr) == 0);
+    ASSERT(pthread_condattr_setclock(&condattr, CLOCK_MONOTONIC) == 0);
+    ASSERT(pthread_cond_init(&server->queued, &condattr) == 0);
+    ASSERT(pthread_condattr_destroy(&condattr) == 0);
+    ASSERT(pthread_cond_init(&server->done, NULL) == 0);
+    ASSERT(pthread_mutex_init(&server->mutex, NULL) == 0);
+
+    const struct sockaddr_un address = my_unix_address(options->socket_path);
+    server->listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    ASSERT_NOT_MINUS_ONE(server->listen_fd);
+    // a socket left by a killed server would fail the bind
+    ASSERT(unlink(options->socket_path) == 0 || errno == ENOENT, "%s: %s", options->socket_path, strerror(errno));
+    ASSERT_NOT_MINUS_ONE(bind(server->listen_fd, (const struct sockaddr*)&address, sizeof(address)), "%s", options->socket_path);
+    ASSERT_NOT_MINUS_ONE(listen(server->listen_fd, SOMAXCONN));
+    ASSERT(pthread_create(&server->batcher, NULL, my_server_batcher, server) == 0);
+    ASSERT(pthread_create(&server->acceptor, NULL, my_server_acceptor, server) == 0);
+    LOG("listening: %s", options->socket_path);
+}
+
+static MyServeStats my_server_stop(MyServer server[static 1]) {
+    ASSERT(pthread_mutex_lock(&server->mutex) == 0);
+    atomic_store_explicit(&server->stopping, true, memory_order_release);
+    ASSERT(pthread_cond_signal(&server->queued) == 0);
+    ASSERT(pthread_mutex_unlock(&server->mutex) == 0);
+    ASSERT_NOT_MINUS_ONE(shutdown(server->listen_fd, SHUT_RDWR));
+    ASSERT(pthread_join(server->acceptor, NULL) == 0);
+    // the batcher drains the queue, connections still reading are cut off when the process exits and must not send
+    // another request once the server is stopped
+    ASSERT(pthread_join(server->batcher, NULL) == 0);
+    ASSERT_NOT_MINUS_ONE(close(server->listen_fd));
+    ASSERT_NOT_MINUS_ONE(unlink(server->options->socket_path));
+    const MyServeStats stats = my_server_stats(server);
+    ASSERT(pthread_cond_destroy(&server->done) == 0);
+    ASSERT(pthread_cond_destroy(&server->queued) == 0);
+    ASSERT(pthread_mutex_destroy(&server->mutex) == 0);
+    my_model_destroy(&server->model);
+    return stats;
+}
+
+// Serves until SIGINT or SIGTERM.
+static void my_serve(const MyServeOptions options[static 1]) {
+    // the threads inherit the mask, so only sigwait below sees the signals
+    sigset_t signals;
+    ASSERT_NOT_MINUS_ONE(sigemptyset(&signals));
+    ASSERT_NOT_MINUS_ONE(sigaddset(&signals, SIGINT));
+    ASSERT_NOT_MINUS_ONE(sigaddset(&signals, SIGTERM));
+    ASSERT(pthread_sigmask(SIG_BLOCK, &signals, NULL) == 0);
+    static MyServer server;
+    my_server_start(&server, options);
+
+    int signal_number;
+    ASSERT(sigwait(&signals, &signal_number) == 0);
+    LOG("stopping on signal %d", signal_number);
+    const MyServeStats stats = my_server_stop(&server);
+    my_serve_stats_log(&stats);
+}
+
+typedef struct {
+    const char *socket_path;
+    size_t clients_count;
+    size_t requests_count;
+    size_t rows;
+} MyLoadOptions;
+
+typedef struct {
+    const MyLoadOptions *options;
+    const MyMat *x;
+    size_t client;
+    double *latencies;
+} MyLoadClient;
+
+static int my_unix_connect(const char path[static 1]) {
+    const struct sockaddr_un address = my_unix_address(path);
+    const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    ASSERT_NOT_MINUS_ONE(fd);
+    ASSERT_NOT_MINUS_ONE(connect(fd, (const struct sockaddr*)&address, sizeof(address)), "%s", path);
+    return fd;
+}
+
+static void* my_load_client(void *const arg) {
+    const MyLoadClient *const client = (const MyLoadClient*)arg;
+    const MyLoadOptions *const options = client->options;
+    const int fd = my_unix_connect(options->socket_path);
+    MyServeHello hello;
+    ASSERT(my_fd_read(fd, &hello, sizeof(hello)));
+    ASSERT(hello.features_count == client->x->cols, "the server takes %u features, the data has %zu", hello.features_count, client->x->cols);
+    const size_t row_bytes_count = client->x->cols * sizeof(GLfloat);
+    char *const message = (char*)malloc(sizeof(uint32_t) + options->rows * row_bytes_count);
+    GLfloat *const predictions = (GLfloat*)malloc(options->rows * sizeof(GLfloat));
+    ASSERT(message && predictions);
+    const uint32_t rows = (uint32_t)options->rows;
+    memcpy(message, &rows, sizeof(rows));
+    my_range_for_zero(size_t, request, options->requests_count) {
+        // clients start at different rows and walk the test set
+        my_range_for_zero(size_t, row, options->rows) {
+            const size_t x_row = ((client->client * options->requests_count + request) * options->rows + row) % client->x->rows;
+            memcpy(message + sizeof(rows) + row * row_bytes_count, &my_mat_row(client->x, x_row), row_bytes_count);
+        }
+        const double start_ms = my_time_ms();
+        ASSERT(my_fd_write(fd, message, sizeof(rows) + options->rows * row_bytes_count));
+        ASSERT(my_fd_read(fd, predictions, options->rows * sizeof(GLfloat)), "the server closed the connection");
+        client->latencies[request] = my_time_ms() - start_ms;
+    }
+    free(predictions);
+    free(message);
+    ASSERT_NOT_MINUS_ONE(close(fd));
+    return NULL;
+}
+
+// Drives a running server with closed-loop clients, each on its own connection, and reports the round trip latency
+// next to the server's counters.
+static void my_load(const MyLoadOptions options[static 1]) {
+    MyMat x_test = {.rows = 1053, .cols = 167};
+    MyArena arena = my_arena_init(my_mat_bytes_count(&x_test));
+    my_read_bin_data_to_mat(&x_test, &arena, "data/x_test.bin");
+    const size_t latencies_count = options->clients_count * options->requests_count;
+    double *const latencies = (double*)malloc(latencies_count * sizeof(double));
+    MyLoadClient *const clients = (MyLoadClient*)malloc(options->clients_count * sizeof(MyLoadClient));
+    pthread_t *const threads = (pthread_t*)malloc(options->clients_count * sizeof(pthread_t));
+    ASSERT(latencies && clients && threads);
+    const double start_ms = my_time_ms();
+    my_range_for_zero(size_t, i, options->clients_count) {
+        clients[i] = (MyLoadClient){.options = options, .x = &x_test, .client = i, .latencies = latencies + i * options->requests_count};
+        ASSERT(pthread_create(&threads[i], NULL, my_load_client, &clients[i]) == 0);
+    }
+    my_range_for_zero(size_t, i, options->clients_count) {
+        ASSERT(pthread_join(threads[i], NULL) == 0);
+    }
+    const double elapsed_ms = my_time_ms() - start_ms;
+    qsort(latencies, latencies_count, sizeof(double), my_double_compare);
+    LOG(
+        "clients: %zu, requests: %zu, rows per request: %zu, p50 ms: %lf, p99 ms: %lf, requests/s: %lf, rows/s: %lf",
+        options->clients_count, latencies_count, options->rows, latencies[latencies_count / 2], latencies[latencies_count * 99 / 100],
+        (double)latencies_count / elapsed_ms * 1e3, (double)(latencies_count * options->rows) / elapsed_ms * 1e3
+    );
+    {
+        const int fd = my_unix_connect(options->socket_path);
+        MyServeHello hello;
+        const uint32_t rows = 0;
+        MyServeStats stats;
+        ASSERT(my_fd_read(fd, &hello, sizeof(hello)) && my_fd_write(fd, &rows, sizeof(rows)) && my_fd_read(fd, &stats, sizeof(stats)));
+        ASSERT_NOT_MINUS_ONE(close(fd));
+        LOG("server:");
+        my_serve_stats_log(&stats);
+    }
+    free(threads);
+    free(clients);
+    free(latencies);
+    my_arena_free(&arena);
+}
+
+#define MY_DENSITY_BASE 512
+#define MY_DENSITY_LEVELS 6
+// views with more points than this are drawn as a heatmap
+#define MY_DENSITY_POINTS_MAX 16384
+#define MY_DENSITY_PIXELS_PER_BIN 4.0
+
+// Density pyramid of a scatter plot. Level 0 bins the bounds into MY_DENSITY_BASE x MY_DENSITY_BASE cells, row major
+// from y_min, every further level halves the cells per axis by summing 2 x 2 blocks. The points are sorted by their
+// level 0 cell, so the points of a view are one contiguous run of `cell_offsets` per cell row.
+typedef struct {
+    double x_min;
+    double x_max;
+    double y_min;
+    double y_max;
+    size_t points_count;
+    GLfloat *xs;
+    GLfloat *ys;
+    uint32_t *cell_offsets;
+    GLfloat *levels[MY_DENSITY_LEVELS];
+    // render loop scratch: the points or the heatmap cells of the current view
+    GLfloat *view_xs;
+    GLfloat *view_ys;
+    GLfloat *view_values;
+} MyDensityPyramid;
+
+// Cells of the current view in the units of `level`, end exclusive.
+typedef struct {
+    size_t level;
+    size_t col_first;
+    size_t col_end;
+    size_t row_first;
+    size_t row_end;
+    size_t points_count;
+    bool heatmap;
+} MyDensityView;
+
+static size_t my_density_cell(const double min, const double max, const double value) {
+    const double cell = floor((value - min) / (max - min) * MY_DENSITY_BASE);
+    return !(cell >= 0.0) ? 0 : cell >= MY_DENSITY_BASE ? MY_DENSITY_BASE - 1 : (size_t)cell;
+}
+
+static MyDensityPyramid my_density_pyramid_create(const GLfloat *const xs, const GLfloat *const ys, const size_t points_count) {
+    ASSERT(points_count > 0 && points_count <= UINT32_MAX);
+    MyDensityPyramid pyramid = {
+        .x_min = (double)xs[0], .x_max = (double)xs[0], .y_min = (double)ys[0], .y_max = (double)ys[0],
+        .points_count = points_count,
+        .xs = (GLfloat*)malloc(points_count * sizeof(GLfloat)),
+        .ys = (GLfloat*)malloc(points_count * sizeof(GLfloat)),
+        .cell_offsets = (uint32_t*)calloc(MY_DENSITY_BASE * MY_DENSITY_BASE + 1, sizeof(uint32_t)),
+        .view_xs = (GLfloat*)malloc(points_count * sizeof(GLfloat)),
+        .view_ys = (GLfloat*)malloc(points_count * sizeof(GLfloat)),
+        .view_values = (GLfloat*)malloc(MY_DENSITY_BASE * MY_DENSITY_BASE * sizeof(GLfloat)),
+    };
+    ASSERT(pyramid.xs && pyramid.ys && pyramid.cell_offsets && pyramid.view_xs && pyramid.view_ys && pyramid.view_values);
+    my_range_for_zero(size_t, i, points_count) {
+        pyramid.x_min = fmin(pyramid.x_min, (double)xs[i]);
+        pyramid.x_max = fmax(pyramid.x_max, (double)xs[i]);
+        pyramid.y_min = fmin(pyramid.y_min, (double)ys[i]);
+        pyramid.y_max = fmax(pyramid.y_max, (double)ys[i]);
+    }
+    // the last point lands inside the last cell
+    pyramid.x_max += pyramid.x_max > pyramid.x_min ? (pyramid.x_max - pyramid.x_min) * 1e-6 : 1.0;
+    pyramid.y_max += pyramid.y_max > pyramid.y_min ? (pyramid.y_max - pyramid.y_min) * 1e-6 : 1.0;
+
+    uint32_t *const cells = (uint32_t*)malloc(points_count * sizeof(uint32_t));
+    ASSERT(cells);
+    my_range_for_zero(size_t, i, points_count) {
+        const size_t row = my_density_cell(pyramid.y_min, pyramid.y_max, (double)ys[i]);
+        cells[i] = (uint32_t)(row * MY_DENSITY_BASE + my_density_cell(pyramid.x_min, pyramid.x_max, (double)xs[i]));
+        pyramid.cell_offsets[cells[i] + 1] += 1;
+    }
+    pyramid.levels[0] = (GLfloat*)malloc(MY_DENSITY_BASE * MY_DENSITY_BASE * sizeof(GLfloat));
+    ASSERT(pyramid.levels[0]);
+    my_range_for_zero(size_t, cell, MY_DENSITY_BASE * MY_DENSITY_BASE) {
+        pyramid.levels[0][cell] = (GLfloat)pyramid.cell_offsets[cell + 1];
+        pyramid.cell_offsets[cell + 1] += pyramid.cell_offsets[cell];
+    }
+    // counting sort, the level 0 counts are the insertion cursors until they are recounted
+    my_range_for_zero(size_t, i, points_count) {
+        const uint32_t cell = cells[i];
+        const uint32_t slot = pyramid.cell_offsets[cell + 1] - (uint32_t)pyramid.levels[0][cell];
+        pyramid.levels[0][cell] -= 1.f;
+        pyramid.xs[slot] = xs[i];
+        pyramid.ys[slot] = ys[i];
+    }
+    free(cells);
+    my_range_for_zero(size_t, cell, MY_DENSITY_BASE * MY_DENSITY_BASE) {
+        pyramid.levels[0][cell] = (GLfloat)(pyramid.cell_offsets[cell + 1] - pyramid.cell_offsets[cell]);
+    }
+    my_range_for(size_t, level, 1, MY_DENSITY_LEVELS) {
+        const size_t cells_count = MY_DENSITY_BASE >> level;
+        const GLfloat *const finer = pyramid.levels[level - 1];
+        GLfloat *const coarser = (GLfloat*)malloc(cells_count * cells_count * sizeof(GLfloat));
+        ASSERT(coarser);
+        my_range_for_zero(size_t, row, cells_count) {
+            my_range_for_zero(size_t, col, cells_count) {
+                const size_t cell = 2 * row * 2 * cells_count + 2 * col;
+                coarser[row * cells_count + col] = finer[cell] + finer[cell + 1] + finer[cell + 2 * cells_count] + finer[cell + 2 * cells_count + 1];
+            }
+        }
+        pyramid.levels[level] = coarser;
+    }
+    return pyramid;
+}
+
+static void my_density_pyramid_destroy(MyDensityPyramid pyramid[static 1]) {
+    my_range_for_zero(size_t, level, MY_DENSITY_LEVELS) {
+        free(pyramid->levels[level]);
+    }
+    free(pyramid->view_values);
+    free(pyramid->view_ys);
+    free(pyramid->view_xs);
+    free(pyramid->cell_offsets);
+    free(pyramid->ys);
+    free(pyramid->xs);
+    *pyramid = (MyDensityPyramid){0};
+}
+
+// Counts the points of the level 0 cells the limits touch and, past MY_DENSITY_POINTS_MAX, picks the finest level
+// whose cells are at least MY_DENSITY_PIXELS_PER_BIN pixels wide and tall.
+static MyDensityView my_density_view(
+    const MyDensityPyramid pyramid[static 1],
+    const double x_first,
+    const double x_last,
+    const double y_first,
+    const double y_last,
+    const double width_pixels,
+    const double height_pixels
+) {
+    MyDensityView view = {
+        .col_first = my_density_cell(pyramid->x_min, pyramid->x_max, x_first),
+        .col_end = my_density_cell(pyramid->x_min, pyramid->x_max, x_last) + 1,
+        .row_first = my_density_cell(pyramid->y_min, pyramid->y_max, y_first),
+        .row_end = my_density_cell(pyramid->y_min, pyramid->y_max, y_last) + 1,
+    };
+    my_range_for(size_t, row, view.row_first, view.row_end) {
+        view.points_count += pyramid->cell_offsets[row * MY_DENSITY_BASE + view.col_end] - pyramid->cell_offsets[row * MY_DENSITY_BASE + view.col_first];
+    }
+    view.heatmap = view.points_count > MY_DENSITY_POINTS_MAX;
+    if(!view.heatmap) {
+        return view;
+    }
+    const size_t col_last = view.col_end - 1, row_last = view.row_end - 1;
+    while(
+        view.level + 1 < MY_DENSITY_LEVELS
+        && ((double)((col_last >> view.level) - (view.col_first >> view.level) + 1) * MY_DENSITY_PIXELS_PER_BIN > width_pixels
+            || (double)((row_last >> view.level) - (view.row_first >> view.level) + 1) * MY_DENSITY_PIXELS_PER_BIN > height_pixels)
+    ) {
+        view.level += 1;
+    }
+    view.col_first >>= view.level;
+    view.col_end = (col_last >> view.level) + 1;
+    view.row_first >>= view.level;
+    view.row_end = (row_last >> view.level) + 1;
+    return view;
+}
+
+// Hands ImPlot either the points of the visible cells or a heatmap of the visible cells of one level, so a frame costs
+// at most MY_DENSITY_POINTS_MAX markers or a screen's worth of cells at any zoom. Called between BeginPlot and EndPlot.
+static MyDensityView my_density_plot(MyDensityPyramid pyramid[static 1], const char label[static 1]) {
+    const ImPlotRect_c limits = ImPlot_GetPlotLimits(ImAxis_X1, ImAxis_Y1);
+    const ImVec2 size = ImPlot_GetPlotSize();
+    const MyDensityView view = my_density_view(pyramid, limits.X.Min, limits.X.Max, limits.Y.Min, limits.Y.Max, (double)size.x, (double)size.y);
+    if(!view.heatmap) {
+        size_t count = 0;
+        my_range_for(size_t, row, view.row_first, view.row_end) {
+            const size_t first = pyramid->cell_offsets[row * MY_DENSITY_BASE + view.col_first];
+            const size_t run = pyramid->cell_offsets[row * MY_DENSITY_BASE + view.col_end] - first;
+            memcpy(pyramid->view_xs + count, pyramid->xs + first, run * sizeof(GLfloat));
+            memcpy(pyramid->view_ys + count, pyramid->ys + first, run * sizeof(GLfloat));
+            count += run;
+        }
+        ImPlot_PlotScatter_FloatPtrFloatPtr(label, pyramid->view_xs, pyramid->view_ys, (int)count, 0, 0, sizeof(GLfloat));
+        return view;
+    }
+    const size_t cells_count = MY_DENSITY_BASE >> view.level;
+    const size_t cols = view.col_end - view.col_first, rows = view.row_end - view.row_first;
+    const GLfloat *const level = pyramid->levels[view.level];
+    GLfloat max = 0.f;
+    // heatmap rows run from the top, log1p keeps sparse cells visible next to the dense diagonal
+    my_range_for_zero(size_t, row, rows) {
+        my_range_for_zero(size_t, col, cols) {
+            const GLfloat value = log1pf(level[(view.row_end - 1 - row) * cells_count + view.col_first + col]);
+            pyramid->view_values[row * cols + col] = value;
+            max = value > max ? value : max;
+        }
+    }
+    const double cell_width = (pyramid->x_max - pyramid->x_min) / (double)cells_count;
+    const double cell_height = (pyramid->y_max - pyramid->y_min) / (double)cells_count;
+    ImPlot_PlotHeatmap_FloatPtr(
+        label, pyramid->view_values, (int)rows, (int)cols, 0.0, max > 0.f ? (double)max : 1.0, NULL,
+        (ImPlotPoint_c){pyramid->x_min + (double)view.col_first * cell_width, pyramid->y_min + (double)view.row_first * cell_height},
+        (ImPlotPoint_c){pyramid->x_min + (double)view.col_end * cell_width, pyramid->y_min + (double)view.row_end * cell_height},
+        ImPlotHeatmapFlags_None
+    );
+    return view;
+}
+
+// Largest-Triangle-Three-Buckets: keeps the first and the last point and, from each of the `threshold - 2` buckets
+// between them, the point spanning the largest triangle with the point kept before it and the mean of the next bucket.
+static size_t my_lttb(
+    const double *const xs,
+    const double *const ys,
+    const size_t count,
+    const size_t threshold,
+    double *const out_xs,
+    double *const out_ys
+) {
+    if(threshold >= count || threshold < 3) {
+        memcpy(out_xs, xs, count * sizeof(double));
+        memcpy(out_ys, ys, count * sizeof(double));
+        return count;
+    }
+    const double bucket_width = (double)(count - 2) / (double)(threshold - 2);
+    size_t kept = 0;
+    out_xs[0] = xs[0];
+    out_ys[0] = ys[0];
+    my_range_for_zero(size_t, bucket, threshold - 2) {
+        const size_t first = (size_t)((double)bucket * bucket_width) + 1;
+        const size_t end = (size_t)((double)(bucket + 1) * bucket_width) + 1;
+        const size_t next_end = (size_t)((double)(bucket + 2) * bucket_width) + 1 < count ? (size_t)((double)(bucket + 2) * bucket_width) + 1 : count;
+        double next_x = 0.0, next_y = 0.0;
+        my_range_for(size_t, i, end, next_end) {
+            next_x += xs[i];
+            next_y += ys[i];
+        }
+        next_x /= (double)(next_end - end);
+        next_y /= (double)(next_end - end);
+        size_t best = first;
+        double best_area = -1.0;
+        my_range_for(size_t, i, first, end) {
+            const double area = fabs((xs[kept] - next_x) * (ys[i] - ys[kept]) - (xs[kept] - xs[i]) * (next_y - ys[kept]));
+            if(area > best_area) {
+                best_area = area;
+                best = i;
+            }
+        }
+        kept = best;
+        out_xs[bucket + 1] = xs[kept];
+        out_ys[bucket + 1] = ys[kept];
+    }
+    out_xs[threshold - 1] = xs[count - 1];
+    out_ys[threshold - 1] = ys[count - 1];
+    return threshold;
+}
+
+typedef enum {
+    MY_DASHBOARD_PLOT_MSE,
+    MY_DASHBOARD_PLOT_GRADIENT_NORM,
+    MY_DASHBOARD_PLOT_EPOCH_MS,
+    MY_DASHBOARD_PLOT_GFLOPS,
+    MY_DASHBOARD_PLOT_COUNT,
+} MyDashboardPlot;
+
+static const char *const my_dashboard_plot_names[MY_DASHBOARD_PLOT_COUNT] = {
+    [MY_DASHBOARD_PLOT_MSE] = "mse",
+    [MY_DASHBOARD_PLOT_GRADIENT_NORM] = "gradient norm",
+    [MY_DASHBOARD_PLOT_EPOCH_MS] = "epoch ms",
+    [MY_DASHBOARD_PLOT_GFLOPS] = "gflops",
+};
+
+// History of one job owned by the render loop, the epoch time and gflops of a device are plotted from its first job.
+typedef struct {
+    size_t device;
+    uint32_t job;
+    char label[64];
+    double *epochs;
+    double *values[MY_DASHBOARD_PLOT_COUNT];
+    size_t count;
+    size_t capacity;
+} MyDashboardSeries;
+
+typedef struct {
+    MyTrainOptions options;
+    // predicted against actual training targets of the saved model, set before `finished`
+    MyDensityPyramid *scatter;
+    atomic_bool finished;
+} MyDashboardTraining;
+
+static void* my_dashboard_train(void *const arg) {
+    MyDashboardTraining *const training = (MyDashboardTraining*)arg;
+    my_trace_thread_name("trainer");
+    my_polynomial_train(training->options);
+    if(training->options.model_path) {
+        my_mem_phase_set(MY_MEM_PHASE_EVALUATE);
+        const double start_ms = my_time_ms();
+        MyModel model = my_model_load(training->options.model_path);
+        MyMat x_train = {.rows = 20210, .cols = 167};
+        MyMat y_train = {.rows = 20210, .cols = 1};
+        MyArena arena = my_arena_init(my_mat_bytes_count(&x_train) + my_mat_bytes_count(&y_train) + y_train.rows * sizeof(GLfloat));
+        my_read_bin_data_to_mat(&x_train, &arena, "data/x_train.bin");
+        my_read_bin_data_to_mat(&y_train, &arena, "data/y_train.bin");
+        GLfloat *const predictions = (GLfloat*)my_arena_alloc(&arena, y_train.rows * sizeof(GLfloat));
+        my_model_predict(&model, &x_train, predictions);
+        training->scatter = (MyDensityPyramid*)malloc(sizeof(MyDensityPyramid));
+        ASSERT(training->scatter);
+        *training->scatter = my_density_pyramid_create(y_train.items, predictions, y_train.rows);
+        LOG("scatter points: %zu, pyramid ms: %lf", y_train.rows, my_time_ms() - start_ms);
+        my_model_destroy(&model);
+        my_arena_free(&arena);
+    }
+    atomic_store_explicit(&training->finished, true, memory_order_release);
+    return NULL;
+}
+
+static void my_dashboard_series_append(MyDashboardSeries series[static 1], const MyTrainMetric metric[static 1]) {
+    if(series->count == series->capacity) {
+        series->capacity = series->capacity > 0 ? 2 * series->capacity : 256;
+        series->epochs = (double*)realloc(series->epochs, series->capacity * sizeof(double));
+        ASSERT(series->epochs);
+        my_range_for_zero(size_t, plot, MY_DASHBOARD_PLOT_COUNT) {
+            series->values[plot] = (double*)realloc(series->values[plot], series->capacity * sizeof(double));
+            ASSERT(series->values[plot]);
+        }
+    }
+    series->epochs[series->count] = (double)metric->epoch;
+    series->values[MY_DASHBOARD_PLOT_MSE][series->count] = metric->mse;
+    series->values[MY_DASHBOARD_PLOT_GRADIENT_NORM][series->count] = metric->gradient_norm;
+    series->values[MY_DASHBOARD_PLOT_EPOCH_MS][series->count] = metric->epoch_ms;
+    series->values[MY_DASHBOARD_PLOT_GFLOPS][series->count] = metric->gflops;
+    series->count += 1;
+}
+
+// Training runs on its own thread and its device workers on their own EGL contexts, the window's context only renders.
+// The render loop drains the metric rings once a frame and waits for events at most a frame long, so it neither
+// blocks the training threads nor spins against them for CPU time.
+static void my_dashboard(const MyTrainOptions options[static 1]) {
+    GLFWwindow* const glfw_window = my_glfw_init(true);
+    ImGuiContext *const ig_context = igCreateContext(NULL);
+    ImPlotContext *const implot_context = ImPlot_CreateContext();
+    ImGuiIO *const ig_io = igGetIO_Nil();
+    ig_io->IniFilename = NULL;
+    igStyleColorsDark(igGetStyle());
+    ImGui_ImplGlfw_InitForOpenGL(glfw_window, true);
+    ImGui_ImplOpenGL3_Init("#version 460");
+
+    MyMetricRing *const rings = my_metric_rings_create(MY_GL_CONTEXT_DISPLAYS_MAX);
+    MyDiagnosticsBuffer *const diagnostics = (MyDiagnosticsBuffer*)calloc(MY_GL_CONTEXT_DISPLAYS_MAX, sizeof(MyDiagnosticsBuffer));
+    ASSERT(diagnostics);
+    my_range_for_zero(size_t, device, MY_GL_CONTEXT_DISPLAYS_MAX) {
+        my_diagnostics_buffer_init(&diagnostics[device]);
+    }
+    MyDashboardTraining *const training = (MyDashboardTraining*)calloc(1, sizeof(MyDashboardTraining));
+    ASSERT(training);
+    training->options = *options;
+    training->options.metric_rings = rings;
+    training->options.diagnostics = options->backend == MY_TRAIN_BACKEND_GL ? diagnostics : NULL;
+    pthread_t trainer;
+    ASSERT(pthread_create(&trainer, NULL, my_dashboard_train, training) == 0);
+
+    MyDashboardSeries *series = NULL;
+    size_t series_count = 0;
+    // line plots of more epochs than pixels are decimated into these
+    double *line_xs = NULL, *line_ys = NULL;
+    size_t line_capacity = 0;
+    // the scatter view is known once its plot is laid out, the caption shows the previous frame's
+    MyDensityView scatter_view = {0};
+    const MyDiagnosticsFrame *diagnostics_frames[MY_GL_CONTEXT_DISPLAYS_MAX] = {NULL};
+    while(!glfwWindowShouldClose(glfw_window)) {
+        glfwWaitEventsTimeout(1.0 / 60.0);
+        size_t dropped = 0;
+        my_range_for_zero(size_t, device, MY_GL_CONTEXT_DISPLAYS_MAX) {
+            MyTrainMetric metric;
+            while(my_metric_ring_pop(&rings[device], &metric)) {
+                size_t i = 0;
+                while(i < series_count && (series[i].device != device || series[i].job != metric.job)) {
+                    i += 1;
+                }
+                if(i == series_count) {
+                    series = (MyDashboardSeries*)realloc(series, (series_count + 1) * sizeof(MyDashboardSeries));
+                    ASSERT(series);
+                    series[i] = (MyDashboardSeries){.device = device, .job = metric.job};
+                    snprintf(series[i].label, sizeof(series[i].label), "degree %u, l2 %g##%zu.%u", metric.degree, (double)metric.l2, device, metric.job);
+                    series_count += 1;
+                }
+                my_dashboard_series_append(&series[i], &metric);
+                if(series[i].count > line_capacity) {
+                    line_capacity = series[i].capacity;
+                    line_xs = (double*)realloc(line_xs, line_capacity * sizeof(double));
+                    line_ys = (double*)realloc(line_ys, line_capacity * sizeof(double));
+                    ASSERT(line_xs && line_ys);
+                }
+            }
+            dropped += atomic_load_explicit(&rings[device].dropped, memory_order_relaxed);
+            const MyDiagnosticsFrame *const frame = my_diagnostics_buffer_take(&diagnostics[device]);
+            diagnostics_frames[device] = frame ? frame : diagnostics_frames[device];
+        }
+
+        ASSERT_GL(glClearColor(0, 0, 0, 1));
+        ASSERT_GL(glClear(GL_COLOR_BUFFER_BIT));
+        ImGui_ImplOpenGL3_NewFrame();
+        ImGui_ImplGlfw_NewFrame();
+        igNewFrame();
+        igSetNextWindowPos((ImVec2){0.f, 0.f}, ImGuiCond_Always, (ImVec2){0.f, 0.f});
+        igSetNextWindowSize(igGetMainViewport()->WorkSize, ImGuiCond_Always);
+        const bool finished = atomic_load_explicit(&training->finished, memory_order_acquire);
+        if(igBegin("training", NULL, ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoMove | ImGuiWindowFlags_NoCollapse)) {
+            igText(
+                "solver: %s, optimizer: %s, jobs: %zu, %s, dropped metrics: %zu", my_solver_names[options->solver], my_optimizer_names[options->optimizer],
+                series_count, finished ? "finished" : "training", dropped
+            );
+            if(igBeginTabBar("views", 0)) {
+                if(igBeginTabItem("metrics", NULL, 0)) {
+                    const ImVec2 plot_size = {igGetContentRegionAvail().x / 2.f - 4.f, igGetContentRegionAvail().y / 2.f - 4.f};
+                    my_range_for_zero(size_t, plot, MY_DASHBOARD_PLOT_COUNT) {
+                        if(plot % 2 == 1) {
+                            igSameLine(0.f, -1.f);
+                        }
+                        const bool per_device = plot == MY_DASHBOARD_PLOT_EPOCH_MS || plot == MY_DASHBOARD_PLOT_GFLOPS;
+                        if(ImPlot_BeginPlot(my_dashboard_plot_names[plot], plot_size, 0)) {
+                            ImPlot_SetupAxes("epoch", NULL, ImPlotAxisFlags_AutoFit, ImPlotAxisFlags_AutoFit);
+                            if(plot == MY_DASHBOARD_PLOT_MSE || plot == MY_DASHBOARD_PLOT_GRADIENT_NORM) {
+                                ImPlot_SetupAxisScale_PlotScale(ImAxis_Y1, ImPlotScale_Log10);
+                            }
+                            // two points per pixel column keep the extremes of every column
+                            const size_t threshold = 2 * (size_t)ImPlot_GetPlotSize().x;
+                            my_range_for_zero(size_t, i, series_count) {
+                                if(per_device && series[i].job != 0) {
+                                    continue;
+                                }
+                                char device_label[32];
+                                snprintf(device_label, sizeof(device_label), "device %zu", series[i].device);
+                                const size_t count = my_lttb(series[i].epochs, series[i].values[plot], series[i].count, threshold, line_xs, line_ys);
+                                ImPlot_PlotLine_doublePtrdoublePtr(per_device ? device_label : series[i].label, line_xs, line_ys, (int)count, 0, 0, sizeof(double));
+                            }
+                            ImPlot_EndPlot();
+                        }
+                    }
+                    igEndTabItem();
+                }
+                if(training->options.diagnostics && igBeginTabItem("diagnostics", NULL, 0)) {
+                    my_range_for_zero(size_t, device, MY_GL_CONTEXT_DISPLAYS_MAX) {
+                        const MyDiagnosticsFrame *const frame = diagnostics_frames[device];
+                        if(!frame) {
+                            continue;
+                        }
+                        int jobs_count = 0;
+                        my_range_for_zero(size_t, i, series_count) {
+                            jobs_count = series[i].device == device && (int)series[i].job >= jobs_count ? (int)series[i].job + 1 : jobs_count;
+                        }
+                        igText("device %zu, job %u, epoch %u", device, frame->job, frame->epoch);
+                        int job = (int)atomic_load_explicit(&diagnostics[device].job, memory_order_relaxed);
+                        char label[64];
+                        snprintf(label, sizeof(label), "job##%zu", device);
+                        if(jobs_count > 1 && igSliderInt(label, &job, 0, jobs_count - 1, "%d", 0)) {
+                            atomic_store_explicit(&diagnostics[device].job, (unsigned)job, memory_order_relaxed);
+                        }
+                        const ImVec2 plot_size = {igGetContentRegionAvail().x / 2.f - 4.f, 320.f};
+                        snprintf(label, sizeof(label), "residuals##%zu", device);
+                        if(ImPlot_BeginPlot(label, plot_size, 0)) {
+                            ImPlot_SetupAxes("residual", "rows", ImPlotAxisFlags_AutoFit, ImPlotAxisFlags_AutoFit);
+                            double centers[MY_DIAGNOSTICS_BINS], counts[MY_DIAGNOSTICS_BINS];
+                            const double bin_width = 2.0 * (double)frame->range / MY_DIAGNOSTICS_BINS;
+                            my_range_for_zero(size_t, bin, MY_DIAGNOSTICS_BINS) {
+                                centers[bin] = -(double)frame->range + ((double)bin + 0.5) * bin_width;
+                                counts[bin] = (double)frame->bins[bin];
+                            }
+                            ImPlot_PlotBars_doublePtrdoublePtr("rows", centers, counts, MY_DIAGNOSTICS_BINS, bin_width, 0, 0, sizeof(double));
+                            ImPlot_EndPlot();
+                        }
+                        igSameLine(0.f, -1.f);
+                        snprintf(label, sizeof(label), "log10 |weight|##%zu", device);
+                        if(ImPlot_BeginPlot(label, plot_size, 0)) {
+                            ImPlot_SetupAxes("feature", "power", ImPlotAxisFlags_AutoFit, ImPlotAxisFlags_AutoFit);
+                            const size_t cells_count = (size_t)frame->rows * frame->cols;
+                            GLfloat min = INFINITY, max = -INFINITY;
+                            my_range_for_zero(size_t, cell, cells_count) {
+                                min = frame->image[cell] < min ? frame->image[cell] : min;
+                                max = frame->image[cell] > max ? frame->image[cell] : max;
+                            }
+                            ImPlot_PushColormap_PlotColormap(ImPlotColormap_Viridis);
+                            ImPlot_PlotHeatmap_FloatPtr(
+                                "weights", frame->image, (int)frame->rows, (int)frame->cols, (double)min, max > min ? (double)max : (double)min + 1.0, NULL,
+                                (ImPlotPoint_c){0.0, 0.5}, (ImPlotPoint_c){(double)frame->cols, (double)frame->rows + 0.5}, ImPlotHeatmapFlags_None
+                            );
+                            ImPlot_PopColormap(1);
+                            ImPlot_EndPlot();
+                        }
+                    }
+                    igEndTabItem();
+                }
+                if(finished && training->scatter && igBeginTabItem("predicted vs actual", NULL, 0)) {
+                    MyDensityPyramid *const scatter = training->scatter;
+                    igText("visible points: %zu, drawn as %s", scatter_view.points_count, scatter_view.heatmap ? "a heatmap" : "points");
+                    if(ImPlot_BeginPlot("##scatter", (ImVec2){-1.f, -1.f}, 0)) {
+                        ImPlot_SetupAxes("actual", "predicted", ImPlotAxisFlags_None, ImPlotAxisFlags_None);
+                        ImPlot_SetupAxesLimits(scatter->x_min, scatter->x_max, scatter->y_min, scatter->y_max, ImPlotCond_Once);
+                        ImPlot_PushColormap_PlotColormap(ImPlotColormap_Viridis);
+                        scatter_view = my_density_plot(scatter, "train rows");
+                        ImPlot_PopColormap(1);
+                        const double diagonal[2] = {fmax(scatter->x_min, scatter->y_min), fmin(scatter->x_max, scatter->y_max)};
+                        ImPlot_PlotLine_doublePtrdoublePtr("predicted = actual", diagonal, diagonal, 2, 0, 0, sizeof(double));
+                        ImPlot_EndPlot();
+                    }
+                    igEndTabItem();
+                }
+                if(igBeginTabItem("memory", NULL, 0)) {
+                    igText("alive, host MiB: %.2lf, gl MiB: %.2lf", my_mem_mib(&my_mem.host_alive_bytes), my_mem_mib(&my_mem.gl_alive_bytes));
+                    const char *const columns[] = {"phase", "host MiB", "host peak MiB", "gl MiB", "gl peak MiB", "uploaded MiB", "downloaded MiB"};
+                    if(igBeginTable("phases", (int)my_array_count(columns), ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg, (ImVec2){0.f, 0.f}, 0.f)) {
+                        my_range_for_zero(size_t, column, my_array_count(columns)) {
+                            igTableSetupColumn(columns[column], 0, 0.f, 0);
+                        }
+                        igTableHeadersRow();
+                        my_range_for_zero(size_t, phase, MY_MEM_PHASE_COUNT) {
+                            const MyMemPhaseStats *const stats = &my_mem.phases[phase];
+                            igTableNextRow(0, 0.f);
+                            igTableNextColumn(); igText("%s", my_mem_phase_names[phase]);
+                            igTableNextColumn(); igText("%.2lf", my_mem_mib(&stats->host_bytes));
+                            igTableNextColumn(); igText("%.2lf", my_mem_mib(&stats->host_peak_bytes));
+                            igTableNextColumn(); igText("%.2lf", my_mem_mib(&stats->gl_bytes));
+                            igTableNextColumn(); igText("%.2lf", my_mem_mib(&stats->gl_peak_bytes));
+                            igTableNextColumn(); igText("%.2lf", my_mem_mib(&stats->uploaded_bytes));
+                            igTableNextColumn(); igText("%.2lf", my_mem_mib(&stats->downloaded_bytes));
+                        }
+                        igEndTable();
+                    }
+                    igEndTabItem();
+                }
+                igEndTabBar();
+            }
+        }
+        igEnd();
+        igRender();
+        ImGui_ImplOpenGL3_RenderDrawData(igGetDrawData());
+        glfwSwapBuffers(glfw_window);
+    }
+
+    if(!atomic_load_explicit(&training->finished, memory_order_acquire)) {
+        LOG("window closed, waiting for training to finish");
+    }
+    ASSERT(pthread_join(trainer, NULL) == 0);
+    my_range_for_zero(size_t, i, series_count) {
+        free(series[i].epochs);
+        my_range_for_zero(size_t, plot, MY_DASHBOARD_PLOT_COUNT) {
+            free(series[i].values[plot]);
+        }
+    }
+    free(series);
+    free(line_ys);
+    free(line_xs);
+    if(training->scatter) {
+        my_density_pyramid_destroy(training->scatter);
+        free(training->scatter);
+    }
+    free(training);
+    free(diagnostics);
+    free(rings);
+
+    ImGui_ImplOpenGL3_Shutdown();
+    ImGui_ImplGlfw_Shutdown();
+    ImPlot_DestroyContext(implot_context);
+    igDestroyContext(ig_context);
+    glfwTerminate();
+}
+
+static void window_demo(void) {
+    GLFWwindow* const glfw_window = my_glfw_init(true);
+    ImGuiContext *const ig_context = igCreateContext(NULL);
+    ImPlotContext *const implot_context = ImPlot_CreateContext();
+    ImGuiIO *const ig_io = igGetIO_Nil();
+    ig_io->IniFilename = NULL;
+    ig_io->ConfigFlags |= ImGuiConfigFlags_NavEnableKeyboard;
+    ig_io->ConfigFlags |= ImGuiConfigFlags_NavEnableGamepad;
+
+    ig_io->ConfigFlags |= ImGuiConfigFlags_DockingEnable;
+    ImGuiStyle *const ig_style = igGetStyle();
+    igStyleColorsDark(ig_style);
+    ImGui_ImplGlfw_InitForOpenGL(glfw_window, true);
+    ImGui_ImplOpenGL3_Init("#version 460");
+
+    while(!glfwWindowShouldClose(glfw_window)) {
+        glfwPollEvents();
+        ASSERT_GL(glClearColor(0, 0, 0, 1));
+        ASSERT_GL(glClear(GL_COLOR_BUFFER_BIT));
+
+        ImGui_ImplOpenGL3_NewFrame();
+        ImGui_ImplGlfw_NewFrame();
+        igNewFrame();
+
+        // {
+        //     ImGuiViewport* const ig_viewport = igGetWindowViewport();
+        //     igSetNextWindowPos((ImVec2){0}, ImGuiCond_FirstUseEver, (ImVec2){0});
+        //     igSetNextWindowSize(ig_viewport->WorkSize, ImGuiCond_Always);
+        // }
+        // if(igBegin("demo", NULL, ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoMove)) {
+        //
+        // }
+        // igEnd();
+
+
+            ImS64   bar_data[11];
+            for(int i = 0; i < 11; i++) {
+                bar_data[i] = i;
+            }
+
+            ImVec2 plot_size;
+            plot_size.x = 500;
+            plot_size.y = 300;
+            
+            igBegin("My Window", NULL, 0);
+            
+            if(ImPlot_BeginPlot("My Plot",plot_size,0)) {
+                ImPlot_PlotBars_S64PtrInt("My Bar Plot", bar_data, 11,0.67,0,0,0,sizeof(ImS64));
+                ImPlot_EndPlot();
+            }
+            
+            //igText("Test");
+            //igButton("Test",(struct ImVec2){200,50});
+
+            igEnd();
+
+
+        static bool showdemowindow = true;
+        igShowDemoWindow(&showdemowindow);
+
+
+
+        igRender();
+        ImGui_ImplOpenGL3_RenderDrawData(igGetDrawData());
+        glfwSwapBuffers(glfw_window);
+    }
+
+    ImGui_ImplOpenGL3_Shutdown();
+    ImGui_ImplGlfw_Shutdown();
+    ImPlot_DestroyContext(implot_context);
+    igDestroyContext(ig_context);
+
+    glfwTerminate();
+}
+
+#define MY_ROOFLINE_STREAM_ITEMS ((size_t)1 << 24)
+#define MY_ROOFLINE_FMA_LANES 32
+#define MY_ROOFLINE_FMA_ITERATIONS ((size_t)1 << 20)
+#define MY_ROOFLINE_FMA_CHUNKS_MAX 1024
+#define MY_ROOFLINE_GL_FMA_GROUPS 1024
+#define MY_ROOFLINE_GL_FMA_ITERATIONS 256
+#define MY_ROOFLINE_KERNELS_MAX 16
+// axpby runs one invocation per item and dispatches are capped at 65535 groups
+#define MY_ROOFLINE_GL_AXPBY_ITEMS ((size_t)65535 * 256)
+
+typedef enum {
+    MY_ROOFLINE_DEVICE_CPU,
+    MY_ROOFLINE_DEVICE_GL,
+    MY_ROOFLINE_DEVICE_COUNT,
+} MyRooflineDevice;
+
+static const char *const my_roofline_device_names[MY_ROOFLINE_DEVICE_COUNT] = {
+    [MY_ROOFLINE_DEVICE_CPU] = "cpu",
+    [MY_ROOFLINE_DEVICE_GL] = "gl",
+};
+
+typedef struct {
+    const char *device;
+    size_t repeats;
+    bool plot;
+} MyRooflineOptions;
+
+// Peak compute and memory bandwidth of a device as reached by the microbenchmarks, which are built with the
+// same flags as the kernels, so the CPU peak is what this binary can vectorize rather than the datasheet figure.
+typedef struct {
+    double gflops;
+    double gbytes_per_s;
+} MyRooflineCeilings;
+
+// Flops and bytes are analytic counts of one call, bytes are the compulsory traffic of the operands.
+typedef struct {
+    const char *name;
+    MyRooflineDevice device;
+    double flops;
+    double bytes;
+    double ms;
+} MyRooflineKernel;
+
+typedef struct {
+    MyRooflineCeilings ceilings[MY_ROOFLINE_DEVICE_COUNT];
+    MyRooflineKernel kernels[MY_ROOFLINE_KERNELS_MAX];
+    size_t kernels_count;
+} MyRoofline;
+
+typedef struct {
+    double intensity;
+    double gflops;
+    double gbytes_per_s;
+    double roof_gflops;
+    // achieved share of the ceiling that bounds the kernel
+    double of_roof;
+    bool compute_bound;
+} MyRooflinePoint;
+
+// Operands of the kernel being timed, every kernel reads the fields it needs.
+typedef struct {
+    MyArena arena;
+    MyMat first;
+    MyMat second;
+    MyMat result;
+    size_t degree;
+    size_t fma_chunks;
+    GLfloat fma_sums[MY_ROOFLINE_FMA_CHUNKS_MAX];
+    GLuint shader_program;
+    MyGLMat gl_first;
+    MyGLMat gl_second;
+    MyGLMat gl_result;
+} MyRooflineBench;
+
+typedef void (*MyRooflineFn)(MyRooflineBench *bench);
+
+static const char mygl_roofline_copy_compute_shader[] = S(
+layout(local_size_x = 256, local_size_y = 1, local_size_z = 1) in;
+
+uniform uint n;
+
+layout(std430, binding = 0) readonly buffer ssbo_A { vec4 A[]; };
+layout(std430, binding = 1) writeonly buffer ssbo_R { vec4 R[]; };
+
+void main() {
+    uint i = gl_GlobalInvocationID.x;
+    if(i < n) {
+        R[i] = A[i];
+    }
+}
+);
+
+// Eight independent vec4 chains of 64 flops per iteration, the sum is stored so the loop stays alive.
+static const char mygl_roofline_fma_compute_shader[] = S(
+layout(local_size_x = 256, local_size_y = 1, local_size_z = 1) in;
+
+layout(std430, binding = 0) writeonly buffer ssbo_R { vec4 R[]; };
+
+void main() {
+    vec4 x = vec4(float(gl_GlobalInvocationID.x) * 1e-9);
+    vec4 a0 = x + 0.1, a1 = x + 0.2, a2 = x + 0.3, a3 = x + 0.4, a4 = x + 0.5, a5 = x + 0.6, a6 = x + 0.7, a7 = x + 0.8;
+    for(uint i = 0u; i < ITERATIONS; i++) {
+        a0 = fma(a0, vec4(0.999), vec4(0.001));
+        a1 = fma(a1, vec4(0.999), vec4(0.001));
+        a2 = fma(a2, vec4(0.999), vec4(0.001));
+        a3 = fma(a3, vec4(0.999), vec4(0.001));
+        a4 = fma(a4, vec4(0.999), vec4(0.001));
+        a5 = fma(a5, vec4(0.999), vec4(0.001));
+        a6 = fma(a6, vec4(0.999), vec4(0.001));
+        a7 = fma(a7, vec4(0.999), vec4(0.001));
+    }
+    R[gl_GlobalInvocationID.x] = a0 + a1 + a2 + a3 + a4 + a5 + a6 + a7;
+}
+);
+
+static void my_roofline_triad_items(void *const context, const size_t first, const size_t end) {
+    MyRooflineBench *const bench = (MyRooflineBench*)context;
+    my_range_for(size_t, i, first, end) {
+        bench->result.items[i] = bench->first.items[i] + 3.f * bench->second.items[i];
+    }
+}
+
+static void my_roofline_triad(MyRooflineBench bench[static 1]) {
+    my_parallel_for("my_roofline_triad", my_mat_items_count(&bench->result), (size_t)1 << 16, my_roofline_triad_items, bench);
+}
+
+static void my_roofline_fma_chunks(void *const context, const size_t chunk_first, const size_t chunk_end) {
+    MyRooflineBench *const bench = (MyRooflineBench*)context;
+    my_range_for(size_t, chunk, chunk_first, chunk_end) {
+        GLfloat lanes[MY_ROOFLINE_FMA_LANES];
+        my_range_for_zero(size_t, lane, MY_ROOFLINE_FMA_LANES) {
+            lanes[lane] = (GLfloat)(chunk + lane) * 1e-6f;
+        }
+        my_range_for_zero(size_t, i, MY_ROOFLINE_FMA_ITERATIONS) {
+            my_range_for_zero(size_t, lane, MY_ROOFLINE_FMA_LANES) {
+                lanes[lane] = lanes[lane] * 0.999f + 0.001f;
+            }
+        }
+        GLfloat sum = 0.f;
+        my_range_for_zero(size_t, lane, MY_ROOFLINE_FMA_LANES) {
+            sum += lanes[lane];
+        }
+        bench->fma_sums[chunk] = sum;
+    }
+}
+
+static void my_roofline_fma(MyRooflineBench bench[static 1]) {
+    my_parallel_for("my_roofline_fma", bench->fma_chunks, 1, my_roofline_fma_chunks, bench);
+}
+
+static void my_roofline_mat_mul(MyRooflineBench bench[static 1]) {
+    my_mat_mul(&bench->result, &bench->first, &bench->second);
+}
+
+static void my_roofline_transpose(MyRooflineBench bench[static 1]) {
+    my_mat_transpose(&bench->result, &bench->first);
+}
+
+static void my_roofline_features(MyRooflineBench bench[static 1]) {
+    const size_t arena_count = bench->arena.count;
+    my_polynomial_features_create(&bench->arena, &bench->first, bench->degree);
+    bench->arena.count = arena_count;
+}
+
+static void my_roofline_gl_copy(MyRooflineBench bench[static 1]) {
+    const GLuint n = (GLuint)(my_mat_items_count(&bench->gl_result) / 4);
+    ASSERT_GL(glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, bench->gl_first.ssb));
+    ASSERT_GL(glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, bench->gl_result.ssb));
+    ASSERT_GL(glUseProgram(bench->shader_program));
+        ASSERT_GL(glUniform1ui(my_gl_get_uniform_location(bench->shader_program, "n"), n));
+        my_gl_dispatch_compute("roofline_copy", (n + 255) / 256, 1, 1);
+    ASSERT_GL(glUseProgram(0));
+    ASSERT_GL(glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, 0));
+    ASSERT_GL(glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, 0));
+}
+
+static void my_roofline_gl_fma(MyRooflineBench bench[static 1]) {
+    ASSERT_GL(glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, bench->gl_result.ssb));
+    ASSERT_GL(glUseProgram(bench->shader_program));
+        my_gl_dispatch_compute("roofline_fma", MY_ROOFLINE_GL_FMA_GROUPS, 1, 1);
+    ASSERT_GL(glUseProgram(0));
+    ASSERT_GL(glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, 0));
+}
+
+static void my_roofline_gl_mat_mul(MyRooflineBench bench[static 1]) {
+    my_gl_dispatch_compute_mat_mul(bench->shader_program, &bench->gl_first, &bench->gl_second, &bench->gl_result);
+}
+
+static void my_roofline_gl_axpby(MyRooflineBench bench[static 1]) {
+    my_gl_dispatch_compute_axpby(
+        bench->shader_program, bench->gl_result.ssb, 0, (GLuint)MY_ROOFLINE_GL_AXPBY_ITEMS,
+        2.f, bench->gl_first.ssb, 0, 1, 3.f, bench->gl_second.ssb, 0, 1
+    );
+}
+
+// Best of `repeats` calls after a warm-up call, GL calls are timed up to glFinish.
+static double my_roofline_time_ms(MyRooflineBench bench[static 1], const MyRooflineFn fn, const bool gl, const size_t repeats) {
+    double best_ms = INFINITY;
+    my_range_for_zero(size_t, i, repeats + 1) {
+        if(gl) {
+            ASSERT_GL(glFinish());
+        }
+        const double start_ms = my_time_ms();
+        fn(bench);
+        if(gl) {
+            ASSERT_GL(glFinish());
+        }
+        const double ms = my_time_ms() - start_ms;
+        best_ms = i > 0 ? fmin(best_ms, ms) : best_ms;
+    }
+    return best_ms;
+}
+
+static void my_roofline_add(
+    MyRoofline roofline[static 1],
+    const char name[static 1],
+    const MyRooflineDevice device,
+    const double flops,
+    const double bytes,
+    const double ms
+) {
+    ASSERT(roofline->kernels_count < MY_ROOFLINE_KERNELS_MAX);
+    roofline->kernels[roofline->kernels_count++] = (MyRooflineKernel){.name = name, .device = device, .flops = flops, .bytes = bytes, .ms = ms};
+}
+
+static MyRooflinePoint my_roofline_point(const MyRoofline roofline[static 1], const MyRooflineKernel kernel[static 1]) {
+    const MyRooflineCeilings *const ceilings = &roofline->ceilings[kernel->device];
+    MyRooflinePoint point = {
+        .intensity = kernel->flops / kernel->bytes,
+        .gflops = kernel->flops / kernel->ms / 1e6,
+        .gbytes_per_s = kernel->bytes / kernel->ms / 1e6,
+    };
+    point.roof_gflops = fmin(ceilings->gflops, point.intensity * ceilings->gbytes_per_s);
+    point.compute_bound = point.intensity * ceilings->gbytes_per_s >= ceilings->gflops;
+    // for a bandwidth bound kernel the two shares are equal, the bandwidth one is defined without flops
+    point.of_roof = point.compute_bound ? point.gflops / ceilings->gflops : point.gbytes_per_s / ceilings->gbytes_per_s;
+    return point;
+}
+
+static void my_roofline_measure_cpu(MyRoofline roofline[static 1], MyRooflineBench bench[static 1], const size_t repeats) {
+    MyRooflineCeilings *const ceilings = &roofline->ceilings[MY_ROOFLINE_DEVICE_CPU];
+    MyArena *const arena = &bench->arena;
+    {
+        bench->first = my_mat_alloc(arena, MY_ROOFLINE_STREAM_ITEMS, 1);
+        bench->second = my_mat_alloc(arena, MY_ROOFLINE_STREAM_ITEMS, 1);
+        bench->result = my_mat_alloc(arena, MY_ROOFLINE_STREAM_ITEMS, 1);
+        const double ms = my_roofline_time_ms(bench, my_roofline_triad, false, repeats);
+        ceilings->gbytes_per_s = 3.0 * sizeof(GLfloat) * (double)MY_ROOFLINE_STREAM_ITEMS / ms / 1e6;
+        my_arena_reset(arena);
+    }
+    {
+        const size_t threads_count = my_thread_pool.threads_count > 0 ? my_thread_pool.threads_count : 1;
+        bench->fma_chunks = 4 * threads_count < MY_ROOFLINE_FMA_CHUNKS_MAX ? 4 * threads_count : MY_ROOFLINE_FMA_CHUNKS_MAX;
+        const double ms = my_roofline_time_ms(bench, my_roofline_fma, false, repeats);
+        ceilings->gflops = 2.0 * MY_ROOFLINE_FMA_LANES * (double)MY_ROOFLINE_FMA_ITERATIONS * (double)bench->fma_chunks / ms / 1e6;
+    }
+    LOG(
+        "cpu ceilings: %lf gflop/s, %lf gb/s, ridge: %lf flop/byte",
+        ceilings->gflops, ceilings->gbytes_per_s, ceilings->gflops / ceilings->gbytes_per_s
+    );
+
+    const struct {
+        const char *name;
+        size_t rows, inner, cols;
+    } mat_muls[] = {
+        {"gemm", 1024, 1024, 16},
+        {"gemv", 4096, 4096, 1},
+    };
+    my_range_for_zero(size_t, i, my_array_count(mat_muls)) {
+        const double rows = (double)mat_muls[i].rows, inner = (double)mat_muls[i].inner, cols = (double)mat_muls[i].cols;
+        bench->first = my_mat_alloc(arena, mat_muls[i].rows, mat_muls[i].inner);
+        bench->second = my_mat_alloc(arena, mat_muls[i].inner, mat_muls[i].cols);
+        bench->result = my_mat_alloc(arena, mat_muls[i].rows, mat_muls[i].cols);
+        my_mat_foreach(el, &bench->first) {
+            *el = (GLfloat)(rand() % 2000) / 1000.f - 1.f;
+        }
+        my_mat_foreach(el, &bench->second) {
+            *el = (GLfloat)(rand() % 2000) / 1000.f - 1.f;
+        }
+        const double ms = my_roofline_time_ms(bench, my_roofline_mat_mul, false, repeats);
+        my_roofline_add(roofline, mat_muls[i].name, MY_ROOFLINE_DEVICE_CPU, 2.0 * rows * inner * cols, sizeof(GLfloat) * (rows * inner + inner * cols + rows * cols), ms);
+        if(i + 1 < my_array_count(mat_muls)) {
+            my_arena_reset(arena);
+        }
+    }
+    {
+        // reuses the gemv matrix
+        const double items_count = (double)my_mat_items_count(&bench->first);
+        bench->result = my_mat_alloc(arena, bench->first.cols, bench->first.rows);
+        const double ms = my_roofline_time_ms(bench, my_roofline_transpose, false, repeats);
+        my_roofline_add(roofline, "transpose", MY_ROOFLINE_DEVICE_CPU, 0.0, 2.0 * sizeof(GLfloat) * items_count, ms);
+        my_arena_reset(arena);
+    }
+    {
+        // power d of an item takes d - 1 multiplications
+        bench->degree = 4;
+        bench->first = my_mat_alloc(arena, 16384, 167);
+        my_mat_foreach(el, &bench->first) {
+            *el = (GLfloat)(rand() % 2000) / 1000.f - 1.f;
+        }
+        const double items_count = (double)my_mat_items_count(&bench->first), degree = (double)bench->degree;
+        const double ms = my_roofline_time_ms(bench, my_roofline_features, false, repeats);
+        my_roofline_add(roofline, "features", MY_ROOFLINE_DEVICE_CPU, items_count * degree * (degree - 1.0) / 2.0, sizeof(GLfloat) * items_count * (1.0 + degree), ms);
+        my_arena_reset(arena);
+    }
+}
+
+static void my_roofline_measure_gl(MyRoofline roofline[static 1], MyRooflineBench bench[static 1], const size_t repeats) {
+    MyRooflineCeilings *const ceilings = &roofline->ceilings[MY_ROOFLINE_DEVICE_GL];
+    GLuint compute_shader;
+    {
+        mygl_create_compute_shader_program_with_header(&bench->shader_program, &compute_shader, "", mygl_roofline_copy_compute_shader);
+        bench->gl_first = mygl_mat_buffer_data(&(MyMat){.rows = MY_ROOFLINE_STREAM_ITEMS, .cols = 1}, GL_STATIC_DRAW);
+        bench->gl_result = mygl_mat_buffer_data(&(MyMat){.rows = MY_ROOFLINE_STREAM_ITEMS, .cols = 1}, GL_DYNAMIC_COPY);
+        const double ms = my_roofline_time_ms(bench, my_roofline_gl_copy, true, repeats);
+        ceilings->gbytes_per_s = 2.0 * sizeof(GLfloat) * (double)MY_ROOFLINE_STREAM_ITEMS / ms / 1e6;
+        mygl_mat_delete(&bench->gl_first);
+        mygl_mat_delete(&bench->gl_result);
+        ASSERT_GL(glDeleteProgram(bench->shader_program));
+        ASSERT_GL(glDeleteShader(compute_shader));
+    }
+    {
+        char header[64];
+        snprintf(header, sizeof(header), "#define ITERATIONS %du\n", MY_ROOFLINE_GL_FMA_ITERATIONS);
+        mygl_create_compute_shader_program_with_header(&bench->shader_program, &compute_shader, header, mygl_roofline_fma_compute_shader);
+        bench->gl_result = mygl_mat_buffer_data(&(MyMat){.rows = 256 * MY_ROOFLINE_GL_FMA_GROUPS, .cols = 4}, GL_DYNAMIC_COPY);
+        const double ms = my_roofline_time_ms(bench, my_roofline_gl_fma, true, repeats);
+        ceilings->gflops = 64.0 * 256.0 * MY_ROOFLINE_GL_FMA_GROUPS * MY_ROOFLINE_GL_FMA_ITERATIONS / ms / 1e6;
+        mygl_mat_delete(&bench->gl_result);
+        ASSERT_GL(glDeleteProgram(bench->shader_program));
+        ASSERT_GL(glDeleteShader(compute_shader));
+    }
+    LOG(
+        "gl ceilings: %lf gflop/s, %lf gb/s, ridge: %lf flop/byte",
+        ceilings->gflops, ceilings->gbytes_per_s, ceilings->gflops / ceilings->gbytes_per_s
+    );
+
+    const struct {
+        const char *name;
+        GLuint rows, inner, cols;
+    } mat_muls[] = {
+        {"tiled gemm", 2048, 2048, 16},
+        {"tiled gemv", 4096, 4096, 1},
+    };
+    mygl_matrix_mul_create_program(&bench->shader_program, &compute_shader, MY_GL_MAT_FORMAT_F32, MY_PRECISION_F32);
+    my_range_for_zero(size_t, i, my_array_count(mat_muls)) {
+        const double rows = (double)mat_muls[i].rows, inner = (double)mat_muls[i].inner, cols = (double)mat_muls[i].cols;
+        bench->gl_first = mygl_mat_buffer_data(&(MyMat){.rows = mat_muls[i].rows, .cols = mat_muls[i].inner}, GL_STATIC_DRAW);
+        bench->gl_second = mygl_mat_buffer_data(&(MyMat){.rows = mat_muls[i].inner, .cols = mat_muls[i].cols}, GL_STATIC_DRAW);
+        bench->gl_result = mygl_mat_buffer_data(&(MyMat){.rows = mat_muls[i].rows, .cols = mat_muls[i].cols}, GL_DYNAMIC_COPY);
+        const double ms = my_roofline_time_ms(bench, my_roofline_gl_mat_mul, true, repeats);
+        my_roofline_add(roofline, mat_muls[i].name, MY_ROOFLINE_DEVICE_GL, 2.0 * rows * inner * cols, sizeof(GLfloat) * (rows * inner + inner * cols + rows * cols), ms);
+        mygl_mat_delete(&bench->gl_first);
+        mygl_mat_delete(&bench->gl_second);
+        mygl_mat_delete(&bench->gl_result);
+    }
+    ASSERT_GL(glDeleteProgram(bench->shader_program));
+    ASSERT_GL(glDeleteShader(compute_shader));
+    {
+        mygl_create_compute_shader_program_with_header(&bench->shader_program, &compute_shader, "", mygl_axpby_compute_shader);
+        bench->gl_first = mygl_mat_buffer_data(&(MyMat){.rows = MY_ROOFLINE_GL_AXPBY_ITEMS, .cols = 1}, GL_STATIC_DRAW);
+        bench->gl_second = mygl_mat_buffer_data(&(MyMat){.rows = MY_ROOFLINE_GL_AXPBY_ITEMS, .cols = 1}, GL_STATIC_DRAW);
+        bench->gl_result = mygl_mat_buffer_data(&(MyMat){.rows = MY_ROOFLINE_GL_AXPBY_ITEMS, .cols = 1}, GL_DYNAMIC_COPY);
+        const double ms = my_roofline_time_ms(bench, my_roofline_gl_axpby, true, repeats);
+        my_roofline_add(roofline, "axpby", MY_ROOFLINE_DEVICE_GL, 3.0 * MY_ROOFLINE_GL_AXPBY_ITEMS, 3.0 * sizeof(GLfloat) * MY_ROOFLINE_GL_AXPBY_ITEMS, ms);
+        mygl_mat_delete(&bench->gl_first);
+        mygl_mat_delete(&bench->gl_second);
+        mygl_mat_delete(&bench->gl_result);
+        ASSERT_GL(glDeleteProgram(bench->shader_program));
+        ASSERT_GL(glDeleteShader(compute_shader));
+    }
+}
+
+static void my_roofline_report(const MyRoofline roofline[static 1]) {
+    my_range_for_zero(size_t, i, roofline->kernels_count) {
+        const MyRooflineKernel *const kernel = &roofline->kernels[i];
+        const MyRooflinePoint point = my_roofline_point(roofline, kernel);
+        LOG(
+            "kernel: %s, device: %s, ms: %lf, intensity: %lf flop/byte, gflop/s: %lf, gb/s: %lf, roof gflop/s: %lf, bound: %s, of roof: %.1lf%%",
+            kernel->name, my_roofline_device_names[kernel->device], kernel->ms, point.intensity, point.gflops, point.gbytes_per_s,
+            point.roof_gflops, point.compute_bound ? "compute" : "bandwidth", 100.0 * point.of_roof
+        );
+    }
+}
+
+// Log-log roofline of both devices, kernels without flops only appear in the table.
+static void my_roofline_plot(const MyRoofline roofline[static 1]) {
+    GLFWwindow* const glfw_window = my_glfw_init(true);
+    ImGuiContext *const ig_context = igCreateContext(NULL);
+    ImPlotContext *const implot_context = ImPlot_CreateContext();
+    ImGuiIO *const ig_io = igGetIO_Nil();
+    ig_io->IniFilename = NULL;
+    igStyleColorsDark(igGetStyle());
+    ImGui_ImplGlfw_InitForOpenGL(glfw_window, true);
+    ImGui_ImplOpenGL3_Init("#version 460");
+
+    double intensity_min = INFINITY, intensity_max = 0.0;
+    my_range_for_zero(size_t, i, roofline->kernels_count) {
+        const MyRooflineKernel *const kernel = &roofline->kernels[i];
+        if(kernel->flops > 0.0) {
+            intensity_min = fmin(intensity_min, kernel->flops / kernel->bytes);
+            intensity_max = fmax(intensity_max, kernel->flops / kernel->bytes);
+        }
+    }
+    my_range_for_zero(size_t, device, MY_ROOFLINE_DEVICE_COUNT) {
+        const MyRooflineCeilings *const ceilings = &roofline->ceilings[device];
+        intensity_max = fmax(intensity_max, ceilings->gflops / ceilings->gbytes_per_s);
+    }
+    intensity_min = fmin(intensity_min, 1.0) / 4.0;
+    intensity_max *= 4.0;
+
+    while(!glfwWindowShouldClose(glfw_window)) {
+        glfwWaitEventsTimeout(1.0 / 30.0);
+        ASSERT_GL(glClearColor(0, 0, 0, 1));
+        ASSERT_GL(glClear(GL_COLOR_BUFFER_BIT));
+        ImGui_ImplOpenGL3_NewFrame();
+        ImGui_ImplGlfw_NewFrame();
+        igNewFrame();
+        igSetNextWindowPos((ImVec2){0.f, 0.f}, ImGuiCond_Always, (ImVec2){0.f, 0.f});
+        igSetNextWindowSize(igGetMainViewport()->WorkSize, ImGuiCond_Always);
+        if(igBegin("roofline", NULL, ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoMove | ImGuiWindowFlags_NoCollapse)) {
+            if(ImPlot_BeginPlot("##roofline", (ImVec2){-1.f, igGetContentRegionAvail().y * 0.6f}, 0)) {
+                ImPlot_SetupAxes("intensity, flop/byte", "gflop/s", ImPlotAxisFlags_AutoFit, ImPlotAxisFlags_AutoFit);
+                ImPlot_SetupAxisScale_PlotScale(ImAxis_X1, ImPlotScale_Log10);
+                ImPlot_SetupAxisScale_PlotScale(ImAxis_Y1, ImPlotScale_Log10);
+                my_range_for_zero(size_t, device, MY_ROOFLINE_DEVICE_COUNT) {
+                    const MyRooflineCeilings *const ceilings = &roofline->ceilings[device];
+                    const double ridge = ceilings->gflops / ceilings->gbytes_per_s;
+                    const double xs[3] = {intensity_min, ridge, intensity_max};
+                    const double ys[3] = {intensity_min * ceilings->gbytes_per_s, ceilings->gflops, ceilings->gflops};
+                    char label[32];
+                    snprintf(label, sizeof(label), "%s roof", my_roofline_device_names[device]);
+                    ImPlot_PlotLine_doublePtrdoublePtr(label, xs, ys, 3, 0, 0, sizeof(double));
+                }
+                my_range_for_zero(size_t, i, roofline->kernels_count) {
+                    const MyRooflineKernel *const kernel = &roofline->kernels[i];
+                    if(kernel->flops > 0.0) {
+                        const MyRooflinePoint point = my_roofline_point(roofline, kernel);
+                        char label[64];
+                        snprintf(label, sizeof(label), "%s (%s)", kernel->name, my_roofline_device_names[kernel->device]);
+                        ImPlot_SetNextMarkerStyle(ImPlotMarker_Circle, 6.f, (ImVec4_c){0.f, 0.f, 0.f, -1.f}, -1.f, (ImVec4_c){0.f, 0.f, 0.f, -1.f});
+                        ImPlot_PlotScatter_doublePtrdoublePtr(label, &point.intensity, &point.gflops, 1, 0, 0, sizeof(double));
+                    }
+                }
+                ImPlot_EndPlot();
+            }
+            const char *const columns[] = {"kernel", "device", "ms", "flop/byte", "gflop/s", "gb/s", "roof gflop/s", "bound", "of roof"};
+            if(igBeginTable("kernels", (int)my_array_count(columns), ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg, (ImVec2){0.f, 0.f}, 0.f)) {
+                my_range_for_zero(size_t, column, my_array_count(columns)) {
+                    igTableSetupColumn(columns[column], 0, 0.f, 0);
+                }
+                igTableHeadersRow();
+                my_range_for_zero(size_t, i, roofline->kernels_count) {
+                    const MyRooflineKernel *const kernel = &roofline->kernels[i];
+                    const MyRooflinePoint point = my_roofline_point(roofline, kernel);
+                    igTableNextRow(0, 0.f);
+                    igTableNextColumn(); igText("%s", kernel->name);
+                    igTableNextColumn(); igText("%s", my_roofline_device_names[kernel->device]);
+                    igTableNextColumn(); igText("%.3lf", kernel->ms);
+                    igTableNextColumn(); igText("%.3lf", point.intensity);
+                    igTableNextColumn(); igText("%.2lf", point.gflops);
+                    igTableNextColumn(); igText("%.2lf", point.gbytes_per_s);
+                    igTableNextColumn(); igText("%.2lf", point.roof_gflops);
+                    igTableNextColumn(); igText("%s", point.compute_bound ? "compute" : "bandwidth");
+                    igTableNextColumn(); igText("%.1lf%%", 100.0 * point.of_roof);
+                }
+                igEndTable();
+            }
+        }
+        igEnd();
         igRender();
         ImGui_ImplOpenGL3_RenderDrawData(igGetDrawData());
         glfwSwapBuffers(glfw_window);
     }
 
-    ImGui_ImplOpenGL3_Shutdown();
-    ImGui_ImplGlfw_Shutdown();
-    ImPlot_DestroyContext(implot_context);
-    igDestroyContext(ig_context);
+    ImGui_ImplOpenGL3_Shutdown();
+    ImGui_ImplGlfw_Shutdown();
+    ImPlot_DestroyContext(implot_context);
+    igDestroyContext(ig_context);
+    glfwTerminate();
+}
+
+// Measures the ceilings of both devices, times every kernel against them and logs the table.
+static void my_roofline(const MyRooflineOptions options[static 1]) {
+    MyRoofline *const roofline = (MyRoofline*)calloc(1, sizeof(MyRoofline));
+    MyRooflineBench *const bench = (MyRooflineBench*)calloc(1, sizeof(MyRooflineBench));
+    ASSERT(roofline && bench);
+    bench->arena = my_arena_init(4 * MY_ROOFLINE_STREAM_ITEMS * sizeof(GLfloat));
+    my_roofline_measure_cpu(roofline, bench, options->repeats);
+    my_arena_free(&bench->arena);
+    MyGLContext gl_context = my_gl_context_create(options->device);
+    my_roofline_measure_gl(roofline, bench, options->repeats);
+    my_gl_context_destroy(&gl_context);
+    my_roofline_report(roofline);
+    if(options->plot) {
+        my_roofline_plot(roofline);
+    }
+    free(bench);
+    free(roofline);
+}
+
+#define MY_REGRESSION_RUNS_MAX 64
+#define MY_REGRESSION_FIELD_MAX 256
+// a slowdown must also exceed this many median absolute deviations of both sides to count
+#define MY_REGRESSION_NOISE_MADS 3.0
+
+typedef struct {
+    const char *store_path;
+    const char *baseline_commit;
+    const char *commit;
+    const char *device;
+    size_t runs;
+    size_t repeats;
+    double tolerance;
+    bool record;
+} MyRegressionOptions;
+
+typedef struct {
+    const char *name;
+    size_t rows;
+    size_t inner;
+    size_t cols;
+} MyRegressionShape;
+
+// Fixed so that results of different commits stay comparable, the last one is the forward pass of a degree 4 training run.
+static const MyRegressionShape my_regression_shapes[] = {
+    {"gemm", 1024, 1024, 16},
+    {"gemv", 2048, 2048, 1},
+    {"forward", 20210, 669, 1},
+};
+
+// Median and median absolute deviation of the per-run means.
+typedef struct {
+    double median_ms;
+    double mad_ms;
+    size_t runs;
+} MyRegressionResult;
+
+typedef enum {
+    MY_REGRESSION_NEW,
+    MY_REGRESSION_OK,
+    MY_REGRESSION_IMPROVED,
+    MY_REGRESSION_REGRESSED,
+    MY_REGRESSION_COUNT,
+} MyRegressionStatus;
+
+static const char *const my_regression_status_names[MY_REGRESSION_COUNT] = {
+    [MY_REGRESSION_NEW] = "new",
+    [MY_REGRESSION_OK] = "ok",
+    [MY_REGRESSION_IMPROVED] = "improved",
+    [MY_REGRESSION_REGRESSED] = "regressed",
+};
+
+typedef struct {
+    const MyRegressionShape *shape;
+    MyTrainBackend backend;
+    MyMat first;
+    MyMat second;
+    MyMat result;
+    GLuint shader_program;
+    MyGLMat gl_first;
+    MyGLMat gl_second;
+    MyGLMat gl_result;
+} MyRegressionBench;
+
+// Sorts `values` in place.
+static MyRegressionResult my_regression_result(double values[static 1], const size_t count) {
+    ASSERT(count > 0);
+    qsort(values, count, sizeof(double), my_double_compare);
+    const double median = count % 2 == 1 ? values[count / 2] : (values[count / 2 - 1] + values[count / 2]) / 2.0;
+    my_range_for_zero(size_t, i, count) {
+        values[i] = fabs(values[i] - median);
+    }
+    qsort(values, count, sizeof(double), my_double_compare);
+    const double mad = count % 2 == 1 ? values[count / 2] : (values[count / 2 - 1] + values[count / 2]) / 2.0;
+    return (MyRegressionResult){.median_ms = median, .mad_ms = mad, .runs = count};
+}
+
+// A change counts when it is beyond `tolerance` relative to the baseline and beyond the noise of both sides.
+static MyRegressionStatus my_regression_compare(const MyRegressionResult baseline[static 1], const MyRegressionResult current[static 1], const double tolerance) {
+    const double noise_ms = MY_REGRESSION_NOISE_MADS * (baseline->mad_ms + current->mad_ms);
+    const double change_ms = current->median_ms - baseline->median_ms;
+    if(change_ms > tolerance * baseline->median_ms && change_ms > noise_ms) {
+        return MY_REGRESSION_REGRESSED;
+    }
+    if(-change_ms > tolerance * baseline->median_ms && -change_ms > noise_ms) {
+        return MY_REGRESSION_IMPROVED;
+    }
+    return MY_REGRESSION_OK;
+}
+
+static void my_regression_call(MyRegressionBench bench[static 1]) {
+    if(bench->backend == MY_TRAIN_BACKEND_CPU) {
+        my_mat_mul(&bench->result, &bench->first, &bench->second);
+    } else {
+        my_gl_dispatch_compute_mat_mul(bench->shader_program, &bench->gl_first, &bench->gl_second, &bench->gl_result);
+    }
+}
+
+// `runs` means of `repeats` calls each, after one warm-up call. GL calls are timed up to glFinish.
+static MyRegressionResult my_regression_measure(MyRegressionBench bench[static 1], const size_t runs, const size_t repeats) {
+    const bool gl = bench->backend == MY_TRAIN_BACKEND_GL;
+    double means[MY_REGRESSION_RUNS_MAX];
+    my_regression_call(bench);
+    my_range_for_zero(size_t, run, runs) {
+        if(gl) {
+            ASSERT_GL(glFinish());
+        }
+        const double start_ms = my_time_ms();
+        my_range_for_zero(size_t, i, repeats) {
+            my_regression_call(bench);
+        }
+        if(gl) {
+            ASSERT_GL(glFinish());
+        }
+        means[run] = (my_time_ms() - start_ms) / (double)repeats;
+    }
+    return my_regression_result(means, runs);
+}
+
+// CPU model and thread count from /proc/cpuinfo and the GL_RENDERER of the current context.
+static void my_regression_machine(char machine[static MY_REGRESSION_FIELD_MAX]) {
+    char cpu_model[128] = "unknown cpu";
+    FILE *const cpuinfo = fopen("/proc/cpuinfo", "r");
+    if(cpuinfo) {
+        char line[256];
+        while(fgets(line, sizeof(line), cpuinfo)) {
+            const char *const colon = strchr(line, ':');
+            if(strncmp(line, "model name", strlen("model name")) == 0 && colon) {
+                snprintf(cpu_model, sizeof(cpu_model), "%s", colon + 2);
+                cpu_model[strcspn(cpu_model, "\n")] = '\0';
+                break;
+            }
+        }
+        ASSERT(fclose(cpuinfo) == 0);
+    }
+    const GLubyte *renderer;
+    ASSERT_GL(renderer = glGetString(GL_RENDERER));
+    snprintf(machine, MY_REGRESSION_FIELD_MAX, "%s x%zu, %s", cpu_model, my_thread_pool.threads_count, (const char*)renderer);
+    machine[strcspn(machine, "\t\n")] = '\0';
+}
+
+static void my_regression_commit(char commit[static MY_REGRESSION_FIELD_MAX]) {
+    snprintf(commit, MY_REGRESSION_FIELD_MAX, "unknown");
+    FILE *const git = popen("git rev-parse --short HEAD 2>/dev/null", "r");
+    if(git) {
+        char line[MY_REGRESSION_FIELD_MAX];
+        if(fgets(line, sizeof(line), git) && line[0] != '\n') {
+            line[strcspn(line, "\n")] = '\0';
+            snprintf(commit, MY_REGRESSION_FIELD_MAX, "%s", line);
+        }
+        pclose(git);
+    }
+}
+
+// The store holds one tab separated line per result: commit, machine, benchmark, median ms, mad ms, runs.
+// The baseline is the last line of `baseline_commit`, or of the last other commit when it is NULL.
+static bool my_regression_baseline(
+    const char store_path[static 1],
+    const char *const baseline_commit,
+    const char commit[static 1],
+    const char machine[static 1],
+    const char benchmark[static 1],
+    char found_commit[static MY_REGRESSION_FIELD_MAX],
+    MyRegressionResult baseline[static 1]
+) {
+    FILE *const store = fopen(store_path, "r");
+    if(!store) {
+        ASSERT(errno == ENOENT, "%s: %s", store_path, strerror(errno));
+        return false;
+    }
+    bool found = false;
+    char *line = NULL;
+    size_t line_capacity = 0;
+    while(getline(&line, &line_capacity, store) != -1) {
+        line[strcspn(line, "\n")] = '\0';
+        const char *fields[6];
+        size_t fields_count = 0;
+        for(char *field = line, *tab; fields_count < my_array_count(fields); field = tab + 1) {
+            fields[fields_count++] = field;
+            if(!(tab = strchr(field, '\t'))) {
+                break;
+            }
+            *tab = '\0';
+        }
+        if(fields_count < my_array_count(fields)) {
+            continue;
+        }
+        const bool commit_matches = baseline_commit ? strcmp(fields[0], baseline_commit) == 0 : strcmp(fields[0], commit) != 0;
+        if(commit_matches && strcmp(fields[1], machine) == 0 && strcmp(fields[2], benchmark) == 0) {
+            snprintf(found_commit, MY_REGRESSION_FIELD_MAX, "%s", fields[0]);
+            *baseline = (MyRegressionResult){.median_ms = strtod(fields[3], NULL), .mad_ms = strtod(fields[4], NULL), .runs = (size_t)strtoull(fields[5], NULL, 10)};
+            found = true;
+        }
+    }
+    free(line);
+    ASSERT(fclose(store) == 0);
+    return found;
+}
+
+// Runs every shape on both backends, compares each with its baseline and appends the results to the store.
+// False when any benchmark regressed.
+static bool my_regression(const MyRegressionOptions options[static 1]) {
+    MyGLContext gl_context = my_gl_context_create(options->device);
+    char machine[MY_REGRESSION_FIELD_MAX], commit[MY_REGRESSION_FIELD_MAX];
+    my_regression_machine(machine);
+    if(options->commit) {
+        snprintf(commit, sizeof(commit), "%s", options->commit);
+    } else {
+        my_regression_commit(commit);
+    }
+    LOG("commit: %s, machine: %s, runs: %zu, repeats: %zu, tolerance: %g", commit, machine, options->runs, options->repeats, options->tolerance);
+
+    size_t items_count = 0;
+    my_range_for_zero(size_t, i, my_array_count(my_regression_shapes)) {
+        const MyRegressionShape *const shape = &my_regression_shapes[i];
+        const size_t shape_items_count = shape->rows * shape->inner + shape->inner * shape->cols + shape->rows * shape->cols;
+        items_count = shape_items_count > items_count ? shape_items_count : items_count;
+    }
+    MyArena arena = my_arena_init(items_count * sizeof(GLfloat));
+    GLuint compute_shader;
+    MyRegressionBench bench = {0};
+    mygl_matrix_mul_create_program(&bench.shader_program, &compute_shader, MY_GL_MAT_FORMAT_F32, MY_PRECISION_F32);
+
+    FILE *store = NULL;
+    if(options->record) {
+        store = fopen(options->store_path, "a");
+        ASSERT(store, "%s: %s", options->store_path, strerror(errno));
+    }
+    size_t regressed_count = 0;
+    my_range_for_zero(size_t, i, my_array_count(my_regression_shapes)) {
+        const MyRegressionShape *const shape = &my_regression_shapes[i];
+        my_arena_reset(&arena);
+        bench.shape = shape;
+        bench.first = my_mat_alloc(&arena, shape->rows, shape->inner);
+        bench.second = my_mat_alloc(&arena, shape->inner, shape->cols);
+        bench.result = my_mat_alloc(&arena, shape->rows, shape->cols);
+        my_mat_foreach(el, &bench.first) {
+            *el = (GLfloat)(rand() % 2000) / 1000.f - 1.f;
+        }
+        my_mat_foreach(el, &bench.second) {
+            *el = (GLfloat)(rand() % 2000) / 1000.f - 1.f;
+        }
+        bench.gl_first = mygl_mat_buffer_data(&bench.first, GL_STATIC_DRAW);
+        bench.gl_second = mygl_mat_buffer_data(&bench.second, GL_STATIC_DRAW);
+        bench.gl_result = mygl_mat_buffer_data(&bench.result, GL_DYNAMIC_COPY);
+        my_range_for_zero(size_t, backend, MY_TRAIN_BACKEND_COUNT) {
+            bench.backend = (MyTrainBackend)backend;
+            char benchmark[MY_REGRESSION_FIELD_MAX];
+            snprintf(benchmark, sizeof(benchmark), "%s %zux%zux%zu %s", shape->name, shape->rows, shape->inner, shape->cols, my_train_backend_names[backend]);
+            const MyRegressionResult result = my_regression_measure(&bench, options->runs, options->repeats);
+
+            char baseline_commit[MY_REGRESSION_FIELD_MAX];
+            MyRegressionResult baseline;
+            MyRegressionStatus status = MY_REGRESSION_NEW;
+            if(my_regression_baseline(options->store_path, options->baseline_commit, commit, machine, benchmark, baseline_commit, &baseline)) {
+                status = my_regression_compare(&baseline, &result, options->tolerance);
+                LOG(
+                    "benchmark: %s, ms: %lf, mad ms: %lf, baseline: %s, baseline ms: %lf, baseline mad ms: %lf, change: %+.1lf%%, status: %s",
+                    benchmark, result.median_ms, result.mad_ms, baseline_commit, baseline.median_ms, baseline.mad_ms,
+                    100.0 * (result.median_ms / baseline.median_ms - 1.0), my_regression_status_names[status]
+                );
+            } else {
+                LOG("benchmark: %s, ms: %lf, mad ms: %lf, status: %s", benchmark, result.median_ms, result.mad_ms, my_regression_status_names[status]);
+            }
+            regressed_count += status == MY_REGRESSION_REGRESSED;
+            if(store) {
+                fprintf(store, "%s\t%s\t%s\t%.6lf\t%.6lf\t%zu\n", commit, machine, benchmark, result.median_ms, result.mad_ms, result.runs);
+            }
+        }
+        mygl_mat_delete(&bench.gl_first);
+        mygl_mat_delete(&bench.gl_second);
+        mygl_mat_delete(&bench.gl_result);
+    }
+    if(store) {
+        ASSERT(fclose(store) == 0);
+    }
+    ASSERT_GL(glDeleteProgram(bench.shader_program));
+    ASSERT_GL(glDeleteShader(compute_shader));
+    my_arena_free(&arena);
+    my_gl_context_destroy(&gl_context);
+    LOG("regressed: %zu", regressed_count);
+    return regressed_count == 0;
+}
+
+static void test_matrix_multiplication(void) {
+    MyGLContext gl_context = my_gl_context_create(NULL);
+    MyArena arena = my_arena_init(1024 * 1024 * 500);
+
+    MyMat first_mat = my_mat_alloc(&arena, 10000, 10000);
+    MyMat second_mat = my_mat_alloc(&arena, first_mat.cols, 1);
+    MyMat third_mat = my_mat_alloc(&arena, first_mat.rows, second_mat.cols);
+    my_mat_foreach(el, &first_mat) {
+        *el = rand() % 100;
+    }
+    my_mat_foreach(el, &second_mat) {
+        *el = rand() % 1000;
+    }
+    my_mat_foreach(el, &third_mat) {
+        *el = NAN;
+    }
+
+    MyGLMat first_mat_gl = {.rows = (GLuint)first_mat.rows, .cols = (GLuint)first_mat.cols};
+    MyGLMat second_mat_gl = {.rows = (GLuint)second_mat.rows, .cols = (GLuint)second_mat.cols};
+    MyGLMat third_mat_gl = {.rows = (GLuint)third_mat.rows, .cols = (GLuint)third_mat.cols};
+
+    GLuint buffers[3];
+    ASSERT_GL(glGenBuffers(3, buffers));
+    first_mat_gl.ssb = buffers[0];
+    second_mat_gl.ssb = buffers[1];
+    third_mat_gl.ssb = buffers[2];
+
+    ASSERT_GL(glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffers[0]));
+        ASSERT_GL(glBufferData(GL_SHADER_STORAGE_BUFFER, (GLsizeiptr)my_mat_bytes_count(&first_mat), first_mat.items, GL_DYNAMIC_DRAW));
+    ASSERT_GL(glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0));
+
+    ASSERT_GL(glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffers[1]));
+        ASSERT_GL(glBufferData(GL_SHADER_STORAGE_BUFFER, (GLsizeiptr)my_mat_bytes_count(&second_mat), second_mat.items, GL_DYNAMIC_DRAW));
+    ASSERT_GL(glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0));
+
+    ASSERT_GL(glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffers[2]));
+        ASSERT_GL(glBufferData(GL_SHADER_STORAGE_BUFFER, (GLsizeiptr)my_mat_bytes_count(&third_mat), NULL, GL_DYNAMIC_DRAW));
+    ASSERT_GL(glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0));
+
+    GLuint shader_program, compute_shader;
+    mygl_matrix_mul_create_program(&shader_program, &compute_shader, MY_GL_MAT_FORMAT_F32, MY_PRECISION_F32);
+
+    clock_t start = clock();
+        my_gl_dispatch_compute_mat_mul(shader_program, &first_mat_gl, &second_mat_gl, &third_mat_gl);
+    clock_t end = clock();
+    const double opengl_elapsed_time = (((double)(end - start)) / CLOCKS_PER_SEC) * 1000;
+    LOG("opengl_elapsed_time ms: %lf", opengl_elapsed_time);
+    start = clock();
+        my_mat_mul(&third_mat, &first_mat, &second_mat);
+    end = clock();
+    const double cpu_elapsed_time = (((double)(end - start)) / CLOCKS_PER_SEC) * 1000;
+    LOG("cpu_elapsed_time ms: %lf", cpu_elapsed_time);
+    LOG("cpu_elapsed_time / opengl_elapsed_time: %lf", cpu_elapsed_time / opengl_elapsed_time);
+    {
+        ASSERT_GL(glBindBuffer(GL_SHADER_STORAGE_BUFFER, third_mat_gl.ssb));
+            GLfloat *data; 
+            ASSERT_GL(data = (GLfloat*)glMapBufferRange(GL_SHADER_STORAGE_BUFFER, 0, (GLsizeiptr)my_mat_bytes_count(&third_mat), GL_MAP_READ_BIT));
+            my_range_for_zero(size_t, i, my_mat_items_count(&third_mat)) {
+                // LOG("opengl: %lf, cpu: %lf", (double)data[i], (double)third_mat.items[i]);
+                ASSERT(fabsf(data[i] - third_mat.items[i]) < 0.0001f);
+            }
+            ASSERT_GL(glUnmapBuffer(GL_SHADER_STORAGE_BUFFER));
+
+        ASSERT_GL(glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0));
+    } 
+    
+    ASSERT_GL(glDeleteShader(compute_shader));
+    ASSERT_GL(glDeleteProgram(shader_program));
+    ASSERT_GL(glDeleteBuffers(my_array_count(buffers), buffers));
+    my_arena_free(&arena);
+
+    my_gl_context_destroy(&gl_context);
+}
+
+static void test_gl_reduce(void) {
+    MyGLContext gl_context = my_gl_context_create(NULL);
+    MyArena arena = my_arena_init(1024 * 1024 * 8);
+
+    MyMat mat = my_mat_alloc(&arena, 5000, 37);
+    MyMat vec = my_mat_alloc(&arena, mat.rows, 1);
+    my_mat_foreach(el, &mat) {
+        *el = (GLfloat)(rand() % 1000) / 100.f - 5.f;
+    }
+    my_mat_foreach(el, &vec) {
+        *el = (GLfloat)(rand() % 1000) / 100.f - 5.f;
+    }
+    const MyGLMat mat_gl = mygl_mat_buffer_data(&mat, GL_STATIC_DRAW);
+    const MyGLMat vec_gl = mygl_mat_buffer_data(&vec, GL_STATIC_DRAW);
+    const MyGLMat col_stats_gl = mygl_mat_buffer_data(&(MyMat){.rows = mat.cols, .cols = MY_GL_STATS_FIELDS_COUNT}, GL_DYNAMIC_COPY);
+
+    MyGLReduce reduce = mygl_reduce_create(4);
+    const MyGLReduceView cols_view = mygl_reduce_view_cols(&mat_gl);
+    const MyGLReduceView all_view = mygl_reduce_view_all(&mat_gl);
+    const MyGLReduceView row_view = mygl_reduce_view_rows(&mat_gl);
+    const MyGLReduceView vec_view = mygl_reduce_view_all(&vec_gl);
+    const MyGLReduceView vec_broadcast_view = mygl_reduce_view_broadcast(&vec_gl);
+    mygl_reduce(&reduce, MY_GL_REDUCE_PRODUCT, &cols_view, &vec_broadcast_view, col_stats_gl.ssb, 0);
+    const GLuint all_slot = mygl_reduce_scalar(&reduce, MY_GL_REDUCE_VALUE, &all_view, NULL);
+    const GLuint mse_slot = mygl_reduce_scalar(&reduce, MY_GL_REDUCE_SQUARED_DIFF, &(MyGLReduceView){.ssb = mat_gl.ssb, .line_count = 1, .line_length = mat_gl.rows, .elem_stride = mat_gl.cols}, &vec_view);
+    const MyGLStats *const scalars = mygl_reduce_scalars_wait(&reduce);
+
+    #define ASSERT_CLOSE(actual, expected) ASSERT(fabs((double)(actual) - (expected)) <= 1e-3 * fmax(1.0, fabs(expected)), "%lf != %lf", (double)(actual), (expected))
+        {
+            double sum = 0.0, minimum = INFINITY, maximum = -INFINITY;
+            my_mat_foreach(el, &mat) {
+                sum += (double)*el;
+                minimum = fmin(minimum, (double)*el);
+                maximum = fmax(maximum, (double)*el);
+            }
+            const double mean = sum / (double)my_mat_items_count(&mat);
+            double m2 = 0.0;
+            my_mat_foreach(el, &mat) {
+                m2 += my_pow((double)*el - mean, 2);
+            }
+            ASSERT_CLOSE(scalars[all_slot].sum, sum);
+            ASSERT_CLOSE(scalars[all_slot].minimum, minimum);
+            ASSERT_CLOSE(scalars[all_slot].maximum, maximum);
+            ASSERT_CLOSE(scalars[all_slot].mean, mean);
+            ASSERT_CLOSE(scalars[all_slot].m2, m2);
+            ASSERT_CLOSE(scalars[all_slot].count, (double)my_mat_items_count(&mat));
+        }
+        {
+            double sum = 0.0;
+            my_range_for_zero(size_t, row, mat.rows) {
+                sum += my_pow((double)my_mat_item(&mat, row, 0) - (double)my_mat_item(&vec, row, 0), 2);
+            }
+            ASSERT_CLOSE(scalars[mse_slot].sum, sum);
+        }
+        {
+            ASSERT_GL(glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT));
+            MyGLStats col_stats[37];
+            ASSERT(my_array_count(col_stats) == mat.cols);
+            mygl_buffer_read(col_stats_gl.ssb, 0, sizeof(col_stats), col_stats);
+            my_range_for_zero(size_t, col, mat.cols) {
+                double sum = 0.0;
+                my_range_for_zero(size_t, row, mat.rows) {
+                    sum += (double)my_mat_item(&mat, row, col) * (double)my_mat_item(&vec, row, 0);
+                }
+                ASSERT_CLOSE(col_stats[col].sum, sum);
+                ASSERT_CLOSE(col_stats[col].count, (double)mat.rows);
+            }
+        }
+        {
+            const MyGLMat row_stats_gl = mygl_mat_buffer_data(&(MyMat){.rows = mat.rows, .cols = MY_GL_STATS_FIELDS_COUNT}, GL_DYNAMIC_COPY);
+            mygl_reduce(&reduce, MY_GL_REDUCE_SQUARE, &row_view, NULL, row_stats_gl.ssb, 0);
+            ASSERT_GL(glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT));
+            MyGLStats row_stats;
+            const size_t row = 4321;
+            mygl_buffer_read(row_stats_gl.ssb, (GLintptr)(row * sizeof(row_stats)), sizeof(row_stats), &row_stats);
+            double sum = 0.0;
+            my_range_for_zero(size_t, col, mat.cols) {
+                sum += my_pow((double)my_mat_item(&mat, row, col), 2);
+            }
+            ASSERT_CLOSE(row_stats.sum, sum);
+            mygl_mat_delete(&row_stats_gl);
+        }
+        {
+            GLuint shader_program, compute_shader;
+            mygl_create_compute_shader_program_with_header(&shader_program, &compute_shader, "", mygl_standard_scale_compute_shader);
+            mygl_mat_standard_scale(&reduce, shader_program, &mat_gl, 1, &col_stats_gl);
+            ASSERT_GL(glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT));
+            MyMat scaled = my_mat_alloc(&arena, mat.rows, mat.cols);
+            mygl_buffer_read(mat_gl.ssb, 0, (GLsizeiptr)my_mat_bytes_count(&scaled), scaled.items);
+            my_mat_polynomial_features_standard_scale(&mat, NULL);
+            my_range_for_zero(size_t, row, mat.rows) {
+                my_range_for(size_t, col, 1, mat.cols) {
+                    ASSERT_CLOSE(my_mat_item(&scaled, row, col), (double)my_mat_item(&mat, row, col));
+                }
+            }
+            ASSERT_GL(glDeleteShader(compute_shader));
+            ASSERT_GL(glDeleteProgram(shader_program));
+        }
+    #undef ASSERT_CLOSE
+
+    mygl_reduce_destroy(&reduce);
+    mygl_mat_delete(&mat_gl);
+    mygl_mat_delete(&vec_gl);
+    mygl_mat_delete(&col_stats_gl);
+    my_arena_free(&arena);
+
+    my_gl_context_destroy(&gl_context);
+}
+
+static void test_gl_mat_formats(void) {
+    ASSERT(my_f32_to_f16(1.f) == 0x3c00);
+    ASSERT(my_f32_to_f16(-2.f) == 0xc000);
+    ASSERT(my_f32_to_f16(65504.f) == 0x7bff);
+    ASSERT(my_f32_to_f16(65520.f) == 0x7c00);
+    ASSERT(my_f32_to_f16(5.9604645e-8f) == 0x0001);
+    ASSERT(my_f32_to_f16(1e-9f) == 0x0000);
+    ASSERT(my_f32_to_f16(1.f + 1.f / 2048.f) == 0x3c00);
+    ASSERT(my_f32_to_f16(1.f + 3.f / 2048.f) == 0x3c02);
+    ASSERT(my_f32_to_bf16(1.f) == 0x3f80);
+    ASSERT(my_f32_to_bf16(-3.f) == 0xc040);
+    ASSERT(my_f32_to_bf16(1.f + 1.f / 256.f) == 0x3f80);
+    ASSERT(my_f32_to_bf16(1.f + 3.f / 256.f) == 0x3f82);
+
+    MyGLContext gl_context = my_gl_context_create(NULL);
+    MyArena arena = my_arena_init(1024 * 1024);
+    MyMat mat = my_mat_alloc(&arena, 301, 7);
+    my_mat_foreach(el, &mat) {
+        *el = (GLfloat)(rand() % 2000) / 100.f - 10.f;
+    }
+    MyGLReduce reduce = mygl_reduce_create(MY_GL_MAT_FORMAT_COUNT);
+    GLuint slots[MY_GL_MAT_FORMAT_COUNT];
+    MyGLMat gl_mats[MY_GL_MAT_FORMAT_COUNT];
+    my_range_for_zero(size_t, format, MY_GL_MAT_FORMAT_COUNT) {
+        gl_mats[format] = mygl_mat_buffer_data_format(&mat, (MyGLMatFormat)format, GL_STATIC_DRAW);
+        const MyGLReduceView view = mygl_reduce_view_col(&gl_mats[format], 3);
+        slots[format] = mygl_reduce_scalar(&reduce, MY_GL_REDUCE_SQUARE, &view, NULL);
+    }
+    const MyGLStats *const scalars = mygl_reduce_scalars_wait(&reduce);
+    my_range_for_zero(size_t, format, MY_GL_MAT_FORMAT_COUNT) {
+        double expected = 0.0;
+        my_range_for_zero(size_t, row, mat.rows) {
+            expected += my_pow((double)my_mat_item(&mat, row, 3), 2);
+        }
+        const double tolerance = format == MY_GL_MAT_FORMAT_F32 ? 1e-4 : format == MY_GL_MAT_FORMAT_F16 ? 1e-3 : 1e-2;
+        ASSERT(fabs((double)scalars[slots[format]].sum - expected) <= tolerance * expected, "%s: %lf != %lf", my_gl_mat_format_names[format], (double)scalars[slots[format]].sum, expected);
+        mygl_mat_delete(&gl_mats[format]);
+    }
+    mygl_reduce_destroy(&reduce);
+    my_arena_free(&arena);
+
+    my_gl_context_destroy(&gl_context);
+}
+
+static void test_hstack(void) {
+    MyArena arena = my_arena_init(1024);
+    MyMat first = my_mat_alloc(&arena, 4, 4);
+    MyMat second = my_mat_alloc(&arena, 4, 3);
+
+    my_mat_item(&first, 0, 0) = 1;
+    my_mat_item(&first, 0, 1) = 1;
+    my_mat_item(&first, 0, 2) = 1;
+    my_mat_item(&first, 0, 3) = 1;
+
+    my_mat_item(&first, 1, 0) = 2;
+    my_mat_item(&first, 1, 1) = 2;
+    my_mat_item(&first, 1, 2) = 2;
+    my_mat_item(&first, 1, 3) = 2;
+
+    my_mat_item(&first, 2, 0) = 3;
+    my_mat_item(&first, 2, 1) = 3;
+    my_mat_item(&first, 2, 2) = 3;
+    my_mat_item(&first, 2, 3) = 3;
+
+    my_mat_item(&first, 3, 0) = 4;
+    my_mat_item(&first, 3, 1) = 4;
+    my_mat_item(&first, 3, 2) = 4;
+    my_mat_item(&first, 3, 3) = 4;
+
+    my_mat_item(&second, 0, 0) = 5;
+    my_mat_item(&second, 0, 1) = 5;
+    my_mat_item(&second, 0, 2) = 5;
+
+    my_mat_item(&second, 1, 0) = 6;
+    my_mat_item(&second, 1, 1) = 6;
+    my_mat_item(&second, 1, 2) = 6;
+
+    my_mat_item(&second, 2, 0) = 7;
+    my_mat_item(&second, 2, 1) = 7;
+    my_mat_item(&second, 2, 2) = 7;
+
+    my_mat_item(&second, 3, 0) = 8;
+    my_mat_item(&second, 3, 1) = 8;
+    my_mat_item(&second, 3, 2) = 8;
+
+    const MyMat result = my_mat_hstack(&arena, &first, &second);
+    #define ASSERT_MAT_VALUE(row, col, expected_value) ASSERT(fabsf(my_mat_item(&result, (row), (col)) - (expected_value)) < 0.0000000001f)
+        ASSERT_MAT_VALUE(0, 0, 1);
+        ASSERT_MAT_VALUE(0, 1, 1);
+        ASSERT_MAT_VALUE(0, 2, 1);
+        ASSERT_MAT_VALUE(0, 3, 1);
+        ASSERT_MAT_VALUE(0, 4, 5);
+        ASSERT_MAT_VALUE(0, 5, 5);
+        ASSERT_MAT_VALUE(0, 6, 5);
+
+        ASSERT_MAT_VALUE(1, 0, 2);
+        ASSERT_MAT_VALUE(1, 1, 2);
+        ASSERT_MAT_VALUE(1, 2, 2);
+        ASSERT_MAT_VALUE(1, 3, 2);
+        ASSERT_MAT_VALUE(1, 4, 6);
+        ASSERT_MAT_VALUE(1, 5, 6);
+        ASSERT_MAT_VALUE(1, 6, 6);
+
+        ASSERT_MAT_VALUE(2, 0, 3);
+        ASSERT_MAT_VALUE(2, 1, 3);
+        ASSERT_MAT_VALUE(2, 2, 3);
+        ASSERT_MAT_VALUE(2, 3, 3);
+        ASSERT_MAT_VALUE(2, 4, 7);
+        ASSERT_MAT_VALUE(2, 5, 7);
+        ASSERT_MAT_VALUE(2, 6, 7);
+
+        ASSERT_MAT_VALUE(3, 0, 4);
+        ASSERT_MAT_VALUE(3, 1, 4);
+        ASSERT_MAT_VALUE(3, 2, 4);
+        ASSERT_MAT_VALUE(3, 3, 4);
+        ASSERT_MAT_VALUE(3, 4, 8);
+        ASSERT_MAT_VALUE(3, 5, 8);
+        ASSERT_MAT_VALUE(3, 6, 8);
+
+    #undef ASSERT_MAT_VALUE
+
+    my_arena_free(&arena);
+}
+
+static void test_gl_minibatch(void) {
+    MyGLContext gl_context = my_gl_context_create(NULL);
+    GLuint shader_programs[MY_MINIBATCH_STAGE_COUNT], shader_computes[MY_MINIBATCH_STAGE_COUNT];
+    mygl_minibatch_create_programs(shader_programs, shader_computes, MY_GL_MAT_FORMAT_F32, MY_PRECISION_F32, MY_OPTIMIZER_ADAM);
+
+    MyArena arena = my_arena_init(1024 * 1024);
+    MyMat xb = my_mat_alloc(&arena, 300, 13);
+    MyMat y = my_mat_alloc(&arena, xb.rows, 1);
+    MyMat weights = my_mat_alloc(&arena, xb.cols, 1);
+    my_mat_foreach(el, &xb) {
+        *el = (GLfloat)(rand() % 200 - 100) / 100.f;
+    }
+    my_mat_foreach(el, &y) {
+        *el = (GLfloat)(rand() % 200 - 100) / 10.f;
+    }
+    my_mat_foreach(el, &weights) {
+        *el = (GLfloat)(rand() % 200 - 100) / 100.f;
+    }
+    const MyGLMat gl_xb = mygl_mat_buffer_data(&xb, GL_STATIC_DRAW);
+    const MyGLMat gl_y = mygl_mat_buffer_data(&y, GL_STATIC_DRAW);
+    const MyGLMat gl_weights = mygl_mat_buffer_data(&weights, GL_DYNAMIC_COPY);
+    const MyGLMat gl_indices = mygl_mat_buffer_data(&(MyMat){.rows = xb.rows, .cols = 1}, GL_DYNAMIC_COPY);
+    const MyGLMat gl_residuals = mygl_mat_buffer_data(&(MyMat){.rows = xb.rows, .cols = 1}, GL_DYNAMIC_COPY);
+    MyMat state = my_mat_alloc(&arena, 2, xb.cols);
+    memset(state.items, 0, my_mat_bytes_count(&state));
+    const MyGLMat gl_state = mygl_mat_buffer_data(&state, GL_DYNAMIC_COPY);
+
+    my_gl_dispatch_compute_shuffle(shader_programs[MY_MINIBATCH_STAGE_SHUFFLE], gl_indices.ssb, gl_indices.rows, 12345u);
+    ASSERT_GL(glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT));
+    GLuint indices[300];
+    mygl_buffer_read(gl_indices.ssb, 0, sizeof(indices), indices);
+    bool visited[300] = {false};
+    size_t fixed_points = 0;
+    my_range_for_zero(size_t, i, xb.rows) {
+        ASSERT(indices[i] < xb.rows && !visited[indices[i]], "index %zu is %u", i, indices[i]);
+        visited[indices[i]] = true;
+        fixed_points += indices[i] == i ? 1 : 0;
+    }
+    ASSERT(fixed_points < xb.rows / 10);
+
+    const GLuint batch_offset = 37, batch_size = 50, cols = 11;
+    const GLfloat learning_rate = 0.01f, l2 = 0.1f;
+    const size_t step = 3;
+    my_gl_dispatch_compute_minibatch_forward(shader_programs[MY_MINIBATCH_STAGE_FORWARD], &gl_xb, &gl_y, gl_indices.ssb, batch_offset, batch_size, gl_weights.ssb, cols, gl_residuals.ssb);
+    ASSERT_GL(glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT));
+    my_gl_dispatch_compute_minibatch_update(
+        shader_programs[MY_MINIBATCH_STAGE_UPDATE], MY_OPTIMIZER_ADAM, &gl_xb, gl_indices.ssb, batch_offset, batch_size,
+        gl_residuals.ssb, gl_weights.ssb, gl_state.ssb, cols, learning_rate, l2, step
+    );
+    ASSERT_GL(glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT));
+    GLfloat updated[13];
+    mygl_buffer_read(gl_weights.ssb, 0, sizeof(updated), updated);
+
+    double residuals[50];
+    my_range_for_zero(size_t, k, batch_size) {
+        const size_t row = indices[batch_offset + k];
+        residuals[k] = -(double)my_mat_item(&y, row, 0);
+        my_range_for_zero(size_t, col, cols) {
+            residuals[k] += (double)my_mat_item(&xb, row, col) * (double)weights.items[col];
+        }
+    }
+    const double beta1 = (double)my_optimizer_betas[MY_OPTIMIZER_ADAM][0], beta2 = (double)my_optimizer_betas[MY_OPTIMIZER_ADAM][1];
+    my_range_for_zero(size_t, col, xb.cols) {
+        double expected = (double)weights.items[col];
+        if(col < cols) {
+            double gradient = col > 0 ? 2.0 * (double)l2 * expected : 0.0;
+            my_range_for_zero(size_t, k, batch_size) {
+                gradient += 2.0 / batch_size * residuals[k] * (double)my_mat_item(&xb, indices[batch_offset + k], col);
+            }
+            const double m = (1.0 - beta1) * gradient / (1.0 - pow(beta1, (double)step));
+            const double v = (1.0 - beta2) * gradient * gradient / (1.0 - pow(beta2, (double)step));
+            expected -= (double)learning_rate * m / (sqrt(v) + (double)MY_OPTIMIZER_EPSILON);
+        }
+        ASSERT(fabs((double)updated[col] - expected) < 1e-5, "col %zu: %f != %lf", col, (double)updated[col], expected);
+    }
+
+    mygl_mat_delete(&gl_xb);
+    mygl_mat_delete(&gl_y);
+    mygl_mat_delete(&gl_weights);
+    mygl_mat_delete(&gl_indices);
+    mygl_mat_delete(&gl_residuals);
+    mygl_mat_delete(&gl_state);
+    my_range_for_zero(size_t, stage, MY_MINIBATCH_STAGE_COUNT) {
+        ASSERT_GL(glDeleteShader(shader_computes[stage]));
+        ASSERT_GL(glDeleteProgram(shader_programs[stage]));
+    }
+    my_arena_free(&arena);
+    my_gl_context_destroy(&gl_context);
+}
+
+// Both solvers against the normal equations solved by Gaussian elimination on the CPU.
+static void test_gl_solvers(void) {
+    MyGLContext gl_context = my_gl_context_create(NULL);
+    MyArena arena = my_arena_init(1024 * 1024);
+    MyMat xb = my_mat_alloc(&arena, 200, 9);
+    MyMat y = my_mat_alloc(&arena, xb.rows, 1);
+    my_range_for_zero(size_t, row, xb.rows) {
+        my_mat_item(&xb, row, 0) = 1.f;
+        my_range_for(size_t, col, 1, xb.cols) {
+            my_mat_item(&xb, row, col) = (GLfloat)(rand() % 200 - 100) / 100.f;
+        }
+        my_mat_item(&y, row, 0) = 0.5f + 2.f * my_mat_item(&xb, row, 1) - my_mat_item(&xb, row, 4) + (GLfloat)(rand() % 100) / 1000.f;
+    }
+    const GLfloat l2 = 0.05f;
+    // the job uses the first 7 columns
+    const size_t cols = 7;
+    double normal[7][8];
+    my_range_for_zero(size_t, i, cols) {
+        my_range_for_zero(size_t, j, cols) {
+            normal[i][j] = i == j && i > 0 ? (double)l2 * (double)xb.rows : 0.0;
+            my_range_for_zero(size_t, row, xb.rows) {
+                normal[i][j] += (double)my_mat_item(&xb, row, i) * (double)my_mat_item(&xb, row, j);
+            }
+        }
+        normal[i][cols] = 0.0;
+        my_range_for_zero(size_t, row, xb.rows) {
+            normal[i][cols] += (double)my_mat_item(&xb, row, i) * (double)my_mat_item(&y, row, 0);
+        }
+    }
+    my_range_for_zero(size_t, pivot, cols) {
+        my_range_for(size_t, i, pivot + 1, cols) {
+            const double factor = normal[i][pivot] / normal[pivot][pivot];
+            my_range_for(size_t, j, pivot, cols + 1) {
+                normal[i][j] -= factor * normal[pivot][j];
+            }
+        }
+    }
+    double expected[7];
+    for(size_t i = cols; i-- > 0;) {
+        expected[i] = normal[i][cols];
+        my_range_for(size_t, j, i + 1, cols) {
+            expected[i] -= normal[i][j] * expected[j];
+        }
+        expected[i] /= normal[i][i];
+    }
+
+    MyTrainOptions options = {.epochs = 100, .tolerance = 1e-5f};
+    MyTrainDevice device = {.options = &options, .gl_xb = mygl_mat_buffer_data(&xb, GL_STATIC_DRAW), .gl_y = mygl_mat_buffer_data(&y, GL_STATIC_DRAW)};
+    mygl_matrix_mul_create_program(&device.shader_program_mul_mat, &device.compute_shader_mul_mat, MY_GL_MAT_FORMAT_F32, MY_PRECISION_F32);
+    mygl_create_compute_shader_program_with_header(&device.shader_program_axpby, &device.compute_shader_axpby, "", mygl_axpby_compute_shader);
+    MyGLReduce reduce = mygl_reduce_create(4);
+    my_range_for(size_t, solver, MY_SOLVER_CG, MY_SOLVER_LBFGS + 1) {
+        MyTrainJob job = my_train_job_create(&(MyTrainJob){.degree = 2, .l2 = l2}, 3, &device.gl_xb, 0);
+        ASSERT(job.cols == cols);
+        const MySolveResult result = solver == MY_SOLVER_CG ? my_train_job_solve_cg(&device, &job, &reduce) : my_train_job_solve_lbfgs(&device, &job, &reduce);
+        ASSERT(result.converged, "%s: %zu iterations, gradient norm %lf", my_solver_names[solver], result.iterations, result.gradient_norm);
+        GLfloat weights[9];
+        mygl_buffer_read(job.weights.ssb, 0, sizeof(weights), weights);
+        my_range_for_zero(size_t, col, xb.cols) {
+            const double value = col < cols ? expected[col] : 0.0;
+            ASSERT(fabs((double)weights[col] - value) < 1e-3, "%s: col %zu: %f != %lf", my_solver_names[solver], col, (double)weights[col], value);
+        }
+        my_train_job_destroy(&job);
+    }
+    mygl_reduce_destroy(&reduce);
+    ASSERT_GL(glDeleteShader(device.compute_shader_axpby));
+    ASSERT_GL(glDeleteProgram(device.shader_program_axpby));
+    ASSERT_GL(glDeleteShader(device.compute_shader_mul_mat));
+    ASSERT_GL(glDeleteProgram(device.shader_program_mul_mat));
+    mygl_mat_delete(&device.gl_xb);
+    mygl_mat_delete(&device.gl_y);
+    my_arena_free(&arena);
+    my_gl_context_destroy(&gl_context);
+}
+
+static void test_upload_pipeline(void) {
+    MyGLContext gl_context = my_gl_context_create(NULL);
+    MyArena arena = my_arena_init(1024 * 1024 * 4);
+    const size_t degree = 3;
+    MyMat features = my_mat_alloc(&arena, 203, 5);
+    my_mat_foreach(el, &features) {
+        *el = (GLfloat)(rand() % 2000) / 1000.f - 1.f;
+    }
+
+    MyMat scaler = my_mat_alloc(&arena, 2, features.cols * degree);
+    MyMat expected_scaler = my_mat_alloc(&arena, 2, features.cols * degree);
+    my_polynomial_scaler_fit(&features, degree, &scaler);
+    my_polynomial_design_matrix(&arena, &features, degree, &expected_scaler, true);
+    my_range_for_zero(size_t, i, my_mat_items_count(&scaler)) {
+        ASSERT(fabsf(scaler.items[i] - expected_scaler.items[i]) <= 1e-5f * fmaxf(1.f, fabsf(expected_scaler.items[i])));
+    }
+    const MyMat xb = my_polynomial_design_matrix(&arena, &features, degree, &scaler, false);
+
+    my_range_for_zero(size_t, format, MY_GL_MAT_FORMAT_COUNT) {
+        const size_t bytes_count = my_gl_mat_format_bytes_count(format, my_mat_items_count(&xb));
+        void *const expected = my_arena_alloc(&arena, bytes_count);
+        void *const actual = my_arena_alloc(&arena, bytes_count);
+        my_gl_mat_format_pack((MyGLMatFormat)format, xb.items, my_mat_items_count(&xb), expected);
+
+        const size_t block_rows[] = {1, 17, 64, xb.rows};
+        my_range_for_zero(size_t, i, my_array_count(block_rows)) {
+            MyUploadPipeline upload;
+            my_upload_pipeline_start(&upload, &features, degree, &scaler, (MyGLMatFormat)format, block_rows[i]);
+            GLuint row_first, row_end, rows_uploaded = 0;
+            while(my_upload_pipeline_next(&upload, &row_first, &row_end)) {
+                ASSERT(row_first == rows_uploaded && row_end > row_first);
+                rows_uploaded = row_end;
+            }
+            my_upload_pipeline_finish(&upload);
+            ASSERT(rows_uploaded == xb.rows && upload.gl_mat.cols == xb.cols);
+
+            mygl_buffer_read(upload.gl_mat.ssb, 0, (GLsizeiptr)bytes_count, actual);
+            ASSERT(memcmp(expected, actual, bytes_count) == 0, "%s, block rows: %zu", my_gl_mat_format_names[format], block_rows[i]);
+            mygl_mat_delete(&upload.gl_mat);
+        }
+    }
+    my_arena_free(&arena);
+
+    my_gl_context_destroy(&gl_context);
+}
+
+typedef struct {
+    size_t *visits;
+    size_t nested_count;
+} MyThreadPoolTestTask;
+
+static void test_thread_pool_nested(void *const context, const size_t first, const size_t end) {
+    MyThreadPoolTestTask *const task = (MyThreadPoolTestTask*)context;
+    task->nested_count += end - first;
+}
+
+static void test_thread_pool_visit(void *const context, const size_t first, const size_t end) {
+    MyThreadPoolTestTask *const task = (MyThreadPoolTestTask*)context;
+    my_range_for(size_t, i, first, end) {
+        // uneven work so idle workers have something to steal
+        volatile double sink = 0.0;
+        my_range_for_zero(size_t, j, i % 97 * 50) {
+            sink += (double)j;
+        }
+        task->visits[i]++;
+        MyThreadPoolTestTask nested = {0};
+        my_parallel_for("test_thread_pool_nested", 10, 3, test_thread_pool_nested, &nested);
+        ASSERT(nested.nested_count == 10);
+    }
+}
+
+static double test_thread_pool_sum(void *const context, const size_t first, const size_t end) {
+    double sum = 0.0;
+    my_range_for(size_t, i, first, end) {
+        sum += 1.0 / (double)(i + 1);
+    }
+    return sum;
+}
+
+static void test_thread_pool(void) {
+    const size_t count = 100003;
+    MyThreadPoolTestTask task = {.visits = (size_t*)calloc(count, sizeof(size_t))};
+    ASSERT(task.visits);
+    my_parallel_for("test_thread_pool_visit", count, 7, test_thread_pool_visit, &task);
+    my_range_for_zero(size_t, i, count) {
+        ASSERT(task.visits[i] == 1, "index %zu visited %zu times", i, task.visits[i]);
+    }
+    free(task.visits);
+
+    double expected = 0.0;
+    my_range_for_zero(size_t, i, (count + 99) / 100) {
+        expected += test_thread_pool_sum(NULL, i * 100, (i + 1) * 100 < count ? (i + 1) * 100 : count);
+    }
+    my_range_for_zero(size_t, i, 3) {
+        ASSERT(my_f64_bits_equal(my_parallel_reduce("test_thread_pool_sum", count, 100, test_thread_pool_sum, NULL, my_add, 0.0), expected));
+    }
+
+    MyArena arena = my_arena_init(1024 * 1024);
+    MyMat first = my_mat_alloc(&arena, 97, 31);
+    MyMat second = my_mat_alloc(&arena, 31, 5);
+    MyMat result = my_mat_alloc(&arena, 97, 5);
+    MyMat expected_result = my_mat_alloc(&arena, 97, 5);
+    my_mat_foreach(el, &first) {
+        *el = (GLfloat)(rand() % 100);
+    }
+    my_mat_foreach(el, &second) {
+        *el = (GLfloat)(rand() % 100);
+    }
+    my_mat_mul(&result, &first, &second);
+    my_range_for_zero(size_t, row, first.rows) {
+        my_range_for_zero(size_t, col, second.cols) {
+            GLfloat sum = 0.f;
+            my_range_for_zero(size_t, k, first.cols) {
+                sum += my_mat_item(&first, row, k) * my_mat_item(&second, k, col);
+            }
+            my_mat_item(&expected_result, row, col) = sum;
+        }
+    }
+    ASSERT(my_mat_max_abs_diff(&result, &expected_result) == 0.0);
+    my_arena_free(&arena);
+}
+
+// Partial gradients and losses of the fused CPU epoch against a double precision reference, on a column prefix
+// whose length is not a multiple of the lanes and with a row count that leaves a tail after the four row blocks.
+static void test_train_cpu_rows(void) {
+    const size_t rows = 2 * MY_TRAIN_CPU_GRAIN + 7;
+    const size_t cols = 29;
+    MyArena arena = my_arena_init(1024 * 1024);
+    MyMat xb = my_mat_alloc(&arena, rows, cols + 3);
+    MyMat y = my_mat_alloc(&arena, rows, 1);
+    MyMat weights = my_mat_alloc(&arena, cols, 1);
+    MyMat partials = my_mat_alloc(&arena, (rows + MY_TRAIN_CPU_GRAIN - 1) / MY_TRAIN_CPU_GRAIN, cols + 1);
+    my_mat_foreach(el, &xb) {
+        *el = (GLfloat)(rand() % 200 - 100) / 100.f;
+    }
+    my_mat_foreach(el, &y) {
+        *el = (GLfloat)(rand() % 200 - 100) / 10.f;
+    }
+    my_mat_foreach(el, &weights) {
+        *el = (GLfloat)(rand() % 200 - 100) / 100.f;
+    }
+    my_parallel_for(
+        "test_train_cpu_rows", rows, MY_TRAIN_CPU_GRAIN, my_train_cpu_rows,
+        &(MyTrainCpuTask){.xb = &xb, .y = &y, .weights = weights.items, .cols = cols, .partials = &partials}
+    );
+    my_range_for_zero(size_t, chunk, partials.rows) {
+        double gradient[29] = {0.0};
+        double loss = 0.0;
+        my_range_for(size_t, row, chunk * MY_TRAIN_CPU_GRAIN, (chunk + 1) * MY_TRAIN_CPU_GRAIN < rows ? (chunk + 1) * MY_TRAIN_CPU_GRAIN : rows) {
+            double residual = -(double)my_mat_item(&y, row, 0);
+            my_range_for_zero(size_t, col, cols) {
+                residual += (double)my_mat_item(&xb, row, col) * (double)weights.items[col];
+            }
+            loss += residual * residual;
+            my_range_for_zero(size_t, col, cols) {
+                gradient[col] += residual * (double)my_mat_item(&xb, row, col);
+            }
+        }
+        my_range_for_zero(size_t, col, cols) {
+            ASSERT(fabs((double)my_mat_item(&partials, chunk, col) - gradient[col]) < 1e-3 * (1.0 + fabs(gradient[col])), "chunk %zu col %zu", chunk, col);
+        }
+        ASSERT(fabs((double)my_mat_item(&partials, chunk, cols) - loss) < 1e-4 * loss, "chunk %zu loss", chunk);
+    }
+    my_arena_free(&arena);
+}
+
+static void test_train_cd(void) {
+    const size_t rows = 301;
+    const size_t features_count = 5;
+    const size_t degree = 3;
+    const size_t count = features_count * degree;
+    MyArena arena = my_arena_init(1024 * 1024);
+    MyMat x = my_mat_alloc(&arena, rows, features_count);
+    MyMat y = my_mat_alloc(&arena, rows, 1);
+    my_mat_foreach(el, &x) {
+        *el = (GLfloat)(rand() % 200 - 100) / 50.f;
+    }
+    my_range_for_zero(size_t, row, rows) {
+        y.items[row] = 1.f + 3.f * my_mat_item(&x, row, 0) - my_powf(my_mat_item(&x, row, 2), 2) + (GLfloat)(rand() % 200 - 100) / 1000.f;
+    }
+    MyMat scaler = my_mat_alloc(&arena, 2, count);
+    MyMat xb = my_polynomial_design_matrix(&arena, &x, degree, &scaler, true);
+    const MyMat cols = my_polynomial_features_create_cols(&arena, &x, degree, &scaler);
+    my_range_for_zero(size_t, row, rows) {
+        my_range_for_zero(size_t, col, count) {
+            ASSERT(fabsf(my_mat_item(&cols, col, row) - my_mat_item(&xb, row, col + 1)) < 1e-5f, "row %zu col %zu", row, col);
+        }
+    }
+    const GLfloat l1_ratio = 0.7f;
+    MyCdPath path = my_cd_path_create(&cols, count, &y);
+    const GLfloat lambda_max = my_cd_lambda_max(&path, l1_ratio);
+    GLfloat previous_l1 = lambda_max * l1_ratio;
+    my_range_for_zero(size_t, step, 4) {
+        const GLfloat lambda = lambda_max * powf(0.1f, (GLfloat)(step + 1));
+        const GLfloat l1 = lambda * l1_ratio;
+        const GLfloat l2 = lambda * (1.f - l1_ratio);
+        my_cd_fit(&path, l1, l2, previous_l1, 1e-7f, 10000);
+        previous_l1 = l1;
+        my_range_for_zero(size_t, col, count) {
+            double correlation = 0.0;
+            my_range_for_zero(size_t, row, rows) {
+                double residual = (double)y.items[row] - (double)path.intercept;
+                my_range_for_zero(size_t, k, count) {
+                    residual -= (double)path.weights[k] * (double)my_mat_item(&cols, k, row);
+                }
+                correlation += residual * (double)my_mat_item(&cols, col, row);
+            }
+            const double subgradient = correlation / (double)rows - (double)l2 * (double)path.weights[col];
+            if(path.weights[col] == 0.f) {
+                ASSERT(fabs(subgradient) <= (double)l1 + 1e-4, "step %zu col %zu", step, col);
+            } else {
+                ASSERT(fabs(subgradient - (double)(path.weights[col] > 0.f ? l1 : -l1)) <= 1e-4, "step %zu col %zu", step, col);
+            }
+        }
+    }
+    my_cd_path_destroy(&path);
+    my_arena_free(&arena);
+}
+
+// Held out rows get outlier features and targets, so any leak into the scaler, the loss or the gradient of the
+// training rows shows up.
+static void test_gl_folds(void) {
+    MyGLContext gl_context = my_gl_context_create(NULL);
+    MyArena arena = my_arena_init(1024 * 1024);
+    const GLuint fold_first = 4, fold_end = 8;
+
+    MyMat x = my_mat_alloc(&arena, 12, 2);
+    MyMat x_in_fold = my_mat_alloc(&arena, x.rows - (fold_end - fold_first), x.cols);
+    my_range_for_zero(size_t, row, x.rows) {
+        my_range_for_zero(size_t, col, x.cols) {
+            my_mat_item(&x, row, col) = row >= fold_first && row < fold_end ? 100.f : (GLfloat)((row * 7 + col * 3) % 11) / 4.f - 1.f;
+        }
+    }
+    memcpy(x_in_fold.items, x.items, fold_first * my_mat_row_bytes_count(&x));
+    memcpy(&my_mat_row(&x_in_fold, fold_first), &my_mat_row(&x, fold_end), (x.rows - fold_end) * my_mat_row_bytes_count(&x));
+    MyMat scaler = my_mat_alloc(&arena, 2, x.cols * 2);
+    MyMat expected_scaler = my_mat_alloc(&arena, 2, x.cols * 2);
+    my_polynomial_scaler_fit_rows(&x, 2, fold_first, fold_end, &scaler);
+    my_polynomial_scaler_fit(&x_in_fold, 2, &expected_scaler);
+    ASSERT(memcmp(scaler.items, expected_scaler.items, my_mat_bytes_count(&scaler)) == 0);
+
+    MyMat xb = my_mat_alloc(&arena, 12, 3);
+    MyMat y = my_mat_alloc(&arena, xb.rows, 1);
+    my_range_for_zero(size_t, row, xb.rows) {
+        my_mat_item(&xb, row, 0) = 1.f;
+        my_mat_item(&xb, row, 1) = (GLfloat)(row % 5) * 0.25f - 0.5f;
+        my_mat_item(&xb, row, 2) = (GLfloat)(row % 3) * 0.5f;
+        const bool held_out = row >= fold_first && row < fold_end;
+        my_mat_item(&y, row, 0) = held_out ? 1000.f : 1.f + 2.f * my_mat_item(&xb, row, 1) - my_mat_item(&xb, row, 2);
+    }
+
+    MyTrainOptions options = {.epochs = 1};
+    MyTrainDevice device = {.options = &options, .gl_xb = mygl_mat_buffer_data(&xb, GL_STATIC_DRAW), .gl_y = mygl_mat_buffer_data(&y, GL_STATIC_DRAW)};
+    mygl_matrix_mul_create_program(&device.shader_program_mul_mat, &device.compute_shader_mul_mat, MY_GL_MAT_FORMAT_F32, MY_PRECISION_F32);
+    mygl_create_compute_shader_program_with_header(&device.shader_program_axpby, &device.compute_shader_axpby, "", mygl_axpby_compute_shader);
+    MyGLReduce reduce = mygl_reduce_create(4);
+    MyTrainJob job = my_train_job_create(&(MyTrainJob){.degree = 1, .fold_first = fold_first, .fold_end = fold_end}, 2, &device.gl_xb, 0);
+    ASSERT(job.cols == xb.cols && my_train_job_rows(&device, &job) == xb.rows - (fold_end - fold_first));
+
+    // from zero weights the residuals are -y, one step moves the weights by lr * 2 / n * X^T y over the training rows
+    const GLfloat learning_rate = 0.1f;
+    GLuint loss_slot, gradient_slot;
+    my_train_job_epoch(&device, &job, &reduce, true, learning_rate, &loss_slot, &gradient_slot);
+    const double loss = (double)mygl_reduce_scalars_wait(&reduce)[loss_slot].sum;
+    double expected_loss = 0.0, expected_weights[3] = {0.0};
+    my_range_for_zero(size_t, row, xb.rows) {
+        if(row >= fold_first && row < fold_end) {
+            continue;
+        }
+        const double target = (double)my_mat_item(&y, row, 0);
+        expected_loss += target * target;
+        my_range_for_zero(size_t, col, xb.cols) {
+            expected_weights[col] += (double)learning_rate * 2.0 / (double)(xb.rows - (fold_end - fold_first)) * (double)my_mat_item(&xb, row, col) * target;
+        }
+    }
+    ASSERT(fabs(loss - expected_loss) < 1e-4 * expected_loss, "loss %lf != %lf", loss, expected_loss);
+    GLfloat weights[3], residuals[12];
+    mygl_buffer_read(job.weights.ssb, 0, sizeof(weights), weights);
+    mygl_buffer_read(job.residuals.ssb, 0, sizeof(residuals), residuals);
+    my_range_for_zero(size_t, col, xb.cols) {
+        ASSERT(fabs((double)weights[col] - expected_weights[col]) < 1e-5, "col %zu: %f != %lf", col, (double)weights[col], expected_weights[col]);
+    }
+    my_range_for(size_t, row, fold_first, fold_end) {
+        ASSERT(residuals[row] == 0.f, "held out row %zu has residual %f", row, (double)residuals[row]);
+    }
+
+    // the fold mse only sees the held out rows
+    const GLuint fold_slot = my_train_job_fold_loss(&device, &job, &reduce);
+    const MyGLStats fold_stats = mygl_reduce_scalars_wait(&reduce)[fold_slot];
+    double expected_fold_loss = 0.0;
+    my_range_for(size_t, row, fold_first, fold_end) {
+        double prediction = 0.0;
+        my_range_for_zero(size_t, col, xb.cols) {
+            prediction += (double)weights[col] * (double)my_mat_item(&xb, row, col);
+        }
+        expected_fold_loss += my_pow(prediction - (double)my_mat_item(&y, row, 0), 2);
+    }
+    ASSERT((GLuint)fold_stats.count == fold_end - fold_first, "fold count %f", (double)fold_stats.count);
+    ASSERT(fabs((double)fold_stats.sum - expected_fold_loss) < 1e-4 * expected_fold_loss, "fold loss %f != %lf", (double)fold_stats.sum, expected_fold_loss);
+
+    my_train_job_destroy(&job);
+    mygl_reduce_destroy(&reduce);
+    ASSERT_GL(glDeleteShader(device.compute_shader_axpby));
+    ASSERT_GL(glDeleteProgram(device.shader_program_axpby));
+    ASSERT_GL(glDeleteShader(device.compute_shader_mul_mat));
+    ASSERT_GL(glDeleteProgram(device.shader_program_mul_mat));
+    mygl_mat_delete(&device.gl_xb);
+    mygl_mat_delete(&device.gl_y);
+    my_arena_free(&arena);
+    my_gl_context_destroy(&gl_context);
+}
+
+static void test_train_cholesky(void) {
+    const size_t rows = 257;
+    const size_t features_count = 4;
+    const size_t degree = 3;
+    MyArena arena = my_arena_init(1024 * 1024);
+    MyMat x = my_mat_alloc(&arena, rows, features_count);
+    MyMat y = my_mat_alloc(&arena, rows, 1);
+    my_mat_foreach(el, &x) {
+        *el = (GLfloat)(rand() % 200 - 100) / 50.f;
+    }
+    my_range_for_zero(size_t, row, rows) {
+        y.items[row] = 0.5f - my_mat_item(&x, row, 1) + 0.3f * my_powf(my_mat_item(&x, row, 3), 3) + (GLfloat)(rand() % 200 - 100) / 1000.f;
+    }
+    MyMat scaler = my_mat_alloc(&arena, 2, features_count * degree);
+    MyMat xb = my_polynomial_design_matrix(&arena, &x, degree, &scaler, true);
+    const MyMat cols = my_polynomial_features_create_cols(&arena, &x, degree, &scaler);
+    MyGram gram = my_gram_create(&cols, &y);
+    const GLfloat l2 = 0.01f;
+    // degree 1, then 3 on top of it
+    my_range_for(size_t, deg, 1, degree + 1) {
+        if(deg == 2) {
+            continue;
+        }
+        const size_t count = features_count * deg + 1;
+        my_gram_grow(&gram, count);
+        ASSERT(my_gram_factor(&gram, count, l2));
+        double weights[13];
+        my_gram_solve(&gram, count, weights);
+
+        double normal[13][14];
+        my_range_for_zero(size_t, i, count) {
+            my_range_for(size_t, j, 0, count + 1) {
+                normal[i][j] = i == j && i > 0 ? (double)l2 * (double)rows : 0.0;
+                my_range_for_zero(size_t, row, rows) {
+                    normal[i][j] += (double)my_mat_item(&xb, row, i) * (double)(j < count ? my_mat_item(&xb, row, j) : y.items[row]);
+                }
+            }
+        }
+        my_range_for_zero(size_t, pivot, count) {
+            my_range_for(size_t, i, pivot + 1, count) {
+                const double factor = normal[i][pivot] / normal[pivot][pivot];
+                my_range_for(size_t, j, pivot, count + 1) {
+                    normal[i][j] -= factor * normal[pivot][j];
+                }
+            }
+        }
+        double expected[13];
+        for(size_t i = count; i-- > 0;) {
+            expected[i] = normal[i][count];
+            my_range_for(size_t, j, i + 1, count) {
+                expected[i] -= normal[i][j] * expected[j];
+            }
+            expected[i] /= normal[i][i];
+        }
+        double mse = 0.0;
+        my_range_for_zero(size_t, row, rows) {
+            double residual = -(double)y.items[row];
+            my_range_for_zero(size_t, col, count) {
+                ASSERT(fabs(weights[col] - expected[col]) < 1e-4, "degree %zu col %zu: %lf != %lf", deg, col, weights[col], expected[col]);
+                residual += expected[col] * (double)my_mat_item(&xb, row, col);
+            }
+            mse += residual * residual / (double)rows;
+        }
+        ASSERT(fabs(my_gram_mse(&gram, count, weights) - mse) < 1e-4 * (1.0 + mse), "degree %zu", deg);
+    }
+    my_gram_destroy(&gram);
+    my_arena_free(&arena);
+}
+
+static void test_monomials(void) {
+    const size_t features_count = 5;
+    // C(5 + 3, 3) - 1 monomials in graded order, each one new
+    MyMonomial monomials[55];
+    size_t monomials_count = 0;
+    for(MyMonomial monomial = {0}; my_monomial_next(&monomial, features_count, 3);) {
+        ASSERT(monomials_count < my_array_count(monomials));
+        ASSERT(monomials_count == 0 || monomials[monomials_count - 1].degree <= monomial.degree);
+        my_range_for(size_t, i, 1, monomial.degree) {
+            ASSERT(monomial.vars[i - 1] <= monomial.vars[i]);
+        }
+        my_range_for_zero(size_t, i, monomials_count) {
+            ASSERT(memcmp(&monomials[i], &monomial, sizeof(monomial)) != 0);
+        }
+        monomials[monomials_count++] = monomial;
+    }
+    ASSERT(monomials_count == my_array_count(monomials), "%zu monomials", monomials_count);
+
+    const size_t rows = 500;
+    MyArena arena = my_arena_init(1024 * 1024);
+    MyMat z_cols = my_mat_alloc(&arena, features_count, rows);
+    MyMat y = my_mat_alloc(&arena, rows, 1);
+    my_mat_foreach(el, &z_cols) {
+        *el = (GLfloat)(rand() % 200 - 100) / 50.f;
+    }
+    my_range_for_zero(size_t, row, rows) {
+        const GLfloat x1 = my_mat_item(&z_cols, 1, row), x3 = my_mat_item(&z_cols, 3, row), x4 = my_mat_item(&z_cols, 4, row);
+        y.items[row] = 2.f * x1 * x3 + 0.5f * x4 * x4 * x4 + (GLfloat)(rand() % 200 - 100) / 1000.f;
+    }
+    MyMonomialStats selected[2];
+    size_t scored_count;
+    ASSERT(my_monomial_select(&z_cols, &y, 3, 2, selected, &scored_count) == 2 && scored_count == monomials_count);
+    char first[32], second[32];
+    my_monomial_name(&selected[0].monomial, first, sizeof(first));
+    my_monomial_name(&selected[1].monomial, second, sizeof(second));
+    ASSERT(strcmp(first, "x1*x3") == 0 && strcmp(second, "x4*x4*x4") == 0, "%s, %s", first, second);
+    ASSERT(selected[0].score >= selected[1].score);
+    my_arena_free(&arena);
+}
+
+static void test_model(void) {
+    const size_t rows = 100;
+    const size_t features_count = 11;
+    const size_t degree = 3;
+    MyArena arena = my_arena_init(1024 * 1024);
+    MyMat x = my_mat_alloc(&arena, rows, features_count);
+    my_mat_foreach(el, &x) {
+        *el = (GLfloat)(rand() % 200 - 100) / 50.f;
+    }
+    MyMat scaler = my_mat_alloc(&arena, 2, features_count * degree);
+    MyMat xb = my_polynomial_design_matrix(&arena, &x, degree, &scaler, true);
+    GLfloat weights[34];
+    my_range_for_zero(size_t, col, xb.cols) {
+        weights[col] = (GLfloat)(rand() % 200 - 100) / 100.f;
+    }
+    char path[] = "/tmp/test_model_XXXXXX";
+    ASSERT_NOT_MINUS_ONE(close(mkstemp(path)));
+    my_model_save(path, features_count, degree, &scaler, weights);
+    MyModel model = my_model_load(path);
+    ASSERT_NOT_MINUS_ONE(unlink(path));
+    GLfloat predictions[100];
+    my_model_predict(&model, &x, predictions);
+    my_range_for_zero(size_t, row, rows) {
+        double expected = 0.0;
+        my_range_for_zero(size_t, col, xb.cols) {
+            expected += (double)weights[col] * (double)my_mat_item(&xb, row, col);
+        }
+        ASSERT(fabs((double)predictions[row] - expected) < 1e-4 * (1.0 + fabs(expected)), "row %zu: %f != %lf", row, (double)predictions[row], expected);
+    }
+    my_model_destroy(&model);
+    my_arena_free(&arena);
+}
+
+static void test_checkpoint(void) {
+    MyGLContext gl_context = my_gl_context_create(NULL);
+    const size_t features_count = 2, degree = 2, jobs_count = 2;
+    MyArena arena = my_arena_init(1024 * 1024);
+    MyMat scaler = my_mat_alloc(&arena, 2, features_count * degree);
+    my_mat_foreach(el, &scaler) {
+        *el = (GLfloat)(rand() % 200 - 100) / 50.f;
+    }
+    const MyGLMat gl_xb = mygl_mat_buffer_data(&(MyMat){.rows = 8, .cols = features_count * degree + 1}, GL_STATIC_DRAW);
+    MyTrainJob jobs[2];
+    my_range_for_zero(size_t, i, jobs_count) {
+        jobs[i] = my_train_job_create(&(MyTrainJob){.degree = degree, .l2 = 0.1f * (GLfloat)i}, features_count, &gl_xb, 4);
+    }
+    const size_t cols = gl_xb.cols;
+    #define LOCAL_MACRO(seed) do {\
+        my_range_for_zero(size_t, i, jobs_count) {\
+            GLfloat values[3 * 5];\
+            my_range_for_zero(size_t, k, 3 * cols) {\
+                values[k] = (GLfloat)((seed) * 100 + i * 20 + k);\
+            }\
+            ASSERT_GL(glBindBuffer(GL_SHADER_STORAGE_BUFFER, jobs[i].weights.ssb));\
+                ASSERT_GL(glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, (GLsizeiptr)(cols * sizeof(GLfloat)), values));\
+            ASSERT_GL(glBindBuffer(GL_SHADER_STORAGE_BUFFER, jobs[i].optimizer_state.ssb));\
+                ASSERT_GL(glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, (GLsizeiptr)(2 * cols * sizeof(GLfloat)), values + cols));\
+            ASSERT_GL(glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0));\
+        }\
+    } while(0)
+    char path[] = "/tmp/test_checkpoint_XXXXXX";
+    ASSERT_NOT_MINUS_ONE(close(mkstemp(path)));
+    MyCheckpointer checkpointer;
+    my_checkpointer_start(&checkpointer, path, jobs, jobs_count, &gl_xb, features_count, degree, &scaler, MY_OPTIMIZER_ADAM);
+    // the periodic snapshots may occupy every slot, the final one must still land
+    my_range_for_zero(size_t, snapshot, 3) {
+        LOCAL_MACRO(snapshot + 1);
+        my_checkpointer_snapshot(&checkpointer, jobs, 10 * (snapshot + 1), snapshot == 2);
+    }
+    my_checkpointer_finish(&checkpointer);
+
+    LOCAL_MACRO(0);
+    ASSERT(my_checkpoint_restore(path, jobs, jobs_count, &gl_xb, features_count, &scaler, MY_OPTIMIZER_ADAM) == 30);
+    my_range_for_zero(size_t, i, jobs_count) {
+        GLfloat values[3 * 5];
+        mygl_buffer_read(jobs[i].weights.ssb, 0, (GLsizeiptr)(cols * sizeof(GLfloat)), values);
+        mygl_buffer_read(jobs[i].optimizer_state.ssb, 0, (GLsizeiptr)(2 * cols * sizeof(GLfloat)), values + cols);
+        my_range_for_zero(size_t, k, 3 * cols) {
+            ASSERT((size_t)values[k] == 300 + i * 20 + k, "job %zu, value %zu: %f", i, k, (double)values[k]);
+        }
+    }
+    #undef LOCAL_MACRO
+    ASSERT_NOT_MINUS_ONE(unlink(path));
+    my_range_for_zero(size_t, i, jobs_count) {
+        my_train_job_destroy(&jobs[i]);
+    }
+    mygl_mat_delete(&gl_xb);
+    my_arena_free(&arena);
+    my_gl_context_destroy(&gl_context);
+}
+
+#define MY_TEST_SERVE_CLIENTS 4
+#define MY_TEST_SERVE_ROWS 2
+
+typedef struct {
+    const char *socket_path;
+    GLfloat x[MY_TEST_SERVE_ROWS][2];
+    GLfloat predictions[MY_TEST_SERVE_ROWS];
+} MyTestServeClient;
+
+static void* test_server_client(void *const arg) {
+    MyTestServeClient *const client = (MyTestServeClient*)arg;
+    const int fd = my_unix_connect(client->socket_path);
+    MyServeHello hello;
+    ASSERT(my_fd_read(fd, &hello, sizeof(hello)) && hello.features_count == 2 && hello.degree == 2);
+    const uint32_t rows = MY_TEST_SERVE_ROWS;
+    ASSERT(my_fd_write(fd, &rows, sizeof(rows)) && my_fd_write(fd, client->x, sizeof(client->x)));
+    ASSERT(my_fd_read(fd, client->predictions, sizeof(client->predictions)));
+    ASSERT_NOT_MINUS_ONE(close(fd));
+    return NULL;
+}
+
+static void test_server(void) {
+    const size_t features_count = 2, degree = 2;
+    GLfloat scaler_items[2 * 4] = {0.f, 0.f, 0.f, 0.f, 1.f, 1.f, 1.f, 1.f};
+    const MyMat scaler = {.rows = 2, .cols = features_count * degree, .items = scaler_items};
+    const GLfloat weights[5] = {0.5f, 1.f, -2.f, 0.25f, 3.f};
+    char model_path[] = "/tmp/test_server_model_XXXXXX";
+    ASSERT_NOT_MINUS_ONE(close(mkstemp(model_path)));
+    my_model_save(model_path, features_count, degree, &scaler, weights);
+    char socket_path[] = "/tmp/test_server_socket_XXXXXX";
+    ASSERT_NOT_MINUS_ONE(close(mkstemp(socket_path)));
+
+    // the batch holds exactly the rows of every client and the window outlasts the test, so all requests share one batch
+    const MyServeOptions options = {
+        .model_path = model_path, .socket_path = socket_path, .backend = MY_TRAIN_BACKEND_CPU,
+        .window_ms = 60000.0, .batch_rows_max = MY_TEST_SERVE_CLIENTS * MY_TEST_SERVE_ROWS,
+    };
+    static MyServer server;
+    my_server_start(&server, &options);
+    MyTestServeClient clients[MY_TEST_SERVE_CLIENTS];
+    pthread_t threads[MY_TEST_SERVE_CLIENTS];
+    my_range_for_zero(size_t, i, MY_TEST_SERVE_CLIENTS) {
+        clients[i] = (MyTestServeClient){.socket_path = socket_path};
+        my_range_for_zero(size_t, row, MY_TEST_SERVE_ROWS) {
+            clients[i].x[row][0] = (GLfloat)i - 1.5f;
+            clients[i].x[row][1] = 0.5f * (GLfloat)row + 0.25f;
+        }
+        ASSERT(pthread_create(&threads[i], NULL, test_server_client, &clients[i]) == 0);
+    }
+    my_range_for_zero(size_t, i, MY_TEST_SERVE_CLIENTS) {
+        ASSERT(pthread_join(threads[i], NULL) == 0);
+    }
+    const MyServeStats stats = my_server_stop(&server);
+    ASSERT_NOT_MINUS_ONE(unlink(model_path));
+    ASSERT(stats.requests == MY_TEST_SERVE_CLIENTS && stats.rows == MY_TEST_SERVE_CLIENTS * MY_TEST_SERVE_ROWS && stats.batches == 1);
+
+    my_range_for_zero(size_t, i, MY_TEST_SERVE_CLIENTS) {
+        my_range_for_zero(size_t, row, MY_TEST_SERVE_ROWS) {
+            double expected = (double)weights[0];
+            my_range_for_zero(size_t, d, degree) {
+                my_range_for_zero(size_t, j, features_count) {
+                    expected += (double)weights[1 + d * features_count + j] * pow((double)clients[i].x[row][j], (double)(d + 1));
+                }
+            }
+            const double prediction = (double)clients[i].predictions[row];
+            ASSERT(fabs(prediction - expected) < 1e-5, "client %zu, row %zu: %lf != %lf", i, row, prediction, expected);
+        }
+    }
+}
+
+#define MY_TEST_METRIC_RING_PUSHES 100000
+
+typedef struct {
+    MyMetricRing *ring;
+    atomic_bool done;
+} MyTestMetricRingProducer;
+
+static void* test_metric_ring_producer(void *const arg) {
+    MyTestMetricRingProducer *const producer = (MyTestMetricRingProducer*)arg;
+    my_range_for_zero(size_t, epoch, MY_TEST_METRIC_RING_PUSHES) {
+        my_metric_ring_push(producer->ring, &(MyTrainMetric){.epoch = (uint32_t)epoch, .mse = (double)epoch});
+    }
+    atomic_store(&producer->done, true);
+    return NULL;
+}
+
+static void test_metric_ring(void) {
+    MyMetricRing *const ring = my_metric_rings_create(1);
+    ASSERT(((uintptr_t)ring & (_Alignof(MyMetricRing) - 1)) == 0);
+    MyTrainMetric metric;
+    my_range_for_zero(size_t, epoch, MY_METRIC_RING_CAPACITY + 3) {
+        my_metric_ring_push(ring, &(MyTrainMetric){.epoch = (uint32_t)epoch});
+    }
+    ASSERT(atomic_load(&ring->dropped) == 3);
+    my_range_for_zero(size_t, epoch, MY_METRIC_RING_CAPACITY) {
+        ASSERT(my_metric_ring_pop(ring, &metric) && metric.epoch == epoch);
+    }
+    ASSERT(!my_metric_ring_pop(ring, &metric));
+
+    // a concurrent producer only loses what the full ring drops and never reorders
+    atomic_store(&ring->dropped, 0);
+    MyTestMetricRingProducer producer = {.ring = ring};
+    pthread_t thread;
+    ASSERT(pthread_create(&thread, NULL, test_metric_ring_producer, &producer) == 0);
+    size_t popped = 0;
+    int64_t last_epoch = -1;
+    for(bool done = false; !done;) {
+        done = atomic_load(&producer.done);
+        while(my_metric_ring_pop(ring, &metric)) {
+            ASSERT((int64_t)metric.epoch > last_epoch && my_f64_bits_equal(metric.mse, (double)metric.epoch));
+            last_epoch = metric.epoch;
+            popped += 1;
+        }
+    }
+    ASSERT(pthread_join(thread, NULL) == 0);
+    ASSERT(popped + atomic_load(&ring->dropped) == MY_TEST_METRIC_RING_PUSHES, "%zu + %zu", popped, atomic_load(&ring->dropped));
+    free(ring);
+}
+
+static void test_density_pyramid(void) {
+    const size_t points_count = 50000;
+    GLfloat *const xs = (GLfloat*)malloc(points_count * sizeof(GLfloat));
+    GLfloat *const ys = (GLfloat*)malloc(points_count * sizeof(GLfloat));
+    ASSERT(xs && ys);
+    my_range_for_zero(size_t, i, points_count) {
+        xs[i] = (GLfloat)(rand() % 10000) / 100.f;
+        ys[i] = xs[i] + (GLfloat)(rand() % 1000 - 500) / 100.f;
+    }
+    MyDensityPyramid pyramid = my_density_pyramid_create(xs, ys, points_count);
+    my_range_for_zero(size_t, level, MY_DENSITY_LEVELS) {
+        double sum = 0.0;
+        my_range_for_zero(size_t, cell, (MY_DENSITY_BASE >> level) * (MY_DENSITY_BASE >> level)) {
+            sum += (double)pyramid.levels[level][cell];
+        }
+        ASSERT(my_f64_bits_equal(sum, (double)points_count), "level %zu: %lf", level, sum);
+    }
+    my_range_for_zero(size_t, cell, MY_DENSITY_BASE * MY_DENSITY_BASE) {
+        my_range_for(size_t, i, pyramid.cell_offsets[cell], pyramid.cell_offsets[cell + 1]) {
+            ASSERT(my_density_cell(pyramid.y_min, pyramid.y_max, (double)pyramid.ys[i]) * MY_DENSITY_BASE + my_density_cell(pyramid.x_min, pyramid.x_max, (double)pyramid.xs[i]) == cell);
+        }
+    }
+    // the whole plot is a heatmap, coarser on a smaller plot, a zoomed view counts exactly the points of its cells
+    MyDensityView view = my_density_view(&pyramid, pyramid.x_min, pyramid.x_max, pyramid.y_min, pyramid.y_max, 4096.0, 4096.0);
+    ASSERT(view.points_count == points_count && view.heatmap && view.level == 0);
+    view = my_density_view(&pyramid, pyramid.x_min, pyramid.x_max, pyramid.y_min, pyramid.y_max, 256.0, 256.0);
+    ASSERT(view.heatmap && view.level == 3 && view.col_end - view.col_first == MY_DENSITY_BASE >> 3);
+    view = my_density_view(&pyramid, 10.0, 12.0, 10.0, 20.0, 256.0, 256.0);
+    size_t expected = 0;
+    my_range_for_zero(size_t, i, points_count) {
+        const size_t col = my_density_cell(pyramid.x_min, pyramid.x_max, (double)xs[i]);
+        const size_t row = my_density_cell(pyramid.y_min, pyramid.y_max, (double)ys[i]);
+        expected += col >= view.col_first && col < view.col_end && row >= view.row_first && row < view.row_end;
+    }
+    ASSERT(!view.heatmap && view.points_count == expected && expected > 0, "%zu != %zu", view.points_count, expected);
+    my_density_pyramid_destroy(&pyramid);
+    free(ys);
+    free(xs);
+}
+
+static void test_lttb(void) {
+    const size_t count = 10000, threshold = 100;
+    double *const xs = (double*)malloc(4 * count * sizeof(double));
+    ASSERT(xs);
+    double *const ys = xs + count, *const out_xs = ys + count, *const out_ys = out_xs + count;
+    my_range_for_zero(size_t, i, count) {
+        xs[i] = (double)i;
+        ys[i] = sin((double)i / 100.0) + (i == 5000 ? 10.0 : 0.0);
+    }
+    ASSERT(my_lttb(xs, ys, threshold, threshold, out_xs, out_ys) == threshold && my_f64_bits_equal(out_xs[threshold - 1], xs[threshold - 1]));
+    ASSERT(my_lttb(xs, ys, count, threshold, out_xs, out_ys) == threshold);
+    ASSERT(out_xs[0] == 0.0 && my_f64_bits_equal(out_xs[threshold - 1], (double)(count - 1)));
+    bool spike = false;
+    my_range_for(size_t, i, 1, threshold) {
+        ASSERT(out_xs[i] > out_xs[i - 1] && my_f64_bits_equal(out_ys[i], ys[(size_t)out_xs[i]]));
+        spike = spike || out_xs[i] == 5000.0;
+    }
+    // a one point outlier is the largest triangle of its bucket
+    ASSERT(spike);
+    free(xs);
+}
 
-    glfwTerminate();
+static void test_gl_diagnostics(void) {
+    MyGLContext gl_context = my_gl_context_create(NULL);
+    const size_t rows = 10000, features_count = 7, degree = 3;
+    const GLuint skip_first = 100, skip_end = 300;
+    const GLfloat range = 2.f;
+    MyArena arena = my_arena_init(1024 * 1024);
+    MyMat residuals = my_mat_alloc(&arena, rows, 1);
+    my_mat_foreach(el, &residuals) {
+        *el = (GLfloat)(rand() % 600 - 300) / 100.f;
+    }
+    MyMat weights = my_mat_alloc(&arena, features_count * degree + 1, 1);
+    my_mat_foreach(el, &weights) {
+        *el = (GLfloat)(rand() % 2000 - 1000) / 10.f;
+    }
+    uint32_t expected[MY_DIAGNOSTICS_BINS] = {0};
+    my_range_for_zero(size_t, row, rows) {
+        if(row < skip_first || row >= skip_end) {
+            const double position = ((double)residuals.items[row] + (double)range) / (2.0 * (double)range) * MY_DIAGNOSTICS_BINS;
+            expected[position < 0.0 ? 0 : position >= MY_DIAGNOSTICS_BINS ? MY_DIAGNOSTICS_BINS - 1 : (size_t)position] += 1;
+        }
+    }
+    const MyGLMat gl_residuals = mygl_mat_buffer_data(&residuals, GL_STATIC_DRAW);
+    const MyGLMat gl_weights = mygl_mat_buffer_data(&weights, GL_STATIC_DRAW);
+    MyDiagnosticsBuffer *const buffer = (MyDiagnosticsBuffer*)calloc(1, sizeof(MyDiagnosticsBuffer));
+    ASSERT(buffer);
+    my_diagnostics_buffer_init(buffer);
+    ASSERT(!my_diagnostics_buffer_take(buffer));
+    MyGLDiagnostics diagnostics;
+    my_gl_diagnostics_create(&diagnostics, buffer, range);
+    const MyTrainJob job = {.degree = degree, .weights = gl_weights, .residuals = gl_residuals, .fold_first = skip_first, .fold_end = skip_end};
+    my_gl_diagnostics_update(&diagnostics, &job, 1, features_count, (GLuint)rows, 7, true);
+    my_gl_diagnostics_poll(&diagnostics, true);
+    const MyDiagnosticsFrame *const frame = my_diagnostics_buffer_take(buffer);
+    ASSERT(frame && frame->epoch == 7 && frame->rows == degree && frame->cols == features_count && !my_diagnostics_buffer_take(buffer));
+    my_range_for_zero(size_t, bin, MY_DIAGNOSTICS_BINS) {
+        ASSERT(frame->bins[bin] == expected[bin], "bin %zu: %u != %u", bin, frame->bins[bin], expected[bin]);
+    }
+    my_range_for_zero(size_t, d, degree) {
+        my_range_for_zero(size_t, j, features_count) {
+            const double magnitude = log10(fabs((double)weights.items[1 + d * features_count + j]) + 1e-12);
+            ASSERT(fabs((double)frame->image[(degree - 1 - d) * features_count + j] - magnitude) < 1e-4, "power %zu, feature %zu", d + 1, j);
+        }
+    }
+    my_gl_diagnostics_destroy(&diagnostics);
+    free(buffer);
+    mygl_mat_delete(&gl_residuals);
+    mygl_mat_delete(&gl_weights);
+    my_arena_free(&arena);
+    my_gl_context_destroy(&gl_context);
 }
 
-static void test_matrix_multiplication(void) {
-    my_glfw_init(false);
-    MyArena arena = my_arena_init(1024 * 1024 * 500);
+static double test_trace_event_ts(const char json[static 1], const char name[static 1]) {
+    char key[64];
+    snprintf(key, sizeof(key), "{\"name\":\"%s\"", name);
+    const char *const event = strstr(json, key);
+    ASSERT(event, "no event: %s", name);
+    const char *const ts = strstr(event, "\"ts\":");
+    ASSERT(ts);
+    return strtod(ts + strlen("\"ts\":"), NULL);
+}
 
-    MyMat first_mat = my_mat_alloc(&arena, 10000, 10000);
-    MyMat second_mat = my_mat_alloc(&arena, first_mat.cols, 1);
-    MyMat third_mat = my_mat_alloc(&arena, first_mat.rows, second_mat.cols);
-    my_mat_foreach(el, &first_mat) {
-        *el = rand() % 100;
+static void test_trace(void) {
+    char path[] = "/tmp/polynomial_regression_trace_XXXXXX";
+    const int fd = mkstemp(path);
+    ASSERT_NOT_MINUS_ONE(fd);
+    ASSERT_NOT_MINUS_ONE(close(fd));
+
+    // `--trace=<path> test` is already recording, park that trace while this one runs
+    my_trace_gpu_flush();
+    const MyTrace outer = {
+        .enabled = my_trace_enabled(), .generation = my_trace.generation, .start_ns = my_trace.start_ns,
+        .threads = my_trace.threads, .threads_count = my_trace.threads_count,
+    };
+    MyTraceThread *const outer_thread = my_trace_thread;
+    const size_t outer_thread_generation = my_trace_thread_generation;
+    atomic_store_explicit(&my_trace.enabled, false, memory_order_relaxed);
+    my_trace.threads = NULL;
+    my_trace.threads_count = 0;
+
+    size_t runs = 0;
+    my_trace_zone("test disabled") {
+        runs++;
     }
-    my_mat_foreach(el, &second_mat) {
-        *el = rand() % 1000;
+    ASSERT(runs == 1 && my_trace.threads == NULL);
+
+    my_trace_start();
+    my_trace_zone("test outer") {
+        my_trace_zone("test inner") {
+            runs++;
+        }
     }
-    my_mat_foreach(el, &third_mat) {
-        *el = NAN;
+    ASSERT(runs == 2);
+    MyGLContext gl_context = my_gl_context_create(NULL);
+    GLuint shader_program, compute_shader;
+    mygl_create_compute_shader_program(&shader_program, &compute_shader, "#version 430\nlayout(local_size_x = 1) in;\nvoid main() {}\n");
+    ASSERT_GL(glUseProgram(shader_program));
+        // more dispatches than queries, so the ring wraps around
+        my_range_for_zero(size_t, i, MY_TRACE_GPU_QUERIES_MAX + 10) {
+            my_gl_dispatch_compute("test dispatch", 1, 1, 1);
+        }
+    ASSERT_GL(glUseProgram(0));
+    ASSERT_GL(glDeleteProgram(shader_program));
+    ASSERT_GL(glDeleteShader(compute_shader));
+    my_gl_context_destroy(&gl_context);
+    // 2 zones, compile and every dispatch
+    ASSERT(my_trace_finish(path) == 3 + MY_TRACE_GPU_QUERIES_MAX + 10);
+    ASSERT(!my_trace_enabled() && my_trace.threads == NULL);
+
+    MyArena arena = my_arena_init(1024 * 1024);
+    FILE *const file = fopen(path, "r");
+    ASSERT(file);
+    char *const json = (char*)my_arena_alloc(&arena, arena.capacity);
+    const size_t bytes_count = fread(json, 1, arena.capacity - 1, file);
+    ASSERT(bytes_count > 0 && bytes_count < arena.capacity - 1);
+    json[bytes_count] = '\0';
+    ASSERT(fclose(file) == 0);
+    ASSERT_NOT_MINUS_ONE(unlink(path));
+
+    ASSERT(strncmp(json, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[", strlen("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[")) == 0);
+    ASSERT(strstr(json, "\"name\":\"compile\""));
+    ASSERT(strstr(json, "{\"name\":\"test dispatch\",\"cat\":\"gpu\",\"ph\":\"X\",\"pid\":2"));
+    ASSERT(test_trace_event_ts(json, "test outer") <= test_trace_event_ts(json, "test inner"));
+    ASSERT(test_trace_event_ts(json, "test outer") < test_trace_event_ts(json, "test dispatch"));
+    ASSERT(strcmp(&json[bytes_count - 4], "\n]}\n") == 0);
+    my_arena_free(&arena);
+
+    atomic_store_explicit(&my_trace.enabled, atomic_load_explicit(&outer.enabled, memory_order_relaxed), memory_order_relaxed);
+    my_trace.generation = outer.generation;
+    my_trace.start_ns = outer.start_ns;
+    my_trace.threads = outer.threads;
+    my_trace.threads_count = outer.threads_count;
+    my_trace_thread = outer_thread;
+    my_trace_thread_generation = outer_thread_generation;
+}
+
+static void test_perf_counters(void) {
+    {
+        const MyPerfSample first = {.values = {100, 100}, .enabled_ns = {10, 10}, .running_ns = {10, 10}};
+        const MyPerfSample end = {.values = {300, 100}, .enabled_ns = {30, 30}, .running_ns = {20, 10}};
+        double counts[MY_PERF_EVENT_COUNT];
+        my_perf_delta(&first, &end, counts);
+        // multiplexed for half of the time, never scheduled, never opened
+        ASSERT(counts[0] == 400.0);
+        ASSERT(isnan(counts[1]) && isnan(counts[2]) && isnan(counts[3]));
+
+        static MyThreadPool pool;
+        my_thread_pool_record(&pool, "test", 1, 0, 1, 1.0, 1.0, 1.0, counts);
+        my_thread_pool_record(&pool, "test", 1, 0, 1, 1.0, 1.0, 1.0, (double[MY_PERF_EVENT_COUNT]){100.0, 50.0, NAN, NAN});
+        const MyThreadPoolTaskStats *const task = &pool.tasks[0];
+        ASSERT(pool.tasks_count == 1 && task->calls == 2);
+        ASSERT(task->counters[0] == 500.0 && task->counter_samples[0] == 2);
+        ASSERT(task->counters[1] == 50.0 && task->counter_samples[1] == 1);
+        ASSERT(task->counters[2] == 0.0 && task->counter_samples[2] == 0);
     }
 
-    MyGLMat first_mat_gl = {.rows = (GLuint)first_mat.rows, .cols = (GLuint)first_mat.cols};
-    MyGLMat second_mat_gl = {.rows = (GLuint)second_mat.rows, .cols = (GLuint)second_mat.cols};
-    MyGLMat third_mat_gl = {.rows = (GLuint)third_mat.rows, .cols = (GLuint)third_mat.cols};
+    const size_t iterations = 1000000;
+    MyPerfSample first, end;
+    my_perf_sample(&first);
+    volatile double sum = 0.0;
+    my_range_for_zero(size_t, i, iterations) {
+        sum += (double)i;
+    }
+    my_perf_sample(&end);
+    double counts[MY_PERF_EVENT_COUNT];
+    my_perf_delta(&first, &end, counts);
+    my_range_for_zero(size_t, i, MY_PERF_EVENT_COUNT) {
+        ASSERT(isnan(counts[i]) || counts[i] >= 0.0, "%s: %lf", my_perf_event_names[i], counts[i]);
+    }
+    ASSERT(isnan(counts[MY_PERF_EVENT_INSTRUCTIONS]) || counts[MY_PERF_EVENT_INSTRUCTIONS] >= (double)iterations);
+}
 
-    GLuint buffers[3];
-    ASSERT_GL(glGenBuffers(3, buffers));
-    first_mat_gl.ssb = buffers[0];
-    second_mat_gl.ssb = buffers[1];
-    third_mat_gl.ssb = buffers[2];
+static void test_mat_transpose(void) {
+    MyArena arena = my_arena_init(1024 * 1024);
+    // not a multiple of the tile on either side
+    MyMat mat = my_mat_alloc(&arena, 70, 45);
+    MyMat result = my_mat_alloc(&arena, mat.cols, mat.rows);
+    my_mat_foreach(el, &mat) {
+        *el = (GLfloat)(el - mat.items);
+    }
+    my_mat_transpose(&result, &mat);
+    my_range_for_zero(size_t, row, mat.rows) {
+        my_range_for_zero(size_t, col, mat.cols) {
+            ASSERT(my_f64_bits_equal((double)my_mat_item(&result, col, row), (double)my_mat_item(&mat, row, col)));
+        }
+    }
+    my_arena_free(&arena);
+}
 
-    ASSERT_GL(glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffers[0]));
-        ASSERT_GL(glBufferData(GL_SHADER_STORAGE_BUFFER, (GLsizeiptr)my_mat_bytes_count(&first_mat), first_mat.items, GL_DYNAMIC_DRAW));
-    ASSERT_GL(glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0));
+static void test_roofline_point(void) {
+    // the ridge sits at 2 flop/byte
+    MyRoofline roofline = {.ceilings[MY_ROOFLINE_DEVICE_CPU] = {.gflops = 100.0, .gbytes_per_s = 50.0}};
+    const MyRooflineKernel compute = {.name = "compute", .device = MY_ROOFLINE_DEVICE_CPU, .flops = 1e9, .bytes = 1e8, .ms = 20.0};
+    MyRooflinePoint point = my_roofline_point(&roofline, &compute);
+    ASSERT(fabs(point.intensity - 10.0) < 1e-12 && fabs(point.gflops - 50.0) < 1e-9 && fabs(point.gbytes_per_s - 5.0) < 1e-9);
+    ASSERT(point.compute_bound && fabs(point.roof_gflops - 100.0) < 1e-9 && fabs(point.of_roof - 0.5) < 1e-12);
+    const MyRooflineKernel bandwidth = {.name = "bandwidth", .device = MY_ROOFLINE_DEVICE_CPU, .flops = 1e8, .bytes = 2e8, .ms = 8.0};
+    point = my_roofline_point(&roofline, &bandwidth);
+    ASSERT(fabs(point.intensity - 0.5) < 1e-12 && fabs(point.gflops - 12.5) < 1e-9 && fabs(point.gbytes_per_s - 25.0) < 1e-9);
+    ASSERT(!point.compute_bound && fabs(point.roof_gflops - 25.0) < 1e-9 && fabs(point.of_roof - 0.5) < 1e-12);
+}
 
-    ASSERT_GL(glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffers[1]));
-        ASSERT_GL(glBufferData(GL_SHADER_STORAGE_BUFFER, (GLsizeiptr)my_mat_bytes_count(&second_mat), second_mat.items, GL_DYNAMIC_DRAW));
-    ASSERT_GL(glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0));
+static void test_regression(void) {
+    // one outlier run must not move the median
+    double means[] = {10.0, 11.0, 9.0, 10.5, 100.0};
+    const MyRegressionResult baseline = my_regression_result(means, my_array_count(means));
+    ASSERT(baseline.median_ms == 10.5 && baseline.mad_ms == 0.5 && baseline.runs == 5);
+    double even_means[] = {4.0, 1.0, 3.0, 2.0};
+    const MyRegressionResult even = my_regression_result(even_means, my_array_count(even_means));
+    ASSERT(even.median_ms == 2.5 && even.mad_ms == 1.0);
+
+    const double tolerance = 0.1;
+    ASSERT(my_regression_compare(&baseline, &(MyRegressionResult){.median_ms = 11.0, .mad_ms = 0.1}, tolerance) == MY_REGRESSION_OK);
+    ASSERT(my_regression_compare(&baseline, &(MyRegressionResult){.median_ms = 20.0, .mad_ms = 0.1}, tolerance) == MY_REGRESSION_REGRESSED);
+    ASSERT(my_regression_compare(&baseline, &(MyRegressionResult){.median_ms = 5.0, .mad_ms = 0.1}, tolerance) == MY_REGRESSION_IMPROVED);
+    // beyond tolerance but within the noise
+    ASSERT(my_regression_compare(&baseline, &(MyRegressionResult){.median_ms = 13.0, .mad_ms = 0.5}, tolerance) == MY_REGRESSION_OK);
+}
 
-    ASSERT_GL(glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffers[2]));
-        ASSERT_GL(glBufferData(GL_SHADER_STORAGE_BUFFER, (GLsizeiptr)my_mat_bytes_count(&third_mat), NULL, GL_DYNAMIC_DRAW));
-    ASSERT_GL(glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0));
+static void test_mem(void) {
+    const MyMemPhase phase = my_mem_phase_set(MY_MEM_PHASE_LOAD);
+    const MyMemPhaseStats *const stats = &my_mem.phases[MY_MEM_PHASE_LOAD];
+    const size_t host_alive = atomic_load(&my_mem.host_alive_bytes);
+    const size_t host_bytes = atomic_load(&stats->host_bytes);
+    MyArena arena = my_arena_init(1024);
+    ASSERT(atomic_load(&my_mem.host_alive_bytes) == host_alive + 1024 && atomic_load(&stats->host_bytes) == host_bytes + 1024);
+    ASSERT(atomic_load(&stats->host_peak_bytes) >= host_alive + 1024);
+    my_arena_free(&arena);
+    ASSERT(atomic_load(&my_mem.host_alive_bytes) == host_alive && atomic_load(&stats->host_bytes) == host_bytes + 1024);
+
+    MyGLContext gl_context = my_gl_context_create(NULL);
+    const size_t gl_alive = atomic_load(&my_mem.gl_alive_bytes);
+    const size_t uploaded = atomic_load(&stats->uploaded_bytes);
+    const size_t downloaded = atomic_load(&stats->downloaded_bytes);
+    GLfloat items[16 * 4] = {0.f};
+    const MyGLMat empty = mygl_mat_buffer_data(&(MyMat){.rows = 16, .cols = 4}, GL_DYNAMIC_COPY);
+    const MyGLMat full = mygl_mat_buffer_data(&(MyMat){.rows = 16, .cols = 4, .items = items}, GL_STATIC_DRAW);
+    ASSERT(atomic_load(&my_mem.gl_alive_bytes) == gl_alive + 2 * sizeof(items) && atomic_load(&stats->uploaded_bytes) == uploaded + sizeof(items));
+    mygl_buffer_read(full.ssb, 0, 4 * sizeof(GLfloat), items);
+    ASSERT(atomic_load(&stats->downloaded_bytes) == downloaded + 4 * sizeof(GLfloat));
+    mygl_mat_delete(&empty);
+    mygl_mat_delete(&full);
+    ASSERT(atomic_load(&my_mem.gl_alive_bytes) == gl_alive);
+    my_gl_context_destroy(&gl_context);
+    my_mem_phase_set(phase);
+}
 
-    GLuint shader_program, compute_shader;
-    mygl_create_compute_shader_program(&shader_program, &compute_shader, mygl_matrix_mul_compute_shader);
+static void test_all(void) {
+    test_thread_pool();
+    test_train_cpu_rows();
+    test_train_cd();
+    test_train_cholesky();
+    test_monomials();
+    test_matrix_multiplication();
+    test_gl_reduce();
+    test_gl_mat_formats();
+    test_upload_pipeline();
+    test_gl_minibatch();
+    test_gl_solvers();
+    test_gl_folds();
+    test_model();
+    test_checkpoint();
+    test_server();
+    test_metric_ring();
+    test_density_pyramid();
+    test_lttb();
+    test_gl_diagnostics();
+    test_trace();
+    test_perf_counters();
+    test_mat_transpose();
+    test_roofline_point();
+    test_regression();
+    test_mem();
+    // test_hstack();
+}
 
-    clock_t start = clock();
-        my_gl_dispatch_compute_mat_mul(shader_program, &first_mat_gl, &second_mat_gl, &third_mat_gl);
-    clock_t end = clock();
-    const double opengl_elapsed_time = (((double)(end - start)) / CLOCKS_PER_SEC) * 1000;
-    LOG("opengl_elapsed_time ms: %lf", opengl_elapsed_time);
-    start = clock();
-        my_mat_mul(&third_mat, &first_mat, &second_mat);
-    end = clock();
-    const double cpu_elapsed_time = (((double)(end - start)) / CLOCKS_PER_SEC) * 1000;
-    LOG("cpu_elapsed_time ms: %lf", cpu_elapsed_time);
-    LOG("cpu_elapsed_time / opengl_elapsed_time: %lf", cpu_elapsed_time / opengl_elapsed_time);
-    {
-        ASSERT_GL(glBindBuffer(GL_SHADER_STORAGE_BUFFER, third_mat_gl.ssb));
-            GLfloat *data; 
-            ASSERT_GL(data = (GLfloat*)glMapBufferRange(GL_SHADER_STORAGE_BUFFER, 0, (GLsizeiptr)my_mat_bytes_count(&third_mat), GL_MAP_READ_BIT));
-            my_range_for_zero(size_t, i, my_mat_items_count(&third_mat)) {
-                // LOG("opengl: %lf, cpu: %lf", (double)data[i], (double)third_mat.items[i]);
-                ASSERT(fabsf(data[i] - third_mat.items[i]) < 0.0001f);
+// Throughput of each accumulation policy for the tiled GL matmul and the CPU kernels, errors are against an fp64 CPU reference.
+static void bench_precision(void) {
+    MyGLContext gl_context = my_gl_context_create(NULL);
+    MyArena arena = my_arena_init(1024 * 1024 * 64);
+
+    MyMat first = my_mat_alloc(&arena, 2048, 2048);
+    MyMat second = my_mat_alloc(&arena, first.cols, 16);
+    MyMat reference = my_mat_alloc(&arena, first.rows, second.cols);
+    MyMat result = my_mat_alloc(&arena, first.rows, second.cols);
+    my_mat_foreach(el, &first) {
+        *el = (GLfloat)(rand() % 2000) / 1000.f - 1.f;
+    }
+    my_mat_foreach(el, &second) {
+        *el = (GLfloat)(rand() % 2000) / 1000.f - 1.f;
+    }
+    my_mat_mul_f64(&reference, &first, &second);
+    const double flops = 2.0 * (double)first.rows * (double)first.cols * (double)second.cols;
+
+    const MyGLMat first_gl = mygl_mat_buffer_data(&first, GL_STATIC_DRAW);
+    const MyGLMat second_gl = mygl_mat_buffer_data(&second, GL_STATIC_DRAW);
+    const MyGLMat result_gl = mygl_mat_buffer_data(&(MyMat){.rows = result.rows, .cols = result.cols}, GL_DYNAMIC_COPY);
+
+    const size_t repeats = 5;
+    double gl_f32_ms = 0.0, cpu_f32_ms = 0.0;
+    my_range_for_zero(size_t, p, MY_PRECISION_COUNT) {
+        const MyPrecision precision = (MyPrecision)p;
+        if(mygl_precision_supported(precision) != precision) {
+            LOG("gl precision: %s, skipped", my_precision_names[precision]);
+        } else {
+            GLuint shader_program, compute_shader;
+            mygl_matrix_mul_create_program(&shader_program, &compute_shader, MY_GL_MAT_FORMAT_F32, precision);
+            my_gl_dispatch_compute_mat_mul(shader_program, &first_gl, &second_gl, &result_gl);
+            ASSERT_GL(glFinish());
+            const double start = my_time_ms();
+            my_range_for_zero(size_t, i, repeats) {
+                my_gl_dispatch_compute_mat_mul(shader_program, &first_gl, &second_gl, &result_gl);
             }
-            ASSERT_GL(glUnmapBuffer(GL_SHADER_STORAGE_BUFFER));
+            ASSERT_GL(glFinish());
+            const double elapsed_ms = (my_time_ms() - start) / (double)repeats;
+            if(precision == MY_PRECISION_F32) {
+                gl_f32_ms = elapsed_ms;
+            }
+            ASSERT_GL(glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT));
+            mygl_buffer_read(result_gl.ssb, 0, (GLsizeiptr)my_mat_bytes_count(&result), result.items);
+            LOG("gl precision: %s, ms: %lf, gflops: %lf, cost vs f32: %lfx, max abs error: %e",
+                my_precision_names[precision], elapsed_ms, flops / elapsed_ms / 1e6, elapsed_ms / gl_f32_ms, my_mat_max_abs_diff(&result, &reference));
+            ASSERT_GL(glDeleteShader(compute_shader));
+            ASSERT_GL(glDeleteProgram(shader_program));
+        }
 
-        ASSERT_GL(glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0));
-    } 
-    
-    ASSERT_GL(glDeleteShader(compute_shader));
-    ASSERT_GL(glDeleteProgram(shader_program));
-    ASSERT_GL(glDeleteBuffers(my_array_count(buffers), buffers));
-    free(arena.items);
+        const double start = my_time_ms();
+        my_mat_mul_precision(precision, &result, &first, &second);
+        const double elapsed_ms = my_time_ms() - start;
+        if(precision == MY_PRECISION_F32) {
+            cpu_f32_ms = elapsed_ms;
+        }
+        LOG("cpu precision: %s, ms: %lf, gflops: %lf, cost vs f32: %lfx, max abs error: %e",
+            my_precision_names[precision], elapsed_ms, flops / elapsed_ms / 1e6, elapsed_ms / cpu_f32_ms, my_mat_max_abs_diff(&result, &reference));
+    }
 
-    glfwTerminate();
+    mygl_mat_delete(&first_gl);
+    mygl_mat_delete(&second_gl);
+    mygl_mat_delete(&result_gl);
+    my_arena_free(&arena);
+
+    my_gl_context_destroy(&gl_context);
 }
 
-static void test_hstack(void) {
-    MyArena arena = my_arena_init(1024);
-    MyMat first = my_mat_alloc(&arena, 4, 4);
-    MyMat second = my_mat_alloc(&arena, 4, 3);
+static void bench_all(void) {
+    bench_precision();
+    my_roofline(&(MyRooflineOptions){.repeats = 5});
+}
 
-    my_mat_item(&first, 0, 0) = 1;
-    my_mat_item(&first, 0, 1) = 1;
-    my_mat_item(&first, 0, 2) = 1;
-    my_mat_item(&first, 0, 3) = 1;
+#define my_shift(xs, xs_sz) (ASSERT((xs_sz) > 0), (xs_sz)--, *(xs)++)
+#define my_arg_value(arg, prefix) (strncmp((arg), (prefix), strlen(prefix)) == 0 ? (arg) + strlen(prefix) : NULL)
 
-    my_mat_item(&first, 1, 0) = 2;
-    my_mat_item(&first, 1, 1) = 2;
-    my_mat_item(&first, 1, 2) = 2;
-    my_mat_item(&first, 1, 3) = 2;
+static MyGLMatFormat my_gl_mat_format_parse(const char name[static 1]) {
+    my_range_for_zero(size_t, format, MY_GL_MAT_FORMAT_COUNT) {
+        if(strcmp(name, my_gl_mat_format_names[format]) == 0) {
+            return (MyGLMatFormat)format;
+        }
+    }
+    ASSERT(false, "unknown storage format: %s", name);
+    return MY_GL_MAT_FORMAT_F32;
+}
 
-    my_mat_item(&first, 2, 0) = 3;
-    my_mat_item(&first, 2, 1) = 3;
-    my_mat_item(&first, 2, 2) = 3;
-    my_mat_item(&first, 2, 3) = 3;
+static MyPrecision my_precision_parse(const char name[static 1]) {
+    my_range_for_zero(size_t, precision, MY_PRECISION_COUNT) {
+        if(strcmp(name, my_precision_names[precision]) == 0) {
+            return (MyPrecision)precision;
+        }
+    }
+    ASSERT(false, "unknown precision: %s", name);
+    return MY_PRECISION_F32;
+}
 
-    my_mat_item(&first, 3, 0) = 4;
-    my_mat_item(&first, 3, 1) = 4;
-    my_mat_item(&first, 3, 2) = 4;
-    my_mat_item(&first, 3, 3) = 4;
+static MyTrainBackend my_train_backend_parse(const char name[static 1]) {
+    my_range_for_zero(size_t, backend, MY_TRAIN_BACKEND_COUNT) {
+        if(strcmp(name, my_train_backend_names[backend]) == 0) {
+            return (MyTrainBackend)backend;
+        }
+    }
+    ASSERT(false, "unknown backend: %s", name);
+    return MY_TRAIN_BACKEND_GL;
+}
 
-    my_mat_item(&second, 0, 0) = 5;
-    my_mat_item(&second, 0, 1) = 5;
-    my_mat_item(&second, 0, 2) = 5;
+static MyOptimizer my_optimizer_parse(const char name[static 1]) {
+    my_range_for_zero(size_t, optimizer, MY_OPTIMIZER_COUNT) {
+        if(strcmp(name, my_optimizer_names[optimizer]) == 0) {
+            return (MyOptimizer)optimizer;
+        }
+    }
+    ASSERT(false, "unknown optimizer: %s", name);
+    return MY_OPTIMIZER_SGD;
+}
 
-    my_mat_item(&second, 1, 0) = 6;
-    my_mat_item(&second, 1, 1) = 6;
-    my_mat_item(&second, 1, 2) = 6;
+static MySchedule my_schedule_parse(const char name[static 1]) {
+    my_range_for_zero(size_t, schedule, MY_SCHEDULE_COUNT) {
+        if(strcmp(name, my_schedule_names[schedule]) == 0) {
+            return (MySchedule)schedule;
+        }
+    }
+    ASSERT(false, "unknown schedule: %s", name);
+    return MY_SCHEDULE_CONSTANT;
+}
 
-    my_mat_item(&second, 2, 0) = 7;
-    my_mat_item(&second, 2, 1) = 7;
-    my_mat_item(&second, 2, 2) = 7;
+static MySolver my_solver_parse(const char name[static 1]) {
+    my_range_for_zero(size_t, solver, MY_SOLVER_COUNT) {
+        if(strcmp(name, my_solver_names[solver]) == 0) {
+            return (MySolver)solver;
+        }
+    }
+    ASSERT(false, "unknown solver: %s", name);
+    return MY_SOLVER_GD;
+}
 
-    my_mat_item(&second, 3, 0) = 8;
-    my_mat_item(&second, 3, 1) = 8;
-    my_mat_item(&second, 3, 2) = 8;
+#define my_strtosize(str, end) ((size_t)strtoull((str), (end), 10))
 
-    const MyMat result = my_mat_hstack(&arena, &first, &second);
-    #define ASSERT_MAT_VALUE(row, col, expected_value) ASSERT(fabsf(my_mat_item(&result, (row), (col)) - (expected_value)) < 0.0000000001f)
-        ASSERT_MAT_VALUE(0, 0, 1);
-        ASSERT_MAT_VALUE(0, 1, 1);
-        ASSERT_MAT_VALUE(0, 2, 1);
-        ASSERT_MAT_VALUE(0, 3, 1);
-        ASSERT_MAT_VALUE(0, 4, 5);
-        ASSERT_MAT_VALUE(0, 5, 5);
-        ASSERT_MAT_VALUE(0, 6, 5);
+// Parses one number at the start of `str` into items[index] and returns the end of the number.
+typedef char* (*MyArgItemParse)(const char str[static 1], void *items, size_t index);
 
-        ASSERT_MAT_VALUE(1, 0, 2);
-        ASSERT_MAT_VALUE(1, 1, 2);
-        ASSERT_MAT_VALUE(1, 2, 2);
-        ASSERT_MAT_VALUE(1, 3, 2);
-        ASSERT_MAT_VALUE(1, 4, 6);
-        ASSERT_MAT_VALUE(1, 5, 6);
-        ASSERT_MAT_VALUE(1, 6, 6);
+static char* my_arg_item_parse_size(const char str[static 1], void *const items, const size_t index) {
+    char *end;
+    ((size_t*)items)[index] = my_strtosize(str, &end);
+    return end;
+}
 
-        ASSERT_MAT_VALUE(2, 0, 3);
-        ASSERT_MAT_VALUE(2, 1, 3);
-        ASSERT_MAT_VALUE(2, 2, 3);
-        ASSERT_MAT_VALUE(2, 3, 3);
-        ASSERT_MAT_VALUE(2, 4, 7);
-        ASSERT_MAT_VALUE(2, 5, 7);
-        ASSERT_MAT_VALUE(2, 6, 7);
+static char* my_arg_item_parse_float(const char str[static 1], void *const items, const size_t index) {
+    char *end;
+    ((GLfloat*)items)[index] = strtof(str, &end);
+    return end;
+}
 
-        ASSERT_MAT_VALUE(3, 0, 4);
-        ASSERT_MAT_VALUE(3, 1, 4);
-        ASSERT_MAT_VALUE(3, 2, 4);
-        ASSERT_MAT_VALUE(3, 3, 4);
-        ASSERT_MAT_VALUE(3, 4, 8);
-        ASSERT_MAT_VALUE(3, 5, 8);
-        ASSERT_MAT_VALUE(3, 6, 8);
+// Comma separated list of at most `capacity` numbers, returns how many were parsed.
+static size_t my_arg_list_parse(const char value[static 1], void *const items, const size_t capacity, const MyArgItemParse parse_item) {
+    size_t items_count = 0;
+    for(const char *it = value; ; ++it) {
+        ASSERT(items_count < capacity, "too many values: %s", value);
+        const char *const end = parse_item(it, items, items_count++);
+        ASSERT(end != it && (*end == ',' || *end == '\0'), "invalid list: %s", value);
+        it = end;
+        if(*it == '\0') {
+            break;
+        }
+    }
+    return items_count;
+}
 
-    #undef ASSERT_MAT_VALUE
+static MyTrainOptions my_train_options_parse(int argc, const char* const* argv) {
+    MyTrainOptions options = {
+        .backend = MY_TRAIN_BACKEND_GL,
+        .storage = MY_GL_MAT_FORMAT_F32,
+        .precision = MY_PRECISION_F32,
+        .upload_block_rows = 1024,
+        .epochs = 100,
+        .degrees = {4},
+        .degrees_count = 1,
+        .l2s = {0.f},
+        .l2s_count = 1,
+        .optimizer = MY_OPTIMIZER_SGD,
+        .schedule = MY_SCHEDULE_CONSTANT,
+        .learning_rate = MY_TRAIN_LEARNING_RATE,
+        .solver = MY_SOLVER_GD,
+        .tolerance = 1e-4f,
+        .l1_ratio = 1.f,
+        .path_count = 20,
+        .top_k = 256,
+        .checkpoint_every = 10,
+    };
+    while(argc > 0) {
+        const char* const arg = my_shift(argv, argc);
+        const char* value;
+        if((value = my_arg_value(arg, "--backend="))) {
+            options.backend = my_train_backend_parse(value);
+        } else if((value = my_arg_value(arg, "--storage="))) {
+            options.storage = my_gl_mat_format_parse(value);
+        } else if(strcmp(arg, "--validate-storage") == 0) {
+            options.validate_storage = true;
+        } else if((value = my_arg_value(arg, "--precision="))) {
+            options.precision = my_precision_parse(value);
+        } else if((value = my_arg_value(arg, "--device="))) {
+            options.device = value;
+        } else if((value = my_arg_value(arg, "--epochs="))) {
+            char *end;
+            options.epochs = my_strtosize(value, &end);
+            ASSERT(*end == '\0', "invalid epochs: %s", value);
+        } else if((value = my_arg_value(arg, "--degrees="))) {
+            options.degrees_count = my_arg_list_parse(value, options.degrees, MY_TRAIN_SWEEP_MAX, my_arg_item_parse_size);
+            my_range_for_zero(size_t, i, options.degrees_count) {
+                ASSERT(options.degrees[i] > 0, "invalid degree: %s", value);
+            }
+        } else if((value = my_arg_value(arg, "--l2="))) {
+            options.l2s_count = my_arg_list_parse(value, options.l2s, MY_TRAIN_SWEEP_MAX, my_arg_item_parse_float);
+            my_range_for_zero(size_t, i, options.l2s_count) {
+                ASSERT(options.l2s[i] >= 0.f, "invalid l2: %s", value);
+            }
+        } else if((value = my_arg_value(arg, "--optimizer="))) {
+            options.optimizer = my_optimizer_parse(value);
+        } else if((value = my_arg_value(arg, "--batch-size="))) {
+            char *end;
+            options.batch_size = my_strtosize(value, &end);
+            ASSERT(*end == '\0', "invalid batch size: %s", value);
+        } else if((value = my_arg_value(arg, "--schedule="))) {
+            options.schedule = my_schedule_parse(value);
+        } else if((value = my_arg_value(arg, "--learning-rate="))) {
+            char *end;
+            options.learning_rate = strtof(value, &end);
+            ASSERT(*end == '\0' && options.learning_rate > 0.f, "invalid learning rate: %s", value);
+        } else if((value = my_arg_value(arg, "--solver="))) {
+            options.solver = my_solver_parse(value);
+        } else if((value = my_arg_value(arg, "--tolerance="))) {
+            char *end;
+            options.tolerance = strtof(value, &end);
+            ASSERT(*end == '\0' && options.tolerance >= 0.f, "invalid tolerance: %s", value);
+        } else if((value = my_arg_value(arg, "--l1-ratio="))) {
+            char *end;
+            options.l1_ratio = strtof(value, &end);
+            ASSERT(*end == '\0' && options.l1_ratio > 0.f && options.l1_ratio <= 1.f, "invalid l1 ratio: %s", value);
+        } else if((value = my_arg_value(arg, "--path="))) {
+            char *end;
+            options.path_count = my_strtosize(value, &end);
+            ASSERT(*end == '\0' && options.path_count > 0, "invalid path: %s", value);
+        } else if((value = my_arg_value(arg, "--folds="))) {
+            char *end;
+            options.folds = my_strtosize(value, &end);
+            ASSERT(*end == '\0' && options.folds >= 2, "invalid folds: %s", value);
+        } else if((value = my_arg_value(arg, "--interactions="))) {
+            char *end;
+            options.interactions = my_strtosize(value, &end);
+            ASSERT(*end == '\0' && options.interactions <= MY_MONOMIAL_DEGREE_MAX, "invalid interactions: %s", value);
+        } else if((value = my_arg_value(arg, "--top-k="))) {
+            char *end;
+            options.top_k = my_strtosize(value, &end);
+            ASSERT(*end == '\0' && options.top_k > 0, "invalid top-k: %s", value);
+        } else if((value = my_arg_value(arg, "--save-model="))) {
+            options.model_path = value;
+        } else if((value = my_arg_value(arg, "--checkpoint="))) {
+            options.checkpoint_path = value;
+        } else if((value = my_arg_value(arg, "--checkpoint-every="))) {
+            char *end;
+            options.checkpoint_every = my_strtosize(value, &end);
+            ASSERT(*end == '\0' && options.checkpoint_every > 0, "invalid checkpoint every: %s", value);
+        } else if(strcmp(arg, "--resume") == 0) {
+            options.resume = true;
+        } else if(strcmp(arg, "--dashboard") == 0) {
+            options.dashboard = true;
+        } else if((value = my_arg_value(arg, "--upload-block-rows="))) {
+            char *end;
+            options.upload_block_rows = strtoull(value, &end, 10);
+            ASSERT(*end == '\0' && options.upload_block_rows > 0, "invalid block rows: %s", value);
+        } else {
+            ASSERT(false, "unknown argument: %s", arg);
+        }
+    }
+    ASSERT(
+        options.solver == MY_SOLVER_GD || (options.optimizer == MY_OPTIMIZER_SGD && options.batch_size == 0),
+        "the %s solver takes no optimizer or batch size", my_solver_names[options.solver]
+    );
+    ASSERT(
+        options.folds == 0 || (options.solver == MY_SOLVER_GD && options.optimizer == MY_OPTIMIZER_SGD && options.batch_size == 0),
+        "cross-validation trains full-batch gradient descent"
+    );
+    ASSERT(
+        !options.model_path || (options.interactions == 0 && options.solver != MY_SOLVER_CD && options.solver != MY_SOLVER_CHOLESKY),
+        "--save-model saves one of the trained jobs"
+    );
+    ASSERT(
+        !options.model_path || options.folds > 0 || options.degrees_count * options.l2s_count == 1,
+        "--save-model needs --folds to pick one of several degree x l2 combinations"
+    );
+    ASSERT(
+        !options.checkpoint_path || (
+            options.backend == MY_TRAIN_BACKEND_GL && options.solver == MY_SOLVER_GD && options.folds == 0 && options.interactions == 0
+            && (!options.device || !strchr(options.device, ','))
+        ),
+        "--checkpoint snapshots gradient descent on one GL device"
+    );
+    ASSERT(!options.resume || options.checkpoint_path, "--resume needs --checkpoint=");
+    return options;
+}
 
-    free(arena.items);
+static MyInferOptions my_infer_options_parse(int argc, const char* const* argv) {
+    MyInferOptions options = {
+        .batch_sizes = {1, 16, 256, 4096},
+        .batch_sizes_count = 4,
+    };
+    while(argc > 0) {
+        const char* const arg = my_shift(argv, argc);
+        const char* value;
+        if((value = my_arg_value(arg, "--model="))) {
+            options.model_path = value;
+        } else if((value = my_arg_value(arg, "--backend="))) {
+            options.backends[my_train_backend_parse(value)] = true;
+        } else if((value = my_arg_value(arg, "--device="))) {
+            options.device = value;
+        } else if((value = my_arg_value(arg, "--batch-sizes="))) {
+            options.batch_sizes_count = my_arg_list_parse(value, options.batch_sizes, MY_INFER_BATCH_SIZES_MAX, my_arg_item_parse_size);
+            my_range_for_zero(size_t, i, options.batch_sizes_count) {
+                ASSERT(options.batch_sizes[i] > 0 && options.batch_sizes[i] <= 65535, "invalid batch size: %s", value);
+            }
+        } else {
+            ASSERT(false, "unknown argument: %s", arg);
+        }
+    }
+    ASSERT(options.model_path, "--model= is required");
+    if(!options.backends[MY_TRAIN_BACKEND_CPU] && !options.backends[MY_TRAIN_BACKEND_GL]) {
+        options.backends[MY_TRAIN_BACKEND_CPU] = options.backends[MY_TRAIN_BACKEND_GL] = true;
+    }
+    return options;
 }
-static void test_all(void) {
-    test_matrix_multiplication();
-    // test_hstack();
+
+static MyServeOptions my_serve_options_parse(int argc, const char* const* argv) {
+    MyServeOptions options = {
+        .socket_path = "polynomial_regression.sock",
+        .backend = MY_TRAIN_BACKEND_CPU,
+        .window_ms = 1.0,
+        .batch_rows_max = 4096,
+    };
+    while(argc > 0) {
+        const char* const arg = my_shift(argv, argc);
+        const char* value;
+        if((value = my_arg_value(arg, "--model="))) {
+            options.model_path = value;
+        } else if((value = my_arg_value(arg, "--socket="))) {
+            options.socket_path = value;
+        } else if((value = my_arg_value(arg, "--backend="))) {
+            options.backend = my_train_backend_parse(value);
+        } else if((value = my_arg_value(arg, "--device="))) {
+            options.device = value;
+        } else if((value = my_arg_value(arg, "--window-ms="))) {
+            char *end;
+            options.window_ms = strtod(value, &end);
+            ASSERT(*end == '\0' && options.window_ms >= 0.0, "invalid window: %s", value);
+        } else if((value = my_arg_value(arg, "--batch-rows="))) {
+            char *end;
+            options.batch_rows_max = my_strtosize(value, &end);
+            ASSERT(*end == '\0' && options.batch_rows_max > 0 && options.batch_rows_max <= 65535, "invalid batch rows: %s", value);
+        } else {
+            ASSERT(false, "unknown argument: %s", arg);
+        }
+    }
+    ASSERT(options.model_path, "--model= is required");
+    return options;
 }
 
-#define my_shift(xs, xs_sz) (ASSERT((xs_sz) > 0), (xs_sz)--, *(xs)++)
+static MyRegressionOptions my_regression_options_parse(int argc, const char* const* argv) {
+    MyRegressionOptions options = {
+        .store_path = "polynomial_regression_baselines.tsv",
+        .runs = 7,
+        .repeats = 5,
+        .tolerance = 0.1,
+        .record = true,
+    };
+    while(argc > 0) {
+        const char* const arg = my_shift(argv, argc);
+        const char* value;
+        char *end;
+        if((value = my_arg_value(arg, "--store="))) {
+            options.store_path = value;
+        } else if((value = my_arg_value(arg, "--baseline="))) {
+            options.baseline_commit = value;
+        } else if((value = my_arg_value(arg, "--commit="))) {
+            ASSERT(*value != '\0' && !strpbrk(value, "\t\n"), "invalid commit: %s", value);
+            options.commit = value;
+        } else if((value = my_arg_value(arg, "--device="))) {
+            options.device = value;
+        } else if((value = my_arg_value(arg, "--runs="))) {
+            options.runs = my_strtosize(value, &end);
+            ASSERT(*end == '\0' && options.runs > 0 && options.runs <= MY_REGRESSION_RUNS_MAX, "invalid runs: %s", value);
+        } else if((value = my_arg_value(arg, "--repeats="))) {
+            options.repeats = my_strtosize(value, &end);
+            ASSERT(*end == '\0' && options.repeats > 0, "invalid repeats: %s", value);
+        } else if((value = my_arg_value(arg, "--tolerance="))) {
+            options.tolerance = strtod(value, &end);
+            ASSERT(*end == '\0' && options.tolerance >= 0.0, "invalid tolerance: %s", value);
+        } else if(strcmp(arg, "--no-record") == 0) {
+            options.record = false;
+        } else {
+            ASSERT(false, "unknown argument: %s", arg);
+        }
+    }
+    return options;
+}
+
+static MyRooflineOptions my_roofline_options_parse(int argc, const char* const* argv) {
+    MyRooflineOptions options = {.repeats = 5};
+    while(argc > 0) {
+        const char* const arg = my_shift(argv, argc);
+        const char* value;
+        char *end;
+        if((value = my_arg_value(arg, "--device="))) {
+            options.device = value;
+        } else if((value = my_arg_value(arg, "--repeats="))) {
+            options.repeats = my_strtosize(value, &end);
+            ASSERT(*end == '\0' && options.repeats > 0, "invalid repeats: %s", value);
+        } else if(strcmp(arg, "--plot") == 0) {
+            options.plot = true;
+        } else {
+            ASSERT(false, "unknown argument: %s", arg);
+        }
+    }
+    return options;
+}
+
+static MyLoadOptions my_load_options_parse(int argc, const char* const* argv) {
+    MyLoadOptions options = {
+        .socket_path = "polynomial_regression.sock",
+        .clients_count = 8,
+        .requests_count = 1000,
+        .rows = 1,
+    };
+    while(argc > 0) {
+        const char* const arg = my_shift(argv, argc);
+        const char* value;
+        char *end;
+        if((value = my_arg_value(arg, "--socket="))) {
+            options.socket_path = value;
+        } else if((value = my_arg_value(arg, "--clients="))) {
+            options.clients_count = my_strtosize(value, &end);
+            ASSERT(*end == '\0' && options.clients_count > 0, "invalid clients: %s", value);
+        } else if((value = my_arg_value(arg, "--requests="))) {
+            options.requests_count = my_strtosize(value, &end);
+            ASSERT(*end == '\0' && options.requests_count > 0, "invalid requests: %s", value);
+        } else if((value = my_arg_value(arg, "--rows="))) {
+            options.rows = my_strtosize(value, &end);
+            ASSERT(*end == '\0' && options.rows > 0 && options.rows <= 65535, "invalid rows: %s", value);
+        } else {
+            ASSERT(false, "unknown argument: %s", arg);
+        }
+    }
+    return options;
+}
 
+// Options before the subcommand apply to every subcommand.
 int main(int argc, const char* const* argv) {
     my_shift(argv, argc);
-    if(argc == 0) {
-        my_polynomial_train();
-    } else {
+    size_t threads_count = 0;
+    bool task_timing = false;
+    const char *trace_path = NULL;
+    int status = 0;
+    for(const char* value; argc > 0; my_shift(argv, argc)) {
+        if((value = my_arg_value(argv[0], "--threads="))) {
+            char *end;
+            threads_count = my_strtosize(value, &end);
+            ASSERT(*end == '\0', "invalid threads: %s", value);
+        } else if(strcmp(argv[0], "--task-timing") == 0) {
+            task_timing = true;
+        } else if(strcmp(argv[0], "--perf-counters") == 0) {
+            my_perf_enabled = true;
+        } else if((value = my_arg_value(argv[0], "--trace="))) {
+            trace_path = value;
+        } else {
+            break;
+        }
+    }
+    if(trace_path) {
+        my_trace_start();
+        my_trace_thread_name("main");
+    }
+    my_thread_pool_init(threads_count);
+
+    if(argc > 0 && strcmp(argv[0], "test") == 0) {
         ASSERT(argc == 1);
-        const char* const arg = my_shift(argv, argc);
-        ASSERT(strcmp(arg, "test") == 0);
         test_all();
+    } else if(argc > 0 && strcmp(argv[0], "bench") == 0) {
+        ASSERT(argc == 1);
+        bench_all();
+    } else if(argc > 0 && strcmp(argv[0], "infer") == 0) {
+        my_shift(argv, argc);
+        const MyInferOptions infer_options = my_infer_options_parse(argc, argv);
+        my_infer(&infer_options);
+    } else if(argc > 0 && strcmp(argv[0], "serve") == 0) {
+        my_shift(argv, argc);
+        const MyServeOptions serve_options = my_serve_options_parse(argc, argv);
+        my_serve(&serve_options);
+    } else if(argc > 0 && strcmp(argv[0], "load") == 0) {
+        my_shift(argv, argc);
+        const MyLoadOptions load_options = my_load_options_parse(argc, argv);
+        my_load(&load_options);
+    } else if(argc > 0 && strcmp(argv[0], "regress") == 0) {
+        my_shift(argv, argc);
+        const MyRegressionOptions regression_options = my_regression_options_parse(argc, argv);
+        status = my_regression(&regression_options) ? 0 : 1;
+    } else if(argc > 0 && strcmp(argv[0], "roofline") == 0) {
+        my_shift(argv, argc);
+        const MyRooflineOptions roofline_options = my_roofline_options_parse(argc, argv);
+        my_roofline(&roofline_options);
+    } else if(argc > 0 && strcmp(argv[0], "devices") == 0) {
+        ASSERT(argc == 1);
+        my_gl_context_list_devices();
+    } else {
+        const MyTrainOptions train_options = my_train_options_parse(argc, argv);
+        if(train_options.dashboard) {
+            my_dashboard(&train_options);
+        } else {
+            my_polynomial_train(train_options);
+        }
+    }
+
+    if(task_timing || my_perf_enabled) {
+        my_thread_pool_report();
+    }
+    my_mem_report();
+    my_thread_pool_deinit();
+    if(trace_path) {
+        my_trace_finish(trace_path);
     }
-    return 0;
+    return status;
 }